@@ -32,6 +32,9 @@
 #include <set>
 #include <string>
 #include <vector>
+#include <typeinfo>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <graphlab/rpc/dc_dist_object.hpp>
 #include <graphlab/vertex_program/icontext.hpp>
 #include <graphlab/graph/distributed_graph.hpp>
@@ -43,6 +46,7 @@
 #include <graphlab/util/mutable_queue.hpp>
 #include <graphlab/logger/assertions.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/fiber_control.hpp>
 #include <graphlab/macros_def.hpp>
 namespace graphlab {
 
@@ -74,6 +78,11 @@ namespace graphlab {
    * tick_synchronous() and tick_asynchronous() should not be used 
    * simultaneously within the same engine execution . For details on their 
    * usage, see their respective documentation.
+   *
+   * The synchronous mode also has an overlapped variant,
+   * tick_synchronous_overlapped(), in which the local map of a
+   * periodic aggregator runs in the background while the engine
+   * continues, and the result is combined and finalized at the next tick.
    * 
    */
   template<typename Graph, typename IContext>
@@ -116,19 +125,21 @@ namespace graphlab {
                  Returns false if it is over edges.*/
       virtual bool is_vertex_map() const = 0;      
       
-      /** \brief Returns the accumulator stored in an any. 
-                 (by some magic, any's can be serialized) */
-      virtual any get_accumulator() const = 0;
-      
-      /** \brief Combines accumulators using a second accumulator 
-                 stored in an any (as returned by get_accumulator).
-                 Must be thread safe.*/
-      virtual void add_accumulator_any(any& other) = 0;
+      /** \brief Replaces the accumulator on every machine with the sum of
+                 the accumulators of all machines. Must be called on all
+                 machines simultaneously. */
+      virtual void all_reduce_accumulator(dc_dist_object<distributed_aggregator>& rmi) = 0;
+
+      /** \brief Serializes the accumulator */
+      virtual void save_accumulator(oarchive& oarc) const = 0;
 
-      /** \brief Sets the value of the accumulator
-                 from an any (as returned by get_accumulator).
-                 Must be thread safe.*/
-      virtual void set_accumulator_any(any& other) = 0;
+      /** \brief Combines accumulators using a second accumulator
+                 serialized by save_accumulator(). Must be thread safe.*/
+      virtual void add_accumulator(iarchive& iarc) = 0;
+
+      /** \brief Sets the value of the accumulator from an accumulator
+                 serialized by save_accumulator(). Must be thread safe.*/
+      virtual void load_accumulator(iarchive& iarc) = 0;
 
       
       /** \brief Combines accumulators using a second accumulator 
@@ -142,6 +153,24 @@ namespace graphlab {
       /** \brief Calls the finalize operation on internal accumulator */
       virtual void finalize(icontext_type&) = 0;
 
+      /** \brief Returns true if the accumulator is to be computed from
+                 deltas rather than by a map over the graph */
+      virtual bool is_incremental() const { return false; }
+
+      /** \brief Moves the deltas pushed since the last aggregation into
+                 the accumulator */
+      virtual void take_deltas() { }
+
+      /** \brief Discards the running value of an incremental aggregator,
+                 so that the next aggregation maps over the graph */
+      virtual void reset_incremental() { }
+
+      /** \brief Adds a delta pushed by a vertex program. delta points
+                 to an object of the reduction type. Must be thread safe. */
+      virtual void add_delta(const void* delta, const std::type_info& type) {
+        ASSERT_MSG(false, "Deltas can only be added to incremental aggregators");
+      }
+
       virtual ~imap_reduce_base() { }
     };
     
@@ -163,6 +192,11 @@ namespace graphlab {
               typename FinalizerType>
     struct map_reduce_type : public imap_reduce_base {
       conditional_addition_wrapper<ReductionType> acc;
+      typedef conditional_addition_wrapper<ReductionType> accumulator_type;
+      /// Receives accumulators of other machines in add_accumulator()
+      accumulator_type incoming;
+      /// Receives accumulators of other machines in all_reduce_accumulator()
+      accumulator_type received;
       VertexMapperType map_vtx_function;
       EdgeMapperType map_edge_function;
       FinalizerType finalize_function;
@@ -239,19 +273,26 @@ namespace graphlab {
         return vertex_map;
       }
       
-      any get_accumulator() const {
-        return any(acc);
+      void all_reduce_accumulator(dc_dist_object<distributed_aggregator>& rmi) {
+        typedef typename dc_dist_object<distributed_aggregator>::
+            template default_plus_equal<accumulator_type> plus_equal_type;
+        rmi.all_reduce2(acc, received, plus_equal_type());
       }
-      
-      void add_accumulator_any(any& other) {
+
+      void save_accumulator(oarchive& oarc) const {
+        oarc << acc;
+      }
+
+      void add_accumulator(iarchive& iarc) {
         lock.lock();
-        acc += other.as<conditional_addition_wrapper<ReductionType> >();
+        iarc >> incoming;
+        acc += incoming;
         lock.unlock();
       }
 
-      void set_accumulator_any(any& other) {
+      void load_accumulator(iarchive& iarc) {
         lock.lock();
-        acc = other.as<conditional_addition_wrapper<ReductionType> >();
+        iarc >> acc;
         lock.unlock();
       }
 
@@ -286,6 +327,119 @@ namespace graphlab {
     };
     
 
+    /**
+     * \internal
+     * An incremental map_reduce_type. The first aggregation maps over
+     * the graph like map_reduce_type and keeps the result as a running
+     * total. After that, the accumulator is only the sum of the deltas
+     * which vertex programs pushed with add_delta() since the previous
+     * aggregation. That sum is added to the total before it is passed to
+     * the finalizer.
+     *
+     * Deltas are summed into one slot per worker thread. The slots and
+     * the total are shared by all clones, so the per thread reducers of
+     * the asynchronous aggregation see the same state.
+     */
+    template <typename ReductionType,
+              typename VertexMapperType,
+              typename EdgeMapperType,
+              typename FinalizerType>
+    struct delta_map_reduce_type :
+        public map_reduce_type<ReductionType, VertexMapperType,
+                               EdgeMapperType, FinalizerType> {
+      typedef map_reduce_type<ReductionType, VertexMapperType,
+                              EdgeMapperType, FinalizerType> base_type;
+
+      struct delta_slot {
+        simple_spinlock lock;
+        conditional_addition_wrapper<ReductionType> value;
+        // keep the slots of different threads on different cache lines
+        char padding[64];
+      };
+
+      struct shared_state {
+        std::vector<delta_slot> slots;
+        conditional_addition_wrapper<ReductionType> total;
+        bool has_total;
+        shared_state(): slots(std::max<size_t>(thread::cpu_count(), 1)),
+                        has_total(false) { }
+      };
+      boost::shared_ptr<shared_state> state;
+
+      delta_map_reduce_type(VertexMapperType map_vtx_function,
+                            FinalizerType finalize_function)
+          : base_type(map_vtx_function, finalize_function),
+            state(new shared_state) { }
+
+      delta_map_reduce_type(EdgeMapperType map_edge_function,
+                            FinalizerType finalize_function,
+                            bool)
+          : base_type(map_edge_function, finalize_function, true),
+            state(new shared_state) { }
+
+      bool is_incremental() const {
+        return state->has_total;
+      }
+
+      void take_deltas() {
+        for (size_t i = 0; i < state->slots.size(); ++i) {
+          delta_slot& slot = state->slots[i];
+          slot.lock.lock();
+          // deltas from before the first map are already part of it
+          if (state->has_total) {
+            base_type::lock.lock();
+            base_type::acc += slot.value;
+            base_type::lock.unlock();
+          }
+          slot.value.clear();
+          slot.lock.unlock();
+        }
+      }
+
+      void reset_incremental() {
+        state->total.clear();
+        state->has_total = false;
+      }
+
+      void add_delta(const void* delta, const std::type_info& type) {
+        ASSERT_MSG(type == typeid(ReductionType),
+                   "Delta type does not match the aggregator reduction type");
+        size_t worker = fiber_control::get_worker_id();
+        if (worker == (size_t)(-1)) worker = thread::thread_id();
+        delta_slot& slot = state->slots[worker % state->slots.size()];
+        slot.lock.lock();
+        slot.value += *reinterpret_cast<const ReductionType*>(delta);
+        slot.lock.unlock();
+      }
+
+      void finalize(icontext_type& context) {
+        if (state->has_total) {
+          state->total += base_type::acc;
+        }
+        else {
+          state->total = base_type::acc;
+          state->has_total = true;
+        }
+        base_type::finalize_function(context, state->total.value);
+      }
+
+      imap_reduce_base* clone_empty() const {
+        delta_map_reduce_type* copy;
+        if (base_type::is_vertex_map()) {
+          copy = new delta_map_reduce_type(base_type::map_vtx_function,
+                                           base_type::finalize_function);
+        }
+        else {
+          copy = new delta_map_reduce_type(base_type::map_edge_function,
+                                           base_type::finalize_function,
+                                           true);
+        }
+        copy->state = state;
+        return copy;
+      }
+    };
+
+
     std::map<std::string, imap_reduce_base*> aggregators;
     std::map<std::string, float> aggregate_period;
 
@@ -311,6 +465,18 @@ namespace graphlab {
     mutex schedule_lock;
     size_t ncpus;
 
+    /// Local vertices mapped at a time by the overlapped aggregation
+    static const size_t OVERLAP_BLOCK_SIZE = 1024;
+    /// Keys started by the last tick_synchronous_overlapped()
+    std::vector<std::string> overlap_keys;
+    /// The reductions of overlap_keys which still need a local map
+    std::vector<imap_reduce_base*> overlap_maps;
+    /// The next (aggregator, block) pair to be mapped
+    atomic<size_t> overlap_next;
+    /// The background thread performing the local maps
+    thread_group overlap_threads;
+    bool overlap_running;
+
     template <typename ReductionType, typename F>
     static void test_vertex_mapper_type(std::string key = "") {
       bool test_result = test_function_or_const_functor_2<F,
@@ -385,7 +551,8 @@ namespace graphlab {
                            graph_type& graph, 
                            icontext_type* context):
                             rmi(dc, this), graph(graph), 
-                            context(context), ncpus(0) { }
+                            context(context), ncpus(0),
+                            overlap_running(false) { }
 
     /**
      * \copydoc graphlab::iengine::add_vertex_aggregator
@@ -511,7 +678,78 @@ namespace graphlab {
       }
     }
 #endif
-    
+
+    /**
+     * \copydoc graphlab::iengine::add_vertex_delta_aggregator
+     */
+    template <typename ReductionType,
+              typename VertexMapperType,
+              typename FinalizerType>
+    bool add_vertex_delta_aggregator(const std::string& key,
+                                     VertexMapperType map_function,
+                                     FinalizerType finalize_function) {
+      if (key.length() == 0) return false;
+      if (aggregators.count(key) == 0) {
+        if (rmi.procid() == 0) {
+          // do a runtime type check
+          test_vertex_mapper_type<ReductionType, VertexMapperType>(key);
+        }
+        aggregators[key] = new delta_map_reduce_type<ReductionType,
+                                  VertexMapperType,
+                                  typename default_map_types<ReductionType>::edge_map_type,
+                                  FinalizerType>(map_function,
+                                                 finalize_function);
+        return true;
+      }
+      else {
+        // aggregator already exists. fail
+        return false;
+      }
+    }
+
+    /**
+     * \copydoc graphlab::iengine::add_edge_delta_aggregator
+     */
+    template <typename ReductionType,
+              typename EdgeMapperType,
+              typename FinalizerType>
+    bool add_edge_delta_aggregator(const std::string& key,
+                                   EdgeMapperType map_function,
+                                   FinalizerType finalize_function) {
+      if (key.length() == 0) return false;
+      if (aggregators.count(key) == 0) {
+        if (rmi.procid() == 0) {
+          // do a runtime type check
+          test_edge_mapper_type<ReductionType, EdgeMapperType>(key);
+        }
+        aggregators[key] = new delta_map_reduce_type<ReductionType,
+                                  typename default_map_types<ReductionType>::vertex_map_type,
+                                  EdgeMapperType,
+                                  FinalizerType>(map_function,
+                                                 finalize_function,
+                                                 true);
+        return true;
+      }
+      else {
+        // aggregator already exists. fail
+        return false;
+      }
+    }
+
+    /**
+     * Adds a delta to the incremental aggregator key. delta must point
+     * to an object of the reduction type of the aggregator. Called by the
+     * context on behalf of vertex programs. Thread safe.
+     */
+    void add_delta(const std::string& key, const void* delta,
+                   const std::type_info& type) {
+      typename std::map<std::string, imap_reduce_base*>::iterator iter =
+                                                      aggregators.find(key);
+      ASSERT_MSG(iter != aggregators.end(),
+                 "Requested aggregator %s not found", key.c_str());
+      iter->second->add_delta(delta, type);
+    }
+
     /**
      * \copydoc graphlab::iengine::aggregate_now
      */
@@ -524,67 +762,56 @@ namespace graphlab {
       
       imap_reduce_base* mr = aggregators[key];
       mr->clear_accumulator();
-      // ok. now we perform reduction on local data in parallel
+      // incremental aggregators only need the deltas since the last time
+      if (mr->is_incremental()) {
+        mr->take_deltas();
+      }
+      else {
+        // ok. now we perform reduction on local data in parallel
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
-      {
-        imap_reduce_base* localmr = mr->clone_empty();
-        if (localmr->is_vertex_map()) {
+        {
+          imap_reduce_base* localmr = mr->clone_empty();
+          if (localmr->is_vertex_map()) {
 #ifdef _OPENMP
-        #pragma omp for
+          #pragma omp for
 #endif
-          for (int i = 0; i < (int)graph.num_local_vertices(); ++i) {
-            local_vertex_type lvertex = graph.l_vertex(i);
-            if (lvertex.owner() == rmi.procid()) {
-              vertex_type vertex(lvertex);
-              localmr->perform_map_vertex(*context, vertex);
+            for (int i = 0; i < (int)graph.num_local_vertices(); ++i) {
+              local_vertex_type lvertex = graph.l_vertex(i);
+              if (lvertex.owner() == rmi.procid()) {
+                vertex_type vertex(lvertex);
+                localmr->perform_map_vertex(*context, vertex);
+              }
             }
           }
-        }
-        else {
+          else {
 #ifdef _OPENMP
-        #pragma omp for
+          #pragma omp for
 #endif
-          for (int i = 0; i < (int)graph.num_local_vertices(); ++i) {
-            foreach(local_edge_type e, graph.l_vertex(i).in_edges()) {
-              edge_type edge(e);
-              localmr->perform_map_edge(*context, edge);
+            for (int i = 0; i < (int)graph.num_local_vertices(); ++i) {
+              foreach(local_edge_type e, graph.l_vertex(i).in_edges()) {
+                edge_type edge(e);
+                localmr->perform_map_edge(*context, edge);
+              }
             }
           }
-        }
 #ifdef _OPENMP
-        #pragma omp critical
+          #pragma omp critical
 #endif
-        {
-          mr->add_accumulator(localmr);
-        }
-        delete localmr;
-      }
-      
-      std::vector<any> gathervec(rmi.numprocs());
-      gathervec[rmi.procid()] = mr->get_accumulator();
-      
-      rmi.gather(gathervec, 0);
-      
-      if (rmi.procid() == 0) {
-        // machine 0 aggregates the accumulators
-        // sums them together and broadcasts it
-        for (procid_t i = 1; i < rmi.numprocs(); ++i) {
-          mr->add_accumulator_any(gathervec[i]);
+          {
+            mr->add_accumulator(localmr);
+          }
+          delete localmr;
         }
-        any val = mr->get_accumulator();
-        rmi.broadcast(val, true);
-      }
-      else {
-        // all other machines wait for the broadcast value
-        any val;
-        rmi.broadcast(val, false);
-        mr->set_accumulator_any(val);
+        // drop the deltas already covered by the map
+        mr->take_deltas();
       }
+
+      // combine the accumulators of all machines in place
+      mr->all_reduce_accumulator(rmi);
       mr->finalize(*context);
       mr->clear_accumulator();
-      gathervec.clear();
       return true;
     }
     
@@ -627,6 +854,16 @@ namespace graphlab {
     void start(size_t ncpus = 0) {
       rmi.barrier();
       schedule.clear();
+      // the graph may have changed since the last run, so incremental
+      // aggregators begin with a full map again
+      {
+        typename std::map<std::string, imap_reduce_base*>::iterator iter =
+                                                          aggregators.begin();
+        while (iter != aggregators.end()) {
+          iter->second->reset_incremental();
+          ++iter;
+        }
+      }
       start_time = timer::approx_time_seconds();
       typename std::map<std::string, float>::iterator iter =
                                                     aggregate_period.begin();
@@ -709,7 +946,9 @@ namespace graphlab {
       
       imap_reduce_base* localmr = iter->second.per_thread_aggregation[cpuid];
       // perform the reduction using the local mr
-      if (localmr->is_vertex_map()) {
+      if (localmr->is_incremental()) {
+        // the deltas are collected once per machine below
+      } else if (localmr->is_vertex_map()) {
         for (int i = cpuid;i < (int)graph.num_local_vertices(); i+=ncpus) {
           local_vertex_type lvertex = graph.l_vertex(i);
           if (lvertex.owner() == rmi.procid()) {
@@ -741,14 +980,17 @@ namespace graphlab {
           iter->second.per_thread_aggregation[i]->clear_accumulator();
         }
         iter->second.local_count_down = ncpus;
+        iter->second.root_reducer->take_deltas();
         
         if (rmi.procid() != 0) {
           // ok we need to signal back to the the root to perform finalization
           // read the accumulator
-          any acc = iter->second.root_reducer->get_accumulator();
+          oarchive oarc;
+          iter->second.root_reducer->save_accumulator(oarc);
           iter->second.root_reducer->clear_accumulator();
           rmi.remote_call(0, &distributed_aggregator::rpc_key_merge,
-                          key, acc);
+                          key, dc_impl::blob(oarc.buf, oarc.off));
+          free(oarc.buf);
         }
         else {
           decrement_distributed_counter(key);
@@ -761,12 +1003,14 @@ namespace graphlab {
      * This function will merge the accumulator and perform finalization
      * when all accumulators are received
      */
-    void rpc_key_merge(const std::string& key, any& acc) {
+    void rpc_key_merge(const std::string& key, dc_impl::blob& acc) {
       // acquire and check the async_aggregator_state 
       typename std::map<std::string, async_aggregator_state>::iterator iter =
                                                       async_state.find(key);
       ASSERT_MSG(iter != async_state.end(), "Key %s not found", key.c_str());
-      iter->second.root_reducer->add_accumulator_any(acc);
+      iarchive iarc(acc.c, acc.len);
+      iter->second.root_reducer->add_accumulator(iarc);
+      acc.free();
       decrement_distributed_counter(key);
     }
 
@@ -791,14 +1035,16 @@ namespace graphlab {
       ASSERT_GE(countdown_val, 0);
       if (countdown_val == 0) {
         logstream(LOG_INFO) << "Aggregate completion of " << key << std::endl;
-        any acc_val = iter->second.root_reducer->get_accumulator();
+        oarchive oarc;
+        iter->second.root_reducer->save_accumulator(oarc);
         // set distributed count down again for the second phase:
         // waiting for everyone to finish finalization
         iter->second.distributed_count_down = rmi.numprocs();
         for (procid_t i = 1;i < rmi.numprocs(); ++i) {
           rmi.remote_call(i, &distributed_aggregator::rpc_perform_finalize,
-                            key, acc_val);
+                            key, dc_impl::blob(oarc.buf, oarc.off));
         }
+        free(oarc.buf);
         iter->second.root_reducer->finalize(*context);
         iter->second.root_reducer->clear_accumulator();
         decrement_finalize_counter(key);
@@ -809,13 +1055,15 @@ namespace graphlab {
      * Called from the root machine to all machines to perform finalization
      * on the key
      */
-    void rpc_perform_finalize(const std::string& key, any& acc_val) {
+    void rpc_perform_finalize(const std::string& key, dc_impl::blob& acc_val) {
       ASSERT_NE(rmi.procid(), 0);
       typename std::map<std::string, async_aggregator_state>::iterator iter =
                                                   async_state.find(key);
       ASSERT_MSG(iter != async_state.end(), "Key %s not found", key.c_str());
       
-      iter->second.root_reducer->set_accumulator_any(acc_val);
+      iarchive iarc(acc_val.c, acc_val.len);
+      iter->second.root_reducer->load_accumulator(iarc);
+      acc_val.free();
       iter->second.root_reducer->finalize(*context);
       iter->second.root_reducer->clear_accumulator();
       // reply to the root machine
@@ -889,11 +1137,89 @@ namespace graphlab {
       }
     }
 
+    /**
+     * The overlapped form of tick_synchronous(). To be called
+     * simultaneously by one thread on each machine. This first completes
+     * the aggregations started by the previous call: waits for their
+     * local maps, combines them across machines, finalizes and
+     * reschedules them. It then starts the local maps of the aggregators
+     * which are ready in a background thread and returns immediately.
+     *
+     * The maps read the graph while the caller continues, so the caller
+     * must call wait_overlapped() before modifying vertex or edge data,
+     * and finish_overlapped() once it stops ticking. The results are
+     * hence delivered one tick later than with tick_synchronous().
+     */
+    void tick_synchronous_overlapped() {
+      finish_overlapped();
+      float curtime = timer::approx_time_seconds() - start_time;
+      rmi.broadcast(curtime, rmi.procid() == 0);
+      while(!schedule.empty() && -schedule.top().second <= curtime) {
+        std::string key = schedule.top().first;
+        schedule.pop();
+        imap_reduce_base* mr = aggregators[key];
+        mr->clear_accumulator();
+        // incremental aggregators only need the deltas. For the others
+        // this drops the deltas which the map will cover.
+        const bool incremental = mr->is_incremental();
+        mr->take_deltas();
+        if (!incremental) overlap_maps.push_back(mr);
+        overlap_keys.push_back(key);
+      }
+      if (!overlap_maps.empty()) {
+        overlap_next = 0;
+        overlap_running = true;
+        overlap_threads.launch(boost::bind(&distributed_aggregator::overlap_map,
+                                           this));
+      }
+    }
+
+    /**
+     * Waits for the local maps started by tick_synchronous_overlapped()
+     * to complete. The calling thread helps with the remaining work.
+     * After this returns, the graph may be modified again.
+     */
+    void wait_overlapped() {
+      if (!overlap_running) return;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      overlap_map();
+      overlap_threads.join();
+      overlap_maps.clear();
+      overlap_running = false;
+    }
+
+    /**
+     * Completes the aggregations started by the last
+     * tick_synchronous_overlapped(). Must be called on all machines
+     * simultaneously.
+     */
+    void finish_overlapped() {
+      wait_overlapped();
+      for (size_t i = 0; i < overlap_keys.size(); ++i) {
+        const std::string& key = overlap_keys[i];
+        imap_reduce_base* mr = aggregators[key];
+        mr->all_reduce_accumulator(rmi);
+        mr->finalize(*context);
+        mr->clear_accumulator();
+        // when is the next time we start. 
+        // time is as an offset to start_time
+        float next_time = (timer::approx_time_seconds() + 
+                           aggregate_period[key] - start_time);
+        rmi.broadcast(next_time, rmi.procid() == 0);
+        schedule.push(key, -next_time);
+      }
+      overlap_keys.clear();
+    }
+
     /**
      * Must be called on engine stop. Clears the internal scheduler
      * And resets all incomplete states.
      */
     void stop() {
+      wait_overlapped();
+      overlap_keys.clear();
       schedule.clear();
       // clear the aggregators
       {
@@ -1086,7 +1412,55 @@ namespace graphlab {
     
     
     
+    /**
+     * Maps blocks of local vertices (or of their in edges) for the
+     * aggregators in overlap_maps until none are left. Each block is
+     * claimed from overlap_next, so any number of threads may run this
+     * at the same time.
+     */
+    void overlap_map() {
+      const size_t nverts = graph.num_local_vertices();
+      const size_t nblocks = (nverts + OVERLAP_BLOCK_SIZE - 1) /
+                             OVERLAP_BLOCK_SIZE;
+      std::vector<imap_reduce_base*> localmrs(overlap_maps.size(), NULL);
+      while(1) {
+        const size_t item = overlap_next.inc_ret_last();
+        if (item >= nblocks * overlap_maps.size()) break;
+        const size_t idx = item / nblocks;
+        const size_t begin = (item % nblocks) * OVERLAP_BLOCK_SIZE;
+        const size_t end = std::min(begin + OVERLAP_BLOCK_SIZE, nverts);
+        if (localmrs[idx] == NULL) {
+          localmrs[idx] = overlap_maps[idx]->clone_empty();
+        }
+        imap_reduce_base* localmr = localmrs[idx];
+        if (localmr->is_vertex_map()) {
+          for (size_t i = begin; i < end; ++i) {
+            local_vertex_type lvertex = graph.l_vertex(i);
+            if (lvertex.owner() == rmi.procid()) {
+              vertex_type vertex(lvertex);
+              localmr->perform_map_vertex(*context, vertex);
+            }
+          }
+        }
+        else {
+          for (size_t i = begin; i < end; ++i) {
+            foreach(local_edge_type e, graph.l_vertex(i).in_edges()) {
+              edge_type edge(e);
+              localmr->perform_map_edge(*context, edge);
+            }
+          }
+        }
+      }
+      for (size_t i = 0; i < localmrs.size(); ++i) {
+        if (localmrs[i] != NULL) {
+          overlap_maps[i]->add_accumulator(localmrs[i]);
+          delete localmrs[i];
+        }
+      }
+    }
+
     ~distributed_aggregator() {
+      wait_overlapped();
       delete context;
     }
   }; 
@@ -199,7 +199,10 @@ namespace graphlab {
    * calls are guaranteed to be locally consistent. Can produce massive
    * increases in throughput at a consistency penalty.
    * \li \b nfibers (default: 10000) Number of fibers to use
-   * \li \b stacksize (default: 16384) Stacksize of each fiber.
+   * \li \b stacksize (default: 16384) Stacksize of each fiber. Stacks are
+   * rounded up to a power of two number of pages. Run with
+   * GRAPHLAB_FIBER_STACK_USAGE=1 to log the stack high-water mark after
+   * each run.
    */
   template<typename VertexProgram>
   class async_consistent_engine: public iengine<VertexProgram> {
@@ -1245,6 +1248,7 @@ namespace graphlab {
                         i % effncpus);
       }
       thrgroup.join();
+      fiber_control::get_instance().log_stack_usage();
       aggregator.stop();
       // if termination reason was not changed, then it must be depletion
       if (termination_reason == execution_status::RUNNING) {
@@ -26,7 +26,9 @@
 #include <graphlab/engine/iengine.hpp>
 #include <graphlab/engine/synchronous_engine.hpp>
 #include <graphlab/engine/async_consistent_engine.hpp>
+#include <graphlab/engine/ssp_engine.hpp>
 #include <graphlab/engine/omni_engine.hpp>
+#include <graphlab/engine/hogwild_engine.hpp>
 
 #include <graphlab/engine/execution_status.hpp>
 
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_HOGWILD_ENGINE_HPP
+#define GRAPHLAB_HOGWILD_ENGINE_HPP
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include <graphlab/options/graphlab_options.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/rpc/dc_dist_object.hpp>
+#include <graphlab/rpc/buffered_exchange.hpp>
+#include <graphlab/util/random.hpp>
+#include <graphlab/util/timer.hpp>
+#include <graphlab/logger/logger.hpp>
+
+#include <graphlab/macros_def.hpp>
+
+namespace graphlab {
+
+  /**
+   * \ingroup engines
+   *
+   * \brief Runs a function on every edge of the graph in parallel
+   * without locks, as in Hogwild! (Niu et al. 2011) stochastic gradient
+   * descent.
+   *
+   * Unlike the vertex program engines there is no gather, apply or
+   * scatter and no consistency: the update function reads and writes
+   * the data of both endpoints of its edge directly, concurrently with
+   * the updates of other edges. This is only suitable for algorithms
+   * which tolerate the races, such as SGD on sparse problems, but it
+   * runs an edge update in the time of a couple of dot products.
+   *
+   * Each machine runs the update over its local edges, in stripes of
+   * consecutive edges of the local CSR which the threads claim one at a
+   * time, in a random stripe order in every epoch. The replicas of a
+   * vertex on different machines therefore diverge during an epoch. Every
+   * sync_interval epochs the replicas are averaged: the mirrors send
+   * their data to the master which combines them and divides by the
+   * number of replicas with the user provided functions, and the result
+   * is sent back to the mirrors.
+   *
+   * The update function returns whether it updated the edge, so that
+   * edges it skips (e.g. held out for validation) are not counted in
+   * num_updates().
+   *
+   * \code
+   * bool sgd_update(graph_type::edge_type& edge) {
+   *   if (!edge.data().train) return false;
+   *   vec_type& u = edge.source().data().factor;
+   *   vec_type& v = edge.target().data().factor;
+   *   const double err = edge.data().obs - u.dot(v);
+   *   for (int k = 0; k < u.size(); ++k) {
+   *     const double uk = u[k];
+   *     u[k] += GAMMA * (err * v[k] - LAMBDA * uk);
+   *     v[k] += GAMMA * (err * uk - LAMBDA * v[k]);
+   *   }
+   *   return true;
+   * }
+   * void combine(vertex_data& master, const vertex_data& mirror) {
+   *   master.factor += mirror.factor;
+   * }
+   * void average(vertex_data& master, size_t nreplicas) {
+   *   master.factor /= nreplicas;
+   * }
+   *
+   * graphlab::hogwild_engine<graph_type> engine(dc, graph, clopts);
+   * engine.set_averaging(combine, average);
+   * for (size_t i = 0; i < nepochs; ++i) engine.run_epoch(sgd_update);
+   * \endcode
+   *
+   * Valid engine options (graphlab_options::get_engine_args()):
+   * \li \c stripe_size The number of edges in a stripe. Defaults to 4096.
+   * \li \c shuffle If true (the default) the stripes are visited in a
+   *                new random order in every epoch.
+   * \li \c sync_interval The number of epochs between averaging the
+   *                replicas. Defaults to 1. Averaging is skipped on a
+   *                single machine.
+   *
+   * \tparam Graph The distributed graph type
+   */
+  template <typename Graph>
+  class hogwild_engine {
+  public:
+    typedef Graph graph_type;
+    typedef typename graph_type::vertex_data_type vertex_data_type;
+    typedef typename graph_type::vertex_type vertex_type;
+    typedef typename graph_type::edge_type edge_type;
+    typedef typename graph_type::local_vertex_type local_vertex_type;
+    typedef typename graph_type::local_edge_type local_edge_type;
+
+    /// The function run on every edge. Returns true if it updated the edge.
+    typedef boost::function<bool (edge_type&)> update_function_type;
+
+    /// Adds the data of a mirror into the data of the master
+    typedef boost::function<void (vertex_data_type&, const vertex_data_type&)>
+        combine_function_type;
+
+    /// Divides the combined data of the master by the number of replicas
+    typedef boost::function<void (vertex_data_type&, size_t)>
+        average_function_type;
+
+  private:
+    typedef std::pair<vertex_id_type, vertex_data_type> vertex_pair_type;
+
+    dc_dist_object<hogwild_engine> rmi;
+    graph_type& graph;
+    size_t ncpus;
+    size_t stripe_size;
+    bool shuffle;
+    size_t sync_interval;
+
+    /// Stripe i holds the out edges of the local vertices
+    /// stripe_begin[i] .. stripe_begin[i+1] - 1
+    std::vector<lvid_type> stripe_begin;
+    std::vector<size_t> stripe_order;
+    atomic<size_t> next_stripe;
+    atomic<size_t> local_updates;
+
+    combine_function_type combine_fn;
+    average_function_type average_fn;
+    buffered_exchange<vertex_pair_type> replica_exchange;
+
+    size_t nepochs;
+    size_t total_updates;
+    double total_time;
+
+  public:
+    /**
+     * \brief Constructs the engine and finalizes the graph. Must be
+     * called on all machines simultaneously.
+     */
+    hogwild_engine(distributed_control& dc, graph_type& graph,
+                   const graphlab_options& opts = graphlab_options()) :
+      rmi(dc, this), graph(graph), ncpus(opts.get_ncpus()),
+      stripe_size(4096), shuffle(true), sync_interval(1),
+      replica_exchange(dc), nepochs(0), total_updates(0), total_time(0) {
+      std::vector<std::string> keys = opts.get_engine_args().get_option_keys();
+      foreach(std::string opt, keys) {
+        if (opt == "stripe_size") {
+          opts.get_engine_args().get_option("stripe_size", stripe_size);
+          if (rmi.procid() == 0)
+            logstream(LOG_EMPH) << "Engine Option: stripe_size = "
+              << stripe_size << std::endl;
+        } else if (opt == "shuffle") {
+          opts.get_engine_args().get_option("shuffle", shuffle);
+          if (rmi.procid() == 0)
+            logstream(LOG_EMPH) << "Engine Option: shuffle = "
+              << shuffle << std::endl;
+        } else if (opt == "sync_interval") {
+          opts.get_engine_args().get_option("sync_interval", sync_interval);
+          if (rmi.procid() == 0)
+            logstream(LOG_EMPH) << "Engine Option: sync_interval = "
+              << sync_interval << std::endl;
+        } else {
+          logstream(LOG_FATAL) << "Unexpected Engine Option: " << opt << std::endl;
+        }
+      }
+      if (stripe_size == 0) stripe_size = 1;
+      if (ncpus == 0) ncpus = 1;
+      graph.finalize();
+      build_stripes();
+      rmi.barrier();
+    }
+
+    /**
+     * \brief Sets the functions used to average the replicas of a
+     * vertex. Without them the replicas are never averaged, which is
+     * only correct on a single machine.
+     */
+    void set_averaging(combine_function_type combine,
+                       average_function_type average) {
+      combine_fn = combine;
+      average_fn = average;
+    }
+
+    /**
+     * \brief Runs the update function once on every edge of the graph,
+     * and averages the replicas if this is a synchronization epoch.
+     * Must be called on all machines simultaneously.
+     *
+     * \return The number of edges for which the update function returned
+     *         true on all machines
+     */
+    size_t run_epoch(const update_function_type& update) {
+      timer ti;
+      ti.start();
+      if (shuffle) random::shuffle(stripe_order);
+      next_stripe = 0;
+      local_updates = 0;
+      thread_group threads;
+      for (size_t i = 0; i < ncpus; ++i) {
+        threads.launch(boost::bind(&hogwild_engine::run_stripes, this,
+                                   boost::cref(update)));
+      }
+      threads.join();
+      ++nepochs;
+      if (rmi.numprocs() > 1 && nepochs % sync_interval == 0) {
+        average_replicas();
+      }
+      size_t updates = local_updates;
+      rmi.all_reduce(updates);
+      total_updates += updates;
+      total_time += ti.current_time();
+      return updates;
+    }
+
+    /**
+     * \brief Averages the replicas of every vertex now. Called by
+     * run_epoch() every sync_interval epochs. Must be called on all
+     * machines simultaneously.
+     */
+    void average_replicas() {
+      if (combine_fn.empty() || average_fn.empty()) {
+        logstream(LOG_WARNING) << "No averaging functions: the replicas "
+                               << "of the vertices are not averaged" << std::endl;
+        return;
+      }
+      // the mirrors send their data to the master
+      for (lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+        local_vertex_type lvertex = graph.l_vertex(lvid);
+        if (!lvertex.owned()) {
+          replica_exchange.send(lvertex.owner(),
+                                vertex_pair_type(lvertex.global_id(),
+                                                 lvertex.data()));
+        }
+      }
+      replica_exchange.flush();
+      procid_t sending_proc;
+      typename buffered_exchange<vertex_pair_type>::buffer_type recv_buffer;
+      while(replica_exchange.recv(sending_proc, recv_buffer)) {
+        foreach(const vertex_pair_type& pair, recv_buffer) {
+          combine_fn(graph.vertex(pair.first).data(), pair.second);
+        }
+        recv_buffer.clear();
+      }
+      for (lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+        local_vertex_type lvertex = graph.l_vertex(lvid);
+        if (lvertex.owned() && lvertex.num_mirrors() > 0) {
+          average_fn(lvertex.data(), lvertex.num_mirrors() + 1);
+        }
+      }
+      // and receive the average back
+      graph.synchronize();
+    }
+
+    /// \brief The number of epochs run
+    size_t num_epochs() const { return nepochs; }
+
+    /// \brief The number of edges updated over all epochs and machines
+    size_t num_updates() const { return total_updates; }
+
+    /// \brief The time spent in run_epoch() in seconds
+    double elapsed_seconds() const { return total_time; }
+
+  private:
+    /// Cuts the local vertices into ranges with about stripe_size out edges
+    void build_stripes() {
+      stripe_begin.clear();
+      size_t nedges = stripe_size;
+      for (lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+        if (nedges >= stripe_size) {
+          stripe_begin.push_back(lvid);
+          nedges = 0;
+        }
+        nedges += graph.l_vertex(lvid).num_out_edges();
+      }
+      stripe_order.resize(stripe_begin.size());
+      for (size_t i = 0; i < stripe_order.size(); ++i) stripe_order[i] = i;
+      stripe_begin.push_back(graph.num_local_vertices());
+    }
+
+    /// Claims stripes and runs the update on their edges until none is left
+    void run_stripes(const update_function_type& update) {
+      size_t nupdates = 0;
+      while (true) {
+        const size_t i = next_stripe.inc_ret_last();
+        if (i >= stripe_order.size()) break;
+        const size_t stripe = stripe_order[i];
+        for (lvid_type lvid = stripe_begin[stripe];
+             lvid < stripe_begin[stripe + 1]; ++lvid) {
+          foreach(const local_edge_type& ledge, graph.l_vertex(lvid).out_edges()) {
+            edge_type edge(ledge);
+            if (update(edge)) ++nupdates;
+          }
+        }
+      }
+      local_updates += nupdates;
+    }
+  }; // end of hogwild_engine
+
+} // namespace graphlab
+
+#include <graphlab/macros_undef.hpp>
+
+#endif
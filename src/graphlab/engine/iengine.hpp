@@ -759,6 +759,105 @@ namespace graphlab {
     } // end of add edge aggregator
 #endif
 
+    /**
+     * \brief Creates an incremental vertex aggregator. Returns true on
+     *        success. Returns false if an aggregator of the same name
+     *        already exists.
+     *
+     * An incremental aggregator is like the aggregator created by
+     * add_vertex_aggregator(), but only maps over the graph on its first
+     * aggregation in each run of the engine. Afterwards, vertex programs
+     * keep the value current by pushing the change of their contribution
+     * with icontext::aggregate_delta(), and each aggregation only combines
+     * the deltas pushed since the previous one. This makes an aggregation
+     * proportional to the amount of change rather than to the size of
+     * the graph.
+     *
+     * For instance, to track the sum of a vertex value which is only
+     * changed in apply:
+     * \code
+     * void apply(icontext_type& context, vertex_type& vertex,
+     *            const gather_type& total) {
+     *   const float old_value = vertex.data();
+     *   vertex.data() = compute_new_value(total);
+     *   context.aggregate_delta("vertex_sum", vertex.data() - old_value);
+     * }
+     * ...
+     * engine.add_vertex_delta_aggregator<float>("vertex_sum",
+     *                                           vertex_value,
+     *                                           print_finalize);
+     * engine.aggregate_periodic("vertex_sum", 1.5);
+     * \endcode
+     *
+     * The finalize function receives the running total. With the
+     * asynchronous engines, deltas pushed while the first map is in
+     * progress may be counted twice or not at all.
+     *
+     * \tparam ReductionType The output of the map function and the type of
+     *                       the deltas. Must have operator+= defined, and
+     *                       must be \ref sec_serializable.
+     *
+     * \param [in] key The name of this aggregator. Must be unique.
+     * \param [in] map_function The Map function to use, as in
+     *                          add_vertex_aggregator().
+     * \param [in] finalize_function The Finalize function to use, as in
+     *                               add_vertex_aggregator().
+     */
+    template <typename ReductionType,
+              typename VertexMapType,
+              typename FinalizerType>
+    bool add_vertex_delta_aggregator(const std::string& key,
+                                     VertexMapType map_function,
+                                     FinalizerType finalize_function) {
+      BOOST_CONCEPT_ASSERT((graphlab::Serializable<ReductionType>));
+      BOOST_CONCEPT_ASSERT((graphlab::OpPlusEq<ReductionType>));
+      aggregator_type* aggregator = get_aggregator();
+      if(aggregator == NULL) {
+        logstream(LOG_FATAL) << "Aggregation not supported by this engine!"
+                             << std::endl;
+        return false; // does not return
+      }
+      return aggregator->template add_vertex_delta_aggregator<ReductionType>
+          (key, map_function, finalize_function);
+    } // end of add vertex delta aggregator
+
+    /**
+     * \brief Creates an incremental edge aggregator. Returns true on
+     *        success. Returns false if an aggregator of the same name
+     *        already exists.
+     *
+     * The edge counterpart of add_vertex_delta_aggregator(). A delta
+     * must be pushed by exactly one of the machines which hold the edge,
+     * for instance from scatter().
+     *
+     * \tparam ReductionType The output of the map function and the type of
+     *                       the deltas. Must have operator+= defined, and
+     *                       must be \ref sec_serializable.
+     *
+     * \param [in] key The name of this aggregator. Must be unique.
+     * \param [in] map_function The Map function to use, as in
+     *                          add_edge_aggregator().
+     * \param [in] finalize_function The Finalize function to use, as in
+     *                               add_edge_aggregator().
+     */
+    template <typename ReductionType,
+              typename EdgeMapType,
+              typename FinalizerType>
+    bool add_edge_delta_aggregator(const std::string& key,
+                                   EdgeMapType map_function,
+                                   FinalizerType finalize_function) {
+      BOOST_CONCEPT_ASSERT((graphlab::Serializable<ReductionType>));
+      BOOST_CONCEPT_ASSERT((graphlab::OpPlusEq<ReductionType>));
+      aggregator_type* aggregator = get_aggregator();
+      if(aggregator == NULL) {
+        logstream(LOG_FATAL) << "Aggregation not supported by this engine!"
+                             << std::endl;
+        return false; // does not return
+      }
+      return aggregator->template add_edge_delta_aggregator<ReductionType>
+          (key, map_function, finalize_function);
+    } // end of add edge delta aggregator
+
     /**
      * \brief Performs an immediate aggregation on a key
      *
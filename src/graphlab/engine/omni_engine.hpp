@@ -31,6 +31,7 @@
 #include <graphlab/engine/iengine.hpp>
 #include <graphlab/engine/synchronous_engine.hpp>
 #include <graphlab/engine/async_consistent_engine.hpp>
+#include <graphlab/engine/ssp_engine.hpp>
 
 namespace graphlab {
 
@@ -71,6 +72,8 @@ namespace graphlab {
    *  (\ref synchronous_engine)
    *  \li "asynchronous" or "async": uses the asynchronous engine
    *  (\ref async_consistent_engine)
+   *  \li "ssp": uses the bounded staleness engine
+   *  (\ref ssp_engine)
 *
    * \see graphlab::synchronous_engine
    * \see graphlab::async_consistent_engine
@@ -136,6 +139,11 @@ namespace graphlab {
      */
     typedef async_consistent_engine<VertexProgram> async_consistent_engine_type;
 
+    /**
+     * \brief the type of bounded staleness engine
+     */
+    typedef ssp_engine<VertexProgram> ssp_engine_type;
+
 
 
   private:
@@ -193,6 +201,9 @@ namespace graphlab {
       } else if(engine_type == "async" || engine_type == "asynchronous") {
         logstream(LOG_INFO) << "Using the Asynchronous engine." << std::endl;
         engine_ptr = new async_consistent_engine_type(dc, graph, new_options);
+      } else if(engine_type == "ssp") {
+        logstream(LOG_INFO) << "Using the SSP engine." << std::endl;
+        engine_ptr = new ssp_engine_type(dc, graph, new_options);
       } else {
         logstream(LOG_FATAL) << "Invalid engine type: " << engine_type << std::endl;
       }
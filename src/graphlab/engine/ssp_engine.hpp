@@ -0,0 +1,1364 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_SSP_ENGINE_HPP
+#define GRAPHLAB_SSP_ENGINE_HPP
+
+#include <deque>
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include <graphlab/engine/iengine.hpp>
+
+#include <graphlab/vertex_program/ivertex_program.hpp>
+#include <graphlab/vertex_program/icontext.hpp>
+#include <graphlab/vertex_program/context.hpp>
+
+#include <graphlab/engine/execution_status.hpp>
+#include <graphlab/options/graphlab_options.hpp>
+
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/fiber_group.hpp>
+#include <graphlab/parallel/fiber_control.hpp>
+#include <graphlab/util/memory_info.hpp>
+
+#include <graphlab/rpc/dc_dist_object.hpp>
+#include <graphlab/rpc/async_consensus.hpp>
+#include <graphlab/rpc/distributed_event_log.hpp>
+
+#include <graphlab/macros_def.hpp>
+
+namespace graphlab {
+
+
+  /**
+   * \ingroup engines
+   *
+   * \brief The SSP engine executes vertex programs in a sequence of
+   * super-steps like the \ref graphlab::synchronous_engine, but lets
+   * each machine run up to \c staleness super-steps ahead of the
+   * slowest machine (Stale Synchronous Parallel execution).
+   *
+   * ### Execution Semantics
+   *
+   * Each machine keeps its own clock (the number of super-steps it
+   * has completed) and never waits on a global barrier.  Before
+   * starting super-step \c t a machine only waits until every other
+   * machine has completed at least <code>t - staleness</code>
+   * super-steps.  All data exchanged between machines is tagged with
+   * the clock of the sender and delivered asynchronously in batches,
+   * one batch per destination and worker thread per super-step:
+   *
+   * \li Messages sent to mirrors are forwarded to the master which
+   * becomes active in its next super-step.
+   * \li Active masters run \ref graphlab::ivertex_program::init and
+   * the gather over their local edges immediately. The vertex program
+   * is sent to the mirrors which compute their partial gather in their
+   * next super-step and return it to the master.
+   * \li The apply on the master waits until every mirror has returned
+   * its partial gather for this activation, so the gather is exact
+   * for the activation. A master waiting for its mirrors keeps any new
+   * messages until its apply has run.
+   * \li The new vertex data (and vertex program if the vertex
+   * scatters) is sent to the mirrors, which scatter on their local
+   * edges when they receive it.
+   *
+   * As a consequence, only vertex data read on mirrors may be stale:
+   * the data read on a mirror at super-step \c t reflects the master
+   * at super-step <code>t - staleness</code> or later.  With
+   * <code>staleness = 0</code> machines advance in lock step.  The
+   * engine is therefore intended for algorithms which tolerate stale
+   * reads such as SGD and ALS.
+   *
+   * A machine which finds nothing to do in a super-step stops
+   * advancing its clock and waits in a graphlab::async_consensus,
+   * which also counts the batches in flight.  The other machines do
+   * not wait for an idle machine since its vertex data cannot change,
+   * and an idle machine which receives a batch resumes at the clock
+   * of the fastest machine.  The
+   * engine terminates by task depletion once every machine is idle
+   * and no batch is in flight.
+
+   * <a name=engineopts>Engine Options</a>
+   * =====================
+   * \li <b>max_iterations</b>: (default: infinity) The maximum number
+   * of super-steps each machine runs.
+   *
+   * \li <b>timeout</b>: (default: infinity) The maximum time in
+   * seconds that the engine may run.
+   *
+   * \li <b>staleness</b>: (default: 2) The number of super-steps a
+   * machine may run ahead of the slowest machine.
+   *
+   * At the end of \ref start the engine reports, per machine, the
+   * maximum and average clock lag behind the fastest reachable bound
+   * and the time spent stalled waiting for slower machines.
+   *
+   * \see graphlab::synchronous_engine
+   * \see graphlab::omni_engine
+   */
+  template<typename VertexProgram>
+  class ssp_engine :
+    public iengine<VertexProgram> {
+
+  public:
+    /// \brief The user defined vertex program type.
+    typedef VertexProgram vertex_program_type;
+
+    /// \brief The user defined type returned by the gather function.
+    typedef typename VertexProgram::gather_type gather_type;
+
+    /// \brief The user defined message type.
+    typedef typename VertexProgram::message_type message_type;
+
+    /// \brief The type of data associated with each vertex in the graph
+    typedef typename VertexProgram::vertex_data_type vertex_data_type;
+
+    /// \brief The type of data associated with each edge in the graph
+    typedef typename VertexProgram::edge_data_type edge_data_type;
+
+    /// \brief The type of graph supported by this vertex program
+    typedef typename VertexProgram::graph_type  graph_type;
+
+    /// \brief The type used to represent a vertex in the graph.
+    typedef typename graph_type::vertex_type          vertex_type;
+
+    /// \brief The type used to represent an edge in the graph.
+    typedef typename graph_type::edge_type            edge_type;
+
+    /// \brief The type of the callback interface passed to vertex programs.
+    typedef icontext<graph_type, gather_type, message_type> icontext_type;
+
+  private:
+
+    /// \brief Local vertex type used by the engine for fast indexing
+    typedef typename graph_type::local_vertex_type    local_vertex_type;
+
+    /// \brief Local edge type used by the engine for fast indexing
+    typedef typename graph_type::local_edge_type      local_edge_type;
+
+    /// \brief Local vertex id type used by the engine for fast indexing
+    typedef typename graph_type::lvid_type            lvid_type;
+
+    /// \brief The actual instance of the context type used by this engine.
+    typedef context<ssp_engine> context_type;
+    friend class context<ssp_engine>;
+
+    /// \brief The type of the distributed aggregator inherited from iengine
+    typedef typename iengine<vertex_program_type>::aggregator_type aggregator_type;
+
+    /// \brief The pair type used to forward messages to masters
+    typedef std::pair<vertex_id_type, message_type> vid_message_pair_type;
+
+    /// \brief The pair type used to send vertex programs to mirrors
+    typedef std::pair<vertex_id_type, vertex_program_type> vid_prog_pair_type;
+
+    /**
+     * \brief The partial gather of one mirror returned to the master.
+     * Every mirror answers a gather program, with has_value cleared if
+     * it had no edges to gather on.
+     */
+    struct gather_record {
+      vertex_id_type vid;
+      bool has_value;
+      gather_type value;
+      gather_record() : vid(-1), has_value(false) { }
+      void save(oarchive& oarc) const {
+        oarc << vid << has_value;
+        if (has_value) oarc << value;
+      }
+      void load(iarchive& iarc) {
+        iarc >> vid >> has_value;
+        if (has_value) iarc >> value;
+      }
+    }; // end of gather_record
+
+    /**
+     * \brief The vertex data of a master after apply, together with
+     * the vertex program if the mirrors have to scatter.
+     */
+    struct vdata_record {
+      vertex_id_type vid;
+      vertex_data_type vdata;
+      bool has_vprog;
+      vertex_program_type vprog;
+      vdata_record() : vid(-1), has_vprog(false) { }
+      void save(oarchive& oarc) const {
+        oarc << vid << vdata << has_vprog;
+        if (has_vprog) oarc << vprog;
+      }
+      void load(iarchive& iarc) {
+        iarc >> vid >> vdata >> has_vprog;
+        if (has_vprog) iarc >> vprog;
+      }
+    }; // end of vdata_record
+
+    /**
+     * \brief Everything one worker thread sends to one machine in
+     * one super-step.
+     */
+    struct ssp_batch {
+      procid_t src;
+      size_t iteration;
+      std::vector<vid_message_pair_type> messages;
+      std::vector<vid_prog_pair_type> gather_programs;
+      std::vector<gather_record> partial_gathers;
+      std::vector<vdata_record> vertex_data;
+      ssp_batch() : src(0), iteration(0) { }
+      bool empty() const {
+        return messages.empty() && gather_programs.empty() &&
+               partial_gathers.empty() && vertex_data.empty();
+      }
+      void clear() {
+        messages.clear(); gather_programs.clear();
+        partial_gathers.clear(); vertex_data.clear();
+      }
+      void swap(ssp_batch& other) {
+        std::swap(src, other.src);
+        std::swap(iteration, other.iteration);
+        messages.swap(other.messages);
+        gather_programs.swap(other.gather_programs);
+        partial_gathers.swap(other.partial_gathers);
+        vertex_data.swap(other.vertex_data);
+      }
+      void save(oarchive& oarc) const {
+        oarc << src << iteration << messages << gather_programs
+             << partial_gathers << vertex_data;
+      }
+      void load(iarchive& iarc) {
+        iarc >> src >> iteration >> messages >> gather_programs
+             >> partial_gathers >> vertex_data;
+      }
+    }; // end of ssp_batch
+
+    /// \brief Orders batches by sender and then by super-step
+    static bool batch_less(const ssp_batch* a, const ssp_batch* b) {
+      return a->src < b->src ||
+          (a->src == b->src && a->iteration < b->iteration);
+    }
+
+    /**
+     * \brief The clock of a remote machine. A clock only becomes
+     * effective once all num_batches batches sent before it have
+     * arrived. Machines which are idle or done are not waited for.
+     */
+    struct clock_record : public IS_POD_TYPE {
+      size_t clock;
+      size_t num_batches;
+      bool idle;
+      bool done;
+      clock_record() : clock(0), num_batches(0),
+                       idle(false), done(false) { }
+    };
+
+    dc_dist_object< ssp_engine<VertexProgram> > rmi;
+
+    graph_type& graph;
+
+    size_t ncpus;
+
+    fiber_group threads;
+
+    size_t max_iterations;
+
+    /// \brief The number of super-steps a machine may run ahead
+    size_t staleness;
+
+    /// \brief The number of super-steps completed on this machine
+    size_t iteration_counter;
+
+    float start_time;
+
+    float timeout;
+
+    bool force_abort;
+
+    std::vector<simple_spinlock> vlocks;
+
+    std::vector<vertex_program_type> vertex_programs;
+
+    std::vector<message_type> messages;
+
+    dense_bitset has_message;
+
+    /// \brief The local contribution to the gather of each master
+    std::vector<gather_type> gather_accum;
+
+    dense_bitset has_gather_accum;
+
+    /// \brief The number of mirrors yet to return their partial gather
+    std::vector<procid_t> pending_partials;
+
+    /// \brief Masters waiting for the partial gathers of their mirrors
+    dense_bitset awaiting_gather;
+
+    /// \brief Masters which apply in the current super-step
+    dense_bitset active_superstep;
+
+    /// \brief Vertices (masters and mirrors) which gather this super-step
+    dense_bitset gather_minorstep;
+
+    /// \brief Masters which scatter this super-step
+    dense_bitset scatter_minorstep;
+
+    atomic<size_t> num_active_vertices;
+
+    atomic<size_t> completed_applys;
+
+    atomic<size_t> shared_lvid_counter;
+
+    /// \brief Outgoing batches indexed by worker slot and destination
+    std::vector<std::vector<ssp_batch> > outbound;
+    std::vector<simple_spinlock> outbound_locks;
+
+    /// \brief Protects the inbox and the clock tables
+    mutex clock_lock;
+    conditional clock_cond;
+
+    /// \brief Batches received but not yet processed
+    std::vector<ssp_batch*> inbox;
+
+    /// \brief Batches being processed in the current super-step
+    std::vector<ssp_batch*> draining;
+
+    /// \brief [begin, end) ranges into draining, one per sender
+    std::vector<std::pair<size_t, size_t> > drain_ranges;
+
+    /// \brief Mirror scatters received in the current super-step
+    std::vector<std::vector<std::pair<lvid_type, vertex_program_type> > >
+      mirror_scatters;
+
+    std::vector<size_t> sent_batches;
+    std::vector<size_t> recv_batches;
+
+    std::vector<std::deque<clock_record> > pending_clocks;
+    std::vector<clock_record> effective_clocks;
+
+    /// \brief Detects that all machines are idle with no batch in flight
+    async_consensus consensus;
+
+    /// \brief Lag statistics reported at the end of start()
+    size_t max_lag;
+    size_t total_lag;
+    size_t last_lag;
+    double stall_time;
+    std::vector<size_t> all_max_lag;
+
+    std::string aggregator_key;
+
+    aggregator_type aggregator;
+
+    DECLARE_EVENT(EVENT_APPLIES);
+    DECLARE_EVENT(EVENT_GATHERS);
+    DECLARE_EVENT(EVENT_SCATTERS);
+    DECLARE_EVENT(EVENT_STALLS);
+    DECLARE_EVENT(EVENT_CLOCK_LAG);
+
+  public:
+
+    /**
+     * \brief Construct an SSP engine for a given graph and options.
+     * Must be called on all machines at the same time.
+     */
+    ssp_engine(distributed_control& dc, graph_type& graph,
+               const graphlab_options& opts = graphlab_options());
+
+    ~ssp_engine() {
+      for (size_t i = 0; i < inbox.size(); ++i) delete inbox[i];
+    }
+
+    // documentation inherited from iengine
+    execution_status::status_enum start();
+
+    // documentation inherited from iengine
+    size_t num_updates() const { return completed_applys.value; }
+
+    // documentation inherited from iengine
+    void signal(vertex_id_type vid,
+                const message_type& message = message_type());
+
+    // documentation inherited from iengine
+    void signal_all(const message_type& message = message_type(),
+                    const std::string& order = "shuffle");
+
+    void signal_vset(const vertex_set& vset,
+                    const message_type& message = message_type(),
+                    const std::string& order = "shuffle");
+
+    // documentation inherited from iengine
+    float elapsed_seconds() const {
+      return timer::approx_time_seconds() - start_time;
+    }
+
+    /**
+     * \brief Get the number of super-steps completed by this machine.
+     */
+    int iteration() const { return iteration_counter; }
+
+    /**
+     * \brief Get the maximum clock lag of each machine in the last
+     * call to \ref start. No entry exceeds \c staleness.
+     */
+    const std::vector<size_t>& max_clock_lags() const { return all_max_lag; }
+
+    aggregator_type* get_aggregator() { return &aggregator; }
+
+    /**
+     * \brief Initialize the engine and allocate datastructures.
+     */
+    void init();
+
+  private:
+
+    void resize();
+
+    void internal_stop();
+
+    void rpc_stop();
+
+    void internal_signal(const vertex_type& vertex,
+                         const message_type& message = message_type());
+
+    void internal_signal_gvid(vertex_id_type gvid,
+                              const message_type& message = message_type());
+
+    void internal_signal_rpc(vertex_id_type gvid,
+                             const message_type& message = message_type());
+
+    /// Gather caching is not supported by this engine.
+    void internal_post_delta(const vertex_type& vertex,
+                             const gather_type& delta) { }
+
+    /// Gather caching is not supported by this engine.
+    void internal_clear_gather_cache(const vertex_type& vertex) { }
+
+    /**
+     * \brief Executes ncpus copies of a member function each with a
+     * unique consecutive id. Unlike the synchronous engine no
+     * distributed barrier is run afterwards.
+     */
+    template<typename MemberFunction>
+    void run_parallel(MemberFunction member_fun) {
+      shared_lvid_counter = 0;
+      for(size_t i = 0; i < ncpus; ++i) {
+        fiber_control::affinity_type affinity;
+        affinity.clear(); affinity.set_bit(i);
+        threads.launch(boost::bind(member_fun, this, i), affinity);
+      }
+      threads.join();
+    } // end of run_parallel
+
+    /**
+     * \brief Runs one super-step on this machine.
+     * \return true if any work was done.
+     */
+    bool run_iteration();
+
+    // Program Steps ==========================================================
+    void receive_batches(size_t thread_id);
+    void execute_mirror_scatters(size_t thread_id);
+    void receive_messages(size_t thread_id);
+    void execute_gathers(size_t thread_id);
+    void execute_applys(size_t thread_id);
+    void execute_scatters(size_t thread_id);
+    void run_aggregator(size_t thread_id);
+
+    /// \brief Scatters on the local edges of lvid using vprog
+    void scatter_local_edges(context_type& context,
+                             const vertex_program_type& vprog,
+                             lvid_type lvid);
+
+    // Data Synchronization ===================================================
+    /// \brief Returns the outbound batch for proc owned by the caller
+    ssp_batch& outbound_batch(procid_t proc, size_t& slot);
+
+    void send_message(lvid_type lvid);
+    void send_gather_program(lvid_type lvid);
+    void send_partial_gather(lvid_type lvid, const gather_type& accum,
+                             bool has_value);
+    void send_vertex_data(lvid_type lvid, bool send_vprog);
+
+    /// \brief Sends all outbound batches. Returns the number sent.
+    size_t send_batches();
+
+    void rpc_recv_batch(ssp_batch& batch);
+
+    void rpc_clock(procid_t src, const clock_record& rec);
+
+    /// \brief Promotes pending clocks whose batches have all arrived.
+    /// clock_lock must be held.
+    void promote_clocks(procid_t src);
+
+    void publish_clock(bool idle, bool done);
+
+    /// \brief Blocks until the slowest machine is within staleness
+    void wait_for_clock();
+
+    /**
+     * \brief Called when a super-step did no work. Waits until either a
+     * batch arrives, in which case false is returned, or all machines
+     * agree that the computation is done.
+     */
+    bool wait_for_work();
+
+  }; // end of class ssp_engine
+
+
+
+
+  template<typename VertexProgram>
+  ssp_engine<VertexProgram>::
+  ssp_engine(distributed_control &dc,
+             graph_type& graph,
+             const graphlab_options& opts) :
+    rmi(dc, this), graph(graph),
+    ncpus(opts.get_ncpus()),
+    threads(2*1024*1024 /* 2MB stack per fiber*/),
+    max_iterations(-1), staleness(2), iteration_counter(0),
+    start_time(0), timeout(0), force_abort(false),
+    consensus(dc, 1, &rmi),
+    max_lag(0), total_lag(0), last_lag(0), stall_time(0),
+    aggregator(dc, graph, new context_type(*this, graph)) {
+    std::vector<std::string> keys = opts.get_engine_args().get_option_keys();
+    foreach(std::string opt, keys) {
+      if (opt == "max_iterations") {
+        opts.get_engine_args().get_option("max_iterations", max_iterations);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: max_iterations = "
+            << max_iterations << std::endl;
+      } else if (opt == "timeout") {
+        opts.get_engine_args().get_option("timeout", timeout);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: timeout = "
+            << timeout << std::endl;
+      } else if (opt == "staleness") {
+        opts.get_engine_args().get_option("staleness", staleness);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: staleness = "
+            << staleness << std::endl;
+      } else {
+        logstream(LOG_FATAL) << "Unexpected Engine Option: " << opt << std::endl;
+      }
+    }
+    const size_t nslots =
+        std::max(ncpus, fiber_control::get_instance().num_workers());
+    outbound.resize(nslots);
+    for (size_t i = 0; i < nslots; ++i) outbound[i].resize(rmi.numprocs());
+    outbound_locks.resize(nslots);
+    mirror_scatters.resize(ncpus);
+    sent_batches.resize(rmi.numprocs(), 0);
+    recv_batches.resize(rmi.numprocs(), 0);
+    pending_clocks.resize(rmi.numprocs());
+    effective_clocks.resize(rmi.numprocs());
+    all_max_lag.resize(rmi.numprocs(), 0);
+
+    INITIALIZE_EVENT_LOG(dc);
+    ADD_CUMULATIVE_EVENT(EVENT_APPLIES, "Applies", "Calls");
+    ADD_CUMULATIVE_EVENT(EVENT_GATHERS , "Gathers", "Calls");
+    ADD_CUMULATIVE_EVENT(EVENT_SCATTERS , "Scatters", "Calls");
+    ADD_CUMULATIVE_EVENT(EVENT_STALLS, "SSP Stalls", "Iterations");
+    ADD_INSTANTANEOUS_EVENT(EVENT_CLOCK_LAG, "SSP Clock Lag", "Iterations");
+    graph.finalize();
+    init();
+  } // end of ssp engine
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::init() {
+    resize();
+    force_abort = false;
+    iteration_counter = 0;
+    completed_applys = 0;
+    has_message.clear();
+    has_gather_accum.clear();
+    awaiting_gather.clear();
+    active_superstep.clear();
+    gather_minorstep.clear();
+    scatter_minorstep.clear();
+  }
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::resize() {
+    memory_info::log_usage("Before Engine Initialization");
+    vlocks.resize(graph.num_local_vertices());
+    vertex_programs.resize(graph.num_local_vertices());
+    messages.resize(graph.num_local_vertices(), message_type());
+    has_message.resize(graph.num_local_vertices());
+    gather_accum.resize(graph.num_local_vertices(), gather_type());
+    has_gather_accum.resize(graph.num_local_vertices());
+    pending_partials.resize(graph.num_local_vertices(), 0);
+    awaiting_gather.resize(graph.num_local_vertices());
+    active_superstep.resize(graph.num_local_vertices());
+    gather_minorstep.resize(graph.num_local_vertices());
+    scatter_minorstep.resize(graph.num_local_vertices());
+    memory_info::log_usage("After Engine Initialization");
+  }
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::internal_stop() {
+    for (size_t i = 0; i < rmi.numprocs(); ++i)
+      rmi.remote_call(i, &ssp_engine<VertexProgram>::rpc_stop);
+  } // end of internal_stop
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::rpc_stop() {
+    clock_lock.lock();
+    force_abort = true;
+    clock_cond.broadcast();
+    clock_lock.unlock();
+    consensus.cancel();
+  } // end of rpc_stop
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  signal(vertex_id_type gvid, const message_type& message) {
+    if (vlocks.size() != graph.num_local_vertices())
+      resize();
+    rmi.barrier();
+    internal_signal_rpc(gvid, message);
+    rmi.barrier();
+  } // end of signal
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  signal_all(const message_type& message, const std::string& order) {
+    if (vlocks.size() != graph.num_local_vertices())
+      resize();
+    for(lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+      if(graph.l_is_master(lvid)) {
+        internal_signal(vertex_type(graph.l_vertex(lvid)), message);
+      }
+    }
+  } // end of signal all
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  signal_vset(const vertex_set& vset,
+              const message_type& message, const std::string& order) {
+    if (vlocks.size() != graph.num_local_vertices())
+      resize();
+    for(lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+      if(graph.l_is_master(lvid) && vset.l_contains(lvid)) {
+        internal_signal(vertex_type(graph.l_vertex(lvid)), message);
+      }
+    }
+  } // end of signal_vset
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  internal_signal(const vertex_type& vertex,
+                  const message_type& message) {
+    const lvid_type lvid = vertex.local_id();
+    vlocks[lvid].lock();
+    if( has_message.get(lvid) ) {
+      messages[lvid] += message;
+    } else {
+      messages[lvid] = message;
+      has_message.set_bit(lvid);
+    }
+    vlocks[lvid].unlock();
+  } // end of internal_signal
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  internal_signal_gvid(vertex_id_type gvid, const message_type& message) {
+    const procid_t proc = graph.master(gvid);
+    if(proc == rmi.procid()) {
+      internal_signal_rpc(gvid, message);
+    } else {
+      // route through the batches so that termination detection sees it
+      size_t slot;
+      ssp_batch& batch = outbound_batch(proc, slot);
+      batch.messages.push_back(std::make_pair(gvid, message));
+      outbound_locks[slot].unlock();
+    }
+  } // end of internal_signal_gvid
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  internal_signal_rpc(vertex_id_type gvid,
+                      const message_type& message) {
+    if (graph.is_master(gvid)) {
+      internal_signal(graph.vertex(gvid), message);
+    }
+  } // end of internal_signal_rpc
+
+
+
+  template<typename VertexProgram> execution_status::status_enum
+  ssp_engine<VertexProgram>::start() {
+    if (vlocks.size() != graph.num_local_vertices())
+      resize();
+    completed_applys = 0;
+    iteration_counter = 0;
+    force_abort = false;
+    // Reset the clocks before any machine may send a batch
+    max_lag = 0; total_lag = 0; stall_time = 0;
+    for (procid_t i = 0; i < rmi.numprocs(); ++i) {
+      sent_batches[i] = 0; recv_batches[i] = 0;
+      pending_clocks[i].clear();
+      effective_clocks[i] = clock_record();
+    }
+    consensus.reset();
+    rmi.barrier();
+
+    graphlab::timer timer; timer.start();
+    start_time = timer::approx_time_seconds();
+    execution_status::status_enum termination_reason =
+      execution_status::UNSET;
+    aggregator.start(ncpus);
+    aggregator.aggregate_all_periodic();
+    rmi.barrier();
+
+    float last_print = -5;
+    while(iteration_counter < max_iterations) {
+      wait_for_clock();
+      if (force_abort) break;
+      if(timeout != 0 && timeout < elapsed_seconds()) {
+        termination_reason = execution_status::TIMEOUT;
+        break;
+      }
+      if(rmi.procid() == 0 && (elapsed_seconds() - last_print) >= 5) {
+        logstream(LOG_EMPH)
+          << rmi.procid() << ": Starting iteration: " << iteration_counter
+          << std::endl;
+        last_print = elapsed_seconds();
+      }
+
+      const bool idle = !run_iteration();
+      ++iteration_counter;
+      publish_clock(idle, false);
+
+      // asynchronous aggregation on this machine's schedule
+      aggregator_key = aggregator.tick_asynchronous();
+      if (aggregator_key != "") run_parallel(&ssp_engine::run_aggregator);
+
+      if (idle && wait_for_work()) {
+        termination_reason = execution_status::TASK_DEPLETION;
+        break;
+      }
+    }
+    // let the other machines stop waiting for this one
+    publish_clock(true, true);
+    if (termination_reason != execution_status::TASK_DEPLETION) {
+      // Join the idle machines until the batches in flight have arrived
+      do {
+        consensus.begin_done_critical_section(0);
+      } while (!consensus.end_done_critical_section(0));
+    }
+    // Activations still waiting for their mirrors are dropped
+    if (awaiting_gather.popcount() > 0) {
+      logstream(LOG_WARNING)
+        << awaiting_gather.popcount() << " vertices stopped before "
+        << "their mirrors returned the gather." << std::endl;
+      for (lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+        if (!awaiting_gather.get(lvid)) continue;
+        gather_accum[lvid] = gather_type();
+        pending_partials[lvid] = 0;
+        vertex_programs[lvid] = vertex_program_type();
+      }
+      has_gather_accum.clear();
+      awaiting_gather.clear();
+    }
+
+    if (rmi.procid() == 0) {
+      logstream(LOG_EMPH) << iteration_counter
+                          << " iterations completed." << std::endl;
+    }
+    std::vector<double> all_avg_lag(rmi.numprocs());
+    std::vector<double> all_stall_time(rmi.numprocs());
+    all_max_lag[rmi.procid()] = max_lag;
+    all_avg_lag[rmi.procid()] =
+        iteration_counter > 0 ? double(total_lag) / iteration_counter : 0;
+    all_stall_time[rmi.procid()] = stall_time;
+    rmi.all_gather(all_max_lag);
+    rmi.all_gather(all_avg_lag);
+    rmi.all_gather(all_stall_time);
+
+    size_t global_completed = completed_applys;
+    rmi.all_reduce(global_completed);
+    completed_applys = global_completed;
+    rmi.cout() << "Updates: " << completed_applys.value << "\n";
+    if (rmi.procid() == 0) {
+      logstream(LOG_INFO) << "SSP Lag (max/avg/stall seconds): ";
+      for (size_t i = 0;i < all_max_lag.size(); ++i) {
+        logstream(LOG_INFO) << all_max_lag[i] << "/" << all_avg_lag[i]
+                            << "/" << all_stall_time[i] << " ";
+      }
+      logstream(LOG_INFO) << std::endl;
+    }
+    rmi.full_barrier();
+    // Drop anything that arrived after this machine stopped
+    for (size_t i = 0; i < inbox.size(); ++i) delete inbox[i];
+    inbox.clear();
+    aggregator.stop();
+    return termination_reason;
+  } // end of start
+
+
+
+  template<typename VertexProgram>
+  bool ssp_engine<VertexProgram>::run_iteration() {
+    size_t work = 0;
+    active_superstep.clear();
+    scatter_minorstep.clear();
+
+    // Receive Batches ------------------------------------------------------
+    clock_lock.lock();
+    draining.swap(inbox);
+    clock_lock.unlock();
+    if (!draining.empty()) {
+      work += draining.size();
+      // Batches from one sender only touch mirrors of that sender, so
+      // senders can be processed in parallel, each in clock order.
+      std::sort(draining.begin(), draining.end(), batch_less);
+      drain_ranges.clear();
+      size_t begin = 0;
+      for (size_t i = 1; i <= draining.size(); ++i) {
+        if (i == draining.size() || draining[i]->src != draining[begin]->src) {
+          drain_ranges.push_back(std::make_pair(begin, i));
+          begin = i;
+        }
+      }
+      run_parallel(&ssp_engine::receive_batches);
+      run_parallel(&ssp_engine::execute_mirror_scatters);
+      for (size_t i = 0; i < draining.size(); ++i) delete draining[i];
+      draining.clear();
+    }
+
+    // Receive Messages -----------------------------------------------------
+    num_active_vertices = 0;
+    run_parallel(&ssp_engine::receive_messages);
+    work += num_active_vertices.value;
+
+    // Gather, Apply, Scatter -----------------------------------------------
+    run_parallel(&ssp_engine::execute_gathers);
+    run_parallel(&ssp_engine::execute_applys);
+    gather_minorstep.clear();
+    run_parallel(&ssp_engine::execute_scatters);
+
+    work += send_batches();
+    return work > 0;
+  } // end of run_iteration
+
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  receive_batches(const size_t thread_id) {
+    while (1) {
+      const size_t r = shared_lvid_counter.inc_ret_last(1);
+      if (r >= drain_ranges.size()) break;
+      for (size_t b = drain_ranges[r].first; b < drain_ranges[r].second; ++b) {
+        const ssp_batch& batch = *draining[b];
+        foreach(const vdata_record& rec, batch.vertex_data) {
+          const lvid_type lvid = graph.local_vid(rec.vid);
+          ASSERT_FALSE(graph.l_is_master(lvid));
+          graph.l_vertex(lvid).data() = rec.vdata;
+          if (rec.has_vprog) {
+            mirror_scatters[thread_id].push_back(
+                std::make_pair(lvid, rec.vprog));
+          }
+        }
+        foreach(const vid_prog_pair_type& pair, batch.gather_programs) {
+          const lvid_type lvid = graph.local_vid(pair.first);
+          vertex_programs[lvid] = pair.second;
+          gather_minorstep.set_bit(lvid);
+        }
+        foreach(const gather_record& rec, batch.partial_gathers) {
+          const lvid_type lvid = graph.local_vid(rec.vid);
+          ASSERT_TRUE(graph.l_is_master(lvid));
+          ASSERT_TRUE(awaiting_gather.get(lvid));
+          vlocks[lvid].lock();
+          if (rec.has_value) {
+            if (has_gather_accum.get(lvid)) {
+              gather_accum[lvid] += rec.value;
+            } else {
+              gather_accum[lvid] = rec.value;
+              has_gather_accum.set_bit(lvid);
+            }
+          }
+          ASSERT_GT(pending_partials[lvid], 0);
+          if (--pending_partials[lvid] == 0) {
+            // the last mirror has answered: apply in this super-step
+            awaiting_gather.clear_bit(lvid);
+            active_superstep.set_bit(lvid);
+          }
+          vlocks[lvid].unlock();
+        }
+        foreach(const vid_message_pair_type& pair, batch.messages) {
+          internal_signal_rpc(pair.first, pair.second);
+        }
+      }
+    }
+  } // end of receive_batches
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  execute_mirror_scatters(const size_t thread_id) {
+    context_type context(*this, graph);
+    for (size_t i = 0; i < mirror_scatters[thread_id].size(); ++i) {
+      scatter_local_edges(context, mirror_scatters[thread_id][i].second,
+                          mirror_scatters[thread_id][i].first);
+    }
+    mirror_scatters[thread_id].clear();
+  } // end of execute_mirror_scatters
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  receive_messages(const size_t thread_id) {
+    context_type context(*this, graph);
+    size_t nactive_inc = 0;
+    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
+    while (1) {
+      lvid_type lvid_block_start =
+                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
+      if (lvid_block_start >= graph.num_local_vertices()) break;
+      size_t lvid_bit_block = has_message.containing_word(lvid_block_start);
+      if (lvid_bit_block == 0) continue;
+      local_bitset.clear();
+      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
+      foreach(size_t lvid_block_offset, local_bitset) {
+        lvid_type lvid = lvid_block_start + lvid_block_offset;
+        if (lvid >= graph.num_local_vertices()) break;
+        // keep the message until the previous activation has applied
+        if (awaiting_gather.get(lvid) || active_superstep.get(lvid)) {
+          continue;
+        }
+        has_message.clear_bit(lvid);
+        if(!graph.l_is_master(lvid)) {
+          // forward the message to the master
+          send_message(lvid);
+          messages[lvid] = message_type();
+          continue;
+        }
+        ++nactive_inc;
+        local_vertex_type local_vertex = graph.l_vertex(lvid);
+        vertex_type vertex = vertex_type(local_vertex);
+        vertex_programs[lvid].init(context, vertex, messages[lvid]);
+        messages[lvid] = message_type();
+        const vertex_program_type& const_vprog = vertex_programs[lvid];
+        const vertex_type const_vertex = vertex;
+        if(const_vprog.gather_edges(context, const_vertex) !=
+            graphlab::NO_EDGES) {
+          gather_minorstep.set_bit(lvid);
+          if (local_vertex.num_mirrors() > 0) {
+            pending_partials[lvid] = local_vertex.num_mirrors();
+            awaiting_gather.set_bit(lvid);
+            send_gather_program(lvid);
+            continue;
+          }
+        }
+        active_superstep.set_bit(lvid);
+      }
+    }
+    num_active_vertices += nactive_inc;
+  } // end of receive_messages
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  execute_gathers(const size_t thread_id) {
+    context_type context(*this, graph);
+    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
+    while (1) {
+      lvid_type lvid_block_start =
+                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
+      if (lvid_block_start >= graph.num_local_vertices()) break;
+      size_t lvid_bit_block = gather_minorstep.containing_word(lvid_block_start);
+      if (lvid_bit_block == 0) continue;
+      local_bitset.clear();
+      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
+      foreach(size_t lvid_block_offset, local_bitset) {
+        lvid_type lvid = lvid_block_start + lvid_block_offset;
+        if (lvid >= graph.num_local_vertices()) break;
+        bool accum_is_set = false;
+        gather_type accum = gather_type();
+        const vertex_program_type& vprog = vertex_programs[lvid];
+        local_vertex_type local_vertex = graph.l_vertex(lvid);
+        const vertex_type vertex(local_vertex);
+        const edge_dir_type gather_dir = vprog.gather_edges(context, vertex);
+        size_t edges_touched = 0;
+        vprog.pre_local_gather(accum);
+        if(gather_dir == IN_EDGES || gather_dir == ALL_EDGES) {
+          foreach(local_edge_type local_edge, local_vertex.in_edges()) {
+            edge_type edge(local_edge);
+            if(accum_is_set) {
+              accum += vprog.gather(context, vertex, edge);
+            } else {
+              accum = vprog.gather(context, vertex, edge);
+              accum_is_set = true;
+            }
+            ++edges_touched;
+          }
+        }
+        if(gather_dir == OUT_EDGES || gather_dir == ALL_EDGES) {
+          foreach(local_edge_type local_edge, local_vertex.out_edges()) {
+            edge_type edge(local_edge);
+            if(accum_is_set) {
+              accum += vprog.gather(context, vertex, edge);
+            } else {
+              accum = vprog.gather(context, vertex, edge);
+              accum_is_set = true;
+            }
+            ++edges_touched;
+          }
+        }
+        INCREMENT_EVENT(EVENT_GATHERS, edges_touched);
+        vprog.post_local_gather(accum);
+        if(graph.l_is_master(lvid)) {
+          if (accum_is_set) {
+            gather_accum[lvid] = accum;
+            has_gather_accum.set_bit(lvid);
+          }
+        } else {
+          // answer even without edges so that the master can count
+          send_partial_gather(lvid, accum, accum_is_set);
+          vertex_programs[lvid] = vertex_program_type();
+        }
+      }
+    }
+  } // end of execute_gathers
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  execute_applys(const size_t thread_id) {
+    context_type context(*this, graph);
+    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
+    while (1) {
+      lvid_type lvid_block_start =
+                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
+      if (lvid_block_start >= graph.num_local_vertices()) break;
+      size_t lvid_bit_block = active_superstep.containing_word(lvid_block_start);
+      if (lvid_bit_block == 0) continue;
+      local_bitset.clear();
+      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
+      foreach(size_t lvid_block_offset, local_bitset) {
+        lvid_type lvid = lvid_block_start + lvid_block_offset;
+        if (lvid >= graph.num_local_vertices()) break;
+        ASSERT_TRUE(graph.l_is_master(lvid));
+        vertex_type vertex(graph.l_vertex(lvid));
+        // The local gather combined with the partials of all mirrors
+        gather_type accum = gather_type();
+        if (has_gather_accum.get(lvid)) {
+          accum = gather_accum[lvid];
+          gather_accum[lvid] = gather_type();
+          has_gather_accum.clear_bit(lvid);
+        }
+        INCREMENT_EVENT(EVENT_APPLIES, 1);
+        vertex_programs[lvid].apply(context, vertex, accum);
+        ++completed_applys;
+        const vertex_program_type& const_vprog = vertex_programs[lvid];
+        const vertex_type const_vertex = vertex;
+        const bool scatter_needed =
+            const_vprog.scatter_edges(context, const_vertex) !=
+            graphlab::NO_EDGES;
+        send_vertex_data(lvid, scatter_needed);
+        if (scatter_needed) scatter_minorstep.set_bit(lvid);
+        else vertex_programs[lvid] = vertex_program_type();
+      }
+    }
+  } // end of execute_applys
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  execute_scatters(const size_t thread_id) {
+    context_type context(*this, graph);
+    fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
+    while (1) {
+      lvid_type lvid_block_start =
+                  shared_lvid_counter.inc_ret_last(8 * sizeof(size_t));
+      if (lvid_block_start >= graph.num_local_vertices()) break;
+      size_t lvid_bit_block = scatter_minorstep.containing_word(lvid_block_start);
+      if (lvid_bit_block == 0) continue;
+      local_bitset.clear();
+      local_bitset.initialize_from_mem(&lvid_bit_block, sizeof(size_t));
+      foreach(size_t lvid_block_offset, local_bitset) {
+        lvid_type lvid = lvid_block_start + lvid_block_offset;
+        if (lvid >= graph.num_local_vertices()) break;
+        scatter_local_edges(context, vertex_programs[lvid], lvid);
+        vertex_programs[lvid] = vertex_program_type();
+      }
+    }
+  } // end of execute_scatters
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  scatter_local_edges(context_type& context,
+                      const vertex_program_type& vprog,
+                      lvid_type lvid) {
+    local_vertex_type local_vertex = graph.l_vertex(lvid);
+    const vertex_type vertex(local_vertex);
+    const edge_dir_type scatter_dir = vprog.scatter_edges(context, vertex);
+    size_t edges_touched = 0;
+    if(scatter_dir == IN_EDGES || scatter_dir == ALL_EDGES) {
+      foreach(local_edge_type local_edge, local_vertex.in_edges()) {
+        edge_type edge(local_edge);
+        vprog.scatter(context, vertex, edge);
+        ++edges_touched;
+      }
+    }
+    if(scatter_dir == OUT_EDGES || scatter_dir == ALL_EDGES) {
+      foreach(local_edge_type local_edge, local_vertex.out_edges()) {
+        edge_type edge(local_edge);
+        vprog.scatter(context, vertex, edge);
+        ++edges_touched;
+      }
+    }
+    INCREMENT_EVENT(EVENT_SCATTERS, edges_touched);
+  } // end of scatter_local_edges
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  run_aggregator(const size_t thread_id) {
+    aggregator.tick_asynchronous_compute(thread_id, aggregator_key);
+  } // end of run_aggregator
+
+
+
+  // Data Synchronization ===================================================
+  template<typename VertexProgram>
+  typename ssp_engine<VertexProgram>::ssp_batch&
+  ssp_engine<VertexProgram>::outbound_batch(procid_t proc, size_t& slot) {
+    slot = fiber_control::get_worker_id();
+    if (slot >= outbound.size()) slot = 0;
+    outbound_locks[slot].lock();
+    return outbound[slot][proc];
+  } // end of outbound_batch
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::send_message(lvid_type lvid) {
+    size_t slot;
+    ssp_batch& batch = outbound_batch(graph.l_master(lvid), slot);
+    batch.messages.push_back(std::make_pair(graph.global_vid(lvid),
+                                            messages[lvid]));
+    outbound_locks[slot].unlock();
+  } // end of send_message
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::send_gather_program(lvid_type lvid) {
+    local_vertex_type vertex = graph.l_vertex(lvid);
+    const vertex_id_type vid = graph.global_vid(lvid);
+    foreach(const procid_t& mirror, vertex.mirrors()) {
+      size_t slot;
+      ssp_batch& batch = outbound_batch(mirror, slot);
+      batch.gather_programs.push_back(std::make_pair(vid,
+                                                     vertex_programs[lvid]));
+      outbound_locks[slot].unlock();
+    }
+  } // end of send_gather_program
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  send_partial_gather(lvid_type lvid, const gather_type& accum,
+                      bool has_value) {
+    gather_record rec;
+    rec.vid = graph.global_vid(lvid);
+    rec.has_value = has_value;
+    if (has_value) rec.value = accum;
+    size_t slot;
+    ssp_batch& batch = outbound_batch(graph.l_master(lvid), slot);
+    batch.partial_gathers.push_back(rec);
+    outbound_locks[slot].unlock();
+  } // end of send_partial_gather
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  send_vertex_data(lvid_type lvid, bool send_vprog) {
+    local_vertex_type vertex = graph.l_vertex(lvid);
+    if (vertex.num_mirrors() == 0) return;
+    vdata_record rec;
+    rec.vid = graph.global_vid(lvid);
+    rec.vdata = vertex.data();
+    rec.has_vprog = send_vprog;
+    if (send_vprog) rec.vprog = vertex_programs[lvid];
+    foreach(const procid_t& mirror, vertex.mirrors()) {
+      size_t slot;
+      ssp_batch& batch = outbound_batch(mirror, slot);
+      batch.vertex_data.push_back(rec);
+      outbound_locks[slot].unlock();
+    }
+  } // end of send_vertex_data
+
+
+  template<typename VertexProgram>
+  size_t ssp_engine<VertexProgram>::send_batches() {
+    size_t nsent = 0;
+    for (size_t slot = 0; slot < outbound.size(); ++slot) {
+      outbound_locks[slot].lock();
+      for (procid_t proc = 0; proc < rmi.numprocs(); ++proc) {
+        ssp_batch& batch = outbound[slot][proc];
+        if (batch.empty()) continue;
+        ASSERT_NE(proc, rmi.procid());
+        batch.src = rmi.procid();
+        batch.iteration = iteration_counter;
+        rmi.remote_call(proc, &ssp_engine::rpc_recv_batch, batch);
+        batch.clear();
+        ++sent_batches[proc];
+        ++nsent;
+      }
+      outbound_locks[slot].unlock();
+    }
+    return nsent;
+  } // end of send_batches
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::rpc_recv_batch(ssp_batch& batch) {
+    ssp_batch* b = new ssp_batch();
+    b->swap(batch);
+    clock_lock.lock();
+    inbox.push_back(b);
+    ++recv_batches[b->src];
+    promote_clocks(b->src);
+    clock_lock.unlock();
+    // wake up this machine if it is idle
+    consensus.cancel();
+  } // end of rpc_recv_batch
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::
+  rpc_clock(procid_t src, const clock_record& rec) {
+    clock_lock.lock();
+    pending_clocks[src].push_back(rec);
+    promote_clocks(src);
+    clock_lock.unlock();
+  } // end of rpc_clock
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::promote_clocks(procid_t src) {
+    bool changed = false;
+    std::deque<clock_record>& pending = pending_clocks[src];
+    while (!pending.empty() &&
+           pending.front().num_batches <= recv_batches[src]) {
+      effective_clocks[src] = pending.front();
+      pending.pop_front();
+      changed = true;
+    }
+    if (changed) clock_cond.broadcast();
+  } // end of promote_clocks
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::publish_clock(bool idle, bool done) {
+    clock_record rec;
+    rec.clock = iteration_counter;
+    rec.idle = idle;
+    rec.done = done;
+    for (procid_t proc = 0; proc < rmi.numprocs(); ++proc) {
+      if (proc == rmi.procid()) continue;
+      rec.num_batches = sent_batches[proc];
+      rmi.remote_call(proc, &ssp_engine::rpc_clock, rmi.procid(), rec);
+    }
+    rmi.dc().flush();
+  } // end of publish_clock
+
+
+  template<typename VertexProgram>
+  void ssp_engine<VertexProgram>::wait_for_clock() {
+    timer ti;
+    bool stalled = false;
+    size_t min_clock = iteration_counter;
+    clock_lock.lock();
+    while (!force_abort) {
+      min_clock = iteration_counter;
+      for (procid_t proc = 0; proc < rmi.numprocs(); ++proc) {
+        const clock_record& rec = effective_clocks[proc];
+        // an idle machine only resumes at the clock of the fastest
+        if (proc == rmi.procid() || rec.done || rec.idle) continue;
+        min_clock = std::min(min_clock, effective_clocks[proc].clock);
+      }
+      if (min_clock + staleness >= iteration_counter) break;
+      stalled = true;
+      clock_cond.wait(clock_lock);
+    }
+    clock_lock.unlock();
+    const size_t lag = iteration_counter - min_clock;
+    if (stalled) {
+      stall_time += ti.current_time();
+      INCREMENT_EVENT(EVENT_STALLS, 1);
+    }
+    // the instantaneous event tracks the lag of the current super-step
+    if (lag > last_lag) INCREMENT_EVENT(EVENT_CLOCK_LAG, lag - last_lag);
+    if (lag < last_lag) DECREMENT_EVENT(EVENT_CLOCK_LAG, last_lag - lag);
+    last_lag = lag;
+    max_lag = std::max(max_lag, lag);
+    total_lag += lag;
+  } // end of wait_for_clock
+
+
+  template<typename VertexProgram>
+  bool ssp_engine<VertexProgram>::wait_for_work() {
+    consensus.begin_done_critical_section(0);
+    clock_lock.lock();
+    const bool has_work = !inbox.empty() || force_abort;
+    clock_lock.unlock();
+    if (has_work) {
+      consensus.cancel_critical_section(0);
+    } else if (consensus.end_done_critical_section(0)) {
+      return true;
+    }
+    // The other machines did not wait for this one since it published
+    // an idle clock. Resume at the clock of the fastest machine: this
+    // machine did nothing in between, so its state is the same as if
+    // it had kept running idle super-steps.
+    clock_lock.lock();
+    for (procid_t proc = 0; proc < rmi.numprocs(); ++proc) {
+      const clock_record& rec = effective_clocks[proc];
+      if (proc == rmi.procid() || rec.done) continue;
+      iteration_counter = std::max(iteration_counter, rec.clock);
+    }
+    for (size_t i = 0; i < inbox.size(); ++i) {
+      iteration_counter = std::max(iteration_counter, inbox[i]->iteration);
+    }
+    clock_lock.unlock();
+    return false;
+  } // end of wait_for_work
+
+}; // namespace
+
+
+#include <graphlab/macros_undef.hpp>
+
+#endif
@@ -27,6 +27,7 @@
 
 #include <deque>
 #include <boost/bind.hpp>
+#include <boost/type_traits/is_same.hpp>
 
 #include <graphlab/engine/iengine.hpp>
 
@@ -44,6 +45,7 @@
 #include <graphlab/parallel/fiber_barrier.hpp>
 #include <graphlab/util/tracepoint.hpp>
 #include <graphlab/util/memory_info.hpp>
+#include <graphlab/util/empty.hpp>
 
 #include <graphlab/rpc/dc_dist_object.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
@@ -199,6 +201,36 @@ namespace graphlab {
    * for the snapshot. The path including folder and file prefix in
    * which the snapshots should be saved.
    *
+   * \li \b fused_sync (default: false, true if the gather type is
+   * \ref graphlab::empty) If set to true, the vertex data
+   * and the vertex program of a master are broadcast to its mirrors
+   * as a single record after apply, and the apply minor-step flushes
+   * one exchange instead of two.  This removes a full barrier and a
+   * round of small messages per iteration and is useful for algorithms
+   * which run many short iterations (e.g. kcore, label propagation).
+   *
+   * \li \b overlap_aggregation (default: false) If set to true, the
+   * local map of a periodic aggregator runs in the background during
+   * the message exchange and gather phases of the next iteration,
+   * which do not modify vertex data, and its result is combined and
+   * finalized at the end of that iteration. Aggregation then no longer
+   * stalls the compute threads, but the finalizer observes the graph as
+   * it was one iteration earlier. Vertex programs which modify edge data
+   * in gather must not use this option.
+   *
+   * Independently of the options, the gather minor-step (and its
+   * barriers) is skipped entirely in any super-step in which no
+   * vertex on any machine requests a gather.  Together with the
+   * fused synchronization this makes message-only programs, whose
+   * \ref graphlab::ivertex_program::gather_edges returns
+   * \ref graphlab::NO_EDGES, run as a two-exchange Pregel-style loop:
+   * combined messages to masters, then one broadcast after apply.
+   *
+   * A gather is also kept local to the master when the master already
+   * holds every edge in the gather direction (e.g. the low-degree
+   * vertices of the "hybrid" ingress): the vertex program is then not
+   * sent to the mirrors and they do not take part in the gather.
+   *
    * \see graphlab::omni_engine
    * \see graphlab::async_consistent_engine
    * \see graphlab::semi_synchronous_engine
@@ -383,6 +415,18 @@ namespace graphlab {
     /// \brief The target base name the snapshot is saved in.
     std::string snapshot_path;
 
+    /**
+     * \brief If set, the vertex data and the scatter vertex program
+     * are sent to the mirrors in a single exchange after apply.
+     */
+    bool fused_sync;
+
+    /**
+     * \brief If set, periodic aggregators are mapped in the background
+     * while the next iteration exchanges messages and gathers.
+     */
+    bool overlap_aggregation;
+
     /**
      * \brief A counter that tracks the current iteration number since
      * start was last invoked.
@@ -497,6 +541,26 @@ namespace graphlab {
      */
     atomic<size_t> num_active_vertices;
 
+    /**
+     * \brief  The number of local vertices (masters) that are active on this
+     * iteration and run a gather.
+     */
+    atomic<size_t> num_gather_vertices;
+
+    /**
+     * \brief The per super-step counts reduced across all machines in a
+     * single all_reduce.
+     */
+    struct superstep_counts : public IS_POD_TYPE {
+      size_t active_vertices;
+      size_t gather_vertices;
+      superstep_counts& operator+=(const superstep_counts& other) {
+        active_vertices += other.active_vertices;
+        gather_vertices += other.gather_vertices;
+        return *this;
+      }
+    };
+
     /**
      * \brief A bit indicating (for all vertices) whether to
      * participate in the current minor-step (gather or scatter).
@@ -580,6 +644,39 @@ namespace graphlab {
      */
     message_exchange_type message_exchange;
 
+    /**
+     * \brief The record used to synchronize the vertex data together
+     * with the (optional) vertex program of a master vertex when
+     * fused_sync is enabled.
+     */
+    struct vid_vdata_vprog_type {
+      vertex_id_type vid;
+      vertex_data_type vdata;
+      bool has_vprog;
+      vertex_program_type vprog;
+      vid_vdata_vprog_type() : vid(-1), has_vprog(false) { }
+      void save(oarchive& oarc) const {
+        oarc << vid << vdata << has_vprog;
+        if (has_vprog) oarc << vprog;
+      }
+      void load(iarchive& iarc) {
+        iarc >> vid >> vdata >> has_vprog;
+        if (has_vprog) iarc >> vprog;
+      }
+    }; // end of vid_vdata_vprog_type
+
+    /**
+     * \brief The type of the exchange used to synchronize vertex data
+     * and vertex programs in a single pass
+     */
+    typedef fiber_buffered_exchange<vid_vdata_vprog_type> vdata_vprog_exchange_type;
+
+    /**
+     * \brief The distributed exchange used to synchronize vertex data
+     * and vertex programs after apply when fused_sync is enabled.
+     */
+    vdata_vprog_exchange_type vdata_vprog_exchange;
+
 
     /**
      * \brief The distributed aggregator used to manage background
@@ -886,6 +983,14 @@ namespace graphlab {
      */
     void sync_vertex_program(lvid_type lvid, size_t thread_id);
 
+    /**
+     * \brief Returns true if the master of the local vertex holds all
+     * of the edges in the given direction, in which case the gather
+     * can run on the master alone.
+     */
+    bool is_local_gather(const local_vertex_type& vertex,
+                         edge_dir_type gather_dir) const;
+
     /**
      * \brief Receive all incoming vertex programs and update the
      * local mirrors.
@@ -915,6 +1020,28 @@ namespace graphlab {
      */
     void recv_vertex_data();
 
+    /**
+     * \brief Send the vertex data for the local vertex id, together
+     * with the vertex program if it is scattering, to all of its
+     * mirrors as a single record.
+     *
+     * @param [in] lvid the vertex to sync.  This machine must be the master
+     * of that vertex.
+     * @param [in] send_vprog true if the vertex program should be sent
+     * and the mirrors activated for the scatter minor-step.
+     */
+    void sync_vertex_data_and_program(lvid_type lvid, bool send_vprog,
+                                      size_t thread_id);
+
+    /**
+     * \brief Receive all incoming vertex data and vertex programs sent
+     * by \ref sync_vertex_data_and_program and update the local mirrors.
+     *
+     * This function returns when there is nothing left in the
+     * exchange and should be called after a flush of the exchange.
+     */
+    void recv_vertex_data_and_programs();
+
     /**
      * \brief Send the gather value for the vertex id to its master.
      *
@@ -1006,12 +1133,15 @@ namespace graphlab {
     ncpus(opts.get_ncpus()),
     threads(2*1024*1024 /* 2MB stack per fiber*/),
     thread_barrier(opts.get_ncpus()),
-    max_iterations(-1), snapshot_interval(-1), iteration_counter(0),
-    timeout(0), sched_allv(false),
+    max_iterations(-1), snapshot_interval(-1),
+    fused_sync(boost::is_same<gather_type, graphlab::empty>::value),
+    overlap_aggregation(false),
+    iteration_counter(0), timeout(0), sched_allv(false),
     vprog_exchange(dc),
     vdata_exchange(dc),
     gather_exchange(dc),
     message_exchange(dc),
+    vdata_vprog_exchange(dc),
     aggregator(dc, graph, new context_type(*this, graph)) {
     // Process any additional options
     std::vector<std::string> keys = opts.get_engine_args().get_option_keys();
@@ -1048,6 +1178,17 @@ namespace graphlab {
         if (rmi.procid() == 0)
           logstream(LOG_EMPH) << "Engine Option: sched_allv = "
             << sched_allv << std::endl;
+      } else if (opt == "fused_sync") {
+        opts.get_engine_args().get_option("fused_sync", fused_sync);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: fused_sync = "
+            << fused_sync << std::endl;
+      } else if (opt == "overlap_aggregation") {
+        opts.get_engine_args().get_option("overlap_aggregation",
+                                          overlap_aggregation);
+        if (rmi.procid() == 0)
+          logstream(LOG_EMPH) << "Engine Option: overlap_aggregation = "
+            << overlap_aggregation << std::endl;
       } else {
         logstream(LOG_FATAL) << "Unexpected Engine Option: " << opt << std::endl;
       }
@@ -1321,7 +1462,10 @@ namespace graphlab {
       // be set upon receiving messages
       active_superstep.clear(); active_minorstep.clear();
       has_gather_accum.clear();
-      rmi.barrier();
+      // No barrier is needed: the bits cleared above are only set when
+      // a machine receives from an exchange in its own minor-steps, and
+      // the previous minor-step (or the barrier before the loop)
+      // already synchronized all machines.
 
       // Exchange Messages --------------------------------------------------
       // Exchange any messages in the local message vectors
@@ -1339,6 +1483,7 @@ namespace graphlab {
 
       // if (rmi.procid() == 0) std::cout << "Receive messages..." << std::endl;
       num_active_vertices = 0;
+      num_gather_vertices = 0;
       run_synchronous( &synchronous_engine::receive_messages );
       if (sched_allv) {
         active_minorstep.fill();
@@ -1357,8 +1502,11 @@ namespace graphlab {
        */
 
       // Check termination condition  ---------------------------------------
-      size_t total_active_vertices = num_active_vertices;
-      rmi.all_reduce(total_active_vertices);
+      superstep_counts counts;
+      counts.active_vertices = num_active_vertices;
+      counts.gather_vertices = sched_allv ? 1 : num_gather_vertices.value;
+      rmi.all_reduce(counts);
+      const size_t total_active_vertices = counts.active_vertices;
       if (rmi.procid() == 0 && print_this_round)
         logstream(LOG_EMPH)
           << "\tActive vertices: " << total_active_vertices << std::endl;
@@ -1372,7 +1520,10 @@ namespace graphlab {
       // Execute the gather operation for all vertices that are active
       // in this minor-step (active-minorstep bit set).
       // if (rmi.procid() == 0) std::cout << "Gathering..." << std::endl;
-      run_synchronous( &synchronous_engine::execute_gathers );
+      // Skip the minor-step (and its barriers) if nobody gathers.
+      if (counts.gather_vertices > 0) {
+        run_synchronous( &synchronous_engine::execute_gathers );
+      }
       // Clear the minor step bit since only super-step vertices
       // (only master vertices are required to participate in the
       // apply step)
@@ -1386,6 +1537,9 @@ namespace graphlab {
        */
 
       // Execute Apply Operations -------------------------------------------
+      // Apply modifies vertex data, so any background aggregation
+      // started at the end of the previous iteration must be done.
+      if (overlap_aggregation) aggregator.wait_overlapped();
       // Run the apply function on all active vertices
       // if (rmi.procid() == 0) std::cout << "Applying..." << std::endl;
       run_synchronous( &synchronous_engine::execute_applys );
@@ -1411,7 +1565,8 @@ namespace graphlab {
       if(rmi.procid() == 0 && print_this_round)
         logstream(LOG_EMPH) << "\t Running Aggregators" << std::endl;
       // probe the aggregator
-      aggregator.tick_synchronous();
+      if (overlap_aggregation) aggregator.tick_synchronous_overlapped();
+      else aggregator.tick_synchronous();
 
       ++iteration_counter;
 
@@ -1424,6 +1579,8 @@ namespace graphlab {
       logstream(LOG_EMPH) << iteration_counter
                         << " iterations completed." << std::endl;
     }
+    // Deliver the aggregations still running in the background
+    if (overlap_aggregation) aggregator.finish_overlapped();
     // Final barrier to ensure that all engines terminate at the same time
     double total_compute_time = 0;
     for (size_t i = 0;i < per_thread_compute_time.size(); ++i) {
@@ -1502,6 +1659,7 @@ namespace graphlab {
     const size_t TRY_RECV_MOD = 100;
     size_t vcount = 0;
     size_t nactive_inc = 0;
+    size_t ngather_inc = 0;
     fixed_dense_bitset<8 * sizeof(size_t)> local_bitset; // a word-size = 64 bit
 
     while (1) {
@@ -1534,10 +1692,14 @@ namespace graphlab {
           // Determine if the gather should be run
           const vertex_program_type& const_vprog = vertex_programs[lvid];
           const vertex_type const_vertex = vertex;
-          if(const_vprog.gather_edges(context, const_vertex) !=
-              graphlab::NO_EDGES) {
+          const edge_dir_type gather_dir =
+            const_vprog.gather_edges(context, const_vertex);
+          if(gather_dir != graphlab::NO_EDGES) {
             active_minorstep.set_bit(lvid);
-            sync_vertex_program(lvid, thread_id);
+            ++ngather_inc;
+            // mirrors without edges to gather do not need the program
+            if(!is_local_gather(graph.l_vertex(lvid), gather_dir))
+              sync_vertex_program(lvid, thread_id);
           }
         }
         if(++vcount % TRY_RECV_MOD == 0) recv_vertex_programs();
@@ -1545,6 +1707,7 @@ namespace graphlab {
     }
 
     num_active_vertices += nactive_inc;
+    num_gather_vertices += ngather_inc;
     vprog_exchange.partial_flush();
     // Flush the buffer and finish receiving any remaining vertex
     // programs.
@@ -1699,27 +1862,46 @@ namespace graphlab {
         ++completed_applys;
         // Clear the accumulator to save some memory
         gather_accum[lvid] = gather_type();
-        // synchronize the changed vertex data with all mirrors
-        sync_vertex_data(lvid, thread_id);
         // determine if a scatter operation is needed
         const vertex_program_type& const_vprog = vertex_programs[lvid];
         const vertex_type const_vertex = vertex;
-        if(const_vprog.scatter_edges(context, const_vertex) !=
-           graphlab::NO_EDGES) {
-          active_minorstep.set_bit(lvid);
-          sync_vertex_program(lvid, thread_id);
-        } else { // we are done so clear the vertex program
-          vertex_programs[lvid] = vertex_program_type();
+        const bool scatter_needed =
+            const_vprog.scatter_edges(context, const_vertex) !=
+            graphlab::NO_EDGES;
+        if(scatter_needed) active_minorstep.set_bit(lvid);
+        if(fused_sync) {
+          // synchronize the vertex data and the vertex program with
+          // all mirrors in one record
+          sync_vertex_data_and_program(lvid, scatter_needed, thread_id);
+        } else {
+          // synchronize the changed vertex data with all mirrors
+          sync_vertex_data(lvid, thread_id);
+          if(scatter_needed) sync_vertex_program(lvid, thread_id);
         }
+        // if we are done clear the vertex program
+        if(!scatter_needed) vertex_programs[lvid] = vertex_program_type();
       // try to receive vertex data
         if(++vcount % TRY_RECV_MOD == 0) {
-          recv_vertex_programs();
-          recv_vertex_data();
+          if(fused_sync) {
+            recv_vertex_data_and_programs();
+          } else {
+            recv_vertex_programs();
+            recv_vertex_data();
+          }
         }
       }
     } // end of loop over vertices to run apply
 
     per_thread_compute_time[thread_id] += ti.current_time();
+    if(fused_sync) {
+      vdata_vprog_exchange.partial_flush();
+      // Finish sending and receiving all changes due to apply operations
+      thread_barrier.wait();
+      if(thread_id == 0) vdata_vprog_exchange.flush();
+      thread_barrier.wait();
+      recv_vertex_data_and_programs();
+      return;
+    }
     vprog_exchange.partial_flush();
     vdata_exchange.partial_flush();
       // Finish sending and receiving all changes due to apply operations
@@ -1806,6 +1988,19 @@ namespace graphlab {
   } // end of sync_vertex_program
 
 
+  template<typename VertexProgram>
+  bool synchronous_engine<VertexProgram>::
+  is_local_gather(const local_vertex_type& vertex,
+                  const edge_dir_type gather_dir) const {
+    if(vertex.num_mirrors() == 0) return true;
+    if((gather_dir == IN_EDGES || gather_dir == ALL_EDGES) &&
+       vertex.num_in_edges() != vertex.global_num_in_edges()) return false;
+    if((gather_dir == OUT_EDGES || gather_dir == ALL_EDGES) &&
+       vertex.num_out_edges() != vertex.global_num_out_edges()) return false;
+    return true;
+  } // end of is_local_gather
+
+
 
   template<typename VertexProgram>
   void synchronous_engine<VertexProgram>::
@@ -1857,6 +2052,46 @@ namespace graphlab {
   } // end of recv vertex data
 
 
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  sync_vertex_data_and_program(lvid_type lvid, bool send_vprog,
+                               const size_t thread_id) {
+    ASSERT_TRUE(graph.l_is_master(lvid));
+    local_vertex_type vertex = graph.l_vertex(lvid);
+    if (vertex.num_mirrors() == 0) return;
+    vid_vdata_vprog_type record;
+    record.vid = graph.global_vid(lvid);
+    record.vdata = vertex.data();
+    record.has_vprog = send_vprog;
+    if (send_vprog) record.vprog = vertex_programs[lvid];
+    foreach(const procid_t& mirror, vertex.mirrors()) {
+      vdata_vprog_exchange.send(mirror, record);
+    }
+  } // end of sync_vertex_data_and_program
+
+
+  template<typename VertexProgram>
+  void synchronous_engine<VertexProgram>::
+  recv_vertex_data_and_programs() {
+    typename vdata_vprog_exchange_type::recv_buffer_type recv_buffer;
+    while(vdata_vprog_exchange.recv(recv_buffer)) {
+      for (size_t i = 0;i < recv_buffer.size(); ++i) {
+        typename vdata_vprog_exchange_type::buffer_type& buffer =
+            recv_buffer[i].buffer;
+        foreach(const vid_vdata_vprog_type& rec, buffer) {
+          const lvid_type lvid = graph.local_vid(rec.vid);
+          ASSERT_FALSE(graph.l_is_master(lvid));
+          graph.l_vertex(lvid).data() = rec.vdata;
+          if (rec.has_vprog) {
+            vertex_programs[lvid] = rec.vprog;
+            active_minorstep.set_bit(lvid);
+          }
+        }
+      }
+    }
+  } // end of recv_vertex_data_and_programs
+
+
   template<typename VertexProgram>
   void synchronous_engine<VertexProgram>::
   sync_gather(lvid_type lvid, const gather_type& accum, const size_t thread_id) {
@@ -170,7 +170,10 @@ namespace warp {
    * calls are guaranteed to be locally consistent. Can produce massive
    * increases in throughput at a consistency penalty.
    * \li \b nfibers (default: 10000) Number of fibers to use
-   * \li \b stacksize (default: 16384) Stacksize of each fiber.
+   * \li \b stacksize (default: 16384) Stacksize of each fiber. Stacks are
+   * rounded up to a power of two number of pages. Run with
+   * GRAPHLAB_FIBER_STACK_USAGE=1 to log the stack high-water mark after
+   * each run.
    */
   template <typename GraphType, typename MessageType = graphlab::empty>
   class warp_engine {
@@ -1320,6 +1323,7 @@ namespace warp {
         thrgroup.launch(boost::bind(&engine_type::thread_start, this, i));
       }
       thrgroup.join();
+      fiber_control::get_instance().log_stack_usage();
       aggregator.stop();
       // if termination reason was not changed, then it must be depletion
       if (termination_reason == execution_status::RUNNING) {
@@ -37,6 +37,7 @@
 #endif
 
 #include <graphlab/util/stl_util.hpp>
+#include <graphlab/util/empty.hpp>
 #include <graphlab/logger/logger.hpp>
 #include <graphlab/serialization/serialization_includes.hpp>
 
@@ -190,6 +191,22 @@ namespace graphlab {
     };
 
 
+    /**
+     * \internal
+     * Writer for distributed_graph::save_columnar() which stores only
+     * the vertex ids and the edges.
+     */
+    template <typename Graph>
+    struct columnar_structure_writer{
+      typedef typename Graph::vertex_type vertex_type;
+      typedef typename Graph::edge_type edge_type;
+      typedef graphlab::empty vertex_value_type;
+      typedef graphlab::empty edge_value_type;
+      graphlab::empty vertex_value(vertex_type) { return graphlab::empty(); }
+      graphlab::empty edge_value(edge_type) { return graphlab::empty(); }
+    };
+
+
 
     
     template <typename Graph>
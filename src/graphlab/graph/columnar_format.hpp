@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_GRAPH_COLUMNAR_FORMAT_HPP
+#define GRAPHLAB_GRAPH_COLUMNAR_FORMAT_HPP
+
+#include <stdint.h>
+#include <cstring>
+#include <exception>
+#include <vector>
+#include <iostream>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/static_assert.hpp>
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/logger/assertions.hpp>
+#include <graphlab/serialization/is_pod.hpp>
+#include <graphlab/util/empty.hpp>
+
+namespace graphlab {
+
+  /**
+   * \brief The binary column oriented graph output format written by
+   * distributed_graph::save_columnar().
+   *
+   * A file holds either vertices or edges. It starts with a
+   * file_header followed by a sequence of blocks. Each block begins
+   * with a block_header and is followed by its columns, one after the
+   * other:
+   * \li vertex files: the vertex ids, then the values
+   * \li edge files: the source ids, the target ids, then the values
+   *
+   * Ids are file_header::id_width bytes wide, values
+   * file_header::value_width bytes wide. If the file is compressed, the
+   * columns of each block are compressed together with zlib. A block
+   * with no rows ends the file. All integers are stored in the byte
+   * order of the writing machine.
+   */
+  namespace columnar {
+
+    /// Magic string at the start of every file
+    static const char MAGIC[8] = {'G', 'L', 'C', 'O', 'L', 'U', 'M', 'N'};
+    static const uint32_t VERSION = 1;
+    /// Default number of rows in a block
+    static const size_t DEFAULT_BLOCK_ROWS = 64 * 1024;
+
+    enum file_kind { VERTEX_FILE = 0, EDGE_FILE = 1 };
+
+    enum file_flags { COMPRESSED = 1 };
+
+    /// The type of the values in a file
+    enum value_code {
+      NO_VALUE = 0,
+      INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64,
+      FLOAT, DOUBLE,
+      /// A POD type without further description, value_width bytes wide
+      BYTES
+    };
+
+    /**
+     * Maps a value type to its value_code. Types other than the builtin
+     * arithmetic types are stored as BYTES and must be POD.
+     */
+    template <typename T>
+    struct value_traits {
+      BOOST_STATIC_ASSERT(gl_is_pod_or_scaler<T>::value);
+      static const uint32_t code = BYTES;
+      static const uint32_t width = sizeof(T);
+    };
+
+#define GRAPHLAB_COLUMNAR_VALUE_TRAITS(type, value_code)  \
+    template <> struct value_traits<type> {               \
+      static const uint32_t code = value_code;            \
+      static const uint32_t width = sizeof(type);         \
+    };
+
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(int8_t, INT8)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(uint8_t, UINT8)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(int16_t, INT16)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(uint16_t, UINT16)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(int32_t, INT32)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(uint32_t, UINT32)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(int64_t, INT64)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(uint64_t, UINT64)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(float, FLOAT)
+    GRAPHLAB_COLUMNAR_VALUE_TRAITS(double, DOUBLE)
+#undef GRAPHLAB_COLUMNAR_VALUE_TRAITS
+
+    /// graphlab::empty values are not stored at all
+    template <>
+    struct value_traits<graphlab::empty> {
+      static const uint32_t code = NO_VALUE;
+      static const uint32_t width = 0;
+    };
+
+    /// Returns the name of a value_code
+    inline const char* value_code_name(uint32_t code) {
+      static const char* names[] = {"none", "int8", "uint8", "int16",
+                                    "uint16", "int32", "uint32", "int64",
+                                    "uint64", "float", "double", "bytes"};
+      return code <= BYTES ? names[code] : "unknown";
+    }
+
+    struct file_header {
+      char magic[8];
+      uint32_t version;
+      /// A file_kind
+      uint32_t kind;
+      uint32_t id_width;
+      /// A value_code
+      uint32_t value_code;
+      uint32_t value_width;
+      /// A combination of file_flags
+      uint32_t flags;
+    };
+
+    struct block_header {
+      /// Number of rows in the block. 0 ends the file.
+      uint32_t nrows;
+      /// Number of bytes of the (possibly compressed) columns
+      uint32_t nbytes;
+    };
+
+
+    /**
+     * Writes one columnar file to a stream. Rows are buffered into
+     * columns and written out a block at a time. Not thread safe; the
+     * graph uses one writer per file and thread.
+     *
+     * \tparam ValueType The type of the value of each row.
+     */
+    template <typename ValueType>
+    class block_writer {
+    public:
+      typedef value_traits<ValueType> traits;
+
+      block_writer(std::ostream& out, file_kind kind, bool compress,
+                   size_t block_rows = DEFAULT_BLOCK_ROWS)
+        : out(out), kind(kind), compress(compress),
+          block_rows(block_rows), nrows(0) {
+        ASSERT_GT(block_rows, 0);
+        file_header header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.kind = kind;
+        header.id_width = sizeof(vertex_id_type);
+        header.value_code = traits::code;
+        header.value_width = traits::width;
+        header.flags = compress ? COMPRESSED : 0;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ids.reserve(block_rows);
+        if (kind == EDGE_FILE) targets.reserve(block_rows);
+        values.reserve(block_rows * traits::width);
+      }
+
+      /// Adds a row to a vertex file
+      void add(vertex_id_type vid, const ValueType& value) {
+        DASSERT_EQ(kind, VERTEX_FILE);
+        ids.push_back(vid);
+        add_value(value);
+      }
+
+      /// Adds a row to an edge file
+      void add(vertex_id_type source, vertex_id_type target,
+               const ValueType& value) {
+        DASSERT_EQ(kind, EDGE_FILE);
+        ids.push_back(source);
+        targets.push_back(target);
+        add_value(value);
+      }
+
+      /// Writes out the buffered rows as a block
+      void flush() {
+        if (nrows == 0) return;
+        raw.clear();
+        append(raw, ids);
+        if (kind == EDGE_FILE) append(raw, targets);
+        raw.insert(raw.end(), values.begin(), values.end());
+        const std::vector<char>* payload = &raw;
+        if (compress) {
+          packed.clear();
+          boost::iostreams::filtering_ostream zout;
+          zout.push(boost::iostreams::zlib_compressor());
+          zout.push(boost::iostreams::back_inserter(packed));
+          zout.write(&raw[0], raw.size());
+          zout.reset();
+          payload = &packed;
+        }
+        block_header header;
+        header.nrows = nrows;
+        header.nbytes = payload->size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(&(*payload)[0], payload->size());
+        ids.clear(); targets.clear(); values.clear();
+        nrows = 0;
+      }
+
+      /// Writes out the remaining rows and the end of file marker
+      void close() {
+        flush();
+        block_header header;
+        header.nrows = 0;
+        header.nbytes = 0;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.flush();
+      }
+
+    private:
+      std::ostream& out;
+      file_kind kind;
+      bool compress;
+      size_t block_rows;
+      uint32_t nrows;
+      std::vector<vertex_id_type> ids;
+      std::vector<vertex_id_type> targets;
+      std::vector<char> values;
+      std::vector<char> raw;
+      std::vector<char> packed;
+
+      void add_value(const ValueType& value) {
+        if (traits::width > 0) {
+          const char* c = reinterpret_cast<const char*>(&value);
+          values.insert(values.end(), c, c + traits::width);
+        }
+        if (++nrows == block_rows) flush();
+      }
+
+      static void append(std::vector<char>& buf,
+                         const std::vector<vertex_id_type>& column) {
+        if (column.empty()) return;
+        const char* c = reinterpret_cast<const char*>(&column[0]);
+        buf.insert(buf.end(), c, c + column.size() * sizeof(vertex_id_type));
+      }
+    }; // end of block_writer
+
+
+    /**
+     * Reads a columnar file a block at a time. The columns of the
+     * current block are exposed as raw arrays.
+     *
+     * \code
+     * columnar::block_reader reader(fin);
+     * while(reader.next_block()) {
+     *   for (size_t i = 0; i < reader.num_rows(); ++i) {
+     *     use(reader.id(i), reader.value<double>(i));
+     *   }
+     * }
+     * \endcode
+     */
+    class block_reader {
+    public:
+      /// Reads the file header. Check good() before use.
+      explicit block_reader(std::istream& in) : in(in), nrows(0), ok(false) {
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (in.fail()) return;
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+          logstream(LOG_ERROR) << "Not a columnar graph file" << std::endl;
+          return;
+        }
+        if (header.version != VERSION) {
+          logstream(LOG_ERROR) << "Unsupported columnar file version "
+                               << header.version << std::endl;
+          return;
+        }
+        if (header.id_width != 4 && header.id_width != 8) {
+          logstream(LOG_ERROR) << "Unsupported id width "
+                               << header.id_width << std::endl;
+          return;
+        }
+        ok = true;
+      }
+
+      /// True if the header was read successfully
+      bool good() const { return ok; }
+
+      const file_header& get_header() const { return header; }
+
+      bool is_edge_file() const { return header.kind == EDGE_FILE; }
+
+      /**
+       * Reads the next block. Returns false at the end of the file or
+       * if the block is corrupt.
+       */
+      bool next_block() {
+        nrows = 0;
+        if (!ok) return false;
+        block_header bheader;
+        in.read(reinterpret_cast<char*>(&bheader), sizeof(bheader));
+        if (in.fail() || bheader.nrows == 0) return false;
+        payload.resize(bheader.nbytes);
+        if (bheader.nbytes > 0) in.read(&payload[0], bheader.nbytes);
+        if (in.fail()) {
+          logstream(LOG_ERROR) << "Truncated columnar block" << std::endl;
+          return ok = false;
+        }
+        const std::vector<char>* columns = &payload;
+        if (header.flags & COMPRESSED) {
+          raw.clear();
+          // an empty payload is not a zlib stream, and fails the size
+          // check below
+          if (!payload.empty()) {
+            try {
+              boost::iostreams::filtering_istream zin;
+              zin.push(boost::iostreams::zlib_decompressor());
+              zin.push(boost::iostreams::array_source(&payload[0],
+                                                      payload.size()));
+              boost::iostreams::copy(zin,
+                                     boost::iostreams::back_inserter(raw));
+            } catch (const std::exception& e) {
+              logstream(LOG_ERROR) << "Corrupt compressed columnar block: "
+                                   << e.what() << std::endl;
+              return ok = false;
+            }
+          }
+          columns = &raw;
+        }
+        const size_t ncolumns = is_edge_file() ? 2 : 1;
+        const size_t row_width = ncolumns * header.id_width +
+                                 header.value_width;
+        if (columns->size() != size_t(bheader.nrows) * row_width) {
+          logstream(LOG_ERROR) << "Columnar block has " << columns->size()
+                               << " bytes, expected "
+                               << size_t(bheader.nrows) * row_width
+                               << std::endl;
+          return ok = false;
+        }
+        if (columns != &raw) raw.swap(payload);
+        nrows = bheader.nrows;
+        return true;
+      }
+
+      /// Number of rows in the current block
+      size_t num_rows() const { return nrows; }
+
+      /// The vertex id of a row of a vertex file, or the source of an edge
+      vertex_id_type id(size_t row) const {
+        return read_id(&raw[0], row);
+      }
+
+      /// The target of a row of an edge file
+      vertex_id_type target(size_t row) const {
+        return read_id(&raw[0] + nrows * header.id_width, row);
+      }
+
+      /// Pointer to the value of a row
+      const char* value_ptr(size_t row) const {
+        const size_t ncolumns = is_edge_file() ? 2 : 1;
+        return &raw[0] + ncolumns * nrows * header.id_width +
+               row * header.value_width;
+      }
+
+      /// The value of a row. T must be as wide as the stored values.
+      template <typename T>
+      T value(size_t row) const {
+        DASSERT_EQ(sizeof(T), header.value_width);
+        T ret;
+        memcpy(&ret, value_ptr(row), sizeof(T));
+        return ret;
+      }
+
+    private:
+      std::istream& in;
+      file_header header;
+      size_t nrows;
+      bool ok;
+      std::vector<char> payload;
+      std::vector<char> raw;
+
+      vertex_id_type read_id(const char* column, size_t row) const {
+        if (header.id_width == 4) {
+          uint32_t ret;
+          memcpy(&ret, column + row * 4, 4);
+          return ret;
+        } else {
+          uint64_t ret;
+          memcpy(&ret, column + row * 8, 8);
+          return vertex_id_type(ret);
+        }
+      }
+    }; // end of block_reader
+
+  } // namespace columnar
+} // namespace graphlab
+#endif
@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_COMPACT_VID2LVID_HPP
+#define GRAPHLAB_COMPACT_VID2LVID_HPP
+
+#include <vector>
+#include <algorithm>
+#include <graphlab/graph/graph_basic_types.hpp>
+
+namespace graphlab {
+
+  /**
+   * \internal
+   * \brief A read only map from global to local vertex ids, built once
+   * the local vertex set is final.
+   *
+   * If the local vertex ids fall in a range of at most DENSE_FACTOR times
+   * the number of local vertices, the map is a direct table indexed by
+   * (vid - min_vid), which needs no search. Otherwise it is a sorted
+   * array of global ids with the matching local ids, searched by
+   * bisection. Both take at most two ids per entry, and unlike a hash
+   * map they have no empty slots or per-entry overhead.
+   */
+  class compact_vid2lvid {
+  public:
+    enum { DENSE_FACTOR = 2 };
+
+    compact_vid2lvid(): min_vid(0), nentries(0) { }
+
+    /**
+     * Builds the index from any map of (vertex_id_type, lvid_type) pairs,
+     * replacing the previous contents.
+     */
+    template <typename MapType>
+    void build(const MapType& map) {
+      clear();
+      nentries = map.size();
+      if (nentries == 0) return;
+      vertex_id_type max_vid = map.begin()->first;
+      min_vid = max_vid;
+      for (typename MapType::const_iterator it = map.begin(); it != map.end(); ++it) {
+        min_vid = std::min(min_vid, it->first);
+        max_vid = std::max(max_vid, it->first);
+      }
+      if (size_t(max_vid - min_vid) < DENSE_FACTOR * nentries) {
+        direct.resize(size_t(max_vid - min_vid) + 1, lvid_type(-1));
+        for (typename MapType::const_iterator it = map.begin(); it != map.end(); ++it) {
+          direct[it->first - min_vid] = it->second;
+        }
+      } else {
+        std::vector<std::pair<vertex_id_type, lvid_type> > entries;
+        entries.reserve(nentries);
+        for (typename MapType::const_iterator it = map.begin(); it != map.end(); ++it) {
+          entries.push_back(std::make_pair(it->first, it->second));
+        }
+        std::sort(entries.begin(), entries.end());
+        vids.resize(nentries);
+        lvids.resize(nentries);
+        for (size_t i = 0; i < nentries; ++i) {
+          vids[i] = entries[i].first;
+          lvids[i] = entries[i].second;
+        }
+      }
+    }
+
+    /// Looks up vid, returning false if it is not in the map
+    inline bool find(vertex_id_type vid, lvid_type& lvid) const {
+      if (!direct.empty()) {
+        if (vid < min_vid || size_t(vid - min_vid) >= direct.size()) return false;
+        lvid = direct[vid - min_vid];
+        return lvid != lvid_type(-1);
+      }
+      std::vector<vertex_id_type>::const_iterator it =
+          std::lower_bound(vids.begin(), vids.end(), vid);
+      if (it == vids.end() || *it != vid) return false;
+      lvid = lvids[it - vids.begin()];
+      return true;
+    }
+
+    /// Inserts all entries into a map
+    template <typename MapType>
+    void expand(MapType& map) const {
+      if (!direct.empty()) {
+        for (size_t i = 0; i < direct.size(); ++i) {
+          if (direct[i] != lvid_type(-1)) map[vertex_id_type(min_vid + i)] = direct[i];
+        }
+      } else {
+        for (size_t i = 0; i < vids.size(); ++i) map[vids[i]] = lvids[i];
+      }
+    }
+
+    /// Number of entries
+    inline size_t size() const {
+      return nentries;
+    }
+
+    inline bool empty() const {
+      return nentries == 0;
+    }
+
+    /// True if the index is a direct table
+    inline bool is_direct() const {
+      return !direct.empty();
+    }
+
+    /// Bytes used by the index
+    size_t memory_bytes() const {
+      return direct.capacity() * sizeof(lvid_type) +
+          vids.capacity() * sizeof(vertex_id_type) +
+          lvids.capacity() * sizeof(lvid_type);
+    }
+
+    /// Removes all entries and releases the memory
+    void clear() {
+      std::vector<lvid_type>().swap(direct);
+      std::vector<vertex_id_type>().swap(vids);
+      std::vector<lvid_type>().swap(lvids);
+      min_vid = 0;
+      nentries = 0;
+    }
+
+  private:
+    vertex_id_type min_vid;
+    size_t nentries;
+    std::vector<lvid_type> direct;
+    std::vector<vertex_id_type> vids;
+    std::vector<lvid_type> lvids;
+  };
+
+} // namespace graphlab
+#endif
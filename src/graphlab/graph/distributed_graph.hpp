@@ -71,6 +71,8 @@
 #include <graphlab/vertex_program/op_plus_eq_concept.hpp>
 
 #include <graphlab/graph/local_graph.hpp>
+#include <graphlab/graph/mirror_set.hpp>
+#include <graphlab/graph/compact_vid2lvid.hpp>
 #include <graphlab/graph/dynamic_local_graph.hpp>
 
 #include <graphlab/graph/graph_gather_apply.hpp>
@@ -79,6 +81,7 @@
 #include <graphlab/graph/ingress/distributed_hdrf_ingress.hpp>
 #include <graphlab/graph/ingress/distributed_random_ingress.hpp>
 #include <graphlab/graph/ingress/distributed_identity_ingress.hpp>
+#include <graphlab/graph/ingress/distributed_hybrid_ingress.hpp>
 
 #include <graphlab/graph/ingress/sharding_constraint.hpp>
 #include <graphlab/graph/ingress/distributed_constrained_random_ingress.hpp>
@@ -92,6 +95,7 @@
 
 
 #include <graphlab/graph/builtin_parsers.hpp>
+#include <graphlab/graph/columnar_format.hpp>
 #include <graphlab/graph/vertex_set.hpp>
 
 #include <graphlab/macros_def.hpp>
@@ -208,6 +212,13 @@ namespace graphlab {
    *		    "HDRF: Stream-Based Partitioning for Power-Law Graphs". 
    *		    CIKM, 2015.
    *
+   * \li \c "hybrid" Runs at roughly the speed of random. Places the in-edges
+   *                 of low-degree vertices on the master of the target
+   *                 (edge-cut) and hashes the in-edges of vertices with
+   *                 in-degree above \c threshold by source (vertex-cut),
+   *                 as in PowerLyra. Low-degree vertices then gather their
+   *                 in-edges without involving mirrors.
+   *
    * ### Referencing Vertices / Edges Many GraphLab operations will pass around
    * vertex_type and edge_type objects. These objects are light-weight copyable
    * opaque references to vertices and edges in the distributed graph.  The
@@ -384,7 +395,7 @@ namespace graphlab {
                                  const std::string&)> line_parser_type;
 
 
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> mirror_type;
+    typedef mirror_set mirror_type;
 
     /// The type of the local graph used to store the graph data
 #ifdef USE_DYNAMIC_LOCAL_GRAPH
@@ -409,6 +420,7 @@ namespace graphlab {
     friend class distributed_identity_ingress<VertexData, EdgeData>;
     friend class distributed_oblivious_ingress<VertexData, EdgeData>;
     friend class distributed_hdrf_ingress<VertexData, EdgeData>;
+    friend class distributed_hybrid_ingress<VertexData, EdgeData>;
     friend class distributed_constrained_random_ingress<VertexData, EdgeData>;
 
     typedef graphlab::vertex_id_type vertex_id_type;
@@ -423,6 +435,26 @@ namespace graphlab {
     struct local_edge_list_type;
     class local_edge_type;
 
+    /**
+     * \brief The neighbors of a vertex in the local graph, as a sorted
+     * array of local vertex IDs. See
+     * distributed_graph::build_local_neighborhoods().
+     */
+    struct local_neighbor_list {
+      typedef const lvid_type* iterator;
+      typedef const lvid_type* const_iterator;
+      typedef lvid_type value_type;
+      const lvid_type* begin_ptr;
+      const lvid_type* end_ptr;
+      local_neighbor_list(const lvid_type* begin_ptr, const lvid_type* end_ptr) :
+        begin_ptr(begin_ptr), end_ptr(end_ptr) { }
+      const_iterator begin() const { return begin_ptr; }
+      const_iterator end() const { return end_ptr; }
+      size_t size() const { return end_ptr - begin_ptr; }
+      bool empty() const { return begin_ptr == end_ptr; }
+      lvid_type operator[](size_t i) const { return begin_ptr[i]; }
+    };
+
     /**
      * \brief Vertex object which provides access to the vertex data
      * and information about the vertex.
@@ -500,6 +532,19 @@ namespace graphlab {
         return lvid;
       }
 
+      /**
+       * \brief Returns the neighbors of the vertex among the edges
+       * stored on this machine, as a sorted list of local vertex IDs.
+       *
+       * This reads the index built by
+       * distributed_graph::build_local_neighborhoods() and does not
+       * copy. It is safe to call on the endpoints of an edge during
+       * scatter: both endpoints of every local edge are local vertices.
+       */
+      local_neighbor_list local_neighbors() const {
+        return graph_ref.l_neighbors(lvid);
+      }
+
     };
 
 
@@ -612,6 +657,23 @@ namespace graphlab {
      *                Defaults to 50,000. Increasing this number will
      *                decrease partitioning time with a penalty to partitioning
      *                quality.
+     * \li \c threshold The in-degree above which the hybrid ingress method
+     *                vertex-cuts a vertex. Defaults to 100.
+     * \li \c compact If true, finalize() replaces the hash map from global
+     *                to local vertex ids by a sorted array (or a direct
+     *                table when the local vertex ids are dense), and packs
+     *                the vertex owners into a separate array for master
+     *                checks. Reduces the per vertex metadata at the cost of
+     *                slower global id lookups. Defaults to false.
+     * \li \c compact_exchange If true, the vertices and edges exchanged
+     *                during ingress and the vertex data exchanged by
+     *                synchronize() are serialized in compact mode, with
+     *                integers such as vertex ids written as varints.
+     *                Defaults to false.
+     * \li \c neighborhoods If "all" or "degree", finalize() calls
+     *                build_local_neighborhoods() so that vertex programs can
+     *                read vertex_type::local_neighbors(). "degree" keeps only
+     *                the neighbors of higher degree. Defaults to "none".
      *
      * \param [in] dc Distributed controller to associate with
      * \param [in] opts A graphlab::graphlab_options object specifying engine
@@ -620,7 +682,9 @@ namespace graphlab {
      */
     distributed_graph(distributed_control& dc,
                       const graphlab_options& opts = graphlab_options()) :
-      rpc(dc, this), finalized(false), vid2lvid(),
+      rpc(dc, this), finalized(false), vid2lvid(), compact_metadata(false),
+      compact_exchange(false),
+      neighborhood_order("none"),
       nverts(0), nedges(0), local_own_nverts(0), nreplicas(0),
       ingress_ptr(NULL), 
 #ifdef _OPENMP
@@ -646,6 +710,7 @@ namespace graphlab {
       size_t bufsize = 50000;
       bool usehash = false;
       bool userecent = false;
+      size_t threshold = 100;
       std::string ingress_method = "";
       std::vector<std::string> keys = opts.get_graph_args().get_option_keys();
       foreach(std::string opt, keys) {
@@ -659,6 +724,31 @@ namespace graphlab {
           if (!parallel_ingress && rpc.procid() == 0)
             logstream(LOG_EMPH) << "Disable parallel ingress. Graph will be streamed through one node."
               << std::endl;
+        } else if (opt == "threshold") {
+          opts.get_graph_args().get_option("threshold", threshold);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: threshold = "
+              << threshold << std::endl;
+        } else if (opt == "compact") {
+          opts.get_graph_args().get_option("compact", compact_metadata);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: compact = "
+              << compact_metadata << std::endl;
+        } else if (opt == "compact_exchange") {
+          opts.get_graph_args().get_option("compact_exchange", compact_exchange);
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: compact_exchange = "
+              << compact_exchange << std::endl;
+        } else if (opt == "neighborhoods") {
+          opts.get_graph_args().get_option("neighborhoods", neighborhood_order);
+          if (neighborhood_order != "none" && neighborhood_order != "all" &&
+              neighborhood_order != "degree") {
+            logstream(LOG_FATAL) << "Graph Option: neighborhoods must be "
+                                 << "none, all or degree" << std::endl;
+          }
+          if (rpc.procid() == 0)
+            logstream(LOG_EMPH) << "Graph Option: neighborhoods = "
+              << neighborhood_order << std::endl;
         }
         /**
          * These options below are deprecated.
@@ -682,7 +772,9 @@ namespace graphlab {
           logstream(LOG_ERROR) << "Unexpected Graph Option: " << opt << std::endl;
         }
     }
-      set_ingress_method(ingress_method, bufsize, usehash, userecent);
+      set_ingress_method(ingress_method, bufsize, usehash, userecent, threshold);
+      vertex_exchange.set_compact(compact_exchange);
+      vset_exchange.set_compact(compact_exchange);
     }
 
   public:
@@ -709,13 +801,107 @@ namespace graphlab {
 #endif
       ASSERT_NE(ingress_ptr, NULL);
       logstream(LOG_INFO) << "Distributed graph: enter finalize" << std::endl;
+      // ingress updates vid2lvid in place
+      expand_vertex_index();
       ingress_ptr->finalize();
+      if (compact_metadata) compact_vertex_index();
       lock_manager.resize(num_local_vertices());
+      if (neighborhood_order != "none") {
+        build_local_neighborhoods(neighborhood_order == "degree");
+      } else {
+        // the edges may have changed since the index was built
+        clear_local_neighborhoods();
+      }
       rpc.barrier(); 
 
       finalized = true;
     }
 
+    /**
+     * \brief Builds a sorted list of the neighbors of each local vertex
+     * among the edges stored on this machine, read by
+     * vertex_type::local_neighbors().
+     *
+     * The index holds one local vertex ID per local edge end, so it
+     * takes O(|E|) memory over all machines. It only describes the edges
+     * stored on this machine: on several machines a pattern whose edges
+     * are spread over machines is not visible in any single index.
+     *
+     * If degree_ordered is true each undirected edge is kept only at the
+     * endpoint which precedes the other in the order of (degree, vertex
+     * ID), using the degree over the whole graph. Every vertex then keeps
+     * at most O(sqrt(|E|)) neighbors, and for each triangle whose three
+     * edges are stored on this machine exactly one of its edges (u,v) has
+     * the third vertex in both u.local_neighbors() and
+     * v.local_neighbors().
+     *
+     * Called by finalize() with the graph option \c neighborhoods. It may
+     * also be called directly after finalize(), on any subset of the
+     * machines. Edge directions and duplicate edges are ignored.
+     */
+    void build_local_neighborhoods(bool degree_ordered = true) {
+      const size_t n = local_graph.num_vertices();
+      std::vector<size_t> sizes(n, 0);
+      std::vector<size_t> ptrs(n + 1, 0);
+      for (size_t i = 0; i < n; ++i) {
+        ptrs[i + 1] = ptrs[i] + local_graph.num_in_edges(i) +
+                      local_graph.num_out_edges(i);
+      }
+      std::vector<lvid_type> values(ptrs[n]);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+      for (ssize_t i = 0; i < ssize_t(n); ++i) {
+        const lvid_type lvid = i;
+        lvid_type* out = values.empty() ? NULL : &(values[0]) + ptrs[i];
+        size_t count = 0;
+        foreach(const typename local_graph_type::edge_type& e,
+                local_graph.in_edges(lvid)) {
+          const lvid_type other = e.source().id();
+          if (other != lvid && (!degree_ordered || precedes(lvid, other))) {
+            out[count++] = other;
+          }
+        }
+        foreach(const typename local_graph_type::edge_type& e,
+                local_graph.out_edges(lvid)) {
+          const lvid_type other = e.target().id();
+          if (other != lvid && (!degree_ordered || precedes(lvid, other))) {
+            out[count++] = other;
+          }
+        }
+        std::sort(out, out + count);
+        sizes[i] = std::unique(out, out + count) - out;
+      }
+      // close the gaps left by the dropped neighbors
+      size_t next = 0;
+      for (size_t i = 0; i < n; ++i) {
+        std::copy(values.begin() + ptrs[i], values.begin() + ptrs[i] + sizes[i],
+                  values.begin() + next);
+        ptrs[i] = next;
+        next += sizes[i];
+      }
+      ptrs[n] = next;
+      values.resize(next);
+      std::vector<lvid_type>(values).swap(values);
+      local_neighbor_ptrs.swap(ptrs);
+      local_neighbor_values.swap(values);
+      logstream(LOG_INFO) << "Local neighborhoods: " << next << " neighbors of "
+                          << n << " vertices"
+                          << (degree_ordered ? ", degree ordered" : "")
+                          << std::endl;
+    }
+
+    /// \brief Frees the index built by build_local_neighborhoods()
+    void clear_local_neighborhoods() {
+      std::vector<size_t>().swap(local_neighbor_ptrs);
+      std::vector<lvid_type>().swap(local_neighbor_values);
+    }
+
+    /// \brief Returns true if build_local_neighborhoods() has been called
+    bool has_local_neighborhoods() const {
+      return !local_neighbor_ptrs.empty();
+    }
+
     /// \brief Returns true if the graph is finalized.
     bool is_finalized() {
       return finalized;
@@ -1659,6 +1845,14 @@ namespace graphlab {
           >> vid2lvid
           >> lvid2record
           >> local_graph;
+      vid2lvid_compact.clear();
+      lvid2owner.clear();
+      if (compact_metadata) compact_vertex_index();
+      if (neighborhood_order != "none") {
+        build_local_neighborhoods(neighborhood_order == "degree");
+      } else {
+        clear_local_neighborhoods();
+      }
       finalized = true;
       // check the graph condition
     } // end of load
@@ -1676,9 +1870,16 @@ namespace graphlab {
       arc << nverts
           << nedges
           << local_own_nverts
-          << nreplicas
-          << vid2lvid
-          << lvid2record
+          << nreplicas;
+      // the archive format always holds the hash map
+      if (is_compact()) {
+        hopscotch_map_type expanded_vid2lvid;
+        vid2lvid_compact.expand(expanded_vid2lvid);
+        arc << expanded_vid2lvid;
+      } else {
+        arc << vid2lvid;
+      }
+      arc << lvid2record
           << local_graph;
     } // end of save
 
@@ -1690,6 +1891,8 @@ namespace graphlab {
         vrec.clear();
       lvid2record.clear();
       vid2lvid.clear();
+      vid2lvid_compact.clear();
+      std::vector<procid_t>().swap(lvid2owner);
       local_graph.clear();
       finalized=false;
       nverts = nedges = local_own_nverts = nreplicas = 0;
@@ -2131,7 +2334,8 @@ namespace graphlab {
      *               If prefix begins with "hdfs://", the output is written to
      *               HDFS.
      * \param format The file format to save in.
-     *               Either "tsv", "snap", "graphjrl" or "bin".
+     *               Either "tsv", "snap", "graphjrl", "bin", "bintsv4"
+     *               or "columnar".
      * \param gzip If gzip compression should be used. If set, all files will be
      *             appended with the .gz suffix. Defaults to true. Ignored
      *             if format == "bin".
@@ -2151,6 +2355,9 @@ namespace graphlab {
          save_binary(prefix);
       } else if (format == "bintsv4") {
          save_direct(prefix, gzip, &graph_type::save_bintsv4_to_stream);
+      } else if (format == "columnar") {
+         save_columnar(prefix, builtin_parsers::columnar_structure_writer<distributed_graph>(),
+                       gzip, true, true, files_per_machine);
       } else {
         logstream(LOG_FATAL)
           << "Unrecognized Format \"" << format << "\"!" << std::endl;
@@ -2159,6 +2366,128 @@ namespace graphlab {
     } // end of save structure
 
 
+    /**
+     * \brief Saves the graph in the binary columnar format. This function
+     * should be called on all machines simultaneously.
+     *
+     * Unlike save(), which formats every vertex and edge as text, this
+     * writes fixed width vertex ids and binary values, a block of rows
+     * at a time, and is meant for bulk ingestion by other programs. The
+     * format is described in graphlab::columnar. The files can be read
+     * with graphlab::columnar::block_reader, or converted to text with
+     * the columnar_dump tool.
+     *
+     * The writer object selects the value stored with each vertex and
+     * each edge:
+     * \code
+     * struct pagerank_columns {
+     *   typedef double vertex_value_type;
+     *   typedef graphlab::empty edge_value_type;
+     *   double vertex_value(graph_type::vertex_type v) { return v.data(); }
+     *   graphlab::empty edge_value(graph_type::edge_type e) {
+     *     return graphlab::empty();
+     *   }
+     * };
+     * \endcode
+     * The value types must be POD (a struct may be declared POD by
+     * inheriting from graphlab::IS_POD_TYPE), which is checked at compile
+     * time. Builtin arithmetic types are recorded
+     * as such in the file header, graphlab::empty values are not stored,
+     * and anything else is stored as raw bytes.
+     *
+     * Vertices and edges are written to separate files:
+     * \li [prefix].vertices.1_of_16
+     * \li [prefix].edges.1_of_16
+     * \li etc.
+     *
+     * Each machine writes files_per_machine files of each kind in
+     * parallel. If the prefix begins with "hdfs://", the output is
+     * written to HDFS.
+     *
+     * \param prefix The file prefix to save the output graph files.
+     * \param writer The writer object to use.
+     * \param compress If each block should be compressed with zlib.
+     *                 Defaults to true.
+     * \param save_vertex If vertices should be saved. Defaults to true.
+     * \param save_edges If edges should be saved. Defaults to true.
+     * \param files_per_machine Number of files of each kind to write
+     *                          simultaneously per machine. Defaults to
+     *                          the number of cores.
+     */
+    template<typename Writer>
+    void save_columnar(const std::string& prefix, Writer writer,
+                       bool compress = true,
+                       bool save_vertex = true,
+                       bool save_edge = true,
+                       size_t files_per_machine = 0) {
+      typedef typename Writer::vertex_value_type vertex_value_type;
+      typedef typename Writer::edge_value_type edge_value_type;
+      typedef columnar::block_writer<vertex_value_type> vertex_writer_type;
+      typedef columnar::block_writer<edge_value_type> edge_writer_type;
+      typedef boost::function<void(vertex_type)> vertex_function_type;
+      typedef boost::function<void(edge_type)> edge_function_type;
+      rpc.full_barrier();
+      finalize();
+      if (files_per_machine == 0) files_per_machine = thread::cpu_count();
+      const bool to_hdfs = boost::starts_with(prefix, "hdfs://");
+      if (to_hdfs && !hdfs::has_hadoop()) {
+        logstream(LOG_FATAL)
+          << "\n\tAttempting to save a graph to HDFS but GraphLab"
+          << "\n\twas built without HDFS."
+          << std::endl;
+      }
+      const std::string suffix =
+          "_of_" + tostr(rpc.numprocs() * files_per_machine);
+
+      if (save_vertex) {
+        std::vector<std::ostream*> outstreams(files_per_machine);
+        std::vector<vertex_writer_type*> writers(files_per_machine);
+        std::vector<vertex_function_type> callbacks(files_per_machine);
+        for(size_t i = 0; i < files_per_machine; ++i) {
+          outstreams[i] = open_columnar_file(prefix + ".vertices." +
+              tostr(1 + i + rpc.procid() * files_per_machine) + suffix,
+              to_hdfs);
+          writers[i] = new vertex_writer_type(*outstreams[i],
+                                              columnar::VERTEX_FILE,
+                                              compress);
+          callbacks[i] =
+            boost::bind(&graph_type::template save_vertex_to_columns<Writer>,
+                        this, _1, boost::ref(*writers[i]), boost::ref(writer));
+        }
+        parallel_for_vertices(callbacks);
+        for(size_t i = 0; i < files_per_machine; ++i) {
+          writers[i]->close();
+          delete writers[i];
+          delete outstreams[i];
+        }
+      }
+
+      if (save_edge) {
+        std::vector<std::ostream*> outstreams(files_per_machine);
+        std::vector<edge_writer_type*> writers(files_per_machine);
+        std::vector<edge_function_type> callbacks(files_per_machine);
+        for(size_t i = 0; i < files_per_machine; ++i) {
+          outstreams[i] = open_columnar_file(prefix + ".edges." +
+              tostr(1 + i + rpc.procid() * files_per_machine) + suffix,
+              to_hdfs);
+          writers[i] = new edge_writer_type(*outstreams[i],
+                                            columnar::EDGE_FILE,
+                                            compress);
+          callbacks[i] =
+            boost::bind(&graph_type::template save_edge_to_columns<Writer>,
+                        this, _1, boost::ref(*writers[i]), boost::ref(writer));
+        }
+        parallel_for_edges(callbacks);
+        for(size_t i = 0; i < files_per_machine; ++i) {
+          writers[i]->close();
+          delete writers[i];
+          delete outstreams[i];
+        }
+      }
+      rpc.full_barrier();
+    } // end of save columnar
+
+
 
 
     /**
@@ -2606,13 +2935,14 @@ namespace graphlab {
     struct vertex_record {
       /// The official owning processor for this vertex
       procid_t owner;
+      /** The set of proc that mirror this vertex.  The owner should
+          NOT be in this set. Placed next to owner so that both pack
+          into 16 bytes. */
+      mirror_type _mirrors;
       /// The local vid of this vertex on this proc
       vertex_id_type gvid;
       /// The number of in edges
       vertex_id_type num_in_edges, num_out_edges;
-      /** The set of proc that mirror this vertex.  The owner should
-          NOT be in this set.*/
-      mirror_type _mirrors;
       vertex_record() :
         owner(-1), gvid(-1), num_in_edges(0), num_out_edges(0) { }
       vertex_record(const vertex_id_type& vid) :
@@ -2682,10 +3012,9 @@ namespace graphlab {
     /** \internal
      *\brief Convert a global vid to a local vid */
     lvid_type local_vid (const vertex_id_type vid) const {
-      // typename boost::unordered_map<vertex_id_type, lvid_type>::
-      //   const_iterator iter = vid2lvid.find(vid);
-      typename hopscotch_map_type::const_iterator iter = vid2lvid.find(vid);
-      return iter->second;
+      lvid_type lvid(-1);
+      find_lvid(vid, lvid);
+      return lvid;
     } // end of local_vertex_id
 
     /** \internal
@@ -2701,7 +3030,16 @@ namespace graphlab {
      * of the vertex ID.
      */
     bool contains_vertex(const vertex_id_type vid) const {
-      return vid2lvid.find(vid) != vid2lvid.end();
+      lvid_type lvid;
+      return find_lvid(vid, lvid);
+    }
+
+    /** \internal
+     * \brief Returns true if the vertex index was compacted by finalize().
+     * See the \c compact graph option.
+     */
+    bool is_compact() const {
+      return !lvid2owner.empty();
     }
     /**
      * \internal
@@ -2766,11 +3104,9 @@ namespace graphlab {
      * \brief Returns the internal vertex record of a given global vertex ID
      */
     const vertex_record& get_vertex_record(vertex_id_type vid) const {
-      // typename boost::unordered_map<vertex_id_type, lvid_type>::
-      //   const_iterator iter = vid2lvid.find(vid);
-      typename hopscotch_map_type::const_iterator iter = vid2lvid.find(vid);
-      ASSERT_TRUE(iter != vid2lvid.end());
-      return lvid2record[iter->second];
+      lvid_type lvid(-1);
+      ASSERT_TRUE(find_lvid(vid, lvid));
+      return lvid2record[lvid];
     }
 
     /** \internal
@@ -2789,6 +3125,18 @@ namespace graphlab {
       return lvid2record[lvid];
     }
 
+    /** \internal
+     * \brief Returns the local neighbors of a given local vertex ID.
+     * Requires build_local_neighborhoods().
+     */
+    local_neighbor_list l_neighbors(lvid_type lvid) const {
+      ASSERT_LT(lvid + 1, local_neighbor_ptrs.size());
+      const lvid_type* base = local_neighbor_values.empty() ?
+                              NULL : &(local_neighbor_values[0]);
+      return local_neighbor_list(base + local_neighbor_ptrs[lvid],
+                                 base + local_neighbor_ptrs[lvid + 1]);
+    }
+
     /** \internal
      * \brief Returns true if the provided global vertex ID is a
      *        master vertex on this machine and false otherwise.
@@ -2810,6 +3158,7 @@ namespace graphlab {
      */
     bool l_is_master(lvid_type lvid) const {
       ASSERT_LT(lvid, lvid2record.size());
+      if (!lvid2owner.empty()) return lvid2owner[lvid] == rpc.procid();
       return lvid2record[lvid].owner == rpc.procid();
     }
 
@@ -2818,6 +3167,7 @@ namespace graphlab {
      */
     procid_t l_master(lvid_type lvid) const {
       ASSERT_LT(lvid, lvid2record.size());
+      if (!lvid2owner.empty()) return lvid2owner[lvid];
       return lvid2record[lvid].owner;
     }
 
@@ -2966,13 +3316,13 @@ namespace graphlab {
       /** \brief Returns the owner of this local vertex
        */
       procid_t owner() const {
-        return graph_ref.l_get_vertex_record(lvid).owner;
+        return graph_ref.l_master(lvid);
       }
 
       /** \brief Returns the owner of this local vertex
        */
       bool owned() const {
-        return graph_ref.l_get_vertex_record(lvid).owner == graph_ref.procid();
+        return graph_ref.l_is_master(lvid);
       }
 
       /** \brief Returns the number of in_edges of this vertex
@@ -3151,6 +3501,73 @@ namespace graphlab {
 
     hopscotch_map_type vid2lvid;
 
+    /** Replaces vid2lvid after finalize() if compact_metadata is set */
+    compact_vid2lvid vid2lvid_compact;
+
+    /** The owner of each local vertex, packed for master checks. Only
+     * built with compact_metadata, since lvid2record holds the same. */
+    std::vector<procid_t> lvid2owner;
+
+    /** Command option to compact the vertex index on finalize */
+    bool compact_metadata;
+
+    /** If true the buffered exchanges serialize in compact mode */
+    bool compact_exchange;
+
+    /** Command option to build the local neighborhoods on finalize:
+     * "none", "all" or "degree" */
+    std::string neighborhood_order;
+
+    /** The local neighbors of local vertex i are
+     * local_neighbor_values[local_neighbor_ptrs[i] .. local_neighbor_ptrs[i+1]) */
+    std::vector<size_t> local_neighbor_ptrs;
+    std::vector<lvid_type> local_neighbor_values;
+
+    /** True if local vertex a comes before b in the order of
+     * (global degree, global vertex ID) */
+    bool precedes(lvid_type a, lvid_type b) const {
+      const vertex_record& ra = lvid2record[a];
+      const vertex_record& rb = lvid2record[b];
+      const size_t da = ra.num_in_edges + ra.num_out_edges;
+      const size_t db = rb.num_in_edges + rb.num_out_edges;
+      return da < db || (da == db && ra.gvid < rb.gvid);
+    }
+
+    /** Looks up the local vid of vid in whichever index is active */
+    inline bool find_lvid(vertex_id_type vid, lvid_type& lvid) const {
+      if (is_compact()) return vid2lvid_compact.find(vid, lvid);
+      typename hopscotch_map_type::const_iterator iter = vid2lvid.find(vid);
+      if (iter == vid2lvid.end()) return false;
+      lvid = iter->second;
+      return true;
+    }
+
+    /** Moves vid2lvid into the compact index and packs the owners */
+    void compact_vertex_index() {
+      vid2lvid_compact.build(vid2lvid);
+      hopscotch_map_type().swap(vid2lvid);
+      lvid2owner.resize(lvid2record.size());
+      for (size_t i = 0; i < lvid2record.size(); ++i) {
+        lvid2owner[i] = lvid2record[i].owner;
+      }
+      // an empty partition leaves nothing to compact
+      if (lvid2owner.empty()) return;
+      logstream(LOG_INFO) << "Compact vertex index: "
+                          << vid2lvid_compact.size() << " vertices in "
+                          << (vid2lvid_compact.is_direct() ? "a direct table of "
+                                                           : "a sorted array of ")
+                          << vid2lvid_compact.memory_bytes() << " bytes" << std::endl;
+    }
+
+    /** Restores vid2lvid from the compact index so it can be modified */
+    void expand_vertex_index() {
+      if (!is_compact()) return;
+      vid2lvid.rehash(vid2lvid_compact.size());
+      vid2lvid_compact.expand(vid2lvid);
+      vid2lvid_compact.clear();
+      std::vector<procid_t>().swap(lvid2owner);
+    }
+
 
     /** The global number of vertices and edges */
     size_t nverts, nedges;
@@ -3177,7 +3594,8 @@ namespace graphlab {
     lock_manager_type lock_manager;
 
     void set_ingress_method(const std::string& method,
-        size_t bufsize = 50000, bool usehash = false, bool userecent = false) {
+        size_t bufsize = 50000, bool usehash = false, bool userecent = false,
+        size_t threshold = 100) {
       if(ingress_ptr != NULL) { delete ingress_ptr; ingress_ptr = NULL; }
       if (method == "oblivious") {
         if (rpc.procid() == 0) logstream(LOG_EMPH) << "Use oblivious ingress, usehash: " << usehash
@@ -3196,6 +3614,9 @@ namespace graphlab {
       } else if (method == "pds") {
         if (rpc.procid() == 0)logstream(LOG_EMPH) << "Use pds ingress" << std::endl;
         ingress_ptr = new distributed_constrained_random_ingress<VertexData, EdgeData>(rpc.dc(), *this, "pds");
+      } else if (method == "hybrid") {
+        if (rpc.procid() == 0) logstream(LOG_EMPH) << "Use hybrid ingress, threshold: " << threshold << std::endl;
+        ingress_ptr = new distributed_hybrid_ingress<VertexData, EdgeData>(rpc.dc(), *this, threshold);
       } else {
         // use default ingress method if none is specified
         std::string ingress_auto="";
@@ -3213,6 +3634,7 @@ namespace graphlab {
         }
         if (rpc.procid() == 0)logstream(LOG_EMPH) << "Automatically determine ingress method: " << ingress_auto << std::endl;
       }
+      ingress_ptr->set_compact_exchange(compact_exchange);
       // batch ingress is deprecated
       // if (method == "batch") {
       //   logstream(LOG_EMPH) << "Use batch ingress, bufsize: " << bufsize
@@ -3268,6 +3690,38 @@ namespace graphlab {
     } // end of save_edge_to_stream
 
 
+    template<typename Writer>
+    void save_vertex_to_columns(vertex_type& vertex,
+        columnar::block_writer<typename Writer::vertex_value_type>& out,
+        Writer& writer) {
+      out.add(vertex.id(), writer.vertex_value(vertex));
+    } // end of save_vertex_to_columns
+
+
+    template<typename Writer>
+    void save_edge_to_columns(edge_type& edge,
+        columnar::block_writer<typename Writer::edge_value_type>& out,
+        Writer& writer) {
+      out.add(edge.source().id(), edge.target().id(), writer.edge_value(edge));
+    } // end of save_edge_to_columns
+
+
+    /** Opens a file for save_columnar() on the local filesystem or HDFS */
+    std::ostream* open_columnar_file(const std::string& fname, bool to_hdfs) {
+      logstream(LOG_INFO) << "Saving to file: " << fname << std::endl;
+      if (to_hdfs) {
+        return new hdfs::fstream(hdfs::get_hdfs(), fname, true);
+      }
+      std::ofstream* out = new std::ofstream(fname.c_str(),
+                                             std::ios_base::out |
+                                             std::ios_base::binary);
+      if (!out->good()) {
+        logstream(LOG_FATAL) << "Unable to open " << fname << std::endl;
+      }
+      return out;
+    } // end of open_columnar_file
+
+
     void save_bintsv4_to_stream(std::ostream& out) {
       for (int i = 0; i < (int)local_graph.num_vertices(); ++i) {
         uint32_t src = l_vertex(i).global_id();
@@ -28,6 +28,7 @@
 #include <graphlab/graph/graph_hash.hpp>
 #include <graphlab/graph/ingress/distributed_ingress_base.hpp>
 #include <graphlab/graph/distributed_graph.hpp>
+#include <graphlab/graph/mirror_set.hpp>
 #include <graphlab/rpc/buffered_exchange.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
 #include <graphlab/util/dense_bitset.hpp>
@@ -56,7 +57,7 @@ namespace graphlab {
     mutex local_graph_lock;
     mutex lvid2record_lock;
 
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type;
+    typedef mirror_set bin_counts_type;
 
     /** Type of the degree hash table: 
      * a map from vertex id to a bitset of length num_procs. */
@@ -237,10 +238,10 @@ namespace graphlab {
     /** Updates the local part of the distributed table. */
     void block_add_degree_counts (procid_t pid, std::vector<vertex_id_type>& whohas) {
       BEGIN_TRACEPOINT(batch_ingress_update_degree_table);
-      dht_degree_table_lock.readlock();
+      // bin_counts_type is not thread safe, so updates take the writelock
+      dht_degree_table_lock.writelock();
       foreach (vertex_id_type& vid, whohas) {
-        size_t idx = vid_to_dht_entry_with_readlock(vid);
-        dht_degree_table[idx].set_bit_unsync(pid);
+        dht_degree_table[vid].set_bit(pid);
       }
       dht_degree_table_lock.unlock();
       END_TRACEPOINT(batch_ingress_update_degree_table);
@@ -34,6 +34,7 @@
 #include <graphlab/util/dense_bitset.hpp>
 #include <graphlab/util/cuckoo_map_pow2.hpp>
 #include <graphlab/graph/ingress/sharding_constraint.hpp>
+#include <graphlab/graph/mirror_set.hpp>
 #include <graphlab/macros_def.hpp>
 namespace graphlab {
   template<typename VertexData, typename EdgeData>
@@ -57,7 +58,7 @@ namespace graphlab {
 
     typedef distributed_ingress_base<VertexData, EdgeData> base_type;
     // typedef typename boost::unordered_map<vertex_id_type, std::vector<size_t> > degree_hash_table_type;
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+    typedef mirror_set bin_counts_type; 
 
     /** Type of the degree hash table: 
      * a map from vertex id to a bitset of length num_procs. */
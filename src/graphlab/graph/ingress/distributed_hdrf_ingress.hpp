@@ -28,6 +28,7 @@
 #include <graphlab/graph/ingress/distributed_ingress_base.hpp>
 #include <graphlab/graph/ingress/ingress_edge_decision.hpp>
 #include <graphlab/graph/distributed_graph.hpp>
+#include <graphlab/graph/mirror_set.hpp>
 #include <graphlab/rpc/buffered_exchange.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
 #include <graphlab/util/dense_bitset.hpp>
@@ -51,7 +52,7 @@ namespace graphlab {
     typedef typename graph_type::mirror_type mirror_type;
 
     typedef distributed_ingress_base<VertexData, EdgeData> base_type;
-    typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+    typedef mirror_set bin_counts_type; 
 
     /** Type of the replica degree hash table: 
      * a map from vertex id to a bitset of length num_procs.
@@ -0,0 +1,157 @@
+/**  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_DISTRIBUTED_HYBRID_INGRESS_HPP
+#define GRAPHLAB_DISTRIBUTED_HYBRID_INGRESS_HPP
+
+#include <boost/unordered_map.hpp>
+
+#include <graphlab/rpc/buffered_exchange.hpp>
+#include <graphlab/graph/graph_basic_types.hpp>
+#include <graphlab/graph/graph_hash.hpp>
+#include <graphlab/graph/ingress/distributed_ingress_base.hpp>
+#include <graphlab/graph/distributed_graph.hpp>
+
+
+#include <graphlab/macros_def.hpp>
+namespace graphlab {
+  template<typename VertexData, typename EdgeData>
+  class distributed_graph;
+
+  /**
+   * \brief Ingress object combining an edge-cut for low-degree vertices
+   * with a vertex-cut for high-degree vertices.
+   *
+   * Every edge is first sent to the master of its target. Once all edges
+   * have arrived the master knows the exact in-degree of the target:
+   * in-edges of vertices with in-degree at most \c threshold stay on the
+   * master (edge-cut), while in-edges of higher degree vertices are
+   * re-distributed by hashing their source (vertex-cut).
+   *
+   * Low-degree vertices therefore hold all their in-edges on the master
+   * and the engine can run their in-edge gather without mirrors.
+   * The degree is only computed over the edges added since the last
+   * finalize.
+   */
+  template<typename VertexData, typename EdgeData>
+  class distributed_hybrid_ingress : 
+    public distributed_ingress_base<VertexData, EdgeData> {
+  public:
+    typedef distributed_graph<VertexData, EdgeData> graph_type;
+    /// The type of the vertex data stored in the graph 
+    typedef VertexData vertex_data_type;
+    /// The type of the edge data stored in the graph 
+    typedef EdgeData   edge_data_type;
+
+    typedef distributed_ingress_base<VertexData, EdgeData> base_type;
+    typedef typename base_type::edge_buffer_record edge_buffer_record;
+    typedef typename buffered_exchange<edge_buffer_record>::buffer_type 
+      edge_buffer_type;
+
+    /** Vertices with an in-degree above the threshold are vertex-cut. */
+    size_t threshold;
+
+  public:
+    distributed_hybrid_ingress(distributed_control& dc, graph_type& graph,
+                               size_t threshold = 100) :
+    base_type(dc, graph), threshold(threshold) {
+    } // end of constructor
+
+    ~distributed_hybrid_ingress() { }
+
+    /** Add an edge to the ingress object, sending it to the target master. */
+    void add_edge(vertex_id_type source, vertex_id_type target,
+                  const EdgeData& edata) {
+      const procid_t owning_proc = 
+        graph_hash::hash_vertex(target) % base_type::rpc.numprocs();
+      const edge_buffer_record record(source, target, edata);
+#ifdef _OPENMP
+      base_type::edge_exchange.send(owning_proc, record, omp_get_thread_num());
+#else
+      base_type::edge_exchange.send(owning_proc, record);
+#endif
+    } // end of add edge
+
+    /**
+     * \brief Re-assigns the in-edges of high-degree vertices before
+     * running the base finalization.
+     */
+    virtual void finalize() {
+      base_type::rpc.full_barrier();
+      base_type::edge_exchange.flush();
+
+      // Every received edge targets a vertex mastered here, so the
+      // local count is the exact in-degree.
+      std::vector<edge_buffer_type> edge_buffers;
+      boost::unordered_map<vertex_id_type, size_t> in_degree;
+      {
+        edge_buffer_type edge_buffer;
+        procid_t proc;
+        while(base_type::edge_exchange.recv(proc, edge_buffer)) {
+          foreach(const edge_buffer_record& rec, edge_buffer) {
+            ++in_degree[rec.target];
+          }
+          edge_buffers.push_back(edge_buffer_type());
+          edge_buffers.back().swap(edge_buffer);
+        }
+      }
+
+      size_t nhigh_edges = 0;
+      const procid_t procid = base_type::rpc.procid();
+      const procid_t numprocs = base_type::rpc.numprocs();
+      for (size_t i = 0; i < edge_buffers.size(); ++i) {
+        foreach(const edge_buffer_record& rec, edge_buffers[i]) {
+          procid_t owning_proc = procid;
+          if (in_degree[rec.target] > threshold) {
+            owning_proc = graph_hash::hash_vertex(rec.source) % numprocs;
+            ++nhigh_edges;
+          }
+          base_type::edge_exchange.send(owning_proc, rec);
+        }
+        edge_buffer_type().swap(edge_buffers[i]);
+      }
+      edge_buffers.clear();
+
+      size_t nhigh_vertices = 0;
+      typedef typename boost::unordered_map<vertex_id_type, size_t>::value_type
+        degree_pair_type;
+      foreach(const degree_pair_type& pair, in_degree) {
+        if (pair.second > threshold) ++nhigh_vertices;
+      }
+      in_degree.clear();
+
+      base_type::rpc.all_reduce(nhigh_vertices);
+      base_type::rpc.all_reduce(nhigh_edges);
+      if (procid == 0) {
+        logstream(LOG_EMPH) << "Hybrid ingress: " << nhigh_vertices 
+                            << " high-degree vertices (in-degree > " << threshold
+                            << ") with " << nhigh_edges 
+                            << " vertex-cut edges" << std::endl;
+      }
+      base_type::finalize();
+    }
+  }; // end of distributed_hybrid_ingress
+}; // end of namespace graphlab
+#include <graphlab/macros_undef.hpp>
+
+
+#endif
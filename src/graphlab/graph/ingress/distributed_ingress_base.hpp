@@ -22,6 +22,8 @@
 #ifndef GRAPHLAB_DISTRIBUTED_INGRESS_BASE_HPP
 #define GRAPHLAB_DISTRIBUTED_INGRESS_BASE_HPP
 
+#include <algorithm>
+#include <vector>
 #include <graphlab/graph/distributed_graph.hpp>
 #include <graphlab/graph/graph_basic_types.hpp>
 #include <graphlab/graph/graph_hash.hpp>
@@ -81,6 +83,15 @@ namespace graphlab {
       void save(oarchive& arc) const { arc << source << target << edata; }
     };
     buffered_exchange<edge_buffer_record> edge_exchange;
+    /// Bytes sent by the exchanges up to the previous finalize
+    size_t last_bytes_sent;
+
+    /// A sorted list of vertex ids, delta coded on the wire
+    struct sorted_vid_list {
+      std::vector<vertex_id_type> vids;
+      void load(iarchive& arc) { deserialize_sorted_ids(arc, vids); }
+      void save(oarchive& arc) const { serialize_sorted_ids(arc, vids); }
+    };
 
     /// Detail vertex record for the second pass coordination. 
     struct vertex_negotiator_record {
@@ -120,7 +131,7 @@ namespace graphlab {
 #else
       vertex_exchange(dc), edge_exchange(dc),
 #endif
-      edge_decision(dc) {
+      last_bytes_sent(0), edge_decision(dc) {
       rpc.barrier();
     } // end of constructor
 
@@ -152,6 +163,14 @@ namespace graphlab {
     } // end of add vertex
 
 
+    /** \brief Serializes the vertices and edges shuffled between machines
+     * in compact mode, with vertex ids as varints. */
+    void set_compact_exchange(bool compact) {
+      vertex_exchange.set_compact(compact);
+      edge_exchange.set_compact(compact);
+    }
+
+
     void set_duplicate_vertex_strategy(
         boost::function<void(vertex_data_type&,
                              const vertex_data_type&)> combine_strategy) {
@@ -234,6 +253,20 @@ namespace graphlab {
       /**************************************************************************/
       edge_exchange.flush(); vertex_exchange.flush();     
 
+      {
+        const size_t bytes_sent =
+          edge_exchange.bytes_sent() + vertex_exchange.bytes_sent();
+        // the exchanges count over all finalizes
+        size_t nbytes = bytes_sent - last_bytes_sent;
+        last_bytes_sent = bytes_sent;
+        rpc.all_reduce(nbytes);
+        if (rpc.procid() == 0) {
+          logstream(LOG_INFO) << "Graph Finalize: " << nbytes << " bytes shuffled"
+                              << (edge_exchange.is_compact() ? " (compact)" : "")
+                              << std::endl;
+        }
+      }
+
       /**
        * Fast pass for redundant finalization with no graph changes. 
        */
@@ -381,23 +414,35 @@ namespace graphlab {
       /**************************************************************************/
       {
 #ifdef _OPENMP
-        buffered_exchange<vertex_id_type> vid_buffer(rpc.dc(), omp_get_max_threads());
+        buffered_exchange<sorted_vid_list> vid_buffer(rpc.dc(), omp_get_max_threads());
 #else
-        buffered_exchange<vertex_id_type> vid_buffer(rpc.dc());
+        buffered_exchange<sorted_vid_list> vid_buffer(rpc.dc());
 #endif
 
+        // send not owned vids to their master, as one sorted list per
+        // master and thread so that they are delta coded
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+          std::vector<sorted_vid_list> vid_lists(rpc.numprocs());
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp for
 #endif
-        // send not owned vids to their master
-        for (lvid_type i = lvid_start; i < graph.lvid2record.size(); ++i) {
-          procid_t master = graph.lvid2record[i].owner;
-          if (master != rpc.procid())
+          for (lvid_type i = lvid_start; i < graph.lvid2record.size(); ++i) {
+            procid_t master = graph.lvid2record[i].owner;
+            if (master != rpc.procid())
+              vid_lists[master].vids.push_back(graph.lvid2record[i].gvid);
+          }
+          for (procid_t proc = 0; proc < rpc.numprocs(); ++proc) {
+            if (vid_lists[proc].vids.empty()) continue;
+            std::sort(vid_lists[proc].vids.begin(), vid_lists[proc].vids.end());
 #ifdef _OPENMP
-            vid_buffer.send(master, graph.lvid2record[i].gvid, omp_get_thread_num());
+            vid_buffer.send(proc, vid_lists[proc], omp_get_thread_num());
 #else
-            vid_buffer.send(master, graph.lvid2record[i].gvid);
+            vid_buffer.send(proc, vid_lists[proc]);
 #endif
+          }
         }
         vid_buffer.flush();
         rpc.barrier();
@@ -405,28 +450,32 @@ namespace graphlab {
         // receive all vids owned by me
         mutex flying_vids_lock;
         boost::unordered_map<vertex_id_type, mirror_type> flying_vids;
+        // mirror_type is not thread safe. Updates of the vertex records
+        // are serialized by a lock striped over the lvids.
+        std::vector<simple_spinlock> mirror_locks(MIRROR_LOCK_STRIPES);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
-          typename buffered_exchange<vertex_id_type>::buffer_type buffer;
+          typename buffered_exchange<sorted_vid_list>::buffer_type buffer;
           procid_t recvid;
           while(vid_buffer.recv(recvid, buffer)) {
-            foreach(const vertex_id_type vid, buffer) {
-              if (graph.vid2lvid.find(vid) == graph.vid2lvid.end()) {
-                if (vid2lvid_buffer.find(vid) == vid2lvid_buffer.end()) {
-                  flying_vids_lock.lock();
-                  mirror_type& mirrors = flying_vids[vid];
-                  flying_vids_lock.unlock();
-                  mirrors.set_bit(recvid);
+            foreach(const sorted_vid_list& list, buffer) {
+              foreach(const vertex_id_type vid, list.vids) {
+                if (graph.vid2lvid.find(vid) == graph.vid2lvid.end()) {
+                  if (vid2lvid_buffer.find(vid) == vid2lvid_buffer.end()) {
+                    flying_vids_lock.lock();
+                    flying_vids[vid].set_bit(recvid);
+                    flying_vids_lock.unlock();
+                  } else {
+                    lvid_type lvid = vid2lvid_buffer[vid];
+                    add_mirror(mirror_locks, lvid, recvid);
+                  }
                 } else {
-                  lvid_type lvid = vid2lvid_buffer[vid];
-                  graph.lvid2record[lvid]._mirrors.set_bit(recvid);
+                  lvid_type lvid = graph.vid2lvid[vid];
+                  add_mirror(mirror_locks, lvid, recvid);
+                  updated_lvids.set_bit(lvid);
                 }
-              } else {
-                lvid_type lvid = graph.vid2lvid[vid];
-                graph.lvid2record[lvid]._mirrors.set_bit(recvid);
-                updated_lvids.set_bit(lvid);
               }
             }
           }
@@ -556,6 +605,20 @@ namespace graphlab {
   private:
     boost::function<void(vertex_data_type&, const vertex_data_type&)> vertex_combine_strategy;
 
+    /// Number of locks protecting the mirror sets during finalize
+    static const size_t MIRROR_LOCK_STRIPES = 256;
+
+    /**
+     * \brief Adds proc to the mirrors of lvid, holding the lock stripe of lvid.
+     */
+    void add_mirror(std::vector<simple_spinlock>& mirror_locks,
+                    lvid_type lvid, procid_t proc) {
+      simple_spinlock& lock = mirror_locks[lvid % mirror_locks.size()];
+      lock.lock();
+      graph.lvid2record[lvid]._mirrors.set_bit(proc);
+      lock.unlock();
+    }
+
     /**
      * \brief Gather the vertex distributed meta data.
      */
@@ -25,6 +25,7 @@
 #include <graphlab/graph/distributed_graph.hpp>
 #include <graphlab/graph/graph_basic_types.hpp>
 #include <graphlab/graph/graph_hash.hpp>
+#include <graphlab/graph/mirror_set.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
 #include <graphlab/util/dense_bitset.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
@@ -39,7 +40,7 @@ namespace graphlab {
     public:
       typedef graphlab::vertex_id_type vertex_id_type;
       typedef distributed_graph<VertexData, EdgeData> graph_type;
-      typedef fixed_dense_bitset<RPC_MAX_N_PROCS> bin_counts_type; 
+      typedef mirror_set bin_counts_type; 
 
     public:
       /** \brief A decision object for computing the edge assingment. */
@@ -0,0 +1,306 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_MIRROR_SET_HPP
+#define GRAPHLAB_MIRROR_SET_HPP
+
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <boost/static_assert.hpp>
+#include <graphlab/rpc/dc_types.hpp>
+#include <graphlab/logger/assertions.hpp>
+#include <graphlab/serialization/iarchive.hpp>
+#include <graphlab/serialization/oarchive.hpp>
+
+namespace graphlab {
+
+  /**
+   * \brief A set of process ids whose size is only bounded by procid_t.
+   *
+   * Sets of at most INLINE_CAPACITY members, which covers most vertices
+   * of a well partitioned graph, are stored inline as a sorted list.
+   * Larger sets are stored as a heap allocated bitset which is just wide
+   * enough to hold the largest member. Either way the object itself
+   * takes 14 bytes, independent of the number of processes.
+   *
+   * The interface follows fixed_dense_bitset, which this replaces as
+   * the mirror set of the distributed graph. Unlike fixed_dense_bitset,
+   * modifications are not atomic and must be synchronized by the caller.
+   */
+  class mirror_set {
+  public:
+    enum { INLINE_CAPACITY = 6 };
+
+    /// Iterates over the members in increasing order
+    struct const_iterator {
+      typedef std::forward_iterator_tag iterator_category;
+      typedef procid_t value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const procid_t reference;
+      typedef const procid_t* pointer;
+      const mirror_set* set;
+      // index into the inline list, or bit position of the bitset
+      size_t pos;
+      const_iterator(): set(NULL), pos(-1) { }
+      const_iterator(const mirror_set* set, size_t pos): set(set), pos(pos) { }
+
+      procid_t operator*() const {
+        return set->is_inline() ? set->procs[pos] : procid_t(pos);
+      }
+      const_iterator& operator++() {
+        pos = set->next(pos);
+        return *this;
+      }
+      const_iterator operator++(int) {
+        const_iterator prev = *this;
+        pos = set->next(pos);
+        return prev;
+      }
+      bool operator==(const const_iterator& other) const {
+        return pos == other.pos;
+      }
+      bool operator!=(const const_iterator& other) const {
+        return pos != other.pos;
+      }
+    };
+    typedef const_iterator iterator;
+
+    mirror_set(): nelems(0) { }
+
+    mirror_set(const mirror_set& other): nelems(0) {
+      *this = other;
+    }
+
+    ~mirror_set() {
+      clear();
+    }
+
+    mirror_set& operator=(const mirror_set& other) {
+      if (this == &other) return *this;
+      clear();
+      if (other.is_inline()) {
+        memcpy(procs, other.procs, sizeof(procs));
+      } else {
+        const size_t* other_words = other.words();
+        size_t* new_words = new size_t[other_words[0] + 1];
+        memcpy(new_words, other_words, sizeof(size_t) * (other_words[0] + 1));
+        set_words(new_words);
+      }
+      nelems = other.nelems;
+      return *this;
+    }
+
+    /// Removes all members
+    inline void clear() {
+      if (!is_inline()) delete [] words();
+      nelems = 0;
+    }
+
+    inline bool empty() const {
+      return nelems == 0;
+    }
+
+    /// Returns the number of members
+    inline size_t popcount() const {
+      return nelems;
+    }
+
+    /// Returns true if p is a member
+    inline bool get(size_t p) const {
+      if (is_inline()) {
+        for (size_t i = 0; i < nelems; ++i) if (procs[i] == p) return true;
+        return false;
+      }
+      const size_t* w = words();
+      const size_t word = p / WORD_BITS;
+      return word < w[0] && (w[word + 1] & (size_t(1) << (p % WORD_BITS)));
+    }
+
+    /// Adds p to the set returning true if it was already a member
+    bool set_bit(size_t p) {
+      ASSERT_LT(p, size_t(procid_t(-1)));
+      if (get(p)) return true;
+      if (is_inline() && nelems < INLINE_CAPACITY) {
+        size_t i = nelems;
+        for (; i > 0 && procs[i - 1] > p; --i) procs[i] = procs[i - 1];
+        procs[i] = procid_t(p);
+      } else {
+        if (is_inline()) to_bitset(std::max<size_t>(p, procs[nelems - 1]));
+        size_t* w = words();
+        if (p / WORD_BITS >= w[0]) w = grow(p);
+        w[p / WORD_BITS + 1] |= size_t(1) << (p % WORD_BITS);
+      }
+      ++nelems;
+      return false;
+    }
+
+    /// Removes p from the set returning true if it was a member
+    bool clear_bit(size_t p) {
+      if (!get(p)) return false;
+      if (is_inline()) {
+        size_t i = 0;
+        while (procs[i] != p) ++i;
+        for (; i + 1 < nelems; ++i) procs[i] = procs[i + 1];
+        --nelems;
+      } else {
+        size_t* w = words();
+        w[p / WORD_BITS + 1] &= ~(size_t(1) << (p % WORD_BITS));
+        --nelems;
+        if (nelems == INLINE_CAPACITY) to_inline(w);
+      }
+      return true;
+    }
+
+    mirror_set& operator|=(const mirror_set& other) {
+      for (const_iterator it = other.begin(); it != other.end(); ++it) {
+        set_bit(*it);
+      }
+      return *this;
+    }
+
+    bool operator==(const mirror_set& other) const {
+      if (nelems != other.nelems) return false;
+      for (const_iterator it = other.begin(); it != other.end(); ++it) {
+        if (!get(*it)) return false;
+      }
+      return true;
+    }
+
+    bool operator!=(const mirror_set& other) const {
+      return !(*this == other);
+    }
+
+    const_iterator begin() const {
+      if (nelems == 0) return end();
+      return const_iterator(this, is_inline() ? 0 : next_bit(0));
+    }
+
+    const_iterator end() const {
+      return const_iterator(this, size_t(-1));
+    }
+
+    /// Serializes the members as a list of process ids
+    void save(oarchive& oarc) const {
+      oarc << nelems;
+      for (const_iterator it = begin(); it != end(); ++it) {
+        oarc << procid_t(*it);
+      }
+    }
+
+    void load(iarchive& iarc) {
+      clear();
+      uint16_t n;
+      iarc >> n;
+      for (size_t i = 0; i < n; ++i) {
+        procid_t p;
+        iarc >> p;
+        set_bit(p);
+      }
+    }
+
+  private:
+    enum { WORD_BITS = 8 * sizeof(size_t) };
+
+    /* Number of members. With more than INLINE_CAPACITY members, procs
+     * holds a pointer to an array whose first word is the number of
+     * bitset words that follow it. */
+    uint16_t nelems;
+    procid_t procs[INLINE_CAPACITY];
+    BOOST_STATIC_ASSERT(sizeof(size_t*) <= INLINE_CAPACITY * sizeof(procid_t));
+
+    inline bool is_inline() const {
+      return nelems <= INLINE_CAPACITY;
+    }
+
+    inline size_t* words() const {
+      size_t* w;
+      memcpy(&w, procs, sizeof(w));
+      return w;
+    }
+
+    inline void set_words(size_t* w) {
+      memcpy(procs, &w, sizeof(w));
+    }
+
+    static size_t* allocate_words(size_t max_member) {
+      const size_t nwords = max_member / WORD_BITS + 1;
+      size_t* w = new size_t[nwords + 1];
+      memset(w, 0, sizeof(size_t) * (nwords + 1));
+      w[0] = nwords;
+      return w;
+    }
+
+    // Moves the inline members into a bitset which can hold max_member
+    void to_bitset(size_t max_member) {
+      size_t* w = allocate_words(max_member);
+      for (size_t i = 0; i < nelems; ++i) {
+        w[procs[i] / WORD_BITS + 1] |= size_t(1) << (procs[i] % WORD_BITS);
+      }
+      set_words(w);
+    }
+
+    // Moves the members of the bitset w back inline. nelems must already
+    // be INLINE_CAPACITY or less.
+    void to_inline(size_t* w) {
+      size_t i = 0;
+      for (size_t word = 0; word < w[0]; ++word) {
+        size_t bits = w[word + 1];
+        while (bits) {
+          procs[i++] = procid_t(word * WORD_BITS + __builtin_ctzl(bits));
+          bits &= bits - 1;
+        }
+      }
+      delete [] w;
+    }
+
+    size_t* grow(size_t max_member) {
+      size_t* w = words();
+      size_t* new_words = allocate_words(max_member);
+      memcpy(new_words + 1, w + 1, sizeof(size_t) * w[0]);
+      delete [] w;
+      set_words(new_words);
+      return new_words;
+    }
+
+    // Returns the first member at or after bit b, or -1 if there is none
+    size_t next_bit(size_t b) const {
+      const size_t* w = words();
+      size_t word = b / WORD_BITS;
+      if (word >= w[0]) return size_t(-1);
+      size_t bits = w[word + 1] & (size_t(-1) << (b % WORD_BITS));
+      while (bits == 0) {
+        if (++word >= w[0]) return size_t(-1);
+        bits = w[word + 1];
+      }
+      return word * WORD_BITS + __builtin_ctzl(bits);
+    }
+
+    // Returns the iterator position following pos
+    size_t next(size_t pos) const {
+      if (is_inline()) return (pos + 1 < nelems) ? pos + 1 : size_t(-1);
+      return next_bit(pos + 1);
+    }
+  };
+
+} // namespace graphlab
+#endif
@@ -36,6 +36,10 @@ size_t fiber_control::instance_construct_params_nworkers = 0;
 size_t fiber_control::instance_construct_params_affinity_base = 0;
 pthread_key_t fiber_control::tlskey;
 
+// Maximum number of queued fibers a thief inspects looking for one
+// whose affinity allows it to run on the thief.
+static const size_t STEAL_SCAN_LIMIT = 16;
+
 fiber_control::affinity_type fiber_control::all_affinity() {
   affinity_type ret;
   ret.fill();
@@ -47,6 +51,9 @@ fiber_control::fiber_control(size_t nworkers,
     :nworkers(nworkers),
     affinity_base(affinity_base),
     stop_workers(false),
+    work_stealing(true),
+    steal_idle_wait_ms(0),
+    stack_pool(nworkers),
     flsdeleter(NULL) {
   // initialize the thread local storage keys
   if (!tls_created) {
@@ -54,6 +61,9 @@ fiber_control::fiber_control(size_t nworkers,
     tls_created = true;
   }
 
+  char* c_steal_wait = getenv("GRAPHLAB_FIBER_STEAL_WAIT_MS");
+  if (c_steal_wait != NULL) steal_idle_wait_ms = atoi(c_steal_wait);
+
   // set up the queues.
   schedule.resize(nworkers);
   for (size_t i = 0;i < nworkers; ++i) {
@@ -122,6 +132,9 @@ void fiber_control::active_queue_insert_tail(size_t workerid, fiber_control::fib
       schedule[workerid].active_lock.lock();
       schedule[workerid].active_cond.signal();
       schedule[workerid].active_lock.unlock();
+    } else if (work_stealing &&
+               schedule[workerid].affinity_queue->approx_size() > 1) {
+      wake_idle_worker();
     }
   }
 }
@@ -136,6 +149,9 @@ void fiber_control::active_queue_insert_head(size_t workerid, fiber_control::fib
       schedule[workerid].active_lock.lock();
       schedule[workerid].active_cond.signal();
       schedule[workerid].active_lock.unlock();
+    } else if (work_stealing &&
+               schedule[workerid].priority_queue->approx_size() > 1) {
+      wake_idle_worker();
     }
   }
 }
@@ -163,13 +179,97 @@ fiber_control::fiber* fiber_control::try_pop_queue(inplace_lf_queue2<fiber>& lfq
   return ret;
 }
 
+fiber_control::fiber* fiber_control::try_steal_queue(inplace_lf_queue2<fiber>& lfqueue,
+                                                     fiber*& popped_queue,
+                                                     size_t thief) {
+  if (popped_queue == NULL) {
+    popped_queue = lfqueue.dequeue_all();
+  }
+  fiber_control::fiber* prev = NULL;
+  fiber_control::fiber* cur = popped_queue;
+  for (size_t i = 0; cur != NULL && i < STEAL_SCAN_LIMIT; ++i) {
+    // wait for a concurrent enqueue to link the next pointer
+    fiber_control::fiber* next = NULL;
+    do {
+      next = cur->next;
+      asm volatile("pause\n": : :"memory");
+    } while(next == NULL);
+    const bool last = (next == lfqueue.end_of_dequeue_list());
+    if (cur->affinity.get(thief)) {
+      // unlink cur. If it was the last element, prev now points to the
+      // end of the list.
+      if (prev == NULL) popped_queue = last ? NULL : next;
+      else prev->next = next;
+      return cur;
+    }
+    if (last) break;
+    prev = cur;
+    cur = next;
+  }
+  return NULL;
+}
+
+fiber_control::fiber* fiber_control::try_steal(size_t workerid) {
+  if (nworkers <= 1) return NULL;
+  size_t start = graphlab::random::fast_uniform<size_t>(0, nworkers - 1);
+  for (size_t i = 0;i < nworkers; ++i) {
+    size_t victim = (start + i) % nworkers;
+    if (victim == workerid) continue;
+    thread_schedule& ts = schedule[victim];
+    if (ts.popped_priority_queue == NULL && ts.priority_queue->empty() &&
+        ts.popped_affinity_queue == NULL && ts.affinity_queue->empty()) continue;
+    // do not wait on a contended victim, try the next one
+    if (!ts.queue_lock.try_lock()) continue;
+    fiber_control::fiber* ret =
+        try_steal_queue(*ts.priority_queue, ts.popped_priority_queue, workerid);
+    if (ret == NULL) {
+      ret = try_steal_queue(*ts.affinity_queue, ts.popped_affinity_queue, workerid);
+    }
+    ts.queue_lock.unlock();
+    if (ret) {
+      schedule[workerid].nsteals.inc();
+      return ret;
+    }
+  }
+  return NULL;
+}
+
+void fiber_control::wake_idle_worker() {
+  if (active_workers.value >= nworkers) return;
+  // idle workers do not poll by default, so look for one that is waiting
+  size_t start = graphlab::random::fast_uniform<size_t>(0, nworkers - 1);
+  for (size_t i = 0;i < nworkers; ++i) {
+    size_t choice = (start + i) % nworkers;
+    if (schedule[choice].waiting) {
+      schedule[choice].active_lock.lock();
+      schedule[choice].active_cond.signal();
+      schedule[choice].active_lock.unlock();
+      return;
+    }
+  }
+}
+
+size_t fiber_control::total_steals() const {
+  size_t ret = 0;
+  for (size_t i = 0;i < nworkers; ++i) ret += schedule[i].nsteals.value;
+  return ret;
+}
+
+size_t fiber_control::total_idle_waits() const {
+  size_t ret = 0;
+  for (size_t i = 0;i < nworkers; ++i) ret += schedule[i].nidle.value;
+  return ret;
+}
+
 fiber_control::fiber* fiber_control::active_queue_remove(size_t workerid) {
   fiber_control::fiber* ret = NULL;
   thread_schedule& curts = schedule[workerid];
+  curts.queue_lock.lock();
   ret = try_pop_queue(*curts.priority_queue, curts.popped_priority_queue);
   if (ret == NULL) {
     ret = try_pop_queue(*curts.affinity_queue , curts.popped_affinity_queue);
   }
+  curts.queue_lock.unlock();
   if (ret) {
     // printf("%ld: Running %ld\n", get_worker_id(), ret->id);
   }
@@ -216,6 +316,7 @@ void fiber_control::worker_init(size_t workerid) {
   while(!stop_workers) {
     // get a fiber to run
     fiber* next_fib = t->parent->active_queue_remove(workerid);
+    if (next_fib == NULL && work_stealing) next_fib = try_steal(workerid);
     if (next_fib != NULL) {
       // if there is a fiber. yield to it
       schedule[workerid].active_lock.unlock();
@@ -233,7 +334,14 @@ void fiber_control::worker_init(size_t workerid) {
       schedule[workerid].active_lock.lock();
     } else {
       // if there is no fiber. wait.
-      schedule[workerid].active_cond.wait(schedule[workerid].active_lock);
+      schedule[workerid].nidle.inc();
+      if (work_stealing && steal_idle_wait_ms > 0) {
+        // wake up periodically to look for work on the other workers
+        schedule[workerid].active_cond.timedwait_ms(schedule[workerid].active_lock,
+                                                    steal_idle_wait_ms);
+      } else {
+        schedule[workerid].active_cond.wait(schedule[workerid].active_lock);
+      }
     }
   }
   schedule[workerid].active_lock.unlock();
@@ -272,7 +380,8 @@ size_t fiber_control::launch(boost::function<void(void)> fn,
   // allocate a stack
   fiber* fib = new fiber;
   fib->parent = this;
-  fib->stack = malloc(stacksize);
+  fib->stacksize = stacksize;
+  fib->stack = stack_pool.allocate(fib->stacksize, get_worker_id());
   fib->id = fiber_id_counter.inc();
   foreach(size_t b, affinity) {
     if (b < nworkers) fib->affinity_array.push_back((unsigned char)b);
@@ -280,7 +389,7 @@ size_t fiber_control::launch(boost::function<void(void)> fn,
   }
   ASSERT_GT(fib->affinity_array.size(), 0);
   fib->affinity = affinity;
-  //VALGRIND_STACK_REGISTER(fib->stack, (char*)fib->stack + stacksize);
+  //VALGRIND_STACK_REGISTER(fib->stack, (char*)fib->stack + fib->stacksize);
   fib->fls = NULL;
   fib->next = NULL;
   fib->deschedule_lock = NULL;
@@ -292,8 +401,8 @@ size_t fiber_control::launch(boost::function<void(void)> fn,
   args->fn = fn;
   fib->initial_trampoline_args = (intptr_t)(args);
   // stack grows downwards.
-  fib->context = boost::context::make_fcontext((char*)fib->stack + stacksize,
-                                               stacksize,
+  fib->context = boost::context::make_fcontext((char*)fib->stack + fib->stacksize,
+                                               fib->stacksize,
                                                trampoline);
   fibers_active.inc();
 
@@ -404,7 +513,7 @@ void fiber_control::reschedule_fiber(size_t workerid, fiber* fib) {
   } else if (fib->terminate) {
     fib->lock.unlock();
     // previous fiber is dead. destroy it
-    free(fib->stack);
+    stack_pool.release(fib->stack, fib->stacksize, get_worker_id());
     //VALGRIND_STACK_DEREGISTER(fib->stack);
     // delete the fiber local storage if any
     if (fib->fls && flsdeleter) flsdeleter(fib->fls);
@@ -33,6 +33,7 @@
 #include <graphlab/util/inplace_lf_queue2.hpp>
 #include <graphlab/parallel/pthread_tools.hpp>
 #include <graphlab/parallel/atomic.hpp>
+#include <graphlab/parallel/fiber_stack_pool.hpp>
 namespace graphlab {
 
 /**
@@ -49,6 +50,7 @@ class fiber_control {
     fiber_control* parent;
     boost::context::fcontext_t* context;
     void* stack;
+    size_t stacksize;
     size_t id;
     affinity_type affinity;
     std::vector<unsigned char> affinity_array;
@@ -86,14 +88,26 @@ class fiber_control {
   conditional join_cond;
 
   bool stop_workers;
+  // if set, idle workers steal fibers from the queues of other workers
+  bool work_stealing;
+  // if non-zero, idle workers also look for fibers to steal this often
+  size_t steal_idle_wait_ms;
 
   // The scheduler is a simple queue. One for each worker
   struct thread_schedule {
-    thread_schedule():waiting(false) { }
+    thread_schedule():waiting(false), nsteals(0), nidle(0) { }
     mutex active_lock;
     conditional active_cond;
     volatile bool waiting;
     size_t nwaiting;
+    // number of fibers this worker stole from other workers. Only
+    // written by the worker, but read by the others.
+    atomic<size_t> nsteals;
+    // number of times this worker found no fiber to run and waited
+    atomic<size_t> nidle;
+    // guards dequeue_all() and the popped lists below, since thieves
+    // also pop from them
+    simple_spinlock queue_lock;
     // a queue of fibers to evaluate before those in the thread_queue
     inplace_lf_queue2<fiber>* affinity_queue;
     fiber* popped_affinity_queue;
@@ -102,6 +116,8 @@ class fiber_control {
     fiber* popped_priority_queue;
   };
   std::vector<thread_schedule> schedule;
+  // recycles the guard-paged fiber stacks
+  fiber_stack_pool stack_pool;
 
   thread_group workers;
 
@@ -111,6 +127,10 @@ class fiber_control {
   void active_queue_insert_tail(size_t workerid, fiber* value);
   void active_queue_insert_tail(fiber* value);
   fiber* active_queue_remove(size_t workerid);
+  // steals a fiber which may run on workerid from another worker
+  fiber* try_steal(size_t workerid);
+  // wakes an idle worker so it can steal from a busy one
+  void wake_idle_worker();
 
   // a thread local storage for the worker to point to a fiber
   static bool tls_created;
@@ -135,6 +155,11 @@ class fiber_control {
 
   /// Gets a fiber from the lock-free / popped pair
   fiber* try_pop_queue(inplace_lf_queue2<fiber>& lfqueue, fiber*& popped_queue);
+
+  /// Unlinks the first fiber in the lock-free / popped pair which may run
+  /// on the thief worker
+  fiber* try_steal_queue(inplace_lf_queue2<fiber>& lfqueue, fiber*& popped_queue,
+                         size_t thief);
   /// The function that each worker thread starts off running
   void worker_init(size_t workerid);
 
@@ -147,7 +172,7 @@ class fiber_control {
   size_t pick_fiber_worker(fiber* fib);
 
   // delete copy constructor
-  fiber_control(fiber_control&) {};
+  fiber_control(fiber_control&) : stack_pool(0) {};
   
  public:
 
@@ -191,6 +216,76 @@ class fiber_control {
   inline size_t total_threads_created() {
     return fiber_id_counter.value;
   }
+
+  /**
+   * Enables or disables work stealing. When enabled (the default), an
+   * idle worker takes runnable fibers from the queues of other workers,
+   * provided the affinity of the fiber allows it to run on the idle
+   * worker.
+   */
+  void set_work_stealing(bool enabled) {
+    work_stealing = enabled;
+  }
+
+  /**
+   * With work stealing, idle workers are woken up when fibers queue up
+   * on a busy worker. If ms is non-zero, idle workers also wake up every
+   * ms milliseconds to look for fibers to steal. This is off by default,
+   * since the wakeups cost CPU time on idle machines. It can also be set
+   * with the environment variable GRAPHLAB_FIBER_STEAL_WAIT_MS.
+   */
+  void set_steal_idle_wait(size_t ms) {
+    steal_idle_wait_ms = ms;
+  }
+
+  /**
+   * Returns the number of fibers the worker stole from other workers
+   */
+  size_t worker_steals(size_t workerid) const {
+    return schedule[workerid].nsteals.value;
+  }
+
+  /**
+   * Returns the number of times the worker found nothing to run and waited
+   */
+  size_t worker_idle_waits(size_t workerid) const {
+    return schedule[workerid].nidle.value;
+  }
+
+  /**
+   * Returns the largest number of stack bytes used by a terminated fiber.
+   * Only measured if stack usage tracking is enabled, either through
+   * set_stack_usage_tracking() or by setting the environment variable
+   * GRAPHLAB_FIBER_STACK_USAGE=1.
+   */
+  size_t stack_high_water() const {
+    return stack_pool.high_water();
+  }
+
+  /**
+   * Enables or disables measuring the stack usage of terminating fibers
+   */
+  void set_stack_usage_tracking(bool enabled) {
+    stack_pool.set_usage_tracking(enabled);
+  }
+
+  /**
+   * Logs the number of mapped fiber stacks and their high-water usage
+   * for each stack size class
+   */
+  void log_stack_usage() const {
+    stack_pool.log_usage();
+  }
+
+  /**
+   * Returns the number of steals summed over all workers
+   */
+  size_t total_steals() const;
+
+  /**
+   * Returns the number of idle waits summed over all workers
+   */
+  size_t total_idle_waits() const;
   /**
    * Sets the TLS deletion function. The deletion function will be called
    * on every non-NULL TLS value.
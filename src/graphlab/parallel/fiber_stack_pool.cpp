@@ -0,0 +1,190 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <graphlab/parallel/fiber_stack_pool.hpp>
+#include <graphlab/parallel/atomic_ops.hpp>
+#include <graphlab/logger/assertions.hpp>
+namespace graphlab {
+
+fiber_stack_pool::fiber_stack_pool(size_t nworkers)
+    : page_size(sysconf(_SC_PAGESIZE)),
+    track_usage(false),
+    worker_lists(nworkers),
+    unpooled_high_water(0) {
+  for (size_t i = 0;i < NUM_SIZE_CLASSES; ++i) class_high_water[i] = 0;
+  char* c_usage = getenv("GRAPHLAB_FIBER_STACK_USAGE");
+  if (c_usage != NULL && strcmp(c_usage, "1") == 0) track_usage = true;
+}
+
+fiber_stack_pool::~fiber_stack_pool() {
+  for (size_t c = 0;c < NUM_SIZE_CLASSES; ++c) {
+    const size_t stacksize = page_size << c;
+    for (size_t i = 0;i < worker_lists.size(); ++i) {
+      for (size_t j = 0;j < worker_lists[i].stacks[c].size(); ++j) {
+        unmap_stack(worker_lists[i].stacks[c][j], stacksize);
+      }
+    }
+    for (size_t j = 0;j < shared_lists.stacks[c].size(); ++j) {
+      unmap_stack(shared_lists.stacks[c][j], stacksize);
+    }
+  }
+}
+
+size_t fiber_stack_pool::size_class(size_t stacksize) const {
+  size_t c = 0;
+  while(c < NUM_SIZE_CLASSES && (page_size << c) < stacksize) ++c;
+  return c;
+}
+
+void* fiber_stack_pool::map_stack(size_t stacksize) {
+  // one extra page below the stack (stacks grow down) as the guard
+  void* base = mmap(NULL, stacksize + page_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    logstream(LOG_FATAL) << "Unable to map a fiber stack of " << stacksize
+                         << " bytes: " << strerror(errno) << std::endl;
+  }
+  if (mprotect(base, page_size, PROT_NONE) != 0) {
+    logstream(LOG_FATAL) << "Unable to protect the fiber stack guard page: "
+                         << strerror(errno) << std::endl;
+  }
+  nmapped.inc();
+  return (char*)base + page_size;
+}
+
+void fiber_stack_pool::unmap_stack(void* stack, size_t stacksize) {
+  munmap((char*)stack - page_size, stacksize + page_size);
+  nmapped.dec();
+}
+
+void fiber_stack_pool::trim_stack(void* stack, size_t stacksize) {
+  const size_t resident = RESIDENT_STACK_PAGES * page_size;
+  if (stacksize <= resident) return;
+  // the stack grows down, so the pages in use first are at the top
+  madvise(stack, stacksize - resident, MADV_DONTNEED);
+}
+
+void* fiber_stack_pool::allocate(size_t& stacksize, size_t workerid) {
+  const size_t c = size_class(stacksize);
+  if (c == NUM_SIZE_CLASSES) {
+    stacksize = (stacksize + page_size - 1) / page_size * page_size;
+    return map_stack(stacksize);
+  }
+  stacksize = page_size << c;
+  // worker lists are only touched by the thread running the worker
+  if (workerid < worker_lists.size() && !worker_lists[workerid].stacks[c].empty()) {
+    void* ret = worker_lists[workerid].stacks[c].back();
+    worker_lists[workerid].stacks[c].pop_back();
+    return ret;
+  }
+  void* ret = NULL;
+  shared_lock.lock();
+  if (!shared_lists.stacks[c].empty()) {
+    ret = shared_lists.stacks[c].back();
+    shared_lists.stacks[c].pop_back();
+  }
+  shared_lock.unlock();
+  if (ret == NULL) {
+    ret = map_stack(stacksize);
+    class_mapped[c].inc();
+  }
+  return ret;
+}
+
+void fiber_stack_pool::release(void* stack, size_t stacksize, size_t workerid) {
+  const size_t c = size_class(stacksize);
+  if (track_usage) {
+    update_high_water(c == NUM_SIZE_CLASSES ? unpooled_high_water : class_high_water[c],
+                      measure_usage(stack, stacksize));
+  }
+  if (c == NUM_SIZE_CLASSES) {
+    unmap_stack(stack, stacksize);
+    return;
+  }
+  trim_stack(stack, stacksize);
+  if (workerid < worker_lists.size() &&
+      worker_lists[workerid].stacks[c].size() < MAX_POOLED_STACKS) {
+    worker_lists[workerid].stacks[c].push_back(stack);
+    return;
+  }
+  bool pooled = false;
+  shared_lock.lock();
+  if (shared_lists.stacks[c].size() < MAX_POOLED_STACKS) {
+    shared_lists.stacks[c].push_back(stack);
+    pooled = true;
+  }
+  shared_lock.unlock();
+  if (!pooled) {
+    unmap_stack(stack, stacksize);
+    class_mapped[c].dec();
+  }
+}
+
+size_t fiber_stack_pool::measure_usage(void* stack, size_t stacksize) const {
+  const size_t npages = stacksize / page_size;
+  std::vector<unsigned char> resident(npages);
+  if (mincore(stack, stacksize, &resident[0]) != 0) return 0;
+  // the stack grows down, so the lowest resident page bounds the usage
+  for (size_t i = 0;i < npages; ++i) {
+    if (resident[i] & 1) return (npages - i) * page_size;
+  }
+  return 0;
+}
+
+void fiber_stack_pool::update_high_water(size_t& high_water, size_t usage) {
+  size_t prev = high_water;
+  while(usage > prev && !atomic_compare_and_swap(high_water, prev, usage)) {
+    prev = high_water;
+  }
+}
+
+size_t fiber_stack_pool::high_water() const {
+  size_t ret = unpooled_high_water;
+  for (size_t c = 0;c < NUM_SIZE_CLASSES; ++c) {
+    ret = std::max(ret, class_high_water[c]);
+  }
+  return ret;
+}
+
+void fiber_stack_pool::log_usage() const {
+  for (size_t c = 0;c < NUM_SIZE_CLASSES; ++c) {
+    if (class_mapped[c].value == 0 && class_high_water[c] == 0) continue;
+    std::stringstream strm;
+    strm << "Fiber stacks of " << (page_size << c) << " bytes: "
+         << class_mapped[c].value << " mapped";
+    if (track_usage) strm << ", high-water " << class_high_water[c] << " bytes";
+    logstream(LOG_INFO) << strm.str() << std::endl;
+  }
+  if (track_usage && unpooled_high_water > 0) {
+    logstream(LOG_INFO) << "Unpooled fiber stacks high-water: "
+                        << unpooled_high_water << " bytes" << std::endl;
+  }
+}
+
+}
@@ -0,0 +1,122 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+#ifndef GRAPHLAB_FIBER_STACK_POOL_HPP
+#define GRAPHLAB_FIBER_STACK_POOL_HPP
+#include <cstdlib>
+#include <vector>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+namespace graphlab {
+
+/**
+ * Allocates fiber stacks and recycles them between fibers.
+ *
+ * Stacks are mmap-ed, so pages are only committed when the fiber touches
+ * them, and each stack has a PROT_NONE guard page below it so that an
+ * overflow faults instead of corrupting a neighbouring allocation.
+ * Requested sizes are rounded up to a power of two number of pages
+ * (the size class). Released stacks are kept on a free list of the
+ * releasing worker, spill over to a shared list, and are unmapped once
+ * both are full. Stacks larger than the largest size class are not
+ * pooled. Only the top RESIDENT_STACK_PAGES pages of a pooled stack stay
+ * committed: the pages below are returned to the kernel with
+ * madvise(MADV_DONTNEED), so a fiber which once recursed deeply does not
+ * pin its memory in the pool.
+ *
+ * If the environment variable GRAPHLAB_FIBER_STACK_USAGE is set to 1,
+ * the number of touched bytes of every released stack is measured with
+ * mincore() and the high-water mark of each size class is reported by
+ * log_usage(). This is meant for tuning the number of fibers and the
+ * stack sizes of the engines.
+ */
+class fiber_stack_pool {
+ public:
+  /// Number of size classes: one page up to 2^(NUM_SIZE_CLASSES-1) pages
+  static const size_t NUM_SIZE_CLASSES = 12;
+  /// Maximum number of free stacks per size class in each list
+  static const size_t MAX_POOLED_STACKS = 64;
+  /// Number of pages at the top of a pooled stack which stay committed
+  static const size_t RESIDENT_STACK_PAGES = 4;
+
+  explicit fiber_stack_pool(size_t nworkers);
+  ~fiber_stack_pool();
+
+  /**
+   * Returns the lowest usable address of a stack of at least stacksize
+   * bytes. stacksize is rounded up to the size class on return.
+   * workerid may be (size_t)(-1) if not called from a worker.
+   */
+  void* allocate(size_t& stacksize, size_t workerid);
+
+  /**
+   * Returns a stack obtained from allocate(), with the rounded size,
+   * to the pool.
+   */
+  void release(void* stack, size_t stacksize, size_t workerid);
+
+  /// Enables or disables the measurement of stack usage on release
+  void set_usage_tracking(bool enabled) {
+    track_usage = enabled;
+  }
+
+  /// Returns the largest number of stack bytes used by any released fiber
+  size_t high_water() const;
+
+  /// Returns the number of currently mapped stacks (in use or pooled)
+  size_t num_mapped() const {
+    return nmapped.value;
+  }
+
+  /// Logs the mapped stacks and high-water mark of each size class
+  void log_usage() const;
+
+ private:
+  struct free_lists_type {
+    std::vector<void*> stacks[NUM_SIZE_CLASSES];
+  };
+  size_t page_size;
+  bool track_usage;
+  std::vector<free_lists_type> worker_lists;
+  free_lists_type shared_lists;
+  simple_spinlock shared_lock;
+  atomic<size_t> nmapped;
+  atomic<size_t> class_mapped[NUM_SIZE_CLASSES];
+  size_t class_high_water[NUM_SIZE_CLASSES];
+  size_t unpooled_high_water;
+
+  /// Returns the size class of the stack, or NUM_SIZE_CLASSES if too large
+  size_t size_class(size_t stacksize) const;
+  void* map_stack(size_t stacksize);
+  void unmap_stack(void* stack, size_t stacksize);
+  /// Releases the pages below the top RESIDENT_STACK_PAGES pages
+  void trim_stack(void* stack, size_t stacksize);
+  /// Returns the number of bytes of the stack the fiber touched
+  size_t measure_usage(void* stack, size_t stacksize) const;
+  void update_high_water(size_t& high_water, size_t usage);
+
+  // not copyable
+  fiber_stack_pool(const fiber_stack_pool&);
+  void operator=(const fiber_stack_pool&);
+};
+
+}
+#endif
@@ -25,6 +25,7 @@
 #define GRAPHLAB_BUFFERED_EXCHANGE_HPP
 
 #include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
 #include <graphlab/parallel/fiber_control.hpp>
 #include <graphlab/rpc/dc.hpp>
 #include <graphlab/rpc/dc_dist_object.hpp>
@@ -63,6 +64,11 @@ namespace graphlab {
    * \note The buffered exchange sends data in the background, so recv can be
    * called even before the flush calls.
    *
+   * After set_compact(true) the values are serialized by archives in
+   * compact mode (see graphlab::oarchive), which writes integers such as
+   * vertex ids as varints. Each buffer records the mode it was written
+   * in, so the machines do not need to switch at the same time.
+   *
    * \see graphlab::fiber_buffered_exchange
    */
   template<typename T>
@@ -95,6 +101,8 @@ namespace graphlab {
     std::vector< mutex >  send_locks;
     const size_t num_threads;
     const size_t max_buffer_size;
+    bool compact;
+    atomic<size_t> nbytes_sent;
 
 
     // typedef boost::function<void (const T& tref)> handler_type;
@@ -119,14 +127,14 @@ namespace graphlab {
       send_buffers(num_threads *  dc.numprocs()),
       send_locks(num_threads *  dc.numprocs()),
       num_threads(num_threads),
-      max_buffer_size(max_buffer_size) {
+      max_buffer_size(max_buffer_size),
+      compact(false), nbytes_sent(0) {
        //
        for (size_t i = 0;i < send_buffers.size(); ++i) {
          // initialize the split call
          send_buffers[i].oarc = rpc.split_call_begin(&buffered_exchange::rpc_recv);
          send_buffers[i].numinserts = 0;
-         // begin by writing the src proc.
-         (*(send_buffers[i].oarc)) << rpc.procid();
+         begin_buffer(send_buffers[i].oarc);
        }
        rpc.barrier();
       }
@@ -144,6 +152,40 @@ namespace graphlab {
     // max_buffer_size(buffer_size), recv_handler(recv_handler) { rpc.barrier(); }
 
 
+    /**
+     * Serializes the values sent from now on in compact mode, which
+     * writes integers as varints. Must not be called concurrently with
+     * send().
+     */
+    void set_compact(bool value) {
+      if (value == compact) return;
+      compact = value;
+      for (size_t i = 0; i < send_buffers.size(); ++i) {
+        send_locks[i].lock();
+        if (send_buffers[i].numinserts > 0) {
+          const procid_t proc = i % rpc.numprocs();
+          oarchive* prevarc = swap_buffer(i);
+          rpc.split_call_end(proc, prevarc);
+        } else {
+          // only the header has been written
+          rpc.split_call_cancel(send_buffers[i].oarc);
+          send_buffers[i].oarc =
+            rpc.split_call_begin(&buffered_exchange::rpc_recv);
+          begin_buffer(send_buffers[i].oarc);
+        }
+        send_locks[i].unlock();
+      }
+    }
+
+    /// Returns true if the values are serialized in compact mode
+    bool is_compact() const { return compact; }
+
+    /**
+     * Returns the number of bytes of the buffers sent by this machine,
+     * including those sent to itself.
+     */
+    size_t bytes_sent() const { return nbytes_sent.value; }
+
     /**
      * Sends a value to a target machine.
      * Use the send buffer owned by thread_id.
@@ -278,9 +320,13 @@ namespace graphlab {
     void rpc_recv(size_t len, wild_pointer w) {
       buffer_type tmp;
       iarchive iarc(reinterpret_cast<const char*>(w.ptr), len);
+      // the values are received after the buffer is released
+      iarc.transient = true;
       // first desrialize the source process
       procid_t src_proc; iarc >> src_proc;
       ASSERT_LT(src_proc, rpc.numprocs());
+      // the sender's mode for the values
+      iarc >> iarc.compact;
       // create an iarchive which just points to the last size_t bytes
       // to get the number of elements
       iarchive numel_iarc(reinterpret_cast<const char*>(w.ptr) + len - sizeof(size_t),
@@ -310,13 +356,21 @@ namespace graphlab {
       (*swaparc).write(reinterpret_cast<char*>(&send_buffers[index].numinserts), sizeof(size_t));
 
       //std::cout << "Sending : " << (send_buffers[index].numinserts)<< "\n";
+      nbytes_sent += swaparc->off;
       // reset the insertion count
       send_buffers[index].numinserts = 0;
-      // write the current procid into the new buffer
-      (*(send_buffers[index].oarc)) << rpc.procid();
+      begin_buffer(send_buffers[index].oarc);
       return swaparc;
     }
 
+    // write the header of a new buffer: the current procid and whether the
+    // values are compact, both in the fixed width encoding
+    void begin_buffer(oarchive* oarc) {
+      oarc->compact = false;
+      (*oarc) << rpc.procid() << compact;
+      oarc->compact = compact;
+    }
+
 
   }; // end of buffered exchange
 
@@ -166,6 +166,8 @@ distributed_control::~distributed_control() {
   logstream(LOG_INFO) << "Shutting down distributed control " << std::endl;
   FREE_CALLBACK_EVENT(EVENT_NETWORK_BYTES);
   FREE_CALLBACK_EVENT(EVENT_RPC_CALLS);
+  FREE_CALLBACK_EVENT(EVENT_FIBER_STEALS);
+  FREE_CALLBACK_EVENT(EVENT_FIBER_IDLE_WAITS);
   // call all deletion callbacks
   for (size_t i = 0; i < deletion_callbacks.size(); ++i) {
     deletion_callbacks[i]();
@@ -495,8 +497,9 @@ void distributed_control::init(const std::vector<std::string> &machines,
     if (thread::cpu_count() > 2) numhandlerthreads = thread::cpu_count() - 2;
     else numhandlerthreads = 2;
   }
-  ASSERT_MSG(machines.size() <= RPC_MAX_N_PROCS,
-             "Number of processes exceeded hard limit of %d", RPC_MAX_N_PROCS);
+  // procid_t(-1) is reserved as an invalid process id
+  ASSERT_MSG(machines.size() < size_t(procid_t(-1)),
+             "Number of processes exceeded hard limit of %d", int(procid_t(-1)) - 1);
 
   // initialize thread local storage
   if (dc_impl::thrlocal_sequentialization_key_initialized == false) {
@@ -529,6 +532,21 @@ void distributed_control::init(const std::vector<std::string> &machines,
   // parse the initstring
   std::map<std::string,std::string> options = parse_options(initstring);
 
+  bool adaptive_flush = false;
+  if (options.count("flush_policy")) {
+    if (options["flush_policy"] == "adaptive") adaptive_flush = true;
+    else if (options["flush_policy"] != "fixed") {
+      logstream(LOG_WARNING) << "Unknown flush_policy \""
+                             << options["flush_policy"]
+                             << "\". Using fixed." << std::endl;
+    }
+  }
+  flush_controllers.resize(machines.size());
+  for (size_t i = 0; i < flush_controllers.size(); ++i) {
+    if (adaptive_flush) flush_controllers[i].set_adaptive();
+    else flush_controllers[i].set_fixed();
+  }
+
   if (commtype == TCP_COMM) {
     comm = new dc_impl::dc_tcp_comm();
   } else {
@@ -615,6 +633,12 @@ void distributed_control::init(const std::vector<std::string> &machines,
       "MB", boost::bind(&distributed_control::network_megabytes_sent, this));
   ADD_CUMULATIVE_CALLBACK_EVENT(EVENT_RPC_CALLS, "RPC Calls",
       "Calls", boost::bind(&distributed_control::calls_sent, this));
+  ADD_CUMULATIVE_CALLBACK_EVENT(EVENT_FIBER_STEALS, "Fiber Steals",
+      "Fibers", boost::bind(&fiber_control::total_steals,
+                            &fiber_control::get_instance()));
+  ADD_CUMULATIVE_CALLBACK_EVENT(EVENT_FIBER_IDLE_WAITS, "Fiber Idle Waits",
+      "Waits", boost::bind(&fiber_control::total_idle_waits,
+                           &fiber_control::get_instance()));
 }
 
 
@@ -49,6 +49,7 @@
 #include <graphlab/rpc/request_reply_handler.hpp>
 #include <graphlab/rpc/function_ret_type.hpp>
 #include <graphlab/rpc/dc_compile_parameters.hpp>
+#include <graphlab/rpc/dc_flush_controller.hpp>
 #include <graphlab/rpc/thread_local_send_buffer.hpp>
 #include <graphlab/util/tracepoint.hpp>
 #include <graphlab/rpc/distributed_event_log.hpp>
@@ -85,7 +86,14 @@ struct dc_init_param{
   /** Additional construction options of the form
     "key1=value1,key2=value2".
 
-    There are no available options at this time.
+    \li \b flush_policy=fixed|adaptive Defaults to fixed, which uses
+                             the compile time limits in
+                             dc_compile_parameters.hpp. With "adaptive",
+                             the amount of data buffered for each target
+                             machine before a flush is derived from the
+                             observed send rate to that machine.
+                             Individual objects can select their own
+                             policy with dc_dist_object::set_flush_policy().
 
     Internal options which should not be used
     \li \b __socket__=NUMBER Forces TCP comm to use this socket number for its
@@ -267,6 +275,9 @@ class distributed_control{
 
   std::vector<boost::function<void(void)> > deletion_callbacks;
 
+  /// Per target machine flush policy of the thread local send buffers
+  std::vector<dc_impl::flush_controller> flush_controllers;
+
   template <typename T> friend class dc_dist_object;
   friend class dc_impl::dc_stream_receive;
   friend class dc_impl::dc_buffered_stream_send2;
@@ -290,6 +301,8 @@ class distributed_control{
 
   DECLARE_EVENT(EVENT_NETWORK_BYTES);
   DECLARE_EVENT(EVENT_RPC_CALLS);
+  DECLARE_EVENT(EVENT_FIBER_STEALS);
+  DECLARE_EVENT(EVENT_FIBER_IDLE_WAITS);
  public:
 
   /**
@@ -330,6 +343,14 @@ class distributed_control{
    */
   static procid_t get_instance_procid();
 
+  /**
+   * \internal
+   * Returns the flush policy used for the send buffers of a target machine
+   */
+  inline dc_impl::flush_controller& get_flush_controller(procid_t target) {
+    return flush_controllers[target];
+  }
+
   inline size_t num_handler_threads() const {
     return fcallqueue.size();
   }
@@ -1245,6 +1266,11 @@ class distributed_control{
    * // all machines will have i = numprocs() here.
    * \endcode
    *
+   * The values received from other machines are added into data in
+   * place, and are deserialized into a single temporary which is reused
+   * by all rounds of the reduction. \ref sec_serializable_pod "POD types"
+   * are transmitted as a plain copy of their bytes.
+   *
    * \param data  A piece of data to perform a reduction over.
    *              The type must implement operator+=.
    * \param control Optional parameter. Defaults to false. If set to true,
@@ -1274,6 +1300,9 @@ class distributed_control{
    * void plusequal(U& left, const U& right);
    * \endcode
    * and must implement the equivalent of <code>left += right; </code>
+   * It need not be commutative: contributions are always combined in
+   * the order of the machine ids, and every machine obtains an identical
+   * result.
    *
    * Example:
    * \code
@@ -32,13 +32,6 @@
  */
 #define RPC_DEFAULT_COMMTYPE TCP_COMM
 
-/**
-  \ingroup rpc
-  \def RPC_MAX_N_PROCS
-  \brief Maximum number of processes supported
- */
-#define RPC_MAX_N_PROCS 128
-
 /**
  * \ingroup RPC
  * \def RECEIVE_BUFFER_SIZE
@@ -94,6 +87,46 @@
  */
 #define NUM_FULL_BUFFER_LIMIT 32 
 
+/*
+ * With the opt-in "adaptive" flush policy (see dc_init_param::initstring
+ * and dc_dist_object::set_flush_policy()) the two limits above are
+ * replaced per target machine by a single byte threshold derived from
+ * the observed send rate to that machine: a flush is requested once
+ * roughly FLUSH_TARGET_LATENCY_US worth of traffic has been queued.
+ * Slow destinations therefore get small batches, while bulk exchanges
+ * get large batches.
+ */
+
+/**
+ * \ingroup RPC
+ * \def FLUSH_TARGET_LATENCY_US
+ * The adaptive policy queues about this many microseconds of traffic
+ * to a target before requesting a flush.
+ */
+#define FLUSH_TARGET_LATENCY_US 1000
+
+/**
+ * \ingroup RPC
+ * \def MIN_FLUSH_BYTES
+ * Lower bound of the adaptive flush threshold.
+ */
+#define MIN_FLUSH_BYTES 4096
+
+/**
+ * \ingroup RPC
+ * \def MAX_FLUSH_BYTES
+ * Upper bound of the adaptive flush threshold.
+ */
+#define MAX_FLUSH_BYTES (4 * 1024 * 1024)
+
+/**
+ * \ingroup RPC
+ * \def FLUSH_ADAPT_INTERVAL_MS
+ * Minimum number of milliseconds between two updates of the adaptive
+ * flush threshold of a target.
+ */
+#define FLUSH_ADAPT_INTERVAL_MS 100
+
 /**************************************************************************/
 /*                                                                        */
 /*                          RPC Handling Control                          */
@@ -132,6 +165,34 @@
  */
 #define RPC_BLOCK_STRIPING
 
+/**************************************************************************/
+/*                                                                        */
+/*                              Collectives                               */
+/*                                                                        */
+/**************************************************************************/
+
+/*
+ * all_reduce() and all_gather() use recursive doubling, which completes
+ * in log2(numprocs) rounds of pairwise exchanges and has no root.
+ * broadcast() forwards the payload down a tree rooted at the originator,
+ * cut into chunks so that the levels of the tree transmit concurrently.
+ */
+
+/**
+ * \ingroup RPC
+ * \def COLLECTIVE_BRANCH_FACTOR
+ * Number of children of each machine in the broadcast tree.
+ */
+#define COLLECTIVE_BRANCH_FACTOR 4
+
+/**
+ * \ingroup RPC
+ * \def COLLECTIVE_CHUNK_SIZE
+ * Broadcast payloads larger than this many bytes are forwarded down
+ * the tree in chunks of this size.
+ */
+#define COLLECTIVE_CHUNK_SIZE (256 * 1024)
+
 /**************************************************************************/
 /*                                                                        */
 /*                             Miscellaneous                              */
@@ -28,6 +28,10 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <boost/type_traits/integral_constant.hpp>
 #include <graphlab/parallel/atomic.hpp>
 #include <graphlab/parallel/fiber_conditional.hpp>
 #include <graphlab/rpc/dc_internal_types.hpp>
@@ -38,6 +42,7 @@
 #include <graphlab/rpc/function_ret_type.hpp>
 #include <graphlab/rpc/mem_function_arg_types_def.hpp>
 #include <graphlab/util/charstream.hpp>
+#include <graphlab/serialization/is_pod.hpp>
 #include <boost/preprocessor.hpp>
 #include <graphlab/util/tracepoint.hpp>
 #include <graphlab/rpc/request_reply_handler.hpp>
@@ -121,6 +126,10 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
   std::vector<atomic<size_t> > callsreceived;
   std::vector<atomic<size_t> > callssent;
   std::vector<atomic<size_t> > bytessent;
+  // flush policy of the traffic of this object, per target
+  flush_policy_type flush_policy;
+  std::vector<dc_impl::flush_controller> flush_controllers;
+  std::vector<atomic<size_t> > queued_bytes;
   // make operator= private
   dc_dist_object<T>& operator=(const dc_dist_object<T> &d) {return *this;}
   friend class distributed_control;
@@ -181,6 +190,14 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
   /// Should not be used by the user
   void inc_bytes_sent(procid_t p, size_t bytes) {
     bytessent[p].inc(bytes);
+    if (flush_policy != FLUSH_POLICY_DEFAULT) {
+      flush_controllers[p].observe(bytes);
+      const size_t queued = queued_bytes[p].inc(bytes);
+      if (queued >= flush_controllers[p].flush_threshold()) {
+        queued_bytes[p].exchange(0);
+        dc_.flush_soon(p);
+      }
+    }
   }
 
   /// Should not be used by the user
@@ -201,10 +218,12 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
    * \param owner The object to associate with
    */
   dc_dist_object(distributed_control &dc_, T* owner):
-    dc_(dc_),owner(owner) {
+    dc_(dc_),owner(owner),flush_policy(FLUSH_POLICY_DEFAULT) {
     callssent.resize(dc_.numprocs());
     callsreceived.resize(dc_.numprocs());
     bytessent.resize(dc_.numprocs());
+    flush_controllers.resize(dc_.numprocs());
+    queued_bytes.resize(dc_.numprocs());
     //------ Initialize the matched send/recv ------
     recv_froms.resize(dc_.numprocs());
     //------ Initialize the gatherer ------
@@ -230,10 +249,8 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
 
     parent =  (procid_t)((dc_.procid() - 1) / BARRIER_BRANCH_FACTOR)   ;
 
-    //-------- Initialize all gather --------------
-    ab_child_barrier_counter.value = 0;
-    ab_barrier_sense = 1;
-    ab_barrier_release = -1;
+    //-------- Initialize the collectives ----------
+    collective_seq = 0;
 
 
     //-------- Initialize the full barrier ---------
@@ -251,6 +268,47 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
                       std::string("dc_dist_object ") + name + ": remote_call time");
   }
 
+  ~dc_dist_object() {
+    free(collective_oarc.buf);
+  }
+
+  /**
+   * \brief Selects when the calls issued through this object are
+   * flushed to the target, in addition to the flush policy of the
+   * distributed_control.
+   *
+   * \li FLUSH_POLICY_DEFAULT: only the distributed_control decides.
+   * \li FLUSH_POLICY_FIXED: a flush of the target is requested once
+   * \c max_bytes of this object's calls were queued for it. With
+   * <code>max_bytes = 0</code> every call is flushed, in the same way
+   * remote_request() is, which suits objects sending few, small
+   * messages on the critical path (for instance termination messages).
+   * \li FLUSH_POLICY_ADAPTIVE: the threshold is derived from the rate
+   * at which this object sends to the target, within
+   * <code>[min_bytes, max_bytes]</code>.
+   *
+   * This should be called on a quiescent object, typically right after
+   * construction.
+   */
+  void set_flush_policy(flush_policy_type policy,
+                        size_t max_bytes = MAX_FLUSH_BYTES,
+                        size_t min_bytes = MIN_FLUSH_BYTES) {
+    flush_policy = policy;
+    for (size_t i = 0; i < flush_controllers.size(); ++i) {
+      if (policy == FLUSH_POLICY_ADAPTIVE) {
+        flush_controllers[i].set_adaptive(min_bytes, max_bytes);
+      } else {
+        flush_controllers[i].set_fixed(max_bytes);
+      }
+      queued_bytes[i].exchange(0);
+    }
+  }
+
+  /// \brief Returns the policy selected by set_flush_policy()
+  flush_policy_type get_flush_policy() const {
+    return flush_policy;
+  }
+
   /// \brief The number of function calls received by this object
   size_t calls_received() const {
     size_t ctr = 0;
@@ -859,65 +917,210 @@ class dc_dist_object : public dc_impl::dc_dist_object_base{
 
 
 /*****************************************************************************
-                      Implementation of Broadcast
+                      Collective message matching
  *****************************************************************************/
 
-private:
+ private:
+  /* Messages of broadcast(), all_gather() and all_reduce() are matched by
+   * the sequence number of the collective, which advances identically on
+   * every machine, and a tag within the collective (the round, or the
+   * chunk index). Early arrivals wait in the mailbox until the receiver
+   * gets there, so consecutive collectives need no barrier in between.
+   *
+   * Payloads travel as blobs: outgoing ones are serialized into
+   * collective_oarc, whose buffer is reused by every collective, and
+   * POD types are copied as is without going through an archive. */
+  enum { COLLECTIVE_FOLD_IN_TAG = 1000, COLLECTIVE_FOLD_OUT_TAG = 1001 };
+
+  /// Number of collectives this machine has entered
+  size_t collective_seq;
+  /// (sequence, tag) -> (auxiliary value, payload) of unconsumed messages
+  std::map<std::pair<size_t, size_t>,
+           std::pair<size_t, dc_impl::blob> > collective_mailbox;
+  fiber_conditional collective_cond;
+  mutex collective_mut;
+  /// Send buffer of the collectives
+  oarchive collective_oarc;
+
+  void __collective_deliver(size_t seq, size_t tag, size_t aux,
+                            const dc_impl::blob& b) {
+    collective_mut.lock();
+    // the mailbox takes over the memory of the blob
+    collective_mailbox[std::make_pair(seq, tag)] = std::make_pair(aux, b);
+    collective_cond.signal();
+    collective_mut.unlock();
+  }
 
-  std::string broadcast_receive;
+  void collective_send(procid_t target, size_t seq, size_t tag, size_t aux,
+                       const dc_impl::blob& b, bool control) {
+    if (control) {
+      internal_control_call(target,
+                            &dc_dist_object<T>::__collective_deliver,
+                            seq, tag, aux, b);
+    }
+    else {
+      internal_call(target,
+                    &dc_dist_object<T>::__collective_deliver,
+                    seq, tag, aux, b);
+    }
+  }
 
-  void set_broadcast_receive(const std::string &s) {
-    broadcast_receive = s;
+  /**
+   * Waits for the message (seq, tag) and removes it from the mailbox.
+   * The caller owns the returned blob and must free it.
+   */
+  dc_impl::blob collective_recv(size_t seq, size_t tag, size_t* aux = NULL) {
+    const std::pair<size_t, size_t> key(seq, tag);
+    collective_mut.lock();
+    typename std::map<std::pair<size_t, size_t>,
+                      std::pair<size_t, dc_impl::blob> >::iterator iter;
+    while ((iter = collective_mailbox.find(key)) == collective_mailbox.end()) {
+      collective_cond.wait(collective_mut);
+    }
+    if (aux != NULL) (*aux) = iter->second.first;
+    dc_impl::blob ret = iter->second.second;
+    collective_mailbox.erase(iter);
+    collective_mut.unlock();
+    return ret;
+  }
+
+  /**
+   * Returns a blob with the serialization of data. The blob points either
+   * to data itself or to the send buffer, and is valid until data changes
+   * or the next call.
+   */
+  template <typename U>
+  dc_impl::blob collective_pack(const U& data) {
+    return collective_pack(data,
+                           boost::integral_constant<bool, gl_is_pod<U>::value>());
   }
 
+  template <typename U>
+  dc_impl::blob collective_pack(const U& data, boost::true_type) {
+    return dc_impl::blob(reinterpret_cast<char*>(const_cast<U*>(&data)),
+                         sizeof(U));
+  }
+
+  template <typename U>
+  dc_impl::blob collective_pack(const U& data, boost::false_type) {
+    collective_oarc.off = 0;
+    collective_oarc << data;
+    return dc_impl::blob(collective_oarc.buf, collective_oarc.off);
+  }
+
+  /// Deserializes data from the output of collective_pack()
+  template <typename U>
+  static void collective_unpack(const char* c, size_t len, U& data) {
+    collective_unpack(c, len, data,
+                      boost::integral_constant<bool, gl_is_pod<U>::value>());
+  }
+
+  template <typename U>
+  static void collective_unpack(const char* c, size_t len, U& data,
+                                boost::true_type) {
+    ASSERT_EQ(len, sizeof(U));
+    memcpy(reinterpret_cast<char*>(&data), c, sizeof(U));
+  }
+
+  template <typename U>
+  static void collective_unpack(const char* c, size_t len, U& data,
+                                boost::false_type) {
+    iarchive iarc(c, len);
+    iarc >> data;
+  }
+
+  /// Deserializes data from a received blob, and frees the blob
+  template <typename U>
+  static void collective_unpack(dc_impl::blob b, U& data) {
+    collective_unpack(b.c, b.len, data);
+    b.free();
+  }
+
+  /// Largest power of two not larger than numprocs()
+  size_t collective_pow2() const {
+    size_t p2 = 1;
+    while (p2 * 2 <= numprocs()) p2 *= 2;
+    return p2;
+  }
+
+/*****************************************************************************
+                      Implementation of Broadcast
+ *****************************************************************************/
+
+  /* The broadcast tree is the heap with COLLECTIVE_BRANCH_FACTOR children
+   * per node over the machine ids rotated so that the originator is the
+   * root. Each chunk is passed on as soon as it arrives, so large payloads
+   * are pipelined through the levels of the tree. */
+  void broadcast_forward(size_t seq, procid_t root,
+                         const std::pair<size_t, size_t>& chunk,
+                         const dc_impl::blob& b, int control) {
+    const size_t rel = (procid() + numprocs() - root) % numprocs();
+    for (size_t i = 1; i <= COLLECTIVE_BRANCH_FACTOR; ++i) {
+      const size_t child = rel * COLLECTIVE_BRANCH_FACTOR + i;
+      if (child >= numprocs()) break;
+      const procid_t target = (procid_t)((child + root) % numprocs());
+      if (control) {
+        internal_control_call(target,
+                              &dc_dist_object<T>::__broadcast_chunk,
+                              seq, root, chunk, b, control);
+      }
+      else {
+        internal_call(target,
+                      &dc_dist_object<T>::__broadcast_chunk,
+                      seq, root, chunk, b, control);
+      }
+    }
+  }
+
+  /// chunk is the pair (chunk index, number of chunks)
+  void __broadcast_chunk(size_t seq, procid_t root,
+                         const std::pair<size_t, size_t>& chunk,
+                         const dc_impl::blob& b, int control) {
+    broadcast_forward(seq, root, chunk, b, control);
+    __collective_deliver(seq, chunk.first, chunk.second, b);
+  }
 
  public:
 
   /// \copydoc distributed_control::broadcast()
   template <typename U>
   void broadcast(U& data, bool originator, bool control = false) {
+    const size_t seq = collective_seq++;
     if (originator) {
-      // construct the data stream
-      std::stringstream strm;
-      oarchive oarc(strm);
-      oarc << data;
-      strm.flush();
-      broadcast_receive = strm.str();
-      if (control == false) {
-        for (size_t i = 0;i < numprocs(); ++i) {
-          if (i != procid()) {
-            internal_request(i,
-                            &dc_dist_object<T>::set_broadcast_receive,
-                            broadcast_receive);
-          }
-        }
+      const dc_impl::blob b = collective_pack(data);
+      const size_t nchunks =
+          std::max<size_t>((b.len + COLLECTIVE_CHUNK_SIZE - 1) / COLLECTIVE_CHUNK_SIZE, 1);
+      for (size_t i = 0; i < nchunks; ++i) {
+        const size_t begin = i * COLLECTIVE_CHUNK_SIZE;
+        const size_t end = std::min<size_t>(b.len, begin + COLLECTIVE_CHUNK_SIZE);
+        broadcast_forward(seq, procid(), std::make_pair(i, nchunks),
+                          dc_impl::blob(b.c + begin, end - begin),
+                          (int)control);
+      }
+    }
+    else {
+      size_t nchunks = 0;
+      dc_impl::blob first = collective_recv(seq, 0, &nchunks);
+      if (nchunks == 1) {
+        collective_unpack(first, data);
       }
       else {
-        for (size_t i = 0;i < numprocs(); ++i) {
-          if (i != procid()) {
-            internal_control_request(i,
-                                    &dc_dist_object<T>::set_broadcast_receive,
-                                    broadcast_receive);
-          }
+        std::string s;
+        s.reserve(nchunks * COLLECTIVE_CHUNK_SIZE);
+        s.append(first.c, first.len);
+        first.free();
+        for (size_t i = 1; i < nchunks; ++i) {
+          dc_impl::blob b = collective_recv(seq, i);
+          s.append(b.c, b.len);
+          b.free();
         }
+        collective_unpack(s.c_str(), s.length(), data);
       }
     }
-
-    // by the time originator gets here, all machines
-    // will have received the data due to the broadcast_receive
-    // set a barrier here.
-    barrier();
-
-    // all machines will now deserialize the data
-    if (!originator) {
-      std::stringstream strm(broadcast_receive);
-      iarchive iarc(strm);
-      iarc >> data;
-    }
+    // keep the guarantee that all machines have entered the broadcast
     barrier();
   }
 
-
 /*****************************************************************************
       Implementation of Gather, all_gather
  *****************************************************************************/
@@ -978,72 +1181,15 @@ private:
              Implementation of all gather
 *********************************************************************/
 
-
-
- private:
-  // ------- Sense reversing barrier data ----------
-  /// The next value of the barrier. either +1 or -1
-  int ab_barrier_sense;
-  /// When this flag == the current barrier value. The barrier is complete
-  int ab_barrier_release;
-  /** when barrier sense is 1, barrier clears when
-   * child_barrier_counter == numchild. When barrier sense is -1, barrier
-   * clears when child_barrier_counter == 0;
-   */
-  atomic<int> ab_child_barrier_counter;
-  /// condition variable and mutex protecting the barrier variables
-  fiber_conditional ab_barrier_cond;
-  mutex ab_barrier_mut;
-  std::string ab_children_data[BARRIER_BRANCH_FACTOR];
-  std::string ab_alldata;
-
-  /**
-    The child calls this function in the parent once the child enters the barrier
-  */
-  void __ab_child_to_parent_barrier_trigger(procid_t source, std::string collect) {
-    ab_barrier_mut.lock();
-    // assert childbase <= source <= childbase + BARRIER_BRANCH_FACTOR
-    ASSERT_GE(source, childbase);
-    ASSERT_LT(source, childbase + BARRIER_BRANCH_FACTOR);
-    ab_children_data[source - childbase] = collect;
-    ab_child_barrier_counter.inc(ab_barrier_sense);
-    ab_barrier_cond.signal();
-    ab_barrier_mut.unlock();
-  }
-
-  /**
-    This is on the downward pass of the barrier. The parent calls this function
-    to release all the children's barriers
-  */
-  void __ab_parent_to_child_barrier_release(int releaseval,
-                                            std::string allstrings,
-                                            int use_control_calls) {
-    // send the release downwards
-    // get my largest child
-    logger(LOG_DEBUG, "AB Barrier Release %d", releaseval);
-    ab_alldata = allstrings;
-    for (procid_t i = 0;i < numchild; ++i) {
-      if (use_control_calls) {
-        internal_control_call((procid_t)(childbase + i),
-                              &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                              releaseval,
-                              ab_alldata,
-                              use_control_calls);
-      }
-      else {
-        internal_call((procid_t)(childbase + i),
-                      &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                      releaseval,
-                      ab_alldata,
-                      use_control_calls);
-      }
-    }
-    ab_barrier_mut.lock();
-    ab_barrier_release = releaseval;
-    ab_barrier_cond.signal();
-    ab_barrier_mut.unlock();
-  }
-
+  /* all_gather() and all_reduce2() use recursive doubling over the
+   * largest power of two p2 <= numprocs(). In round r the remaining
+   * machines exchange everything they have with the machine whose id
+   * differs in bit r. The nextra = numprocs() - p2 other machines fold
+   * their contribution into a partner first and get the result back at
+   * the end: in all_gather() machine i >= p2 folds into i - p2, and in
+   * all_reduce2() the odd machine 2i + 1 < 2 * nextra folds into 2i, as
+   * in Rabenseifner's reduction, so that each remaining machine holds a
+   * contiguous range of machine ids. */
 
  public:
 
@@ -1051,131 +1197,61 @@ private:
   template <typename U>
   void all_gather(std::vector<U>& data, bool control = false) {
     if (numprocs() == 1) return;
-    // get the string representation of the data
-    charstream strm(128);
-    oarchive oarc(strm);
-    oarc << data[procid()];
-    strm.flush();
-    // upward message
-    int ab_barrier_val = ab_barrier_sense;
-    ab_barrier_mut.lock();
-    // wait for all children to be done
-    while(1) {
-      if ((ab_barrier_sense == -1 && ab_child_barrier_counter.value == 0) ||
-          (ab_barrier_sense == 1 && ab_child_barrier_counter.value == (int)(numchild))) {
-        // flip the barrier sense
-        ab_barrier_sense = -ab_barrier_sense;
-        // call child to parent in parent
-        ab_barrier_mut.unlock();
-        if (procid() != 0) {
-          // collect all my children data
-          charstream strstrm(128);
-          oarchive oarc2(strstrm);
-          oarc2 << std::string(strm->c_str(), strm->size());
-          for (procid_t i = 0;i < numchild; ++i) {
-            strstrm.write(ab_children_data[i].c_str(), ab_children_data[i].length());
-          }
-          strstrm.flush();
-          if (control) {
-            internal_control_call(parent,
-                            &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                            procid(),
-                            std::string(strstrm->c_str(), strstrm->size()));
-          }
-          else {
-            internal_call(parent,
-                          &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                          procid(),
-                          std::string(strstrm->c_str(), strstrm->size()));
-          }
-        }
-        break;
-      }
-      ab_barrier_cond.wait(ab_barrier_mut);
+    const size_t seq = collective_seq++;
+    const size_t me = procid();
+    const size_t p2 = collective_pow2();
+    const size_t nextra = numprocs() - p2;
+    // the serialized contribution of each machine
+    std::vector<std::string> blocks(numprocs());
+    {
+      const dc_impl::blob b = collective_pack(data[me]);
+      blocks[me].assign(b.c, b.len);
     }
 
-
-    logger(LOG_DEBUG, "AB barrier phase 1 complete");
-    // I am root. send the barrier release downwards
-    if (procid() == 0) {
-      ab_barrier_release = ab_barrier_val;
-      // build the downward data
-      charstream strstrm(128);
-      oarchive oarc2(strstrm);
-      oarc2 << std::string(strm->c_str(), strm->size());
-      for (procid_t i = 0;i < numchild; ++i) {
-        strstrm.write(ab_children_data[i].c_str(), ab_children_data[i].length());
-      }
-      strstrm.flush();
-      ab_alldata = std::string(strstrm->c_str(), strstrm->size());
-      for (procid_t i = 0;i < numchild; ++i) {
-        logger(LOG_DEBUG, "Sending AB release to %d", childbase + i);
-        internal_control_call((procid_t)(childbase + i),
-                             &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                             ab_barrier_val,
-                             ab_alldata,
-                             (int)control);
-
-      }
+    if (me >= p2) {
+      collective_send((procid_t)(me - p2), seq, COLLECTIVE_FOLD_IN_TAG, 0,
+                      dc_impl::blob(&blocks[me][0], blocks[me].length()),
+                      control);
+      collective_unpack(collective_recv(seq, COLLECTIVE_FOLD_OUT_TAG), blocks);
     }
-    // wait for the downward message releasing the barrier
-    logger(LOG_DEBUG, "AB barrier waiting for %d", ab_barrier_val);
-    ab_barrier_mut.lock();
-    while(1) {
-      if (ab_barrier_release == ab_barrier_val) break;
-      ab_barrier_cond.wait(ab_barrier_mut);
-    }
-    // read the collected data and release the lock
-    std::string local_ab_alldata = ab_alldata;
-    ab_barrier_mut.unlock();
-
-    logger(LOG_DEBUG, "barrier phase 2 complete");
-    // now the data is a DFS search of a heap
-    // I need to unpack it
-    size_t heappos = 0;
-    std::stringstream istrm(local_ab_alldata);
-    iarchive iarc(istrm);
-
-    for (size_t i = 0;i < numprocs(); ++i) {
-      std::string s;
-      iarc >> s;
-
-      std::stringstream strm2(s);
-      iarchive iarc2(strm2);
-      iarc2 >> data[heappos];
-
-      if (i + 1 == numprocs()) break;
-      // advance heappos
-      // leftbranch
-      bool lefttraverseblock = false;
-      while (1) {
-        // can we continue going deaper down the left?
-        size_t leftbranch = heappos * BARRIER_BRANCH_FACTOR + 1;
-        if (lefttraverseblock == false && leftbranch < numprocs()) {
-          heappos = leftbranch;
-          break;
+    else {
+      if (me < nextra) {
+        dc_impl::blob b = collective_recv(seq, COLLECTIVE_FOLD_IN_TAG);
+        blocks[me + p2].assign(b.c, b.len);
+        b.free();
+      }
+      for (size_t mask = 1, round = 0; mask < p2; mask <<= 1, ++round) {
+        // before round r, a machine holds the blocks of the 2^r machines
+        // which agree with it in all but the lowest r bits, and of the
+        // machines folded into those.
+        const size_t partner = me ^ mask;
+        const size_t mybase = me & ~(mask - 1);
+        const size_t partnerbase = partner & ~(mask - 1);
+        collective_oarc.off = 0;
+        for (size_t i = mybase; i < mybase + mask; ++i) {
+          collective_oarc << blocks[i];
+          if (i < nextra) collective_oarc << blocks[i + p2];
         }
-        // ok. can't go down the left
-        bool this_is_a_right_branch = (((heappos - 1) % BARRIER_BRANCH_FACTOR) == BARRIER_BRANCH_FACTOR - 1);
-        // if we are a left branch, go to sibling
-        if (this_is_a_right_branch == false) {
-          size_t sibling = heappos + 1;
-          if (sibling < numprocs()) {
-            heappos = sibling;
-            break;
-          }
+        collective_send((procid_t)partner, seq, round, 0,
+                        dc_impl::blob(collective_oarc.buf, collective_oarc.off),
+                        control);
+
+        dc_impl::blob b = collective_recv(seq, round);
+        iarchive iarc(b.c, b.len);
+        for (size_t i = partnerbase; i < partnerbase + mask; ++i) {
+          iarc >> blocks[i];
+          if (i < nextra) iarc >> blocks[i + p2];
         }
-
-        // we have finished this subtree, go back up to parent
-        // and block the depth traversal on the next round
-        // unless heappos is 0
-
-        heappos = (heappos - 1) / BARRIER_BRANCH_FACTOR;
-        lefttraverseblock = true;
-        continue;
-        // go to sibling
+        b.free();
+      }
+      if (me < nextra) {
+        collective_send((procid_t)(me + p2), seq, COLLECTIVE_FOLD_OUT_TAG, 0,
+                        collective_pack(blocks), control);
       }
+    }
 
+    for (size_t i = 0; i < numprocs(); ++i) {
+      if (i != me) collective_unpack(blocks[i].c_str(), blocks[i].length(), data[i]);
     }
   }
 
@@ -1183,102 +1259,62 @@ private:
   template <typename U, typename PlusEqual>
   void all_reduce2(U& data, PlusEqual plusequal, bool control = false) {
     if (numprocs() == 1) return;
-    // get the string representation of the data
-   /* charstream strm(128);
-    oarchive oarc(strm);
-    oarc << data;
-    strm.flush();*/
-    // upward message
-    int ab_barrier_val = ab_barrier_sense;
-    ab_barrier_mut.lock();
-    // wait for all children to be done
-    while(1) {
-      if ((ab_barrier_sense == -1 && ab_child_barrier_counter.value == 0) ||
-          (ab_barrier_sense == 1 && ab_child_barrier_counter.value == (int)(numchild))) {
-        // flip the barrier sense
-        ab_barrier_sense = -ab_barrier_sense;
-        // call child to parent in parent
-        ab_barrier_mut.unlock();
-        if (procid() != 0) {
-          // accumulate my children data
-          for (procid_t i = 0;i < numchild; ++i) {
-            std::stringstream istrm(ab_children_data[i]);
-            iarchive iarc(istrm);
-            U tmp;
-            iarc >> tmp;
-            plusequal(data, tmp);
-          }
-          // upward message
-          charstream ostrm(128);
-          oarchive oarc(ostrm);
-          oarc << data;
-          ostrm.flush();
-          if (control) {
-            internal_control_call(parent,
-                            &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                            procid(),
-                            std::string(ostrm->c_str(), ostrm->size()));
-          }
-          else {
-            internal_call(parent,
-                          &dc_dist_object<T>::__ab_child_to_parent_barrier_trigger,
-                          procid(),
-                          std::string(ostrm->c_str(), ostrm->size()));
-          }
-        }
-        break;
-      }
-      ab_barrier_cond.wait(ab_barrier_mut);
-    }
-
-
-    logger(LOG_DEBUG, "AB barrier phase 1 complete");
-    // I am root. send the barrier release downwards
-    if (procid() == 0) {
-      ab_barrier_release = ab_barrier_val;
-      for (procid_t i = 0;i < numchild; ++i) {
-        std::stringstream istrm(ab_children_data[i]);
-        iarchive iarc(istrm);
-        U tmp;
-        iarc >> tmp;
-        plusequal(data, tmp);
-      }
-      // build the downward data
-      charstream ostrm(128);
-      oarchive oarc(ostrm);
-      oarc << data;
-      ostrm.flush();
-      ab_alldata = std::string(ostrm->c_str(), ostrm->size());
-      for (procid_t i = 0;i < numchild; ++i) {
-        internal_control_call((procid_t)(childbase + i),
-                             &dc_dist_object<T>::__ab_parent_to_child_barrier_release,
-                             ab_barrier_val,
-                             ab_alldata,
-                             (int)control);
+    U buffer;
+    all_reduce2(data, buffer, plusequal, control);
+  }
 
-      }
+  /**
+   * \brief Like all_reduce2(data, plusequal, control), but the values of
+   * the other machines are received into \c buffer. A caller which
+   * reduces repeatedly can keep the buffer, so that containers keep
+   * their storage across calls.
+   */
+  template <typename U, typename PlusEqual>
+  void all_reduce2(U& data, U& buffer, PlusEqual plusequal,
+                   bool control = false) {
+    if (numprocs() == 1) return;
+    const size_t seq = collective_seq++;
+    const size_t me = procid();
+    const size_t p2 = collective_pow2();
+    const size_t nextra = numprocs() - p2;
+
+    if (me < 2 * nextra && me % 2 == 1) {
+      collective_send((procid_t)(me - 1), seq, COLLECTIVE_FOLD_IN_TAG, 0,
+                      collective_pack(data), control);
+      collective_unpack(collective_recv(seq, COLLECTIVE_FOLD_OUT_TAG), data);
+      return;
     }
-    // wait for the downward message releasing the barrier
-    logger(LOG_DEBUG, "AB barrier waiting for %d", ab_barrier_val);
-    ab_barrier_mut.lock();
-    while(1) {
-      if (ab_barrier_release == ab_barrier_val) break;
-      ab_barrier_cond.wait(ab_barrier_mut);
+    // received values are deserialized into the same object every round,
+    // so that containers keep their storage
+    U& other = buffer;
+    if (me < 2 * nextra) {
+      collective_unpack(collective_recv(seq, COLLECTIVE_FOLD_IN_TAG), other);
+      plusequal(data, other);
     }
-
-    if (procid() != 0) {
-      // read the collected data and release the lock
-      std::string local_ab_alldata = ab_alldata;
-      ab_barrier_mut.unlock();
-
-      logger(LOG_DEBUG, "barrier phase 2 complete");
-
-      std::stringstream istrm(local_ab_alldata);
-      iarchive iarc(istrm);
-      iarc >> data;
+    // the rank among the remaining machines, which hold the values of
+    // consecutive machine ids in rank order
+    const size_t rank = me < 2 * nextra ? me / 2 : me - nextra;
+    for (size_t mask = 1, round = 0; mask < p2; mask <<= 1, ++round) {
+      const size_t partner_rank = rank ^ mask;
+      const size_t partner = partner_rank < nextra ?
+        2 * partner_rank : partner_rank + nextra;
+      collective_send((procid_t)partner, seq, round, 0,
+                      collective_pack(data), control);
+      collective_unpack(collective_recv(seq, round), other);
+      // Both partners add the lower machine's value on the left, so that
+      // every machine ends with an identical result even when plusequal
+      // is not commutative or, as with floating point, not associative.
+      if (rank < partner_rank) {
+        plusequal(data, other);
+      }
+      else {
+        std::swap(data, other);
+        plusequal(data, other);
+      }
     }
-    else {
-      ab_barrier_mut.unlock();
+    if (me < 2 * nextra) {
+      collective_send((procid_t)(me + 1), seq, COLLECTIVE_FOLD_OUT_TAG, 0,
+                      collective_pack(data), control);
     }
   }
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef GRAPHLAB_DC_FLUSH_CONTROLLER_HPP
+#define GRAPHLAB_DC_FLUSH_CONTROLLER_HPP
+#include <algorithm>
+#include <graphlab/rpc/dc_compile_parameters.hpp>
+#include <graphlab/logger/assertions.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/parallel/atomic.hpp>
+#include <graphlab/util/timer.hpp>
+namespace graphlab {
+
+/**
+ * \ingroup rpc
+ * The flush policies which can be selected for the traffic of a
+ * graphlab::dc_dist_object. See dc_dist_object::set_flush_policy().
+ */
+enum flush_policy_type {
+  /// Only the flush policy of the distributed_control applies
+  FLUSH_POLICY_DEFAULT,
+  /// Flush once a fixed number of bytes of the object is queued
+  FLUSH_POLICY_FIXED,
+  /// Flush once about FLUSH_TARGET_LATENCY_US of traffic is queued
+  FLUSH_POLICY_ADAPTIVE
+};
+
+namespace dc_impl {
+
+/**
+ * \internal
+ * \ingroup rpc
+ * Decides when the thread local send buffers of one target machine are
+ * handed to the sender.
+ *
+ * In the fixed mode, a buffer becomes full at a fixed size
+ * (FULL_BUFFER_SIZE_LIMIT by default) and a flush is requested once a
+ * fixed number of bytes is queued.
+ *
+ * In the adaptive mode, the controller measures the rate at which bytes
+ * are queued for the target, smoothed over FLUSH_ADAPT_INTERVAL_MS
+ * windows, and requests a flush once about FLUSH_TARGET_LATENCY_US
+ * worth of traffic is queued, clamped to the limits given to
+ * set_adaptive(). It starts from the thresholds of the fixed mode.
+ * Buffers become full at the same threshold, capped at
+ * FULL_BUFFER_SIZE_LIMIT. Note that the queueing rate is only a proxy
+ * for the delivery latency, which the send path cannot observe.
+ */
+class flush_controller {
+ public:
+  flush_controller():
+      adaptive(false),
+      flush_bytes(FULL_BUFFER_SIZE_LIMIT * NUM_FULL_BUFFER_LIMIT),
+      buffer_limit(FULL_BUFFER_SIZE_LIMIT),
+      min_bytes(MIN_FLUSH_BYTES), max_bytes(MAX_FLUSH_BYTES),
+      last_update_ms(0), rate(0) { }
+
+  /// Flushes once threshold bytes are queued
+  void set_fixed(size_t threshold =
+                     FULL_BUFFER_SIZE_LIMIT * NUM_FULL_BUFFER_LIMIT) {
+    adaptive = false;
+    flush_bytes = threshold;
+    buffer_limit = std::min<size_t>(threshold, FULL_BUFFER_SIZE_LIMIT);
+  }
+
+  /// Derives the threshold from the send rate, within [lower, upper]
+  void set_adaptive(size_t lower = MIN_FLUSH_BYTES,
+                    size_t upper = MAX_FLUSH_BYTES) {
+    ASSERT_LE(lower, upper);
+    adaptive = true;
+    min_bytes = lower;
+    max_bytes = upper;
+    rate = 0;
+    bytes_observed = 0;
+    last_update_ms = timer::approx_time_millis();
+    update_thresholds(FULL_BUFFER_SIZE_LIMIT * NUM_FULL_BUFFER_LIMIT);
+  }
+
+  inline bool is_adaptive() const {
+    return adaptive;
+  }
+
+  /// The size at which a thread local buffer is queued for sending
+  inline size_t full_buffer_limit() const {
+    return buffer_limit;
+  }
+
+  /// Number of bytes a thread may queue before requesting a flush
+  inline size_t flush_threshold() const {
+    return flush_bytes;
+  }
+
+  /// Smoothed send rate to the target in bytes per second
+  inline double send_rate() const {
+    return rate;
+  }
+
+  /**
+   * Records bytes queued for the target and periodically recomputes the
+   * thresholds. Can be called from any thread.
+   */
+  void observe(size_t bytes) {
+    if (!adaptive) return;
+    bytes_observed.inc(bytes);
+    size_t now = timer::approx_time_millis();
+    if (now < last_update_ms + FLUSH_ADAPT_INTERVAL_MS) return;
+    if (!lock.try_lock()) return;
+    if (now >= last_update_ms + FLUSH_ADAPT_INTERVAL_MS) {
+      double elapsed = double(now - last_update_ms) / 1000;
+      double cur_rate = bytes_observed.exchange(0) / elapsed;
+      rate = (rate == 0) ? cur_rate : (rate + cur_rate) / 2;
+      last_update_ms = now;
+      update_thresholds(rate * FLUSH_TARGET_LATENCY_US / 1000000);
+    }
+    lock.unlock();
+  }
+
+ private:
+  bool adaptive;
+  volatile size_t flush_bytes;
+  volatile size_t buffer_limit;
+  size_t min_bytes;
+  size_t max_bytes;
+  atomic<size_t> bytes_observed;
+  size_t last_update_ms;
+  double rate;
+  simple_spinlock lock;
+
+  void update_thresholds(double target_bytes) {
+    size_t target = std::min<double>(std::max<double>(target_bytes, min_bytes),
+                                     max_bytes);
+    flush_bytes = target;
+    buffer_limit = std::min<size_t>(target, FULL_BUFFER_SIZE_LIMIT);
+  }
+};
+
+} // namespace dc_impl
+} // namespace graphlab
+#endif
@@ -74,7 +74,7 @@ namespace graphlab {
       // insert machines into the address map
       all_addrs.resize(nprocs);
       portnums.resize(nprocs);
-      assert(triggered_timeouts.size() >= nprocs);
+      triggered_timeouts.resize(nprocs);
       triggered_timeouts.clear();
       // fill all the socks
       sock.resize(nprocs);
@@ -260,7 +260,7 @@ class dc_tcp_comm:public dc_comm_base {
   timeout_event send_triggered_timeout;
   timeout_event send_all_timeout;
 
-  fixed_dense_bitset<256> triggered_timeouts;
+  dense_bitset triggered_timeouts;
   ////////////       Listening Sockets     //////////////////////
   int listensock;
   thread listenthread;
@@ -287,6 +287,8 @@ namespace graphlab {
     void rpc_recv(size_t len, wild_pointer w) {
       buffer_type tmp;
       iarchive iarc(reinterpret_cast<const char*>(w.ptr), len);
+      // the values are received after the buffer is released
+      iarc.transient = true;
       // first desrialize the source process
       procid_t src_proc; iarc >> src_proc;
 //       logstream(LOG_DEBUG) << rpc.procid() << ": Receiving exchange of length "
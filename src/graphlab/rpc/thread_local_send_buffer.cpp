@@ -17,6 +17,7 @@ thread_local_buffer::thread_local_buffer() {
   archive_locks.resize(nprocs);
 
   bytes_sent.resize(nprocs, 0);
+  queued_bytes.resize(nprocs, 0);
   dc->register_send_buffer(this);
   procid = dc->procid();
 }
@@ -103,7 +104,15 @@ void thread_local_buffer::add_to_queue(procid_t target, char* ptr, size_t len) {
   elem->len = len;
   elem->next = NULL;
   outbuf[target]->enqueue(elem);
-  if (outbuf[target]->approx_size() > NUM_FULL_BUFFER_LIMIT) {
+  flush_controller& controller = dc->get_flush_controller(target);
+  if (controller.is_adaptive()) {
+    controller.observe(len);
+    queued_bytes[target] += len;
+    if (queued_bytes[target] >= controller.flush_threshold()) {
+      queued_bytes[target] = 0;
+      pull_flush_soon(target);
+    }
+  } else if (outbuf[target]->approx_size() > NUM_FULL_BUFFER_LIMIT) {
     pull_flush_soon(target);
   }
 }
@@ -114,7 +123,8 @@ void thread_local_buffer::release(procid_t target, bool do_not_count_bytes_sent)
     inc_calls_sent(target);
   }
 
-  if (current_archive[target].off >= FULL_BUFFER_SIZE_LIMIT) {
+  if (current_archive[target].off >= 
+      dc->get_flush_controller(target).full_buffer_limit()) {
     // shift the buffer into outbuf
     char* ptr = current_archive[target].buf;
     size_t len = current_archive[target].off;
@@ -168,6 +178,7 @@ std::pair<buffer_elem*, buffer_elem*> thread_local_buffer::extract(procid_t targ
         elem->len = len;
         elem->next = NULL;
         outbuf[target]->enqueue(elem);
+        dc->get_flush_controller(target).observe(len);
       }
     } 
   } 
@@ -14,6 +14,8 @@ namespace dc_impl {
 struct thread_local_buffer {
   std::vector<inplace_lf_queue2<buffer_elem>* > outbuf;
   std::vector<size_t> bytes_sent;
+  // bytes queued to each target since this buffer last requested a flush
+  std::vector<size_t> queued_bytes;
 
 
   std::vector<mutex> archive_locks;
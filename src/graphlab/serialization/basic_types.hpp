@@ -134,12 +134,17 @@ namespace graphlab {
     struct deserialize_impl<InArcType, std::string, false> {
       static void exec(InArcType& iarc, std::string& s) {
         //read the length
-        size_t length;
+        size_t length = 0;
         iarc >> length;
+        // a corrupt length fails the archive instead of allocating
+        if (__unlikely__(length > iarc.remaining())) {
+          s.clear();
+          iarc.set_fail();
+          return;
+        }
         //resize the string and read the characters
         s.resize(length);
         iarc.read(const_cast<char*>(s.c_str()), (std::streamsize)length);
-        DASSERT_FALSE(iarc.fail());
       }
     };
 
@@ -170,6 +175,10 @@ namespace graphlab {
     template <typename OutArcType>
     struct serialize_impl<OutArcType, unsigned long , true> {
       static void exec(OutArcType& oarc, const unsigned long & s) {
+        if (__unlikely__(oarc.is_compact())) {
+          oarc.write_varint(s);
+          return;
+        }
         // only bottom 1 byte
         if ((s >> 8) == 0) {
           unsigned char c = 0;
@@ -204,7 +213,12 @@ namespace graphlab {
     template <typename InArcType>
     struct deserialize_impl<InArcType, unsigned long , true> {
       static void exec(InArcType& iarc, unsigned long & s) {
-        unsigned char c;
+        if (__unlikely__(iarc.is_compact())) {
+          s = iarc.read_varint();
+          return;
+        }
+        // if the archive is exhausted c stays 3, and s is left unchanged
+        unsigned char c = 3;
         iarc.read(reinterpret_cast<char*>(&c), 1);
         switch(c) {
          case 0: {
@@ -34,6 +34,8 @@
 #include <graphlab/logger/assertions.hpp>
 #include <graphlab/serialization/is_pod.hpp>
 #include <graphlab/serialization/has_load.hpp>
+#include <graphlab/util/branch_hints.hpp>
+#include <graphlab/serialization/varint.hpp>
 namespace graphlab {
 
   /**
@@ -71,6 +73,9 @@ namespace graphlab {
    * The iarchive object should not be used once the associated stream
    * object is closed or is destroyed.
    *
+   * If compact is set, integers wider than a byte are read as varints.
+   * It must match the mode of the graphlab::oarchive which wrote them.
+   *
    * To use this class, include
    * graphlab/serialization/serialization_includes.hpp
    */
@@ -80,6 +85,13 @@ namespace graphlab {
     const char* buf;
     size_t off;
     size_t len;
+    /// If true, integers are read as varints
+    bool compact;
+    /**
+     * If true, the buffer is released once deserialization returns, so
+     * nothing deserialized may point into it (see pod_view)
+     */
+    bool transient;
 
     /// Directly reads a single character from the input stream
     inline char read_char() {
@@ -95,10 +107,16 @@ namespace graphlab {
 
     /**
      *  Directly reads a sequence of "len" bytes from the
-     *  input stream into the location pointed to by "c"
+     *  input stream into the location pointed to by "c".
+     *  Reading past the end of the buffer reads nothing and puts the
+     *  archive in a failure state.
      */
     inline void read(char* c, size_t l) {
       if (buf) {
+        if (__unlikely__(l > remaining())) {
+          off = len + 1;
+          return;
+        }
         memcpy(c, buf + off, l);
         off += l;
       } else {
@@ -106,12 +124,58 @@ namespace graphlab {
       }
     }
 
+    /**
+     * The number of bytes left in the buffer, or the largest size_t
+     * when reading from a stream, whose length is not known. Used to
+     * validate the lengths of containers before allocating them.
+     */
+    inline size_t remaining() const {
+      if (buf) return off < len ? len - off : 0;
+      return size_t(-1);
+    }
+
+
+    /**
+     * Reads a LEB128 varint. Reading past the end of the buffer, or a
+     * varint which does not end within VARINT_MAX_BYTES bytes, returns 0
+     * and puts the archive in a failure state.
+     */
+    inline uint64_t read_varint() {
+      uint64_t v = 0;
+      for (size_t shift = 0; shift < 64; shift += 7) {
+        unsigned char c;
+        if (buf) {
+          if (__unlikely__(off >= len)) {
+            off = len + 1;
+            return 0;
+          }
+          c = buf[off++];
+        } else {
+          char ch;
+          if (!in->get(ch)) return 0;
+          c = ch;
+        }
+        v |= uint64_t(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) return v;
+      }
+      set_fail();
+      return 0;
+    }
+
+    /// Returns true if integers are read as varints
+    inline bool is_compact() const { return compact; }
 
     /// Returns true if the underlying stream is in a failure state
     inline bool fail() {
       return in == NULL ? off > len : in->fail();
     }
 
+    /// Puts the archive in a failure state, e.g. on a corrupt length
+    inline void set_fail() {
+      if (buf) off = len + 1;
+      else in->setstate(std::ios::failbit);
+    }
+
     /**
      * Constructs an iarchive object.
      * Takes a reference to a generic std::istream object and associates
@@ -119,10 +183,12 @@ namespace graphlab {
      * assiciated input stream.
      */
     inline iarchive(std::istream& instream)
-      : in(&instream), buf(NULL), off(0), len(0) { }
+      : in(&instream), buf(NULL), off(0), len(0), compact(false),
+        transient(false) { }
 
     inline iarchive(const char* buf, size_t len)
-      : in(NULL), buf(buf), off(0), len(len) { }
+      : in(NULL), buf(buf), off(0), len(len), compact(false),
+        transient(false) { }
 
     ~iarchive() {}
   };
@@ -155,11 +221,28 @@ namespace graphlab {
       iarc->read(c, len);
     }
 
+    inline uint64_t read_varint() {
+      return iarc->read_varint();
+    }
+
+    inline size_t remaining() const {
+      return iarc->remaining();
+    }
+
+    inline bool is_compact() const {
+      return iarc->is_compact();
+    }
+
     /// Returns true if the underlying stream is in a failure state
     inline bool fail() {
       return iarc->fail();
     }
 
+    /// Puts the archive in a failure state, e.g. on a corrupt length
+    inline void set_fail() {
+      iarc->set_fail();
+    }
+
     /**
      * Constructs an iarchive_soft_fail object.
      * Takes a reference to a generic std::istream object and associates
@@ -212,12 +295,34 @@ namespace graphlab {
       }
     };
 
+    /// PODs are read as they are
+    template <typename InArcType, typename T, bool IsCompactInteger>
+    struct deserialize_pod_impl {
+      inline static void exec(InArcType& iarc, T &t) {
+        iarc.read(reinterpret_cast<char*>(&t),
+                  sizeof(T));
+      }
+    };
+
+    /// Integers are read as varints by compact archives
+    template <typename InArcType, typename T>
+    struct deserialize_pod_impl<InArcType, T, true> {
+      inline static void exec(InArcType& iarc, T &t) {
+        if (__unlikely__(iarc.is_compact())) {
+          const uint64_t u = iarc.read_varint();
+          t = boost::is_signed<T>::value ? T(zigzag_decode(u)) : T(u);
+        } else {
+          iarc.read(reinterpret_cast<char*>(&t), sizeof(T));
+        }
+      }
+    };
+
     // catch if type is a POD
     template <typename InArcType, typename T>
     struct deserialize_impl<InArcType, T, true>{
       inline static void exec(InArcType& iarc, T &t) {
-        iarc.read(reinterpret_cast<char*>(&t),
-                  sizeof(T));
+        deserialize_pod_impl<InArcType, T,
+                             is_compact_integer<T>::value>::exec(iarc, t);
       }
     };
 
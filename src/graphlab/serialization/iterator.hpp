@@ -121,7 +121,7 @@ namespace graphlab {
     iarc >> length;
     
     // iterate through and send to the output iterator
-    for (size_t x = 0; x < length ; ++x){
+    for (size_t x = 0; x < length && !iarc.fail(); ++x){
       /**
        * A compiler error on this line means that one of the user
        * defined types currently trying to be serialized (e.g.,
@@ -130,6 +130,7 @@ namespace graphlab {
        */
       T v;
       iarc >> v;
+      if (iarc.fail()) break;
       (*result) = v;
       result++;
     }
@@ -35,6 +35,7 @@
 #include <graphlab/logger/assertions.hpp>
 #include <graphlab/serialization/is_pod.hpp>
 #include <graphlab/serialization/has_save.hpp>
+#include <graphlab/serialization/varint.hpp>
 #include <graphlab/util/branch_hints.hpp>
 namespace graphlab {
 
@@ -80,6 +81,13 @@ namespace graphlab {
    * and input, it is necessary to flush the stream before all bytes written to
    * the stringstream are available for input.
    *
+   * If compact is set, integers wider than a byte are written as LEB128
+   * varints (signed integers zigzag encoded first), so that small
+   * values such as vertex ids, counts and sizes take one or a few bytes.
+   * The archive reading them must be in compact mode too. Compact mode
+   * is off by default, and does not change the encoding of floating
+   * point values, PODs which are not integers, or vectors of PODs.
+   *
    * To use this class, include
    * graphlab/serialization/serialization_includes.hpp
    */
@@ -89,12 +97,14 @@ namespace graphlab {
     char* buf;
     size_t off;
     size_t len;
+    /// If true, integers are written as varints
+    bool compact;
     /// constructor. Takes a generic std::ostream object
     inline oarchive(std::ostream& outstream)
-      : out(&outstream),buf(NULL),off(0),len(0) {}
+      : out(&outstream),buf(NULL),off(0),len(0),compact(false) {}
 
     inline oarchive(void)
-      : out(NULL),buf(NULL),off(0),len(0) {}
+      : out(NULL),buf(NULL),off(0),len(0),compact(false) {}
 
     inline void expand_buf(size_t s) {
         if (__unlikely__(off + s > len)) {
@@ -126,6 +136,20 @@ namespace graphlab {
       }
     }
 
+    /// Writes an unsigned integer as a LEB128 varint
+    inline void write_varint(uint64_t v) {
+      if (out == NULL) {
+        expand_buf(VARINT_MAX_BYTES);
+        off += varint_encode(v, buf + off);
+      } else {
+        char tmp[VARINT_MAX_BYTES];
+        out->write(tmp, varint_encode(v, tmp));
+      }
+    }
+
+    /// Returns true if integers are written as varints
+    inline bool is_compact() const { return compact; }
+
     inline void advance(size_t s) {
       if (out == NULL) {
         expand_buf(s);
@@ -177,6 +201,14 @@ namespace graphlab {
       oarc->direct_assign(t);
     }
 
+    inline void write_varint(uint64_t v) {
+      oarc->write_varint(v);
+    }
+
+    inline bool is_compact() const {
+      return oarc->is_compact();
+    }
+
     inline bool fail() {
       return oarc->fail();
     }
@@ -221,12 +253,34 @@ namespace graphlab {
       }
     };
 
+    /// PODs are written as they are
+    template <typename OutArcType, typename T, bool IsCompactInteger>
+    struct serialize_pod_impl {
+      inline static void exec(OutArcType& oarc, const T& t) {
+        oarc.direct_assign(t);
+        //oarc.write(reinterpret_cast<const char*>(&t), sizeof(T));
+      }
+    };
+
+    /// Integers are written as varints by compact archives
+    template <typename OutArcType, typename T>
+    struct serialize_pod_impl<OutArcType, T, true> {
+      inline static void exec(OutArcType& oarc, const T& t) {
+        if (__unlikely__(oarc.is_compact())) {
+          oarc.write_varint(boost::is_signed<T>::value ?
+                            zigzag_encode(int64_t(t)) : uint64_t(t));
+        } else {
+          oarc.direct_assign(t);
+        }
+      }
+    };
+
     /** Catch if type is a POD */
     template <typename OutArcType, typename T>
     struct serialize_impl<OutArcType, T, true> {
       inline static void exec(OutArcType& oarc, const T& t) {
-        oarc.direct_assign(t);
-        //oarc.write(reinterpret_cast<const char*>(&t), sizeof(T));
+        serialize_pod_impl<OutArcType, T,
+                           is_compact_integer<T>::value>::exec(oarc, t);
       }
     };
 
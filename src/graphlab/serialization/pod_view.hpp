@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_SERIALIZATION_POD_VIEW_HPP
+#define GRAPHLAB_SERIALIZATION_POD_VIEW_HPP
+
+#include <vector>
+#include <boost/type_traits.hpp>
+#include <boost/static_assert.hpp>
+#include <graphlab/serialization/iarchive.hpp>
+#include <graphlab/serialization/oarchive.hpp>
+#include <graphlab/serialization/is_pod.hpp>
+
+namespace graphlab {
+
+  /**
+   * \ingroup group_serialization
+   * \brief A read only array of PODs which deserializes without copying
+   * when it can.
+   *
+   * A pod_view is written as its length, a byte counting the padding
+   * which follows it, the padding, and the elements. The padding aligns
+   * the elements relative to the start of the archive buffer. When
+   * loaded from an iarchive reading a buffer in which the elements are
+   * then aligned, the view points into the buffer itself: loading takes
+   * constant time, but the view is only valid as long as the buffer.
+   * Otherwise the elements are copied into storage owned by the view.
+   *
+   * An RPC handler receiving a pod_view argument may get such a view,
+   * which must not be kept past the return of the handler. The padding
+   * is computed against the sender's buffer, so the elements are only
+   * aligned in the receiver's buffer by chance. Archives marked as
+   * iarchive::transient, such as those buffered_exchange deserializes
+   * from, always produce owning copies. The length is validated
+   * against the bytes left in the buffer before anything is read: a
+   * corrupt length leaves the view empty and the archive failed.
+   *
+   * Since the format differs from that of std::vector<T>, a pod_view
+   * must be read back as a pod_view.
+   *
+   * \code
+   *   std::vector<double> values(1000000);
+   *   oarchive oarc;
+   *   oarc << pod_view<double>(values);
+   *   ...
+   *   iarchive iarc(oarc.buf, oarc.off);
+   *   pod_view<double> view;
+   *   iarc >> view;  // no copy: view.data() points into oarc.buf
+   *   double sum = std::accumulate(view.begin(), view.end(), 0.0);
+   * \endcode
+   */
+  template <typename T>
+  class pod_view {
+    BOOST_STATIC_ASSERT(gl_is_pod_or_scaler<T>::value);
+   public:
+    typedef T value_type;
+    typedef const T* const_iterator;
+    typedef const T* iterator;
+
+    pod_view() : ptr(NULL), len(0) { }
+
+    /// A view of the elements of the vector, valid as long as the vector
+    explicit pod_view(const std::vector<T>& vec) :
+      ptr(vec.empty() ? NULL : &(vec[0])), len(vec.size()) { }
+
+    /// A view of n elements at p, valid as long as they are
+    pod_view(const T* p, size_t n) : ptr(p), len(n) { }
+
+    pod_view(const pod_view& other) { *this = other; }
+
+    pod_view& operator=(const pod_view& other) {
+      if (this == &other) return *this;
+      storage = other.storage;
+      len = other.len;
+      ptr = other.owns_data() ? &(storage[0]) : other.ptr;
+      return *this;
+    }
+
+    const T* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + len; }
+
+    /// True if the elements were copied into the view
+    bool owns_data() const { return !storage.empty(); }
+
+    /// A copy of the elements
+    std::vector<T> to_vector() const { return std::vector<T>(begin(), end()); }
+
+    void save(oarchive& oarc) const {
+      oarc << len;
+      // streams do not track the offset and are never aligned
+      const size_t align = boost::alignment_of<T>::value;
+      const unsigned char pad = oarc.out == NULL ?
+        (align - (oarc.off + 1) % align) % align : 0;
+      oarc << pad;
+      for (size_t i = 0; i < pad; ++i) oarc << char(0);
+      if (len > 0) serialize(oarc, ptr, sizeof(T) * len);
+    }
+
+    void load(iarchive& iarc) {
+      size_t n = 0;
+      unsigned char pad = 0;
+      iarc >> n >> pad;
+      storage.clear();
+      len = 0;
+      ptr = NULL;
+      // a corrupt pad or length leaves the view empty and fails the archive
+      if (__unlikely__(pad > iarc.remaining())) {
+        iarc.set_fail();
+        return;
+      }
+      for (size_t i = 0; i < pad; ++i) iarc.read_char();
+      if (__unlikely__(n > iarc.remaining() / sizeof(T))) {
+        iarc.set_fail();
+        return;
+      }
+      len = n;
+      if (n == 0) return;
+      const char* src = iarc.buf == NULL || iarc.transient ?
+        NULL : iarc.buf + iarc.off;
+      if (src != NULL &&
+          reinterpret_cast<size_t>(src) % boost::alignment_of<T>::value == 0) {
+        ptr = reinterpret_cast<const T*>(src);
+        iarc.off += sizeof(T) * n;
+      } else {
+        storage.resize(n);
+        deserialize(iarc, &(storage[0]), sizeof(T) * n);
+        ptr = &(storage[0]);
+      }
+    }
+
+   private:
+    const T* ptr;
+    size_t len;
+    std::vector<T> storage;
+  };
+
+} // namespace graphlab
+
+#endif
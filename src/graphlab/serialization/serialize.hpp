@@ -33,6 +33,7 @@
 #include <graphlab/serialization/map.hpp>
 #include <graphlab/serialization/unordered_map.hpp>
 #include <graphlab/serialization/unordered_set.hpp>
+#include <graphlab/serialization/pod_view.hpp>
 #include <graphlab/serialization/serializable_pod.hpp>
 #include <graphlab/serialization/unsupported_serialize.hpp>
 #include <graphlab/serialization/serialize_to_from_string.hpp>
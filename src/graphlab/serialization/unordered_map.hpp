@@ -24,6 +24,7 @@
 #ifndef GRAPHLAB_SERIALIZE_UNORDERED_MAP_HPP
 #define GRAPHLAB_SERIALIZE_UNORDERED_MAP_HPP
 
+#include <algorithm>
 #include <boost/unordered_map.hpp>
 #include <graphlab/serialization/iarchive.hpp>
 #include <graphlab/serialization/oarchive.hpp>
@@ -51,11 +52,14 @@ namespace archive_detail {
     // get the number of elements to deserialize
     size_t length = 0;
     iarc >> length;    
+    // size the table once, bounded in case the length is corrupt
+    vec.reserve(std::min(length, iarc.remaining()));
     // iterate through and send to the output iterator
-    for (size_t x = 0; x < length ; ++x){
+    for (size_t x = 0; x < length && !iarc.fail(); ++x){
       std::pair<T, U> v;
       iarc >> v;
-      vec[v.first] = v.second;
+      if (iarc.fail()) break;
+      vec.insert(v);
     }
   }
   };
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+#ifndef GRAPHLAB_SERIALIZATION_VARINT_HPP
+#define GRAPHLAB_SERIALIZATION_VARINT_HPP
+
+#include <vector>
+#include <stdint.h>
+#include <boost/type_traits.hpp>
+#include <graphlab/logger/assertions.hpp>
+
+namespace graphlab {
+
+  /**
+   * \ingroup group_serialization
+   * The largest number of bytes of a LEB128 encoded 64 bit integer
+   */
+  static const size_t VARINT_MAX_BYTES = 10;
+
+  /**
+   * \ingroup group_serialization
+   * Maps signed to unsigned integers so that values of small magnitude
+   * have small codes: 0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...
+   */
+  inline uint64_t zigzag_encode(int64_t v) {
+    return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+  }
+
+  /// \ingroup group_serialization The inverse of zigzag_encode()
+  inline int64_t zigzag_decode(uint64_t u) {
+    return int64_t(u >> 1) ^ -int64_t(u & 1);
+  }
+
+  /**
+   * \ingroup group_serialization
+   * Writes v as a LEB128 varint: 7 bits per byte, least significant
+   * first, with the high bit set on all but the last byte. out must have
+   * room for VARINT_MAX_BYTES.
+   * \return The number of bytes written
+   */
+  inline size_t varint_encode(uint64_t v, char* out) {
+    size_t n = 0;
+    while (v >= 0x80) {
+      out[n++] = char(v | 0x80);
+      v >>= 7;
+    }
+    out[n++] = char(v);
+    return n;
+  }
+
+  /// \ingroup group_serialization The number of bytes varint_encode() writes
+  inline size_t varint_size(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+      v >>= 7;
+      ++n;
+    }
+    return n;
+  }
+
+  namespace archive_detail {
+    /// Integers wider than a byte, which compact archives code as varints
+    template <typename T>
+    struct is_compact_integer {
+      static const bool value = boost::is_integral<T>::value && sizeof(T) > 1;
+    };
+  } // namespace archive_detail
+
+  /**
+   * \ingroup group_serialization
+   * Serializes a sorted vector of integer ids as its length followed
+   * by the differences between consecutive ids, all as varints. Runs of
+   * nearby ids take a byte or two per id whether or not the archive is
+   * in compact mode.
+   * \code
+   *   std::vector<vertex_id_type> vids; // sorted
+   *   serialize_sorted_ids(oarc, vids);
+   *   ...
+   *   deserialize_sorted_ids(iarc, vids);
+   * \endcode
+   */
+  template <typename OutArcType, typename T>
+  void serialize_sorted_ids(OutArcType& oarc, const std::vector<T>& ids) {
+    oarc.write_varint(ids.size());
+    uint64_t prev = 0;
+    for (size_t i = 0; i < ids.size(); ++i) {
+      const uint64_t id = uint64_t(ids[i]);
+      DASSERT_GE(id, prev);
+      oarc.write_varint(id - prev);
+      prev = id;
+    }
+  }
+
+  /// \ingroup group_serialization The inverse of serialize_sorted_ids()
+  template <typename InArcType, typename T>
+  void deserialize_sorted_ids(InArcType& iarc, std::vector<T>& ids) {
+    const uint64_t len = iarc.read_varint();
+    ids.clear();
+    uint64_t id = 0;
+    for (uint64_t i = 0; i < len && !iarc.fail(); ++i) {
+      id += iarc.read_varint();
+      ids.push_back(T(id));
+    }
+  }
+
+} // namespace graphlab
+
+#endif
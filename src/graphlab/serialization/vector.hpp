@@ -24,6 +24,7 @@
 #ifndef GRAPHLAB_SERIALIZE_VECTOR_HPP
 #define GRAPHLAB_SERIALIZE_VECTOR_HPP
 #include <vector>
+#include <algorithm>
 #include <graphlab/serialization/iarchive.hpp>
 #include <graphlab/serialization/oarchive.hpp>
 #include <graphlab/serialization/iterator.hpp>
@@ -72,7 +73,9 @@ namespace graphlab {
     struct vector_serialize_impl<OutArcType, ValueType, true > {
       static void exec(OutArcType& oarc, const std::vector<ValueType>& vec) {
         oarc << size_t(vec.size());
-        serialize(oarc, &(vec[0]),sizeof(ValueType)*vec.size());
+        if (!vec.empty()) {
+          serialize(oarc, &(vec[0]),sizeof(ValueType)*vec.size());
+        }
       }
     };
 
@@ -82,8 +85,10 @@ namespace graphlab {
       static void exec(InArcType& iarc, std::vector<ValueType>& vec){
         size_t len;
         iarc >> len;
-        vec.clear(); vec.reserve(len);
-        deserialize_iterator<InArcType, ValueType>(iarc, std::inserter(vec, vec.end()));
+        // an element may take no bytes, so a corrupt length can only be
+        // bounded for the reservation
+        vec.clear(); vec.reserve(std::min(len, iarc.remaining()));
+        deserialize_iterator<InArcType, ValueType>(iarc, std::back_inserter(vec));
       }
     };
 
@@ -93,8 +98,16 @@ namespace graphlab {
       static void exec(InArcType& iarc, std::vector<ValueType>& vec){
         size_t len;
         iarc >> len;
-        vec.clear(); vec.resize(len);
-        deserialize(iarc, &(vec[0]), sizeof(ValueType)*vec.size());
+        vec.clear();
+        // a corrupt length fails the archive instead of allocating
+        if (__unlikely__(len > iarc.remaining() / sizeof(ValueType))) {
+          iarc.set_fail();
+          return;
+        }
+        vec.resize(len);
+        if (len > 0) {
+          deserialize(iarc, &(vec[0]), sizeof(ValueType)*vec.size());
+        }
       }
     };
 
@@ -25,6 +25,7 @@
 #include <algorithm>
 #include <graphlab/serialization/oarchive.hpp>
 #include <graphlab/serialization/iarchive.hpp>
+#include <graphlab/serialization/is_pod.hpp>
 
 
 
@@ -102,5 +103,14 @@ namespace graphlab {
     }
   
   };
+
+  /**
+   * A wrapper of a POD type is itself a POD, so that for instance the
+   * accumulators of POD aggregators are reduced with a memcpy.
+   */
+  template <typename T>
+  struct gl_is_pod<conditional_addition_wrapper<T> > {
+    BOOST_STATIC_CONSTANT(bool, value = gl_is_pod<T>::value);
+  };
 } // namespace graphlab
 #endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_UTIL_HYPERLOGLOG_HPP
+#define GRAPHLAB_UTIL_HYPERLOGLOG_HPP
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <graphlab/logger/assertions.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+
+namespace graphlab {
+
+/**
+ * \ingroup util
+ * A HyperLogLog counter (Flajolet et al. 2007) which estimates the
+ * number of distinct 64 bit values inserted into it, with a relative
+ * standard error of about 1.04 / sqrt(2^precision).
+ *
+ * The 2^precision registers are 5 bits wide, and are packed 12 to a 64
+ * bit word. The union of two counters of the same precision (operator+=)
+ * takes the maximum of each pair of registers, computed a word at a
+ * time with broadword operations (Boldi, Rosa and Vigna, HyperANF,
+ * WWW 2011), and two words at a time with SSE2.
+ *
+ * A default constructed counter has no registers and is the identity
+ * of operator+=, so it can be used as a gather type.
+ *
+ * \code
+ * hyperloglog counter(10);
+ * for (size_t i = 0; i < 1000000; ++i) counter.insert(i % 1000);
+ * double n = counter.estimate(); // about 1000
+ * \endcode
+ */
+class hyperloglog {
+ public:
+  static const size_t REGISTER_BITS = 5;
+  static const size_t REGISTERS_PER_WORD = 12;
+  static const uint64_t REGISTER_MASK = 0x1f;
+  /// The most significant bit of each register
+  static const uint64_t HIGH_BITS = 0x0842108421084210ULL;
+  static const size_t MIN_PRECISION = 4;
+  static const size_t MAX_PRECISION = 16;
+
+  /// An empty counter without registers
+  hyperloglog() : b(0) { }
+
+  /// A counter with 2^precision registers
+  explicit hyperloglog(size_t precision) : b(precision) {
+    ASSERT_GE(precision, size_t(MIN_PRECISION));
+    ASSERT_LE(precision, size_t(MAX_PRECISION));
+    words.resize((num_registers() + REGISTERS_PER_WORD - 1) /
+                 REGISTERS_PER_WORD, 0);
+  }
+
+  /// log2 of the number of registers, or 0 for an empty counter
+  size_t precision() const { return b; }
+
+  size_t num_registers() const { return b == 0 ? 0 : size_t(1) << b; }
+
+  /// Bytes used by the registers
+  size_t memory_usage() const { return words.size() * sizeof(uint64_t); }
+
+  /// A 64 bit hash (the finalizer of MurmurHash3) of an integer
+  static uint64_t hash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  /// Inserts a value. Equal values are counted once.
+  void insert(uint64_t value) { insert_hash(hash(value)); }
+
+  /// Inserts a value by its (well mixed) 64 bit hash
+  void insert_hash(uint64_t h) {
+    const size_t index = h >> (64 - b);
+    const uint64_t rest = h << b;
+    size_t rank = rest == 0 ? 64 - b + 1 : __builtin_clzll(rest) + 1;
+    if (rank > REGISTER_MASK) rank = REGISTER_MASK;
+    if (rank > get_register(index)) set_register(index, rank);
+  }
+
+  size_t get_register(size_t i) const {
+    return (words[i / REGISTERS_PER_WORD] >>
+            (REGISTER_BITS * (i % REGISTERS_PER_WORD))) & REGISTER_MASK;
+  }
+
+  void set_register(size_t i, size_t value) {
+    const size_t shift = REGISTER_BITS * (i % REGISTERS_PER_WORD);
+    uint64_t& w = words[i / REGISTERS_PER_WORD];
+    w = (w & ~(REGISTER_MASK << shift)) | (uint64_t(value) << shift);
+  }
+
+  /// Register-wise maximum of two words of packed registers
+  static uint64_t register_max(uint64_t x, uint64_t y) {
+    // the high bit of each register of d is set if the low 4 bits of
+    // the register of x are >= those of y: the high bit of x | H stops
+    // the borrow from reaching the next register
+    const uint64_t d = (x | HIGH_BITS) - (y & ~HIGH_BITS);
+    const uint64_t ge = ((x & ~y) | (~(x ^ y) & d)) & HIGH_BITS;
+    // spread the high bit over its register
+    const uint64_t mask = (ge - (ge >> (REGISTER_BITS - 1))) | ge;
+    return (x & mask) | (y & ~mask);
+  }
+
+  /// The union of the two sets: the maximum of each pair of registers
+  hyperloglog& operator+=(const hyperloglog& other) {
+    if (other.b == 0) return *this;
+    if (b == 0) {
+      *this = other;
+      return *this;
+    }
+    ASSERT_EQ(b, other.b);
+    const size_t n = words.size();
+    uint64_t* x = &(words[0]);
+    const uint64_t* y = &(other.words[0]);
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i high = _mm_set1_epi64x(HIGH_BITS);
+    for (; i + 2 <= n; i += 2) {
+      const __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+      const __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+      const __m128i d = _mm_sub_epi64(_mm_or_si128(vx, high),
+                                      _mm_andnot_si128(high, vy));
+      const __m128i eq = _mm_andnot_si128(_mm_xor_si128(vx, vy), d);
+      const __m128i ge = _mm_and_si128(
+          _mm_or_si128(_mm_andnot_si128(vy, vx), eq), high);
+      const __m128i mask = _mm_or_si128(
+          _mm_sub_epi64(ge, _mm_srli_epi64(ge, REGISTER_BITS - 1)), ge);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(x + i),
+                       _mm_or_si128(_mm_and_si128(vx, mask),
+                                    _mm_andnot_si128(mask, vy)));
+    }
+#endif
+    for (; i < n; ++i) x[i] = register_max(x[i], y[i]);
+    return *this;
+  }
+
+  /// True if the registers are equal
+  bool operator==(const hyperloglog& other) const {
+    return b == other.b && words == other.words;
+  }
+  bool operator!=(const hyperloglog& other) const { return !(*this == other); }
+
+  /// The estimated number of distinct values inserted
+  double estimate() const {
+    if (b == 0) return 0;
+    const size_t m = num_registers();
+    double sum = 0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < m; ++i) {
+      const size_t r = get_register(i);
+      sum += std::ldexp(1.0, -int(r));
+      zeros += (r == 0);
+    }
+    double alpha;
+    switch (m) {
+      case 16: alpha = 0.673; break;
+      case 32: alpha = 0.697; break;
+      case 64: alpha = 0.709; break;
+      default: alpha = 0.7213 / (1.0 + 1.079 / m);
+    }
+    const double e = alpha * double(m) * double(m) / sum;
+    // linear counting for small cardinalities
+    if (e <= 2.5 * m && zeros > 0) {
+      return double(m) * std::log(double(m) / double(zeros));
+    }
+    return e;
+  }
+
+  /// Resets all registers to 0
+  void clear() { std::fill(words.begin(), words.end(), 0); }
+
+  void save(oarchive& oarc) const { oarc << b << words; }
+  void load(iarchive& iarc) { iarc >> b >> words; }
+
+ private:
+  uint16_t b;
+  std::vector<uint64_t> words;
+};
+
+} // namespace graphlab
+
+#endif
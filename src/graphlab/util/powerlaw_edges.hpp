@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_UTIL_POWERLAW_EDGES_HPP
+#define GRAPHLAB_UTIL_POWERLAW_EDGES_HPP
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <graphlab/util/random.hpp>
+
+namespace graphlab {
+
+/**
+ * \ingroup util
+ * Generates an edge list on nverts vertices for the benchmarks, by
+ * drawing nedges pairs of endpoints independently with the probability
+ * of vertex i proportional to (i + 1)^(-1 / (alpha - 1)), so that the
+ * degrees follow a power law with exponent alpha. Self loops are
+ * dropped and duplicate edges are kept. If scramble is set the vertex
+ * ids are then permuted at random, so that they are not correlated with
+ * the degree. The edges are drawn from graphlab::random, so the result
+ * depends only on its seed.
+ */
+inline std::vector<std::pair<size_t, size_t> >
+make_powerlaw_edges(size_t nverts, size_t nedges, double alpha,
+                    bool scramble = false) {
+  std::vector<double> prob(nverts);
+  for (size_t i = 0; i < nverts; ++i) {
+    prob[i] = std::pow(double(i + 1), -1.0 / (alpha - 1));
+  }
+  random::pdf2cdf(prob);
+  // a bijection on [0, nverts) to scramble the ids
+  std::vector<size_t> ids;
+  if (scramble) {
+    ids.resize(nverts);
+    for (size_t i = 0; i < nverts; ++i) ids[i] = i;
+    random::shuffle(ids);
+  }
+  std::vector<std::pair<size_t, size_t> > edges;
+  edges.reserve(nedges);
+  for (size_t i = 0; i < nedges; ++i) {
+    size_t u = random::multinomial_cdf(prob);
+    size_t v = random::multinomial_cdf(prob);
+    if (u == v) continue;
+    if (scramble) { u = ids[u]; v = ids[v]; }
+    edges.push_back(std::make_pair(u, v));
+  }
+  return edges;
+}
+
+} // namespace graphlab
+
+#endif
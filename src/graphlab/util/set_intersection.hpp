@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#ifndef GRAPHLAB_UTIL_SET_INTERSECTION_HPP
+#define GRAPHLAB_UTIL_SET_INTERSECTION_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace graphlab {
+
+/**
+ * \ingroup util
+ * When one sorted set is more than this many times larger than the
+ * other, intersection_size() and sorted_intersection() use galloping
+ * search instead of a linear merge.
+ */
+static const size_t INTERSECTION_GALLOP_RATIO = 32;
+
+namespace set_intersection_impl {
+
+/**
+ * Returns the first position in [begin, end) which is not less than
+ * val, probing begin + 1, begin + 2, begin + 4, ... before the binary
+ * search, so the cost is logarithmic in the distance moved rather than
+ * the length of the range.
+ */
+template <typename T>
+inline const T* gallop(const T* begin, const T* end, const T& val) {
+  size_t step = 1;
+  const T* lo = begin;
+  while (lo + step < end && lo[step] < val) {
+    lo += step;
+    step <<= 1;
+  }
+  const T* hi = std::min(lo + step + 1, end);
+  return std::lower_bound(lo, hi, val);
+}
+
+/// Merges the remainders of the two sets after a vectorized loop
+template <typename T>
+inline size_t merge_tail(const T* a, const T* aend, const T* b, const T* bend) {
+  size_t count = 0;
+  while (a != aend && b != bend) {
+    if (*a < *b) ++a;
+    else if (*b < *a) ++b;
+    else { ++count; ++a; ++b; }
+  }
+  return count;
+}
+
+#if defined(__SSE2__)
+/*
+ * The vectorized kernels compare a block of each set against all
+ * rotations of a block of the other set, and then advance the block
+ * with the smaller maximum (or both). Since the elements of each set
+ * are distinct, every common element is found in exactly one block
+ * comparison.
+ */
+inline size_t simd_count(const uint32_t* a, size_t na,
+                         const uint32_t* b, size_t nb) {
+  size_t count = 0;
+  size_t i = 0, j = 0;
+  const size_t na4 = na & ~size_t(3), nb4 = nb & ~size_t(3);
+  while (i < na4 && j < nb4) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+    const __m128i vb1 = _mm_shuffle_epi32(vb0, _MM_SHUFFLE(0,3,2,1));
+    const __m128i vb2 = _mm_shuffle_epi32(vb0, _MM_SHUFFLE(1,0,3,2));
+    const __m128i vb3 = _mm_shuffle_epi32(vb0, _MM_SHUFFLE(2,1,0,3));
+    const __m128i eq = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi32(va, vb0), _mm_cmpeq_epi32(va, vb1)),
+        _mm_or_si128(_mm_cmpeq_epi32(va, vb2), _mm_cmpeq_epi32(va, vb3)));
+    count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+    const uint32_t amax = a[i + 3], bmax = b[j + 3];
+    if (amax <= bmax) i += 4;
+    if (bmax <= amax) j += 4;
+  }
+  return count + merge_tail(a + i, a + na, b + j, b + nb);
+}
+#endif
+
+#if defined(__AVX2__)
+inline size_t simd_count(const uint64_t* a, size_t na,
+                         const uint64_t* b, size_t nb) {
+  size_t count = 0;
+  size_t i = 0, j = 0;
+  const size_t na4 = na & ~size_t(3), nb4 = nb & ~size_t(3);
+  while (i < na4 && j < nb4) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb0 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+    const __m256i vb1 = _mm256_permute4x64_epi64(vb0, _MM_SHUFFLE(0,3,2,1));
+    const __m256i vb2 = _mm256_permute4x64_epi64(vb0, _MM_SHUFFLE(1,0,3,2));
+    const __m256i vb3 = _mm256_permute4x64_epi64(vb0, _MM_SHUFFLE(2,1,0,3));
+    const __m256i eq = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi64(va, vb0), _mm256_cmpeq_epi64(va, vb1)),
+        _mm256_or_si256(_mm256_cmpeq_epi64(va, vb2), _mm256_cmpeq_epi64(va, vb3)));
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+    const uint64_t amax = a[i + 3], bmax = b[j + 3];
+    if (amax <= bmax) i += 4;
+    if (bmax <= amax) j += 4;
+  }
+  return count + merge_tail(a + i, a + na, b + j, b + nb);
+}
+#elif defined(__SSE4_1__)
+inline size_t simd_count(const uint64_t* a, size_t na,
+                         const uint64_t* b, size_t nb) {
+  size_t count = 0;
+  size_t i = 0, j = 0;
+  const size_t na2 = na & ~size_t(1), nb2 = nb & ~size_t(1);
+  while (i < na2 && j < nb2) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+    const __m128i vb1 = _mm_shuffle_epi32(vb0, _MM_SHUFFLE(1,0,3,2));
+    const __m128i eq = _mm_or_si128(_mm_cmpeq_epi64(va, vb0),
+                                    _mm_cmpeq_epi64(va, vb1));
+    count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(eq)));
+    const uint64_t amax = a[i + 1], bmax = b[j + 1];
+    if (amax <= bmax) i += 2;
+    if (bmax <= amax) j += 2;
+  }
+  return count + merge_tail(a + i, a + na, b + j, b + nb);
+}
+#endif
+
+/// Fallback for element types without a vectorized kernel
+template <typename T>
+inline size_t simd_count(const T* a, size_t na, const T* b, size_t nb) {
+  return merge_tail(a, a + na, b, b + nb);
+}
+
+} // namespace set_intersection_impl
+
+
+/**
+ * \ingroup util
+ * Counts the common elements of two sorted arrays of distinct elements
+ * with a linear merge.
+ */
+template <typename T>
+size_t intersection_size_merge(const T* a, size_t na, const T* b, size_t nb) {
+  return set_intersection_impl::merge_tail(a, a + na, b, b + nb);
+}
+
+/**
+ * \ingroup util
+ * Counts the common elements of two sorted arrays of distinct elements
+ * by galloping search of each element of the smaller array in the
+ * larger one. Takes O(n_small log(n_large / n_small)) time.
+ */
+template <typename T>
+size_t intersection_size_galloping(const T* a, size_t na,
+                                   const T* b, size_t nb) {
+  if (na > nb) { std::swap(a, b); std::swap(na, nb); }
+  const T* aend = a + na;
+  const T* bend = b + nb;
+  size_t count = 0;
+  for (; a != aend && b != bend; ++a) {
+    b = set_intersection_impl::gallop(b, bend, *a);
+    if (b != bend && *b == *a) { ++count; ++b; }
+  }
+  return count;
+}
+
+/**
+ * \ingroup util
+ * Counts the common elements of two sorted arrays of distinct elements
+ * by comparing blocks of both arrays at once. The kernels are compiled
+ * according to the target instruction set: 32 bit elements need SSE2,
+ * 64 bit elements need SSE4.1 (blocks of 2) or AVX2 (blocks of 4).
+ * Other element types, or targets without these, use a linear merge.
+ */
+template <typename T>
+size_t intersection_size_simd(const T* a, size_t na, const T* b, size_t nb) {
+  return set_intersection_impl::simd_count(a, na, b, nb);
+}
+
+/**
+ * \ingroup util
+ * Counts the common elements of two sorted arrays of distinct elements,
+ * picking the kernel by the ratio of their sizes: galloping when one is
+ * more than INTERSECTION_GALLOP_RATIO times larger than the other, and
+ * the vectorized block intersection otherwise.
+ *
+ * \code
+ * std::vector<vertex_id_type> a, b; // sorted, no duplicates
+ * size_t common = intersection_size(a, b);
+ * \endcode
+ */
+template <typename T>
+size_t intersection_size(const T* a, size_t na, const T* b, size_t nb) {
+  if (na == 0 || nb == 0) return 0;
+  if (na > nb) { std::swap(a, b); std::swap(na, nb); }
+  // disjoint ranges are common with degree ordered adjacency lists
+  if (a[na - 1] < b[0] || b[nb - 1] < a[0]) return 0;
+  if (nb / na > INTERSECTION_GALLOP_RATIO) {
+    return intersection_size_galloping(a, na, b, nb);
+  }
+  return intersection_size_simd(a, na, b, nb);
+}
+
+/// \copydoc intersection_size(const T*, size_t, const T*, size_t)
+template <typename T>
+size_t intersection_size(const std::vector<T>& a, const std::vector<T>& b) {
+  if (a.empty() || b.empty()) return 0;
+  return intersection_size(&(a[0]), a.size(), &(b[0]), b.size());
+}
+
+/**
+ * \ingroup util
+ * Writes the common elements of two sorted arrays of distinct elements
+ * to out in increasing order, and returns the end of the output.
+ * Uses galloping search when the sizes differ by more than
+ * INTERSECTION_GALLOP_RATIO and a linear merge otherwise.
+ */
+template <typename T, typename OutputIterator>
+OutputIterator sorted_intersection(const T* a, size_t na,
+                                   const T* b, size_t nb,
+                                   OutputIterator out) {
+  if (na > nb) { std::swap(a, b); std::swap(na, nb); }
+  const T* aend = a + na;
+  const T* bend = b + nb;
+  if (na > 0 && nb / na > INTERSECTION_GALLOP_RATIO) {
+    for (; a != aend && b != bend; ++a) {
+      b = set_intersection_impl::gallop(b, bend, *a);
+      if (b != bend && *b == *a) { *out = *a; ++out; ++b; }
+    }
+    return out;
+  }
+  while (a != aend && b != bend) {
+    if (*a < *b) ++a;
+    else if (*b < *a) ++b;
+    else { *out = *a; ++out; ++a; ++b; }
+  }
+  return out;
+}
+
+} // namespace graphlab
+
+#endif
@@ -149,6 +149,22 @@ namespace graphlab {
       engine.internal_clear_gather_cache(vertex);      
     }
 
+    /**
+     * Push a change to an incremental aggregator.
+     */
+    void internal_aggregate_delta(const std::string& key,
+                                  const void* delta,
+                                  const std::type_info& type) {
+      typename engine_type::aggregator_type* aggregator =
+          engine.get_aggregator();
+      if (aggregator == NULL) {
+        logstream(LOG_FATAL) << "Aggregation not supported by this engine!"
+                             << std::endl;
+        return;
+      }
+      aggregator->add_delta(key, delta, type);
+    }
+
 
                                                 
 
@@ -25,7 +25,9 @@
 #define GRAPHLAB_ICONTEXT_HPP
 
 #include <set>
+#include <string>
 #include <vector>
+#include <typeinfo>
 #include <cassert>
 #include <iostream>
 
@@ -264,6 +266,32 @@ namespace graphlab {
      */
     virtual void clear_gather_cache(const vertex_type& vertex) { } 
 
+    /**
+     * \brief Push a change to an incremental aggregator.
+     *
+     * Adds delta to the running total of the aggregator registered under
+     * key with iengine::add_vertex_delta_aggregator() or
+     * iengine::add_edge_delta_aggregator(). The vertex program should push
+     * the difference between the new and the old contribution of the
+     * vertex (or edge) whenever it changes. T must be the ReductionType
+     * the aggregator was created with.
+     *
+     * \param key [in] the name of the aggregator
+     * \param delta [in] the change to add to the aggregated value
+     */
+    template <typename T>
+    void aggregate_delta(const std::string& key, const T& delta) {
+      internal_aggregate_delta(key, &delta, typeid(T));
+    }
+
+    /**
+     * \internal
+     * Type erased implementation of aggregate_delta().
+     */
+    virtual void internal_aggregate_delta(const std::string& key,
+                                          const void* delta,
+                                          const std::type_info& type) { }
+
   }; // end of icontext
   
 } // end of namespace
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <sstream>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/graph/columnar_format.hpp>
+using namespace graphlab;
+
+struct pair_value : public graphlab::IS_POD_TYPE {
+  int a;
+  float b;
+};
+
+class ColumnarFormatTestSuite : public CxxTest::TestSuite {
+public:
+  void check_vertices(bool compress) {
+    std::stringstream strm;
+    {
+      columnar::block_writer<double> writer(strm, columnar::VERTEX_FILE,
+                                            compress, 7);
+      for (size_t i = 0; i < 100; ++i) writer.add(i * 3, i * 0.5);
+      writer.close();
+    }
+    columnar::block_reader reader(strm);
+    TS_ASSERT(reader.good());
+    TS_ASSERT(!reader.is_edge_file());
+    TS_ASSERT_EQUALS(reader.get_header().value_code, (uint32_t)columnar::DOUBLE);
+    size_t row = 0;
+    while(reader.next_block()) {
+      TS_ASSERT_LESS_THAN_EQUALS(reader.num_rows(), 7);
+      for (size_t i = 0; i < reader.num_rows(); ++i, ++row) {
+        TS_ASSERT_EQUALS(reader.id(i), row * 3);
+        TS_ASSERT_EQUALS(reader.value<double>(i), row * 0.5);
+      }
+    }
+    TS_ASSERT_EQUALS(row, 100);
+    TS_ASSERT(reader.good());
+  }
+
+  void test_vertices(void) {
+    check_vertices(false);
+    check_vertices(true);
+  }
+
+  void test_edges(void) {
+    std::stringstream strm;
+    {
+      columnar::block_writer<pair_value> writer(strm, columnar::EDGE_FILE,
+                                                true, 16);
+      for (int i = 0; i < 40; ++i) {
+        pair_value v; v.a = -i; v.b = i * 0.25;
+        writer.add(i, i + 1, v);
+      }
+      writer.close();
+    }
+    columnar::block_reader reader(strm);
+    TS_ASSERT(reader.is_edge_file());
+    TS_ASSERT_EQUALS(reader.get_header().value_code, (uint32_t)columnar::BYTES);
+    TS_ASSERT_EQUALS(reader.get_header().value_width, sizeof(pair_value));
+    int row = 0;
+    while(reader.next_block()) {
+      for (size_t i = 0; i < reader.num_rows(); ++i, ++row) {
+        TS_ASSERT_EQUALS(reader.id(i), (vertex_id_type)row);
+        TS_ASSERT_EQUALS(reader.target(i), (vertex_id_type)row + 1);
+        pair_value v = reader.value<pair_value>(i);
+        TS_ASSERT_EQUALS(v.a, -row);
+        TS_ASSERT_EQUALS(v.b, row * 0.25);
+      }
+    }
+    TS_ASSERT_EQUALS(row, 40);
+  }
+
+  void test_empty_values(void) {
+    std::stringstream strm;
+    {
+      columnar::block_writer<graphlab::empty> writer(strm, columnar::EDGE_FILE,
+                                                     false);
+      writer.add(5, 6, graphlab::empty());
+      writer.close();
+    }
+    columnar::block_reader reader(strm);
+    TS_ASSERT_EQUALS(reader.get_header().value_width, 0);
+    TS_ASSERT(reader.next_block());
+    TS_ASSERT_EQUALS(reader.num_rows(), 1);
+    TS_ASSERT_EQUALS(reader.id(0), 5);
+    TS_ASSERT_EQUALS(reader.target(0), 6);
+    TS_ASSERT(!reader.next_block());
+  }
+
+  void test_bad_input(void) {
+    std::stringstream strm("not a columnar file at all, just some text");
+    columnar::block_reader reader(strm);
+    TS_ASSERT(!reader.good());
+    TS_ASSERT(!reader.next_block());
+    // a compressed block with an empty payload
+    std::stringstream empty_strm;
+    columnar::block_writer<double> writer(empty_strm, columnar::VERTEX_FILE,
+                                          true);
+    columnar::block_header bheader;
+    bheader.nrows = 1;
+    bheader.nbytes = 0;
+    empty_strm.write(reinterpret_cast<const char*>(&bheader), sizeof(bheader));
+    columnar::block_reader empty_reader(empty_strm);
+    TS_ASSERT(empty_reader.good());
+    TS_ASSERT(!empty_reader.next_block());
+    TS_ASSERT(!empty_reader.good());
+    // a compressed block whose payload is not a zlib stream
+    std::stringstream corrupt_strm;
+    columnar::block_writer<double> corrupt_writer(corrupt_strm,
+                                                  columnar::VERTEX_FILE, true);
+    const char garbage[] = "not a zlib stream";
+    bheader.nrows = 1;
+    bheader.nbytes = sizeof(garbage);
+    corrupt_strm.write(reinterpret_cast<const char*>(&bheader), sizeof(bheader));
+    corrupt_strm.write(garbage, sizeof(garbage));
+    columnar::block_reader corrupt_reader(corrupt_strm);
+    TS_ASSERT(corrupt_reader.good());
+    TS_ASSERT(!corrupt_reader.next_block());
+    TS_ASSERT(!corrupt_reader.good());
+  }
+};
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/*
+ * Sends pod_views through a buffered_exchange and checks that the
+ * received views own their elements, since the exchange deserializes
+ * them from a buffer which is released before recv() returns them.
+ */
+
+#include <iostream>
+#include <vector>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/rpc/buffered_exchange.hpp>
+#include <graphlab/rpc/dc_init_from_mpi.hpp>
+#include <graphlab/serialization/pod_view.hpp>
+#include <graphlab/util/mpi_tools.hpp>
+using namespace graphlab;
+
+
+int main(int argc, char ** argv) {
+  mpi_tools::init(argc, argv);
+  global_logger().set_log_level(LOG_INFO);
+
+  dc_init_param param;
+  if (init_param_from_mpi(param) == false) {
+    return 0;
+  }
+  distributed_control dc(param);
+
+  const size_t nviews = 100;
+  const size_t nvalues = 1000;
+  // a small buffer size so that the views are spread over many buffers
+  buffered_exchange<pod_view<double> > exchange(dc, 1, 64 * 1024);
+  std::vector<double> values(nvalues);
+  for (procid_t proc = 0; proc < dc.numprocs(); ++proc) {
+    for (size_t i = 0; i < nviews; ++i) {
+      for (size_t j = 0; j < nvalues; ++j) {
+        values[j] = dc.procid() * 1000000.0 + i * 1000.0 + j;
+      }
+      exchange.send(proc, pod_view<double>(values));
+    }
+  }
+  exchange.flush();
+
+  // keep all the views until every buffer has been received
+  std::vector<std::vector<pod_view<double> > > received(dc.numprocs());
+  procid_t src;
+  buffered_exchange<pod_view<double> >::buffer_type buffer;
+  while (exchange.recv(src, buffer)) {
+    received[src].insert(received[src].end(), buffer.begin(), buffer.end());
+  }
+  for (procid_t proc = 0; proc < dc.numprocs(); ++proc) {
+    ASSERT_EQ(received[proc].size(), nviews);
+    for (size_t i = 0; i < nviews; ++i) {
+      const pod_view<double>& view = received[proc][i];
+      ASSERT_TRUE(view.owns_data());
+      ASSERT_EQ(view.size(), nvalues);
+      for (size_t j = 0; j < nvalues; ++j) {
+        ASSERT_EQ(view[j], proc * 1000000.0 + i * 1000.0 + j);
+      }
+    }
+  }
+  dc.barrier();
+  if (dc.procid() == 0) std::cout << "pod_view exchange test passed" << std::endl;
+  mpi_tools::finalize();
+}
@@ -38,6 +38,7 @@ std::vector<T> operator+=(std::vector<T>& v1, const std::vector<T>& v2) {
 #include <graphlab/util/mpi_tools.hpp>
 #include <graphlab/rpc/dc_init_from_mpi.hpp>
 #include <graphlab/graph/distributed_graph.hpp>
+#include <graphlab/util/set_intersection.hpp>
 #include <graphlab/macros_def.hpp>
 
 
@@ -124,6 +125,92 @@ class distributed_graph_test  {
      dc->cout() << "\n+ Pass test: graph save load binary. :) \n";
    }
 
+   /**
+    * Test the compact vertex index, with dense and sparse vertex ids
+    */
+   void test_compact_metadata() {
+     graphlab::graphlab_options opts;
+     opts.get_graph_args().set_option("compact", true);
+     graphlab::distributed_graph<vertex_data, edge_data> g(*dc, opts);
+     test_add_edge_impl(g, 1000);
+     ASSERT_TRUE(g.is_compact() || g.num_local_vertices() == 0);
+     check_vertex_index(g);
+     test_save_load_impl(g);
+
+     g.clear();
+     for (size_t i = 0; i < 100; ++i) {
+       if (i % dc->numprocs() == dc->procid()) {
+         g.add_edge(i * 1000003, (i + 1) * 1000003, edge_data(i, i + 1));
+       }
+     }
+     g.finalize();
+     check_vertex_index(g);
+     ASSERT_FALSE(g.contains_vertex(1));
+     if (g.is_dynamic()) {
+       for (size_t i = 0; i < 100; ++i) {
+         if (i % dc->numprocs() == dc->procid()) {
+           g.add_edge(i * 1000003 + 1, i * 1000003, edge_data(i, i));
+         }
+       }
+       g.finalize();
+       check_vertex_index(g);
+     }
+     dc->cout() << "\n+ Pass test: compact vertex index. :) \n";
+   }
+
+   /**
+    * Test the local neighborhood index on a complete graph of 6 vertices
+    * with both edge directions and a self edge.
+    */
+   void test_local_neighborhoods() {
+     typedef graphlab::distributed_graph<vertex_data, edge_data> graph_type;
+     graphlab::graphlab_options opts;
+     opts.get_graph_args().set_option("neighborhoods", std::string("all"));
+     graph_type g(*dc, opts);
+     if (dc->procid() == 0) {
+       for (size_t i = 0; i < 6; ++i) {
+         for (size_t j = i + 1; j < 6; ++j) {
+           g.add_edge(i, j, edge_data(i, j));
+           // the reverse edge of (0, x) should not duplicate neighbors
+           if (i == 0) g.add_edge(j, i, edge_data(j, i));
+         }
+       }
+       g.add_edge(6, 6, edge_data(6, 6));
+     }
+     g.finalize();
+     ASSERT_TRUE(g.has_local_neighborhoods());
+     size_t nlocal_edges = 0;
+     for (graphlab::lvid_type i = 0; i < g.num_local_vertices(); ++i) {
+       graph_type::local_neighbor_list nbrs = g.vertex(g.global_vid(i)).local_neighbors();
+       for (size_t j = 1; j < nbrs.size(); ++j) ASSERT_LT(nbrs[j - 1], nbrs[j]);
+       for (size_t j = 0; j < nbrs.size(); ++j) ASSERT_NE(nbrs[j], i);
+       nlocal_edges += nbrs.size();
+     }
+     // undirected edges are listed at both endpoints
+     ASSERT_EQ(nlocal_edges % 2, 0);
+
+     g.build_local_neighborhoods(true);
+     size_t oriented_edges = 0, triangles = 0;
+     for (graphlab::lvid_type i = 0; i < g.num_local_vertices(); ++i) {
+       graph_type::local_neighbor_list nbrs = g.vertex(g.global_vid(i)).local_neighbors();
+       oriented_edges += nbrs.size();
+       for (size_t j = 0; j < nbrs.size(); ++j) {
+         graph_type::local_neighbor_list other = g.vertex(g.global_vid(nbrs[j])).local_neighbors();
+         triangles += graphlab::intersection_size(nbrs.begin(), nbrs.size(),
+                                                  other.begin(), other.size());
+       }
+     }
+     ASSERT_EQ(oriented_edges * 2, nlocal_edges);
+     // with one machine all edges are local: 15 edges and 20 triangles
+     if (dc->numprocs() == 1) {
+       ASSERT_EQ(oriented_edges, 15);
+       ASSERT_EQ(triangles, 20);
+     }
+     g.clear_local_neighborhoods();
+     ASSERT_FALSE(g.has_local_neighborhoods());
+     dc->cout() << "\n+ Pass test: local neighborhoods. :) \n";
+   }
+
  private: 
    template<typename Graph>
        void test_add_vertex_impl(Graph& g, size_t nverts) {
@@ -200,6 +287,17 @@ class distributed_graph_test  {
          check_vertex_info(g);
        }
 
+   template<typename Graph>
+       void check_vertex_index(Graph& g) {
+         for (size_t i = 0; i < g.num_local_vertices(); ++i) {
+           ASSERT_TRUE(g.contains_vertex(g.global_vid(i)));
+           ASSERT_EQ(g.local_vid(g.global_vid(i)), i);
+           ASSERT_EQ(g.l_is_master(i),
+                     g.l_get_vertex_record(i).owner == dc->procid());
+           ASSERT_EQ(g.l_master(i), g.l_get_vertex_record(i).owner);
+         }
+       }
+
    template<typename Graph>
        void test_save_load_impl(Graph& g) {
          typedef typename Graph::local_edge_type local_edge_type;
@@ -335,7 +433,7 @@ class distributed_graph_test  {
            std::vector<vertex_id_type> actual = local_out_adj.data[id];
            std::sort(actual.begin(), actual.end()); std::sort(expected.begin(), expected.end());
            ASSERT_EQ(actual.size(), expected.size());
-           if (g.vid2lvid.count(id))
+           if (g.contains_vertex(id))
              ASSERT_EQ(g.num_out_edges(id), expected.size());
            for (size_t i = 0; i < actual.size(); ++i) {
              ASSERT_EQ(actual[i], expected[i]);
@@ -349,7 +447,7 @@ class distributed_graph_test  {
            std::vector<vertex_id_type> actual = local_in_adj.data[id];
            std::sort(actual.begin(), actual.end()); std::sort(expected.begin(), expected.end());
            ASSERT_EQ(actual.size(), expected.size());
-           if (g.vid2lvid.count(id))
+           if (g.contains_vertex(id))
              ASSERT_EQ(g.num_in_edges(id), expected.size());
            for (size_t i = 0; i < actual.size(); ++i) {
              ASSERT_EQ(actual[i], expected[i]);
@@ -506,6 +604,8 @@ int main(int argc, char** argv) {
   testsuit.test_add_edge();
   testsuit.test_dynamic_add_edge();
   testsuit.test_save_load();
+  testsuit.test_compact_metadata();
+  testsuit.test_local_neighborhoods();
 
   delete(dc);
   graphlab::mpi_tools::finalize();
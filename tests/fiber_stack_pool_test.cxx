@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <vector>
+#include <graphlab/parallel/fiber_stack_pool.hpp>
+
+
+class FiberStackPoolTest: public CxxTest::TestSuite {
+ public:
+  void test_size_classes_and_reuse() {
+    graphlab::fiber_stack_pool pool(2);
+    size_t stacksize = 10000;
+    void* stack = pool.allocate(stacksize, 0);
+    // rounded up to a power of two number of pages
+    TS_ASSERT_LESS_THAN_EQUALS(10000, stacksize);
+    TS_ASSERT_EQUALS(stacksize & (stacksize - 1), 0);
+    memset(stack, 1, stacksize);
+    pool.release(stack, stacksize, 0);
+    // the same worker gets the same stack back
+    size_t stacksize2 = 9000;
+    void* stack2 = pool.allocate(stacksize2, 0);
+    TS_ASSERT_EQUALS(stack, stack2);
+    TS_ASSERT_EQUALS(stacksize, stacksize2);
+    TS_ASSERT_EQUALS(pool.num_mapped(), 1);
+    // released on another worker, then reused from outside the workers
+    pool.release(stack2, stacksize2, 1);
+    for (size_t i = 0;i < graphlab::fiber_stack_pool::MAX_POOLED_STACKS + 1; ++i) {
+      size_t s = stacksize;
+      pool.release(pool.allocate(s, 1), s, (size_t)(-1));
+    }
+    TS_ASSERT_EQUALS(pool.num_mapped(), 1);
+  }
+
+  void test_high_water() {
+    graphlab::fiber_stack_pool pool(1);
+    pool.set_usage_tracking(true);
+    size_t stacksize = 64 * 1024;
+    char* stack = (char*)pool.allocate(stacksize, 0);
+    // touch the top 10000 bytes; stacks grow down
+    memset(stack + stacksize - 10000, 1, 10000);
+    pool.release(stack, stacksize, 0);
+    TS_ASSERT_LESS_THAN_EQUALS(10000, pool.high_water());
+    TS_ASSERT_LESS_THAN(pool.high_water(), stacksize);
+  }
+
+  void test_pooled_stacks_are_trimmed() {
+    graphlab::fiber_stack_pool pool(1);
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t stacksize = 64 * page_size;
+    char* stack = (char*)pool.allocate(stacksize, 0);
+    memset(stack, 1, stacksize);
+    pool.release(stack, stacksize, 0);
+    // only the top pages of the pooled stack remain committed
+    const size_t npages = stacksize / page_size;
+    std::vector<unsigned char> resident(npages);
+    TS_ASSERT_EQUALS(mincore(stack, stacksize, &resident[0]), 0);
+    size_t nresident = 0;
+    for (size_t i = 0;i < npages; ++i) nresident += resident[i] & 1;
+    TS_ASSERT_LESS_THAN_EQUALS(nresident,
+                               graphlab::fiber_stack_pool::RESIDENT_STACK_PAGES);
+    // the stack is still usable after it is handed out again
+    char* stack2 = (char*)pool.allocate(stacksize, 0);
+    TS_ASSERT_EQUALS(stack, stack2);
+    TS_ASSERT_EQUALS(stack2[0], 0);
+    stack2[0] = 1;
+    pool.release(stack2, stacksize, 0);
+  }
+
+  void test_unpooled() {
+    graphlab::fiber_stack_pool pool(1);
+    size_t stacksize = 64 * 1024 * 1024;
+    void* stack = pool.allocate(stacksize, 0);
+    TS_ASSERT_EQUALS(pool.num_mapped(), 1);
+    pool.release(stack, stacksize, 0);
+    TS_ASSERT_EQUALS(pool.num_mapped(), 0);
+  }
+};
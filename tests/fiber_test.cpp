@@ -24,7 +24,18 @@ void threadfn2() {
   }
 }
 
+// launched from inside a fiber, so every child is queued on the
+// spawning worker and the other workers can only get them by stealing
+void spawner() {
+  fiber_group children;
+  for (int i = 0;i < 1000; ++i) {
+    children.launch(threadfn);
+  }
+  children.join();
+}
+
 int main(int argc, char** argv) {
+  fiber_control::get_instance().set_stack_usage_tracking(true);
   timer ti; ti.start();
   fiber_group group;
   fiber_group group2;
@@ -38,4 +49,15 @@ int main(int argc, char** argv) {
   group2.join();
   std::cout << "Completion in " << ti.current_time() << "s\n";
   std::cout << "Context Switches: " << numticks << "\n";
+
+  fiber_group group3;
+  group3.launch(spawner);
+  group3.join();
+  std::cout << "Completion in " << ti.current_time() << "s\n";
+  fiber_control& fc = fiber_control::get_instance();
+  for (size_t i = 0;i < fc.num_workers(); ++i) {
+    std::cout << "Worker " << i << ": " << fc.worker_steals(i) << " steals, "
+              << fc.worker_idle_waits(i) << " idle waits\n";
+  }
+  std::cout << "Stack high-water: " << fc.stack_high_water() << " bytes\n";
 }
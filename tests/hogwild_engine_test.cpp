@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+#include <graphlab.hpp>
+
+struct rating : public graphlab::IS_POD_TYPE {
+  double obs;
+  bool train;
+  rating(double obs = 0, bool train = true) : obs(obs), train(train) { }
+};
+
+typedef graphlab::distributed_graph<double, rating> graph_type;
+
+const size_t NUSERS = 10;
+const size_t NITEMS = 10;
+const double GAMMA = 0.05;
+
+double user_factor(size_t u) { return 1 + u / 10.0; }
+double item_factor(size_t i) { return 1 + i / 10.0; }
+
+/*
+ * The ratings of a complete bipartite graph are an exact rank-1
+ * product. One in five edges is held out and must not be updated or
+ * counted.
+ */
+bool rank1_update(graph_type::edge_type& edge) {
+  if (!edge.data().train) return false;
+  double& u = edge.source().data();
+  double& v = edge.target().data();
+  const double err = edge.data().obs - u * v;
+  const double uu = u;
+  u += GAMMA * err * v;
+  v += GAMMA * err * uu;
+  return true;
+}
+
+double squared_error(const graph_type::edge_type& edge) {
+  const double err = edge.data().obs -
+    edge.source().data() * edge.target().data();
+  return err * err;
+}
+
+size_t count_training(const graph_type::edge_type& edge) {
+  return edge.data().train ? 1 : 0;
+}
+
+void combine(double& master, const double& mirror) { master += mirror; }
+void average(double& master, size_t nreplicas) { master /= nreplicas; }
+
+void set_to_procid(graph_type& graph) {
+  for (graphlab::lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+    graph.l_vertex(lvid).data() = graph.procid() + 1;
+  }
+}
+
+int main(int argc, char** argv) {
+  graphlab::mpi_tools::init(argc, argv);
+  graphlab::dc_init_param rpc_parameters;
+  graphlab::init_param_from_mpi(rpc_parameters);
+  graphlab::distributed_control dc(rpc_parameters);
+
+  graphlab::command_line_options clopts("Test code.");
+  graph_type graph(dc, clopts);
+  if (dc.procid() == 0) {
+    for (size_t u = 0; u < NUSERS; ++u) graph.add_vertex(u, 1.0);
+    for (size_t i = 0; i < NITEMS; ++i) graph.add_vertex(NUSERS + i, 1.0);
+    for (size_t u = 0; u < NUSERS; ++u) {
+      for (size_t i = 0; i < NITEMS; ++i) {
+        graph.add_edge(u, NUSERS + i,
+                       rating(user_factor(u) * item_factor(i), (u + i) % 5 != 0));
+      }
+    }
+  }
+  graphlab::hogwild_engine<graph_type> engine(dc, graph, clopts);
+  engine.set_averaging(combine, average);
+  const size_t ntraining = graph.map_reduce_edges<size_t>(count_training);
+  ASSERT_LT(ntraining, graph.num_edges());
+
+  std::cout << "Running rank-1 SGD" << std::endl;
+  for (size_t i = 0; i < 100; ++i) {
+    ASSERT_EQ(engine.run_epoch(rank1_update), ntraining);
+  }
+  ASSERT_EQ(engine.num_epochs(), 100);
+  ASSERT_EQ(engine.num_updates(), 100 * ntraining);
+  // the held out ratings are predicted as well, since the problem is rank-1
+  const double rmse =
+    std::sqrt(graph.map_reduce_edges<double>(squared_error) / graph.num_edges());
+  std::cout << "RMSE: " << rmse << std::endl;
+  ASSERT_LT(rmse, 1e-3);
+
+  std::cout << "Averaging replicas" << std::endl;
+  // every replica of a vertex holds its machine id + 1: after averaging
+  // they all hold the mean over the machines which have a replica
+  set_to_procid(graph);
+  engine.average_replicas();
+  for (graphlab::lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+    graph_type::local_vertex_type lvertex = graph.l_vertex(lvid);
+    double expected = lvertex.owner() + 1;
+    for (graphlab::procid_t proc = 0; proc < dc.numprocs(); ++proc) {
+      if (lvertex.mirrors().get(proc)) expected += proc + 1;
+    }
+    expected /= lvertex.num_mirrors() + 1;
+    ASSERT_LT(std::fabs(lvertex.data() - expected), 1e-9);
+  }
+  std::cout << "Finished" << std::endl;
+
+  graphlab::mpi_tools::finalize();
+} // end of main
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include <cxxtest/TestSuite.h>
+
+#include <graphlab/util/hyperloglog.hpp>
+#include <graphlab/util/random.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+
+class HyperLogLogTestSuite: public CxxTest::TestSuite {
+ public:
+  void test_estimate() {
+    const size_t precisions[] = {4, 8, 10, 14};
+    const size_t sizes[] = {0, 1, 10, 100, 1000, 10000, 100000};
+    for (size_t p = 0; p < 4; ++p) {
+      for (size_t s = 0; s < 7; ++s) {
+        graphlab::hyperloglog counter(precisions[p]);
+        for (size_t i = 0; i < sizes[s]; ++i) {
+          // every value twice
+          counter.insert(i);
+          counter.insert(i);
+        }
+        // within 4 standard errors
+        const double error = 4 * 1.04 / std::sqrt(double(counter.num_registers()));
+        TS_ASSERT_LESS_THAN_EQUALS(std::fabs(counter.estimate() - sizes[s]),
+                                   error * sizes[s] + 1);
+      }
+    }
+  }
+
+  void test_union() {
+    graphlab::hyperloglog a(10), b(10), all(10), empty;
+    for (size_t i = 0; i < 5000; ++i) {
+      all.insert(i);
+      if (i % 3 == 0) a.insert(i);
+      else b.insert(i);
+      if (i % 7 == 0) b.insert(i);
+    }
+    graphlab::hyperloglog u = a;
+    u += b;
+    TS_ASSERT(u == all);
+    // the empty counter is the identity
+    u += empty;
+    TS_ASSERT(u == all);
+    empty += all;
+    TS_ASSERT(empty == all);
+    // idempotent
+    u += all;
+    TS_ASSERT(u == all);
+  }
+
+  void test_register_max() {
+    // the broadword and vectorized maximum against a register loop
+    for (size_t p = 4; p <= 12; ++p) {
+      for (size_t trial = 0; trial < 20; ++trial) {
+        graphlab::hyperloglog a(p), b(p);
+        for (size_t i = 0; i < a.num_registers(); ++i) {
+          a.set_register(i, graphlab::random::fast_uniform<size_t>(0, 31));
+          b.set_register(i, graphlab::random::fast_uniform<size_t>(0, 31));
+        }
+        graphlab::hyperloglog c = a;
+        c += b;
+        for (size_t i = 0; i < a.num_registers(); ++i) {
+          TS_ASSERT_EQUALS(c.get_register(i),
+                           std::max(a.get_register(i), b.get_register(i)));
+        }
+      }
+    }
+  }
+
+  void test_serialization() {
+    graphlab::hyperloglog a(12), b;
+    for (size_t i = 0; i < 100000; ++i) a.insert(i * 7919);
+    std::stringstream strm;
+    graphlab::oarchive oarc(strm);
+    oarc << a;
+    strm.flush();
+    graphlab::iarchive iarc(strm);
+    iarc >> b;
+    TS_ASSERT(a == b);
+    TS_ASSERT_EQUALS(a.estimate(), b.estimate());
+  }
+};
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <set>
+#include <sstream>
+#include <cstdlib>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/graph/mirror_set.hpp>
+#include <graphlab/macros_def.hpp>
+using namespace graphlab;
+
+class MirrorSetTestSuite : public CxxTest::TestSuite {
+public:
+  void check_equal(const mirror_set& m, const std::set<procid_t>& ref) {
+    TS_ASSERT_EQUALS(m.popcount(), ref.size());
+    std::set<procid_t>::const_iterator refiter = ref.begin();
+    foreach(procid_t p, m) {
+      TS_ASSERT(refiter != ref.end());
+      TS_ASSERT_EQUALS(p, *refiter);
+      ++refiter;
+    }
+    TS_ASSERT(refiter == ref.end());
+  }
+
+  void test_inline(void) {
+    mirror_set m;
+    TS_ASSERT(m.empty());
+    TS_ASSERT(m.begin() == m.end());
+    procid_t probelocations[5] = {90, 3, 511, 0, 7};
+    std::set<procid_t> ref;
+    for (size_t i = 0;i < 5; ++i) {
+      TS_ASSERT_EQUALS(m.set_bit(probelocations[i]), false);
+      ref.insert(probelocations[i]);
+    }
+    TS_ASSERT_EQUALS(m.set_bit(3), true);
+    check_equal(m, ref);
+    TS_ASSERT_EQUALS(m.get(511), true);
+    TS_ASSERT_EQUALS(m.get(4), false);
+
+    TS_ASSERT_EQUALS(m.clear_bit(90), true);
+    TS_ASSERT_EQUALS(m.clear_bit(90), false);
+    ref.erase(90);
+    check_equal(m, ref);
+  }
+
+  void test_large(void) {
+    // grows past the inline capacity into a bitset and back
+    mirror_set m;
+    std::set<procid_t> ref;
+    for (procid_t p = 0; p < 1000; p += 37) {
+      m.set_bit(p);
+      ref.insert(p);
+    }
+    m.set_bit(4000);
+    ref.insert(4000);
+    check_equal(m, ref);
+    TS_ASSERT_EQUALS(m.get(4000), true);
+    TS_ASSERT_EQUALS(m.get(4001), false);
+    TS_ASSERT_EQUALS(m.get(60000), false);
+
+    while (ref.size() > 2) {
+      procid_t p = *ref.begin();
+      TS_ASSERT_EQUALS(m.clear_bit(p), true);
+      ref.erase(p);
+      check_equal(m, ref);
+    }
+  }
+
+  void test_copy_and_union(void) {
+    mirror_set a, b;
+    for (procid_t p = 0; p < 10; ++p) a.set_bit(p * 2);
+    for (procid_t p = 0; p < 3; ++p) b.set_bit(p * 3);
+    mirror_set c(a);
+    TS_ASSERT(c == a);
+    c |= b;
+    TS_ASSERT(c != a);
+    TS_ASSERT_EQUALS(c.popcount(), 11);
+    foreach(procid_t p, b) TS_ASSERT(c.get(p));
+    c = b;
+    TS_ASSERT(c == b);
+    c.clear();
+    TS_ASSERT(c.empty());
+  }
+
+  void test_random(void) {
+    srand(1);
+    for (size_t trial = 0; trial < 100; ++trial) {
+      mirror_set m;
+      std::set<procid_t> ref;
+      const size_t range = (trial % 2) ? 16 : 600;
+      for (size_t i = 0; i < 200; ++i) {
+        procid_t p = rand() % range;
+        if (rand() % 3) {
+          TS_ASSERT_EQUALS(m.set_bit(p), !ref.insert(p).second);
+        } else {
+          TS_ASSERT_EQUALS(m.clear_bit(p), ref.erase(p) > 0);
+        }
+      }
+      check_equal(m, ref);
+    }
+  }
+
+  void test_serialize(void) {
+    mirror_set small, large;
+    small.set_bit(5);
+    small.set_bit(1);
+    for (procid_t p = 0; p < 512; p += 5) large.set_bit(p);
+
+    std::stringstream strm;
+    graphlab::oarchive oarc(strm);
+    oarc << small << large;
+    strm.flush();
+    graphlab::iarchive iarc(strm);
+    mirror_set small2, large2;
+    iarc >> small2 >> large2;
+    TS_ASSERT(small == small2);
+    TS_ASSERT(large == large2);
+  }
+};
+
+#include <graphlab/macros_undef.hpp>
@@ -0,0 +1,245 @@
+/*  
+ * Copyright (c) 2009 Carnegie Mellon University. 
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/*
+ * Loads the same graph once per ingress method and reports the
+ * partition quality of each as JSON: replication factor, edge and
+ * vertex balance, load time (parsing and placing the edges), ingress
+ * time (finalize only), memory, and an estimate of the number of
+ * records a synchronous engine exchanges per iteration when every
+ * vertex is active. heap_bytes is the total over all machines and
+ * max_peak_rss_kb the largest peak of any machine.
+ *
+ * Peak RSS is a process-wide high-water mark, so only the first
+ * method of a run reports an exact peak. Run with a single method in
+ * --ingress to get exact numbers for the others.
+ */
+
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+#include <graphlab.hpp>
+#include <graphlab/util/memory_info.hpp>
+#include <graphlab/macros_def.hpp>
+
+typedef graphlab::distributed_graph<char, char> graph_type;
+
+graphlab::edge_dir_type parse_dir(const std::string& dir) {
+  if (dir == "in") return graphlab::IN_EDGES;
+  if (dir == "out") return graphlab::OUT_EDGES;
+  if (dir == "all") return graphlab::ALL_EDGES;
+  if (dir != "none") {
+    logstream(LOG_FATAL) << "Unknown edge direction: " << dir << std::endl;
+  }
+  return graphlab::NO_EDGES;
+}
+
+/*
+ * Mirrors receive the vertex program for the gather only if they hold
+ * edges in the gather direction (see synchronous_engine), then send
+ * back a partial gather. Vertex data goes to every mirror after apply,
+ * and the vertex program once more if scatter is needed.
+ */
+size_t estimate_records(graph_type& graph,
+                        graphlab::edge_dir_type gather_dir,
+                        graphlab::edge_dir_type scatter_dir) {
+  size_t records = 0;
+  for (graphlab::lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+    graph_type::local_vertex_type vertex = graph.l_vertex(lvid);
+    if (!vertex.owned()) continue;
+    const size_t nmirrors = vertex.num_mirrors();
+    if (nmirrors == 0) continue;
+    bool local_gather = true;
+    if (gather_dir == graphlab::IN_EDGES || gather_dir == graphlab::ALL_EDGES)
+      local_gather &= vertex.num_in_edges() == vertex.global_num_in_edges();
+    if (gather_dir == graphlab::OUT_EDGES || gather_dir == graphlab::ALL_EDGES)
+      local_gather &= vertex.num_out_edges() == vertex.global_num_out_edges();
+    if (gather_dir != graphlab::NO_EDGES && !local_gather) records += 2 * nmirrors;
+    records += nmirrors;
+    if (scatter_dir != graphlab::NO_EDGES) records += nmirrors;
+  }
+  return records;
+}
+
+size_t peak_rss_kb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+size_t max_over_procs(graphlab::distributed_control& dc, size_t value) {
+  std::vector<size_t> values(dc.numprocs());
+  values[dc.procid()] = value;
+  dc.all_gather(values);
+  return *std::max_element(values.begin(), values.end());
+}
+
+// Quotes a string for the JSON report
+std::string json_string(const std::string& str) {
+  std::string ret = "\"";
+  foreach(char c, str) {
+    if (c == '"' || c == '\\') {
+      ret += '\\';
+      ret += c;
+    } else if ((unsigned char)(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)(c));
+      ret += buf;
+    } else {
+      ret += c;
+    }
+  }
+  return ret + "\"";
+}
+
+double max_over_mean(graphlab::distributed_control& dc, size_t value) {
+  std::vector<size_t> values(dc.numprocs());
+  values[dc.procid()] = value;
+  dc.all_gather(values);
+  size_t total = 0, maximum = 0;
+  foreach(size_t v, values) { total += v; maximum = std::max(maximum, v); }
+  return total == 0 ? 1.0 : double(maximum) * values.size() / total;
+}
+
+int main(int argc, char** argv) {
+  graphlab::mpi_tools::init(argc, argv);
+  graphlab::distributed_control dc;
+  global_logger().set_log_level(LOG_INFO);
+  graphlab::command_line_options clopts("Partition quality benchmark.");
+  std::string graphpath;
+  std::string format = "snap";
+  size_t powerlaw = 100000;
+  std::string ingress_list = "random,oblivious,hdrf,hybrid,grid,pds";
+  std::string gather = "in";
+  std::string scatter = "out";
+  std::string json_path = "";
+
+  clopts.attach_option("graph", graphpath,
+                       "The graph path. If empty a synthetic powerlaw graph is used.\n");
+  clopts.attach_option("format", format,
+                       "format of the graph: {adj, snap, tsv}\n");
+  clopts.attach_option("powerlaw", powerlaw,
+                       "Number of vertices of the synthetic powerlaw graph\n");
+  clopts.attach_option("ingress", ingress_list,
+                       "Comma separated ingress methods to compare\n");
+  clopts.attach_option("gather", gather,
+                       "Gather direction of the vertex program: {in, out, all, none}\n");
+  clopts.attach_option("scatter", scatter,
+                       "Scatter direction of the vertex program: {in, out, all, none}\n");
+  clopts.attach_option("json", json_path,
+                       "Output file for the JSON report. Prints to stdout if empty.\n");
+  if(!clopts.parse(argc, argv)) {
+    logstream(LOG_FATAL) << "Error in parsing command line arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const graphlab::edge_dir_type gather_dir = parse_dir(gather);
+  const graphlab::edge_dir_type scatter_dir = parse_dir(scatter);
+
+  std::vector<std::string> methods;
+  boost::split(methods, ingress_list, boost::is_any_of(","));
+
+  std::stringstream json;
+  json << "{\n  \"numprocs\": " << dc.numprocs()
+       << ",\n  \"graph\": "
+       << json_string(graphpath.empty() ? "powerlaw" : graphpath)
+       << ",\n  \"gather\": " << json_string(gather)
+       << ",\n  \"scatter\": " << json_string(scatter)
+       << ",\n  \"results\": [";
+  bool first = true;
+  foreach(const std::string& method, methods) {
+    int nrow, ncol, p;
+    if ((method == "grid" &&
+         !graphlab::sharding_constraint::is_grid_compatible(dc.numprocs(), nrow, ncol)) ||
+        (method == "pds" &&
+         !graphlab::sharding_constraint::is_pds_compatible(dc.numprocs(), p))) {
+      if (dc.procid() == 0) {
+        logstream(LOG_WARNING) << "Skipping " << method << ": incompatible with "
+                               << dc.numprocs() << " machines" << std::endl;
+      }
+      continue;
+    }
+    graphlab::graphlab_options opts = clopts;
+    opts.get_graph_args().set_option("ingress", method);
+    dc.barrier();
+    graphlab::timer ti;
+    graph_type graph(dc, opts);
+    if (graphpath.empty()) graph.load_synthetic_powerlaw(powerlaw);
+    else graph.load_format(graphpath, format);
+    const double load_time = ti.current_time();
+    graph.finalize();
+    const double ingress_time = ti.current_time() - load_time;
+
+    size_t records = estimate_records(graph, gather_dir, scatter_dir);
+    dc.all_reduce(records);
+    size_t heap_bytes = graphlab::memory_info::heap_bytes();
+    dc.all_reduce(heap_bytes);
+    const size_t rss_kb = max_over_procs(dc, peak_rss_kb());
+    const double edge_balance = max_over_mean(dc, graph.num_local_edges());
+    const double vertex_balance = max_over_mean(dc, graph.num_local_own_vertices());
+
+    // an empty graph, e.g. from a bad path, has no replicas
+    const double replication_factor = graph.num_vertices() == 0 ? 0.0 :
+      double(graph.num_replicas()) / graph.num_vertices();
+
+    if (dc.procid() == 0) {
+      json << (first ? "\n" : ",\n")
+           << "    {\"ingress\": " << json_string(method)
+           << ", \"nverts\": " << graph.num_vertices()
+           << ", \"nedges\": " << graph.num_edges()
+           << ", \"nreplicas\": " << graph.num_replicas()
+           << ", \"replication_factor\": "
+           << replication_factor
+           << ", \"edge_balance\": " << edge_balance
+           << ", \"vertex_balance\": " << vertex_balance
+           << ", \"load_time\": " << load_time
+           << ", \"ingress_time\": " << ingress_time
+           << ", \"heap_bytes\": " << heap_bytes
+           << ", \"max_peak_rss_kb\": " << rss_kb
+           << ", \"records_per_iteration\": " << records
+           << "}";
+    }
+    first = false;
+  }
+  json << "\n  ]\n}\n";
+
+  if (dc.procid() == 0) {
+    if (json_path.empty()) {
+      std::cout << json.str();
+    } else {
+      std::ofstream fout(json_path.c_str());
+      fout << json.str();
+    }
+  }
+  graphlab::mpi_tools::finalize();
+  return EXIT_SUCCESS;
+} // end of main
+
+#include <graphlab/macros_undef.hpp>
@@ -0,0 +1,218 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/*
+ * Measures the average time of broadcast(), all_reduce() and
+ * all_gather() over a range of payload sizes, and checks their
+ * results. For comparison, the all_reduce is also timed as a gather
+ * to machine 0 followed by a broadcast, which is how the aggregator
+ * used to combine its accumulators. Results are printed by machine 0
+ * as CSV.
+ *
+ * Before timing, all_reduce2() is checked with a non-commutative
+ * plusequal (vector concatenation), which must produce the machine ids
+ * in order on every machine. Run with a number of processes that is not
+ * a power of two, e.g. mpiexec -n 3, to cover the fold of the extra
+ * machines.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/rpc/dc_dist_object.hpp>
+#include <graphlab/rpc/dc_init_from_mpi.hpp>
+#include <graphlab/util/mpi_tools.hpp>
+#include <graphlab/util/timer.hpp>
+#include <graphlab/options/command_line_options.hpp>
+#include <graphlab/macros_def.hpp>
+using namespace graphlab;
+
+
+struct vector_plus_equal {
+  void operator()(std::vector<double>& left, const std::vector<double>& right) {
+    ASSERT_EQ(left.size(), right.size());
+    for (size_t i = 0; i < left.size(); ++i) left[i] += right[i];
+  }
+};
+
+struct vector_concat {
+  void operator()(std::vector<procid_t>& left,
+                  const std::vector<procid_t>& right) {
+    left.insert(left.end(), right.begin(), right.end());
+  }
+};
+
+
+class collective_bench {
+ public:
+  dc_dist_object<collective_bench> rmi;
+
+  collective_bench(distributed_control& dc): rmi(dc, this) {
+    rmi.barrier();
+  }
+
+  /// Checks that all_reduce2() combines in the order of the machine ids
+  void check_order() {
+    for (size_t r = 0; r < 3; ++r) {
+      std::vector<procid_t> v(1, rmi.procid());
+      rmi.all_reduce2(v, vector_concat());
+      ASSERT_EQ(v.size(), rmi.numprocs());
+      for (size_t i = 0; i < v.size(); ++i) ASSERT_EQ(v[i], i);
+    }
+  }
+
+  /// Microseconds per broadcast of nvalues doubles from machine 0
+  double broadcast_us(size_t nvalues, size_t rounds) {
+    rmi.barrier();
+    timer ti;
+    ti.start();
+    for (size_t r = 0; r < rounds; ++r) {
+      std::vector<double> v;
+      if (rmi.procid() == 0) v.assign(nvalues, double(r));
+      rmi.broadcast(v, rmi.procid() == 0);
+      ASSERT_EQ(v.size(), nvalues);
+      if (nvalues > 0) ASSERT_EQ(v[nvalues - 1], double(r));
+    }
+    return ti.current_time() * 1000000 / rounds;
+  }
+
+  /// Microseconds per all_reduce of nvalues doubles
+  double all_reduce_us(size_t nvalues, size_t rounds) {
+    rmi.barrier();
+    timer ti;
+    ti.start();
+    for (size_t r = 0; r < rounds; ++r) {
+      std::vector<double> v(nvalues, double(rmi.procid()));
+      rmi.all_reduce2(v, vector_plus_equal());
+      check_sum(v, nvalues);
+      // a POD value takes the memcpy path
+      size_t count = 1;
+      rmi.all_reduce(count);
+      ASSERT_EQ(count, rmi.numprocs());
+    }
+    return ti.current_time() * 1000000 / rounds;
+  }
+
+  /// Microseconds per reduction done as a gather followed by a broadcast
+  double gather_broadcast_us(size_t nvalues, size_t rounds) {
+    rmi.barrier();
+    timer ti;
+    ti.start();
+    for (size_t r = 0; r < rounds; ++r) {
+      std::vector<std::vector<double> > all(rmi.numprocs());
+      all[rmi.procid()].assign(nvalues, double(rmi.procid()));
+      rmi.gather(all, 0);
+      std::vector<double> v;
+      if (rmi.procid() == 0) {
+        v = all[0];
+        for (size_t i = 1; i < all.size(); ++i) vector_plus_equal()(v, all[i]);
+      }
+      rmi.broadcast(v, rmi.procid() == 0);
+      check_sum(v, nvalues);
+    }
+    return ti.current_time() * 1000000 / rounds;
+  }
+
+  /// Microseconds per all_gather of nvalues doubles from every machine
+  double all_gather_us(size_t nvalues, size_t rounds) {
+    rmi.barrier();
+    timer ti;
+    ti.start();
+    for (size_t r = 0; r < rounds; ++r) {
+      std::vector<std::vector<double> > all(rmi.numprocs());
+      all[rmi.procid()].assign(nvalues, double(rmi.procid()));
+      rmi.all_gather(all);
+      for (size_t i = 0; i < all.size(); ++i) {
+        ASSERT_EQ(all[i].size(), nvalues);
+        if (nvalues > 0) ASSERT_EQ(all[i][0], double(i));
+      }
+    }
+    return ti.current_time() * 1000000 / rounds;
+  }
+
+ private:
+  void check_sum(const std::vector<double>& v, size_t nvalues) {
+    const double expected = double(rmi.numprocs()) * (rmi.numprocs() - 1) / 2;
+    ASSERT_EQ(v.size(), nvalues);
+    for (size_t i = 0; i < v.size(); ++i) ASSERT_EQ(v[i], expected);
+  }
+};
+
+
+int main(int argc, char** argv) {
+  mpi_tools::init(argc, argv);
+  global_logger().set_log_level(LOG_INFO);
+
+  command_line_options clopts("RPC collective benchmark.", true);
+  std::string sizes = "1,16,256,4096,65536,1048576";
+  size_t rounds = 100;
+  clopts.attach_option("sizes", sizes,
+                       "Comma separated payload sizes in number of doubles\n");
+  clopts.attach_option("rounds", rounds,
+                       "Number of repetitions per measurement\n");
+  if(!clopts.parse(argc, argv)) {
+    std::cout << "Error in parsing command line arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  dc_init_param param;
+  if (init_param_from_mpi(param) == false) {
+    return EXIT_FAILURE;
+  }
+  distributed_control dc(param);
+  collective_bench bench(dc);
+  bench.check_order();
+
+  std::vector<std::string> size_strs;
+  boost::split(size_strs, sizes, boost::is_any_of(","));
+
+  if (dc.procid() == 0) {
+    std::cout << "numprocs,payload_bytes,broadcast_us,all_reduce_us,"
+              << "gather_broadcast_us,all_gather_us\n";
+  }
+  foreach(const std::string& size_str, size_strs) {
+    const size_t nvalues = boost::lexical_cast<size_t>(boost::trim_copy(size_str));
+    // keep the total volume of the larger payloads manageable
+    const size_t nrounds = std::max<size_t>(1, std::min<size_t>(rounds,
+                                              (64 << 20) / (8 * nvalues + 1)));
+    double bcast = bench.broadcast_us(nvalues, nrounds);
+    double allreduce = bench.all_reduce_us(nvalues, nrounds);
+    double gatherbcast = bench.gather_broadcast_us(nvalues, nrounds);
+    double allgather = bench.all_gather_us(nvalues, nrounds);
+    if (dc.procid() == 0) {
+      std::cout << dc.numprocs() << ","
+                << 8 * nvalues << ","
+                << bcast << ","
+                << allreduce << ","
+                << gatherbcast << ","
+                << allgather << std::endl;
+    }
+  }
+  dc.barrier();
+  mpi_tools::finalize();
+}
+
+#include <graphlab/macros_undef.hpp>
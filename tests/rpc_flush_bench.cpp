@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/*
+ * Measures the round trip latency and the bandwidth of remote_call()
+ * between machine 0 and machine 1 over a range of payload sizes, through
+ * distributed objects using the default, the flush-every-call and the
+ * adaptive dc_dist_object::set_flush_policy(). The flush policy of the
+ * send buffers is selected with --flush_policy so that fixed and
+ * adaptive can be compared by running the benchmark twice. Results are
+ * printed by machine 0 as CSV.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <graphlab/rpc/dc.hpp>
+#include <graphlab/rpc/dc_init_from_mpi.hpp>
+#include <graphlab/util/mpi_tools.hpp>
+#include <graphlab/util/timer.hpp>
+#include <graphlab/options/command_line_options.hpp>
+#include <graphlab/macros_def.hpp>
+using namespace graphlab;
+
+
+class flush_bench {
+ public:
+  dc_dist_object<flush_bench> rmi;
+  atomic<size_t> pongs;
+  atomic<size_t> bytes_received;
+
+  flush_bench(distributed_control& dc, flush_policy_type policy,
+              size_t max_bytes = MAX_FLUSH_BYTES): rmi(dc, this) {
+    rmi.set_flush_policy(policy, max_bytes);
+    rmi.barrier();
+  }
+
+  void ping(procid_t source, const std::string& payload) {
+    rmi.remote_call(source, &flush_bench::pong);
+  }
+
+  void pong() {
+    pongs.inc();
+  }
+
+  void receive(const std::string& payload) {
+    bytes_received.inc(payload.size());
+  }
+
+  /// Average round trip time in microseconds. Only meaningful on machine 0.
+  double roundtrip_us(procid_t target, size_t payload_size, size_t rounds) {
+    rmi.barrier();
+    double elapsed = 0;
+    if (rmi.procid() == 0) {
+      std::string payload(payload_size, 'x');
+      pongs.value = 0;
+      timer ti;
+      ti.start();
+      for (size_t i = 0; i < rounds; ++i) {
+        rmi.remote_call(target, &flush_bench::ping, rmi.procid(), payload);
+        while (pongs.value <= i) cpu_relax();
+      }
+      elapsed = ti.current_time();
+    }
+    rmi.barrier();
+    return elapsed * 1000000 / rounds;
+  }
+
+  /// Bandwidth in MB/s. Only meaningful on machine 0.
+  double bandwidth_mbps(procid_t target, size_t payload_size, size_t total_bytes) {
+    rmi.barrier();
+    timer ti;
+    ti.start();
+    if (rmi.procid() == 0) {
+      std::string payload(payload_size, 'x');
+      size_t ncalls = std::max<size_t>(total_bytes / payload_size, 1);
+      for (size_t i = 0; i < ncalls; ++i) {
+        rmi.remote_call(target, &flush_bench::receive, payload);
+      }
+    }
+    rmi.full_barrier();
+    double elapsed = ti.current_time();
+    size_t ncalls = std::max<size_t>(total_bytes / payload_size, 1);
+    return double(ncalls * payload_size) / (1024 * 1024) / elapsed;
+  }
+};
+
+
+int main(int argc, char** argv) {
+  mpi_tools::init(argc, argv);
+  global_logger().set_log_level(LOG_INFO);
+
+  command_line_options clopts("RPC flush policy benchmark.", true);
+  std::string flush_policy = "fixed";
+  std::string sizes = "8,64,512,4096,32768,262144";
+  size_t rounds = 1000;
+  size_t total_mb = 256;
+  clopts.attach_option("flush_policy", flush_policy,
+                       "Flush policy of the send buffers: {fixed, adaptive}\n");
+  clopts.attach_option("sizes", sizes,
+                       "Comma separated payload sizes in bytes\n");
+  clopts.attach_option("rounds", rounds,
+                       "Number of round trips per latency measurement\n");
+  clopts.attach_option("total_mb", total_mb,
+                       "Megabytes sent per bandwidth measurement\n");
+  if(!clopts.parse(argc, argv)) {
+    std::cout << "Error in parsing command line arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  dc_init_param param;
+  if (init_param_from_mpi(param) == false) {
+    return EXIT_FAILURE;
+  }
+  param.initstring += " flush_policy=" + flush_policy + " ";
+  distributed_control dc(param);
+
+  // a single machine measures the loopback path
+  const procid_t target = dc.numprocs() > 1 ? 1 : 0;
+
+  std::vector<std::string> size_strs;
+  boost::split(size_strs, sizes, boost::is_any_of(","));
+
+  flush_bench regular(dc, FLUSH_POLICY_DEFAULT);
+  flush_bench every_call(dc, FLUSH_POLICY_FIXED, 0);
+  flush_bench adaptive(dc, FLUSH_POLICY_ADAPTIVE);
+  flush_bench* benches[] = {&regular, &every_call, &adaptive};
+  const char* names[] = {"regular", "every_call", "adaptive"};
+
+  if (dc.procid() == 0) {
+    std::cout << "policy,object,payload_bytes,roundtrip_us,bandwidth_mbps\n";
+  }
+  foreach(const std::string& size_str, size_strs) {
+    const size_t payload_size = boost::lexical_cast<size_t>(boost::trim_copy(size_str));
+    for (size_t i = 0; i < 3; ++i) {
+      flush_bench& bench = *benches[i];
+      double latency = bench.roundtrip_us(target, payload_size, rounds);
+      double bandwidth = bench.bandwidth_mbps(target, payload_size,
+                                              total_mb * 1024 * 1024);
+      if (dc.procid() == 0) {
+        std::cout << flush_policy << ","
+                  << names[i] << ","
+                  << payload_size << ","
+                  << latency << ","
+                  << bandwidth << std::endl;
+      }
+    }
+  }
+  dc.barrier();
+  mpi_tools::finalize();
+}
+
+#include <graphlab/macros_undef.hpp>
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+
+/*
+ * Times the serialization of the containers exchanged by the engines
+ * and the graph ingress, through the in memory oarchive and iarchive
+ * used by the RPC layer:
+ *
+ *  - a vector of doubles, deserialized into a std::vector (one copy),
+ *    and written and read as a graphlab::pod_view (no copy)
+ *  - a boost::unordered_map and a std::map of integers, deserialized
+ *    with the reserved table and with the previous element by element
+ *    insertion into an empty table
+ *  - a vector of edges (pairs of vertex ids and a float) in the default
+ *    and in the compact archive modes, with the bytes of each
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <iostream>
+#include <boost/unordered_map.hpp>
+
+#include <graphlab.hpp>
+#include <graphlab/serialization/serialization_includes.hpp>
+#include <graphlab/macros_def.hpp>
+
+typedef std::pair<std::pair<size_t, size_t>, float> edge_type;
+
+template <typename T>
+void save(graphlab::oarchive& oarc, const T& t, bool compact = false) {
+  oarc.off = 0;
+  oarc.compact = compact;
+  oarc << t;
+}
+
+// the deserialization of boost::unordered_map before the table was reserved
+void load_unreserved(graphlab::iarchive& iarc,
+                     boost::unordered_map<size_t, size_t>& map) {
+  map.clear();
+  size_t length = 0;
+  iarc >> length;
+  for (size_t x = 0; x < length; ++x) {
+    std::pair<size_t, size_t> v;
+    iarc >> v;
+    map[v.first] = v.second;
+  }
+}
+
+int main(int argc, char** argv) {
+  global_logger().set_log_level(LOG_WARNING);
+  size_t nvalues = 10000000;
+  size_t nkeys = 1000000;
+  size_t nverts = 1000000;
+  size_t nedges = 10000000;
+  size_t repeats = 5;
+  graphlab::command_line_options clopts("Serialization benchmark.", true);
+  clopts.attach_option("nvalues", nvalues, "Length of the vector of doubles");
+  clopts.attach_option("nkeys", nkeys, "Number of keys of the maps");
+  clopts.attach_option("nverts", nverts, "Vertex ids of the edges are below this");
+  clopts.attach_option("nedges", nedges, "Number of edges");
+  clopts.attach_option("repeats", repeats, "Number of times each test is run");
+  if(!clopts.parse(argc, argv)) return EXIT_FAILURE;
+  if (repeats == 0) repeats = 1;
+
+  graphlab::random::seed(1);
+  graphlab::oarchive oarc;
+  graphlab::timer ti;
+
+  // vector of doubles
+  {
+    std::vector<double> values(nvalues);
+    for (size_t i = 0; i < nvalues; ++i) values[i] = i * 0.25;
+    ti.start();
+    for (size_t r = 0; r < repeats; ++r) save(oarc, values);
+    std::cout << "vector<double> save:\t\t" << ti.current_time() / repeats
+              << " s\t" << oarc.off << " bytes" << std::endl;
+    double sum = 0;
+    ti.start();
+    for (size_t r = 0; r < repeats; ++r) {
+      graphlab::iarchive iarc(oarc.buf, oarc.off);
+      std::vector<double> copy;
+      iarc >> copy;
+      sum += copy.back();
+    }
+    std::cout << "vector<double> load:\t\t" << ti.current_time() / repeats
+              << " s" << std::endl;
+    save(oarc, graphlab::pod_view<double>(values));
+    ti.start();
+    for (size_t r = 0; r < repeats; ++r) {
+      graphlab::iarchive iarc(oarc.buf, oarc.off);
+      graphlab::pod_view<double> view;
+      iarc >> view;
+      sum += view[view.size() - 1];
+    }
+    std::cout << "pod_view<double> load:\t\t" << ti.current_time() / repeats
+              << " s" << std::endl;
+    if (sum != 2 * repeats * values.back()) std::cout << "MISMATCH" << std::endl;
+  }
+
+  // maps
+  {
+    boost::unordered_map<size_t, size_t> umap;
+    std::map<size_t, size_t> map;
+    for (size_t i = 0; i < nkeys; ++i) {
+      const size_t key = graphlab::random::fast_uniform<size_t>(0, size_t(-1));
+      umap[key] = i;
+      map[key] = i;
+    }
+    save(oarc, umap);
+    boost::unordered_map<size_t, size_t> umap2;
+    ti.start();
+    for (size_t r = 0; r < repeats; ++r) {
+      graphlab::iarchive iarc(oarc.buf, oarc.off);
+      load_unreserved(iarc, umap2);
+    }
+    std::cout << "unordered_map load unreserved:\t" << ti.current_time() / repeats
+              << " s" << std::endl;
+    ti.start();
+    for (size_t r = 0; r < repeats; ++r) {
+      graphlab::iarchive iarc(oarc.buf, oarc.off);
+      iarc >> umap2;
+    }
+    std::cout << "unordered_map load:\t\t" << ti.current_time() / repeats
+              << " s" << std::endl;
+    if (umap2 != umap) std::cout << "MISMATCH" << std::endl;
+
+    save(oarc, map);
+    std::map<size_t, size_t> map2;
+    ti.start();
+    for (size_t r = 0; r < repeats; ++r) {
+      graphlab::iarchive iarc(oarc.buf, oarc.off);
+      iarc >> map2;
+    }
+    std::cout << "map load:\t\t\t" << ti.current_time() / repeats
+              << " s" << std::endl;
+    if (map2 != map) std::cout << "MISMATCH" << std::endl;
+  }
+
+  // edges in the default and compact modes
+  {
+    std::vector<edge_type> edges(nedges);
+    for (size_t i = 0; i < nedges; ++i) {
+      edges[i].first.first = graphlab::random::fast_uniform<size_t>(0, nverts - 1);
+      edges[i].first.second = graphlab::random::fast_uniform<size_t>(0, nverts - 1);
+      edges[i].second = 1;
+    }
+    for (size_t compact = 0; compact < 2; ++compact) {
+      const char* name = compact ? "compact" : "default";
+      ti.start();
+      for (size_t r = 0; r < repeats; ++r) save(oarc, edges, compact);
+      std::cout << "edges save " << name << ":\t\t" << ti.current_time() / repeats
+                << " s\t" << oarc.off << " bytes" << std::endl;
+      std::vector<edge_type> edges2;
+      ti.start();
+      for (size_t r = 0; r < repeats; ++r) {
+        graphlab::iarchive iarc(oarc.buf, oarc.off);
+        iarc.compact = compact;
+        iarc >> edges2;
+      }
+      std::cout << "edges load " << name << ":\t\t" << ti.current_time() / repeats
+                << " s" << std::endl;
+      if (edges2 != edges) std::cout << "MISMATCH" << std::endl;
+    }
+  }
+  free(oarc.buf);
+  return EXIT_SUCCESS;
+}
+
+#include <graphlab/macros_undef.hpp>
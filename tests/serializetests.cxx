@@ -25,7 +25,10 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <sstream>
 #include <cstring>
+#include <limits>
+#include <stdint.h>
 
 #include <cxxtest/TestSuite.h>
 
@@ -36,6 +39,7 @@
 
 #include <graphlab/util/generics/any.hpp>
 #include <graphlab/serialization/serialization_includes.hpp>
+#include <graphlab/util/generics/conditional_addition_wrapper.hpp>
 
 
 using namespace graphlab;
@@ -414,5 +418,278 @@ public:
         TS_ASSERT_EQUALS(p1[i].x, p2[i].x);
     }
   }
+
+  void test_varint() {
+    const uint64_t values[] = {0, 1, 127, 128, 16383, 16384, 1ULL << 32,
+                               (1ULL << 63) - 1, uint64_t(-1)};
+    for (size_t i = 0; i < 9; ++i) {
+      char buf[VARINT_MAX_BYTES];
+      const size_t n = varint_encode(values[i], buf);
+      TS_ASSERT_EQUALS(n, varint_size(values[i]));
+      iarchive iarc(buf, n);
+      TS_ASSERT_EQUALS(iarc.read_varint(), values[i]);
+      TS_ASSERT(!iarc.fail());
+      // truncated
+      iarchive short_iarc(buf, n - 1);
+      short_iarc.read_varint();
+      TS_ASSERT(short_iarc.fail());
+    }
+    // over-long, with no terminating byte
+    char overlong[VARINT_MAX_BYTES + 1];
+    memset(overlong, 0x80, sizeof(overlong));
+    iarchive overlong_iarc(overlong, sizeof(overlong));
+    TS_ASSERT_EQUALS(overlong_iarc.read_varint(), 0u);
+    TS_ASSERT(overlong_iarc.fail());
+    std::stringstream overlong_strm(std::string(overlong, sizeof(overlong)));
+    iarchive overlong_sarc(overlong_strm);
+    TS_ASSERT_EQUALS(overlong_sarc.read_varint(), 0u);
+    TS_ASSERT(overlong_sarc.fail());
+    const int64_t signed_values[] = {0, -1, 1, -64, 64,
+                                     std::numeric_limits<int64_t>::min(),
+                                     std::numeric_limits<int64_t>::max()};
+    for (size_t i = 0; i < 7; ++i) {
+      TS_ASSERT_EQUALS(zigzag_decode(zigzag_encode(signed_values[i])),
+                       signed_values[i]);
+    }
+    TS_ASSERT_EQUALS(zigzag_encode(-1), 1u);
+    TS_ASSERT_EQUALS(zigzag_encode(1), 2u);
+  }
+
+  void test_compact_archive() {
+    std::stringstream strm;
+    oarchive oarc(strm);
+    oarc.compact = true;
+    const short a = -300;
+    const int b = -1;
+    const unsigned int c = 4000000000u;
+    const long d = -1234567890123L;
+    const size_t e = 5;
+    const double f = 3.5;
+    const char g = 'g';
+    std::vector<std::pair<size_t, int> > h;
+    for (int i = 0; i < 100; ++i) h.push_back(std::make_pair(size_t(i) << 20, -i));
+    std::string str = "hello";
+    oarc << a << b << c << d << e << f << g << h << str;
+    strm.flush();
+    iarchive iarc(strm);
+    iarc.compact = true;
+    short a2; int b2; unsigned int c2; long d2; size_t e2; double f2; char g2;
+    std::vector<std::pair<size_t, int> > h2;
+    std::string str2;
+    iarc >> a2 >> b2 >> c2 >> d2 >> e2 >> f2 >> g2 >> h2 >> str2;
+    TS_ASSERT_EQUALS(a, a2);
+    TS_ASSERT_EQUALS(b, b2);
+    TS_ASSERT_EQUALS(c, c2);
+    TS_ASSERT_EQUALS(d, d2);
+    TS_ASSERT_EQUALS(e, e2);
+    TS_ASSERT_EQUALS(f, f2);
+    TS_ASSERT_EQUALS(g, g2);
+    TS_ASSERT(h == h2);
+    TS_ASSERT_EQUALS(str, str2);
+  }
+
+  void test_compact_size() {
+    // records like the edges shuffled by the ingress
+    std::vector<std::pair<std::pair<size_t, size_t>, float> > edges;
+    for (size_t i = 0; i < 10000; ++i) {
+      edges.push_back(std::make_pair(std::make_pair(i * 7919 % 1000000,
+                                                    i * 104729 % 1000000), 1.0f));
+    }
+    oarchive fixed, compact;
+    compact.compact = true;
+    for (size_t i = 0; i < edges.size(); ++i) {
+      fixed << edges[i];
+      compact << edges[i];
+    }
+    // a 20 bit id takes 3 bytes as a varint and 4 + 1 tag bytes otherwise
+    TS_ASSERT_LESS_THAN_EQUALS(compact.off, edges.size() * (3 + 3 + 4));
+    TS_ASSERT_LESS_THAN(compact.off, fixed.off);
+    iarchive iarc(compact.buf, compact.off);
+    iarc.compact = true;
+    for (size_t i = 0; i < edges.size(); ++i) {
+      std::pair<std::pair<size_t, size_t>, float> edge;
+      iarc >> edge;
+      TS_ASSERT(edge == edges[i]);
+    }
+    TS_ASSERT_EQUALS(iarc.off, compact.off);
+    free(fixed.buf);
+    free(compact.buf);
+  }
+
+  void test_sorted_ids() {
+    std::vector<size_t> ids, ids2;
+    for (size_t i = 0; i < 10000; ++i) ids.push_back(1000000 + i * 3);
+    oarchive oarc;
+    serialize_sorted_ids(oarc, ids);
+    // the count, the first id and a byte per gap
+    TS_ASSERT_EQUALS(oarc.off, varint_size(ids.size()) +
+                               varint_size(ids[0]) + ids.size() - 1);
+    iarchive iarc(oarc.buf, oarc.off);
+    deserialize_sorted_ids(iarc, ids2);
+    TS_ASSERT(ids == ids2);
+    TS_ASSERT(!iarc.fail());
+    free(oarc.buf);
+  }
+
+  void test_pod_view() {
+    std::vector<double> values;
+    for (size_t i = 0; i < 1000; ++i) values.push_back(i * 0.5);
+    oarchive oarc;
+    oarc << size_t(7) << pod_view<double>(values) << pod_view<double>();
+    // aligned: points into the buffer
+    {
+      iarchive iarc(oarc.buf, oarc.off);
+      size_t seven;
+      pod_view<double> view, empty;
+      iarc >> seven >> view >> empty;
+      TS_ASSERT_EQUALS(iarc.off, oarc.off);
+      TS_ASSERT(!view.owns_data());
+      TS_ASSERT(view.to_vector() == values);
+      TS_ASSERT(empty.empty());
+    }
+    // misaligned: copied
+    {
+      char* shifted = (char*)malloc(oarc.off + 1);
+      memcpy(shifted + 1, oarc.buf, oarc.off);
+      iarchive iarc(shifted + 1, oarc.off);
+      size_t seven;
+      pod_view<double> view;
+      iarc >> seven >> view;
+      TS_ASSERT(view.owns_data());
+      TS_ASSERT(view.to_vector() == values);
+      // copies of an owning view own their own copy
+      pod_view<double> copy = view;
+      free(shifted);
+      TS_ASSERT(copy.to_vector() == values);
+    }
+    // streams are always copied
+    {
+      std::stringstream strm;
+      strm.write(oarc.buf, oarc.off);
+      iarchive iarc(strm);
+      size_t seven;
+      pod_view<double> view;
+      iarc >> seven >> view;
+      TS_ASSERT(view.owns_data());
+      TS_ASSERT(view.to_vector() == values);
+    }
+    // transient buffers are always copied
+    {
+      iarchive iarc(oarc.buf, oarc.off);
+      iarc.transient = true;
+      size_t seven;
+      pod_view<double> view;
+      iarc >> seven >> view;
+      TS_ASSERT(view.owns_data());
+      TS_ASSERT(view.to_vector() == values);
+    }
+    free(oarc.buf);
+  }
+
+  void test_truncated_buffer() {
+    boost::unordered_map<size_t, std::string> m, m2;
+    std::vector<std::string> strs, strs2;
+    for (size_t i = 0; i < 100; ++i) {
+      m[i] = std::string(i % 7, 'a');
+      strs.push_back(std::string(i % 5, 'b'));
+    }
+    oarchive oarc;
+    oarc << m << strs;
+    iarchive iarc(oarc.buf, oarc.off);
+    iarc >> m2 >> strs2;
+    TS_ASSERT(m == m2);
+    TS_ASSERT(strs == strs2);
+    TS_ASSERT_EQUALS(iarc.remaining(), 0);
+    TS_ASSERT(!iarc.fail());
+    // reading past the end fails without touching the destination
+    size_t x = 42;
+    iarc >> x;
+    TS_ASSERT(iarc.fail());
+    TS_ASSERT_EQUALS(x, 42);
+    free(oarc.buf);
+    // a truncated map stops at the end of the buffer
+    boost::unordered_map<size_t, size_t> ids, ids2;
+    for (size_t i = 0; i < 1000; ++i) ids[i] = i * i;
+    oarchive idarc;
+    idarc << ids;
+    iarchive short_iarc(idarc.buf, idarc.off / 2);
+    short_iarc >> ids2;
+    TS_ASSERT(short_iarc.fail());
+    TS_ASSERT_LESS_THAN(ids2.size(), ids.size());
+    // and keeps only the pairs it read completely
+    for (boost::unordered_map<size_t, size_t>::const_iterator it = ids2.begin();
+         it != ids2.end(); ++it) {
+      TS_ASSERT_EQUALS(it->second, it->first * it->first);
+    }
+    free(idarc.buf);
+    // a truncated set and vector keep only the strings read completely
+    boost::unordered_set<std::string> names, names2;
+    for (size_t i = 0; i < 100; ++i) names.insert(std::string(i + 1, 'c'));
+    std::vector<std::string> names_vec(names.begin(), names.end()), names_vec2;
+    oarchive narc;
+    narc << names;
+    const size_t names_vec_start = narc.off;
+    narc << names_vec;
+    iarchive short_narc(narc.buf, names_vec_start - 3);
+    short_narc >> names2;
+    TS_ASSERT(short_narc.fail());
+    TS_ASSERT_LESS_THAN(names2.size(), names.size());
+    for (boost::unordered_set<std::string>::const_iterator it = names2.begin();
+         it != names2.end(); ++it) {
+      TS_ASSERT_EQUALS(names.count(*it), 1);
+    }
+    iarchive short_nvarc(narc.buf + names_vec_start,
+                         narc.off - names_vec_start - 3);
+    short_nvarc >> names_vec2;
+    TS_ASSERT(short_nvarc.fail());
+    TS_ASSERT_EQUALS(names_vec2.size(), names_vec.size() - 1);
+    free(narc.buf);
+    // a truncated vector of PODs is left empty instead of aborting
+    std::vector<double> vals(1000, 1.5), vals2(3, 2.5);
+    pod_view<double> view(vals2);
+    oarchive varc;
+    varc << vals;
+    const size_t view_start = varc.off;
+    varc << pod_view<double>(vals);
+    iarchive short_varc(varc.buf, varc.off / 4);
+    short_varc >> vals2;
+    TS_ASSERT(short_varc.fail());
+    TS_ASSERT(vals2.empty());
+    iarchive view_iarc(varc.buf + view_start, (varc.off - view_start) / 2);
+    view_iarc >> view;
+    TS_ASSERT(view_iarc.fail());
+    TS_ASSERT(view.empty());
+    free(varc.buf);
+    // a corrupt pad is not skipped past the end of the buffer
+    oarchive parc;
+    parc << size_t(0) << (unsigned char)(255);
+    iarchive pad_iarc(parc.buf, parc.off);
+    pad_iarc >> view;
+    TS_ASSERT(pad_iarc.fail());
+    TS_ASSERT(view.empty());
+    free(parc.buf);
+  }
+
+  void test_conditional_addition_wrapper() {
+    typedef conditional_addition_wrapper<double> pod_wrapper;
+    typedef conditional_addition_wrapper<std::string> string_wrapper;
+    TS_ASSERT(gl_is_pod<pod_wrapper>::value);
+    TS_ASSERT(!gl_is_pod<string_wrapper>::value);
+    pod_wrapper a(2.5), b;
+    string_wrapper c(std::string("abc")), d;
+    oarchive oarc;
+    oarc << a << b << c << d;
+    iarchive iarc(oarc.buf, oarc.off);
+    pod_wrapper a2, b2(1.0);
+    string_wrapper c2, d2(std::string("x"));
+    iarc >> a2 >> b2 >> c2 >> d2;
+    TS_ASSERT(a2.has_value);
+    TS_ASSERT_EQUALS(a2.value, 2.5);
+    TS_ASSERT(b2.empty());
+    TS_ASSERT(c2.has_value);
+    TS_ASSERT_EQUALS(c2.value, "abc");
+    TS_ASSERT(d2.empty());
+    free(oarc.buf);
+  }
 };
 
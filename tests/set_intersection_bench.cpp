@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+/*
+ * Counts the triangles of a synthetic power-law graph on one thread
+ * with each of the sorted set intersection kernels of
+ * graphlab/util/set_intersection.hpp, and with the hash set lookups
+ * undirected_triangle_count used before, and reports the time taken.
+ *
+ * Edges are drawn between endpoints chosen with probability
+ * proportional to (i+1)^(-1/(alpha-1)), which gives degrees following a
+ * power law with exponent alpha. Vertex ids are then scrambled so that
+ * they are not correlated with the degree.
+ *
+ * Each edge is oriented from the endpoint of lower degree to the one of
+ * higher degree, as in the triangle counting toolkit, and the
+ * triangles are counted as the sum over all edges (u,v) of the
+ * intersection of the out-neighbors of u and v.
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <graphlab.hpp>
+#include <graphlab/util/hopscotch_set.hpp>
+#include <graphlab/util/powerlaw_edges.hpp>
+#include <graphlab/util/set_intersection.hpp>
+#include <graphlab/macros_def.hpp>
+
+typedef graphlab::vertex_id_type vid_type;
+typedef std::vector<std::vector<vid_type> > adjacency_type;
+
+adjacency_type make_powerlaw_graph(size_t nverts, size_t nedges, double alpha) {
+  const std::vector<std::pair<size_t, size_t> > edges =
+    graphlab::make_powerlaw_edges(nverts, nedges, alpha, true);
+  std::vector<std::vector<vid_type> > nbrs(nverts);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const vid_type u = edges[i].first;
+    const vid_type v = edges[i].second;
+    nbrs[u].push_back(v);
+    nbrs[v].push_back(u);
+  }
+  foreach(std::vector<vid_type>& n, nbrs) {
+    std::sort(n.begin(), n.end());
+    n.erase(std::unique(n.begin(), n.end()), n.end());
+  }
+  // orient every edge towards the endpoint with the larger degree
+  adjacency_type out(nverts);
+  for (size_t u = 0; u < nverts; ++u) {
+    foreach(vid_type v, nbrs[u]) {
+      if (nbrs[v].size() > nbrs[u].size() ||
+          (nbrs[v].size() == nbrs[u].size() && v > u)) {
+        out[u].push_back(v);
+      }
+    }
+  }
+  return out;
+}
+
+
+template <typename Kernel>
+size_t count_triangles(const adjacency_type& out, Kernel kernel) {
+  size_t count = 0;
+  for (size_t u = 0; u < out.size(); ++u) {
+    if (out[u].empty()) continue;
+    foreach(vid_type v, out[u]) {
+      if (out[v].empty()) continue;
+      count += kernel(&(out[u][0]), out[u].size(), &(out[v][0]), out[v].size());
+    }
+  }
+  return count;
+}
+
+size_t merge_kernel(const vid_type* a, size_t na, const vid_type* b, size_t nb) {
+  return graphlab::intersection_size_merge(a, na, b, nb);
+}
+size_t galloping_kernel(const vid_type* a, size_t na,
+                        const vid_type* b, size_t nb) {
+  return graphlab::intersection_size_galloping(a, na, b, nb);
+}
+size_t simd_kernel(const vid_type* a, size_t na, const vid_type* b, size_t nb) {
+  return graphlab::intersection_size_simd(a, na, b, nb);
+}
+size_t adaptive_kernel(const vid_type* a, size_t na,
+                       const vid_type* b, size_t nb) {
+  return graphlab::intersection_size(a, na, b, nb);
+}
+
+
+// the previous representation: hash sets above a size threshold
+size_t count_triangles_hashed(const adjacency_type& out, size_t threshold) {
+  std::vector<graphlab::hopscotch_set<vid_type>*> sets(out.size(), NULL);
+  for (size_t u = 0; u < out.size(); ++u) {
+    if (out[u].size() < threshold) continue;
+    sets[u] = new graphlab::hopscotch_set<vid_type>(threshold);
+    foreach(vid_type v, out[u]) sets[u]->insert(v);
+  }
+  size_t count = 0;
+  for (size_t u = 0; u < out.size(); ++u) {
+    foreach(vid_type v, out[u]) {
+      const bool swap = out[v].size() < out[u].size();
+      const size_t small = swap ? v : u, large = swap ? u : v;
+      if (sets[large] != NULL) {
+        foreach(vid_type w, out[small]) count += sets[large]->count(w);
+      } else {
+        count += graphlab::intersection_size_merge(
+            &(out[small][0]), out[small].size(),
+            &(out[large][0]), out[large].size());
+      }
+    }
+  }
+  foreach(graphlab::hopscotch_set<vid_type>* s, sets) delete s;
+  return count;
+}
+
+
+int main(int argc, char** argv) {
+  global_logger().set_log_level(LOG_WARNING);
+  size_t nverts = 1000000;
+  size_t avg_degree = 20;
+  double alpha = 2.1;
+  size_t hash_threshold = 64;
+  graphlab::command_line_options clopts("Set intersection benchmark.", true);
+  clopts.attach_option("nverts", nverts, "Number of vertices");
+  clopts.attach_option("degree", avg_degree, "Average degree");
+  clopts.attach_option("alpha", alpha, "Exponent of the degree distribution");
+  clopts.attach_option("ht", hash_threshold,
+                       "Hash set size threshold of the hashed baseline");
+  if(!clopts.parse(argc, argv)) return EXIT_FAILURE;
+
+  graphlab::random::seed(1);
+  const adjacency_type out =
+      make_powerlaw_graph(nverts, nverts * avg_degree / 2, alpha);
+  size_t nedges = 0, maxdeg = 0;
+  foreach(const std::vector<vid_type>& n, out) {
+    nedges += n.size();
+    maxdeg = std::max(maxdeg, n.size());
+  }
+  std::cout << nverts << " vertices, " << nedges << " edges, "
+            << "max out-degree " << maxdeg << std::endl;
+
+  graphlab::timer ti;
+  ti.start();
+  size_t count = count_triangles_hashed(out, hash_threshold);
+  std::cout << "hashed:\t\t" << ti.current_time() << " s\t"
+            << count << " triangles" << std::endl;
+
+  typedef size_t (*kernel_type)(const vid_type*, size_t, const vid_type*, size_t);
+  const char* names[] = {"merge", "galloping", "simd", "adaptive"};
+  kernel_type kernels[] = {merge_kernel, galloping_kernel,
+                           simd_kernel, adaptive_kernel};
+  for (size_t k = 0; k < 4; ++k) {
+    ti.start();
+    count = count_triangles(out, kernels[k]);
+    std::cout << names[k] << ":\t" << (k == 1 ? "" : "\t")
+              << ti.current_time() << " s\t"
+              << count << " triangles" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+#include <graphlab/macros_undef.hpp>
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cxxtest/TestSuite.h>
+
+#include <graphlab/util/set_intersection.hpp>
+#include <graphlab/util/random.hpp>
+
+class SetIntersectionTestSuite: public CxxTest::TestSuite {
+  // n distinct sorted values drawn from [0, range)
+  template <typename T>
+  std::vector<T> random_set(size_t n, size_t range) {
+    std::vector<T> ret(n);
+    for (size_t i = 0; i < n; ++i) {
+      ret[i] = graphlab::random::fast_uniform<size_t>(0, range - 1);
+    }
+    std::sort(ret.begin(), ret.end());
+    ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+    return ret;
+  }
+
+  template <typename T>
+  void check(const std::vector<T>& a, const std::vector<T>& b) {
+    std::vector<T> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                          std::back_inserter(expected));
+    const T* pa = a.empty() ? NULL : &(a[0]);
+    const T* pb = b.empty() ? NULL : &(b[0]);
+    TS_ASSERT_EQUALS(graphlab::intersection_size_merge(pa, a.size(), pb, b.size()),
+                     expected.size());
+    TS_ASSERT_EQUALS(graphlab::intersection_size_galloping(pa, a.size(), pb, b.size()),
+                     expected.size());
+    TS_ASSERT_EQUALS(graphlab::intersection_size_galloping(pb, b.size(), pa, a.size()),
+                     expected.size());
+    TS_ASSERT_EQUALS(graphlab::intersection_size_simd(pa, a.size(), pb, b.size()),
+                     expected.size());
+    TS_ASSERT_EQUALS(graphlab::intersection_size_simd(pb, b.size(), pa, a.size()),
+                     expected.size());
+    TS_ASSERT_EQUALS(graphlab::intersection_size(a, b), expected.size());
+    std::vector<T> out;
+    graphlab::sorted_intersection(pa, a.size(), pb, b.size(),
+                                  std::back_inserter(out));
+    TS_ASSERT(out == expected);
+  }
+
+  template <typename T>
+  void check_random() {
+    const size_t sizes[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 31, 100, 1000, 10000};
+    const size_t nsizes = sizeof(sizes) / sizeof(size_t);
+    for (size_t i = 0; i < nsizes; ++i) {
+      for (size_t j = 0; j < nsizes; ++j) {
+        // dense and sparse overlaps
+        check(random_set<T>(sizes[i], 2 * (sizes[i] + sizes[j]) + 1),
+              random_set<T>(sizes[j], 2 * (sizes[i] + sizes[j]) + 1));
+        check(random_set<T>(sizes[i], 100000), random_set<T>(sizes[j], 100000));
+      }
+    }
+  }
+
+ public:
+  void test_uint32() {
+    check_random<uint32_t>();
+  }
+
+  void test_uint64() {
+    check_random<uint64_t>();
+  }
+
+  void test_other_types() {
+    check_random<int>();
+  }
+
+  void test_edge_cases() {
+    std::vector<uint64_t> a, b;
+    for (size_t i = 0; i < 100; ++i) a.push_back(i);
+    // identical
+    check(a, a);
+    // disjoint and adjacent
+    for (size_t i = 100; i < 200; ++i) b.push_back(i);
+    check(a, b);
+    // interleaved
+    b.clear();
+    for (size_t i = 0; i < 200; i += 2) b.push_back(i);
+    check(a, b);
+    // large values which do not fit in 32 bits
+    b.clear();
+    for (size_t i = 0; i < 100; ++i) b.push_back(i + (uint64_t(1) << 40));
+    check(a, b);
+    a.push_back(uint64_t(1) << 40);
+    check(a, b);
+  }
+};
+
@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include <graphlab.hpp>
+
+typedef graphlab::distributed_graph<int,int> graph_type;
+
+const int STALENESS = 2;
+const int NAPPLIES = 20;
+const int NITERATIONS = 10;
+
+/// Activations of each vertex before it stops signaling itself
+int napplies = NAPPLIES;
+
+/*
+ * Every vertex counts its own applies and checks that its gather saw
+ * each in edge exactly once, whichever machine the edge is on. The
+ * last machine is throttled so that the others run ahead of it.
+ */
+class count_applies :
+  public graphlab::ivertex_program<graph_type, int>,
+  public graphlab::IS_POD_TYPE {
+public:
+  edge_dir_type
+  gather_edges(icontext_type& context, const vertex_type& vertex) const {
+    return graphlab::IN_EDGES;
+  }
+  gather_type
+  gather(icontext_type& context, const vertex_type& vertex,
+         edge_type& edge) const {
+    return 1;
+  }
+  void apply(icontext_type& context, vertex_type& vertex,
+             const gather_type& total) {
+    ASSERT_EQ(total, int(vertex.num_in_edges()));
+    if (context.num_procs() > 1 &&
+        context.procid() == context.num_procs() - 1 &&
+        vertex.id() % 1000 == 0) {
+      graphlab::timer::sleep_ms(5);
+    }
+    ++vertex.data();
+    if (vertex.data() < napplies) context.signal(vertex);
+  }
+  edge_dir_type
+  scatter_edges(icontext_type& context, const vertex_type& vertex) const {
+    return graphlab::NO_EDGES;
+  }
+}; // end of count_applies
+
+typedef graphlab::ssp_engine<count_applies> engine_type;
+
+int get_vertex_data(const graph_type::vertex_type& vertex) {
+  return vertex.data();
+}
+
+void reset_vertex(graph_type::vertex_type& vertex) {
+  vertex.data() = 0;
+}
+
+struct max_int {
+  int value;
+  max_int(int value = 0) : value(value) { }
+  max_int& operator+=(const max_int& other) {
+    value = std::max(value, other.value);
+    return *this;
+  }
+  void save(graphlab::oarchive& oarc) const { oarc << value; }
+  void load(graphlab::iarchive& iarc) { iarc >> value; }
+};
+
+max_int get_max_vertex_data(const graph_type::vertex_type& vertex) {
+  return max_int(vertex.data());
+}
+
+void check_lags(graphlab::distributed_control& dc, const engine_type& engine) {
+  const std::vector<size_t>& lags = engine.max_clock_lags();
+  ASSERT_EQ(lags.size(), dc.numprocs());
+  for (size_t i = 0; i < lags.size(); ++i) {
+    dc.cout() << "Machine " << i << " max lag " << lags[i] << std::endl;
+    ASSERT_LE(lags[i], size_t(STALENESS));
+  }
+}
+
+/*
+ * Without max_iterations the engine has to detect by itself that all
+ * machines are done, after every vertex applied exactly napplies times.
+ */
+void test_task_depletion(graphlab::distributed_control& dc,
+                         graph_type& graph) {
+  graphlab::command_line_options clopts("Test code.");
+  clopts.engine_args.set_option("staleness", STALENESS);
+  graph.transform_vertices(reset_vertex);
+  engine_type engine(dc, graph, clopts);
+  engine.signal_all();
+  graphlab::execution_status::status_enum status = engine.start();
+  ASSERT_EQ(status, graphlab::execution_status::TASK_DEPLETION);
+
+  int total = graph.map_reduce_vertices<int>(get_vertex_data);
+  ASSERT_EQ(total, int(graph.num_vertices()) * NAPPLIES);
+  ASSERT_EQ(size_t(total), engine.num_updates());
+  check_lags(dc, engine);
+  dc.cout() << "Task depletion passed" << std::endl;
+}
+
+/*
+ * Every activation takes at least one super-step of the master, so no
+ * vertex applies more than max_iterations times.
+ */
+void test_max_iterations(graphlab::distributed_control& dc,
+                         graph_type& graph) {
+  graphlab::command_line_options clopts("Test code.");
+  clopts.engine_args.set_option("max_iterations", NITERATIONS);
+  clopts.engine_args.set_option("staleness", STALENESS);
+  graph.transform_vertices(reset_vertex);
+  engine_type engine(dc, graph, clopts);
+  engine.signal_all();
+  engine.start();
+
+  int total = graph.map_reduce_vertices<int>(get_vertex_data);
+  ASSERT_EQ(size_t(total), engine.num_updates());
+  max_int most = graph.map_reduce_vertices<max_int>(get_max_vertex_data);
+  ASSERT_LE(most.value, NITERATIONS);
+  // a single machine has no mirrors to wait for
+  if (dc.numprocs() == 1) {
+    ASSERT_EQ(total, int(graph.num_vertices()) * NITERATIONS);
+  }
+  check_lags(dc, engine);
+  dc.cout() << "Max iterations passed" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  graphlab::mpi_tools::init(argc, argv);
+  graphlab::dc_init_param rpc_parameters;
+  graphlab::init_param_from_mpi(rpc_parameters);
+  graphlab::distributed_control dc(rpc_parameters);
+
+  graphlab::command_line_options clopts("Test code.");
+  std::cout << "Creating a powerlaw graph" << std::endl;
+  graph_type graph(dc, clopts);
+  graph.load_synthetic_powerlaw(10000);
+  graph.finalize();
+
+  test_task_depletion(dc, graph);
+  test_max_iterations(dc, graph);
+
+  graphlab::mpi_tools::finalize();
+} // end of main
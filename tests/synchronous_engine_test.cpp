@@ -284,6 +284,8 @@ public:
   }
 }; // end of count aggregators
 
+void reset_vertex(graph_type::vertex_type& vertex) { vertex.data() = 0; }
+
 int iteration_counter(count_aggregators::icontext_type& context,
                       const graph_type::vertex_type& vertex) {
   ASSERT_LT(vertex.data(), 100);
@@ -316,6 +318,131 @@ void test_count_aggregators(graphlab::distributed_control& dc,
 }
 
 
+int overlapped_finalize_iter = 0;
+void overlapped_iteration_finalize(count_aggregators::icontext_type& context,
+                                   const int& total) {
+  std::cout << "Finalized (overlapped)" << std::endl;
+  // the map started at the end of iteration i is delivered at the end of
+  // iteration i + 1, or by start() after the last iteration, and sees the
+  // vertex data written in iteration i
+  ++overlapped_finalize_iter;
+  ASSERT_EQ(overlapped_finalize_iter, context.iteration());
+  ASSERT_EQ(total, context.num_vertices() * context.iteration());
+}
+
+
+void test_overlapped_aggregators(graphlab::distributed_control& dc,
+                                 graphlab::command_line_options& clopts,
+                                 graph_type& graph) {
+  std::cout << "Constructing a syncrhonous engine for overlapped aggregators"
+            << std::endl;
+  typedef graphlab::synchronous_engine<count_aggregators> engine_type;
+  graphlab::command_line_options overlap_clopts = clopts;
+  overlap_clopts.engine_args.set_option("overlap_aggregation", true);
+  engine_type engine(dc, graph, overlap_clopts);
+  engine.add_vertex_aggregator<int>("iteration_counter",
+                                    iteration_counter,
+                                    overlapped_iteration_finalize);
+  engine.aggregate_periodic("iteration_counter", 0);
+  engine.signal_all();
+  std::cout << "Running!" << std::endl;
+  engine.start();
+  std::cout << "Finished" << std::endl;
+  // one result per iteration: the last one is flushed by start()
+  ASSERT_EQ(overlapped_finalize_iter, engine.iteration());
+}
+
+
+
+
+class delta_aggregators :
+  public graphlab::ivertex_program<graph_type, int>,
+  public graphlab::IS_POD_TYPE {
+public:
+  edge_dir_type
+  gather_edges(icontext_type& context, const vertex_type& vertex) const {
+    return graphlab::NO_EDGES;
+  }
+  void apply(icontext_type& context, vertex_type& vertex,
+             const gather_type& total) {
+    const int old_value = vertex.data();
+    vertex.data() = context.iteration() + 1;
+    context.aggregate_delta("vertex_sum", vertex.data() - old_value);
+    if(context.iteration() < 10) context.signal(vertex);
+  }
+  edge_dir_type
+  scatter_edges(icontext_type& context, const vertex_type& vertex) const {
+    return graphlab::OUT_EDGES;
+  }
+  void scatter(icontext_type& context, const vertex_type& vertex,
+               edge_type& edge) const {
+    const int old_value = edge.data();
+    edge.data() = context.iteration() + 1;
+    context.aggregate_delta("edge_sum", edge.data() - old_value);
+  }
+}; // end of delta aggregators
+
+int vertex_value(const graph_type::vertex_type& vertex) {
+  return vertex.data();
+}
+int edge_value(const graph_type::edge_type& edge) {
+  return edge.data();
+}
+int delta_vertex_map(delta_aggregators::icontext_type& context,
+                     const graph_type::vertex_type& vertex) {
+  return vertex.data();
+}
+int delta_edge_map(delta_aggregators::icontext_type& context,
+                   const graph_type::edge_type& edge) {
+  return edge.data();
+}
+int vertex_delta_total = 0;
+int vertex_delta_finalizes = 0;
+void vertex_delta_finalize(delta_aggregators::icontext_type& context,
+                           const int& total) {
+  ASSERT_EQ(total, context.num_vertices() * (context.iteration() + 1));
+  vertex_delta_total = total;
+  ++vertex_delta_finalizes;
+}
+int edge_delta_total = 0;
+int edge_delta_finalizes = 0;
+void edge_delta_finalize(delta_aggregators::icontext_type& context,
+                         const int& total) {
+  ASSERT_EQ(total, context.num_edges() * (context.iteration() + 1));
+  edge_delta_total = total;
+  ++edge_delta_finalizes;
+}
+void reset_edge(graph_type::edge_type& edge) { edge.data() = 0; }
+
+
+void test_delta_aggregators(graphlab::distributed_control& dc,
+                            graphlab::command_line_options& clopts,
+                            graph_type& graph) {
+  std::cout << "Constructing a syncrhonous engine for delta aggregators"
+            << std::endl;
+  graph.transform_vertices(reset_vertex);
+  graph.transform_edges(reset_edge);
+  typedef graphlab::synchronous_engine<delta_aggregators> engine_type;
+  engine_type engine(dc, graph, clopts);
+  engine.add_vertex_delta_aggregator<int>("vertex_sum", delta_vertex_map,
+                                          vertex_delta_finalize);
+  engine.add_edge_delta_aggregator<int>("edge_sum", delta_edge_map,
+                                        edge_delta_finalize);
+  engine.aggregate_periodic("vertex_sum", 0);
+  engine.aggregate_periodic("edge_sum", 0);
+  engine.signal_all();
+  std::cout << "Running!" << std::endl;
+  engine.start();
+  std::cout << "Finished" << std::endl;
+  // only the first aggregation maps over the graph, the others add up
+  // the deltas. Both must agree with a full map reduce.
+  ASSERT_EQ(vertex_delta_finalizes, engine.iteration());
+  ASSERT_EQ(edge_delta_finalizes, engine.iteration());
+  ASSERT_EQ(vertex_delta_total, graph.map_reduce_vertices<int>(vertex_value));
+  ASSERT_EQ(edge_delta_total, graph.map_reduce_edges<int>(edge_value));
+}
+
+
 
 
 int main(int argc, char** argv) {
@@ -336,6 +463,25 @@ int main(int argc, char** argv) {
   test_all_neighbors(dc, clopts, graph);
   test_messages(dc, clopts, graph);
   test_count_aggregators(dc, clopts, graph);
+  graph.transform_vertices(reset_vertex);
+  test_overlapped_aggregators(dc, clopts, graph);
+  test_delta_aggregators(dc, clopts, graph);
+
+  std::cout << "Repeating message test with fused_sync" << std::endl;
+  graphlab::command_line_options fused_clopts = clopts;
+  fused_clopts.engine_args.set_option("fused_sync", true);
+  test_messages(dc, fused_clopts, graph);
+
+  std::cout << "Repeating neighbor tests on a hybrid partitioned graph" << std::endl;
+  graphlab::command_line_options hybrid_clopts = clopts;
+  hybrid_clopts.graph_args.set_option("ingress", std::string("hybrid"));
+  hybrid_clopts.graph_args.set_option("threshold", 10);
+  graph_type hybrid_graph(dc, hybrid_clopts);
+  hybrid_graph.load_synthetic_powerlaw(10000);
+  hybrid_graph.finalize();
+  test_in_neighbors(dc, hybrid_clopts, hybrid_graph);
+  test_out_neighbors(dc, hybrid_clopts, hybrid_graph);
+  test_all_neighbors(dc, hybrid_clopts, hybrid_graph);
 
   graphlab::mpi_tools::finalize();
 } // end of main
@@ -40,6 +40,7 @@
 
 // This file defines the serialization code for the eigen types.
 #include "eigen_serialization.hpp"
+#include "als_gather.hpp"
 
 #include <graphlab.hpp>
 #include <graphlab/util/stl_util.hpp>
@@ -52,21 +53,6 @@ const int SAFE_NEG_OFFSET = 2; //add 2 to negative node id
 
 
 
-/**
- * \brief We use the eigen library's vector type to represent
- * mathematical vectors.
- */
-typedef Eigen::VectorXd vec_type;
-
-/**
- * \brief We use the eigen library's matrix type to represent
- * matrices.
- */
-typedef Eigen::MatrixXd mat_type;
-
-
-
-
 /** 
  * \ingroup toolkit_matrix_factorization
  *
@@ -133,9 +119,12 @@ struct edge_data : public graphlab::IS_POD_TYPE {
   /** \brief The train/validation/test designation of the edge */
   data_role_type role;
 
+  /** \brief The squared error last reported to the error aggregator */
+  float sqerr;
+
   /** \brief basic initialization */
   edge_data(float obs = 0, data_role_type role = TRAIN) :
-    obs(obs), role(role) { }
+    obs(obs), role(role), sqerr(0) { }
 
 }; // end of edge data
 
@@ -175,80 +164,6 @@ get_other_vertex(graph_type::edge_type& edge,
 
 
 
-/**
- * \brief The gather type used to construct XtX and Xty needed for the ALS
- * update
- *
- * To compute the ALS update we need to compute the sum of 
- * \code
- *  sum: XtX = nbr.factor.transpose() * nbr.factor 
- *  sum: Xy  = nbr.factor * edge.obs
- * \endcode
- * For each of the neighbors of a vertex. 
- *
- * To do this in the Gather-Apply-Scatter model the gather function
- * computes and returns a pair consisting of XtX and Xy which are then
- * added. The gather type represents that tuple and provides the
- * necessary gather_type::operator+= operation.
- *
- */
-class gather_type {
-public:
-  /**
-   * \brief Stores the current sum of nbr.factor.transpose() *
-   * nbr.factor
-   */
-  mat_type XtX;
-
-  /**
-   * \brief Stores the current sum of nbr.factor * edge.obs
-   */
-  vec_type Xy;
-
-  /** \brief basic default constructor */
-  gather_type() { }
-
-  /**
-   * \brief This constructor computes XtX and Xy and stores the result
-   * in XtX and Xy
-   */
-  gather_type(const vec_type& X, const double y) :
-    XtX(X.size(), X.size()), Xy(X.size()) {
-    XtX.triangularView<Eigen::Upper>() = X * X.transpose();
-    Xy = X * y;
-  } // end of constructor for gather type
-
-  /** \brief Save the values to a binary archive */
-  void save(graphlab::oarchive& arc) const { arc << XtX << Xy; }
-
-  /** \brief Read the values from a binary archive */
-  void load(graphlab::iarchive& arc) { arc >> XtX >> Xy; }  
-
-  /** 
-   * \brief Computes XtX += other.XtX and Xy += other.Xy updating this
-   * tuples value
-   */
-  gather_type& operator+=(const gather_type& other) {
-    if(other.Xy.size() == 0) {
-      ASSERT_EQ(other.XtX.rows(), 0);
-      ASSERT_EQ(other.XtX.cols(), 0);
-    } else {
-      if(Xy.size() == 0) {
-        ASSERT_EQ(XtX.rows(), 0); 
-        ASSERT_EQ(XtX.cols(), 0);
-        XtX = other.XtX; Xy = other.Xy;
-      } else {
-        XtX.triangularView<Eigen::Upper>() += other.XtX;  
-        Xy += other.Xy;
-      }
-    }
-    return *this;
-  } // end of operator+=
-
-}; // end of gather type
-
-
-
 /**
  * \brief ALS vertex program implements the alternating least squares
  * algorithm in the Gather-Apply-Scatter abstraction.
@@ -266,9 +181,9 @@ public:
  *
  * We implement this in the Gather-Apply-Scatter model by:
  *
- *  1) Gather: returns the tuple (X' * X, X' * y)
- *     Sum:   (aX' * aX, aX * ay) + (bX' * bX, bX * by) = 
- *                 (aX' * aX + bX' * bX, aX * ay + bX * by)
+ *  1) Gather: returns the neighbor factor x and the rating y
+ *     Sum:   accumulates (X' * X, X' * y) as the sum of x * x' and x * y,
+ *            adding blocks of factors at once (see gather_type)
  *
  *  2) Apply: Solves  inv(X' * X) * (X' * y)
  *
@@ -290,6 +205,7 @@ public:
   static double MAXVAL;
   static double MINVAL;
   static int    REGNORMAL; //regularization type
+  static size_t GATHER_BLOCK; // factors added to XtX at once
 
   /** The set of edges to gather along */
   edge_dir_type gather_edges(icontext_type& context, 
@@ -297,12 +213,16 @@ public:
     return graphlab::ALL_EDGES; 
   }; // end of gather_edges 
 
-  /** The gather function computes XtX and Xy */
+  /**
+   * The gather function returns the factor of the neighbor and the
+   * rating of the edge, which the sum of gather_type adds to XtX and Xy
+   */
   gather_type gather(icontext_type& context, const vertex_type& vertex, 
                      edge_type& edge) const {
     if(edge.data().role == edge_data::TRAIN) {
       const vertex_type other_vertex = get_other_vertex(edge, vertex);
-      return gather_type(other_vertex.data().factor, edge.data().obs);
+      return gather_type(other_vertex.data().factor, edge.data().obs,
+                         GATHER_BLOCK);
     } else return gather_type();
   } // end of gather function
 
@@ -313,9 +233,11 @@ public:
     vertex_data& vdata = vertex.data(); 
     // Determine the number of neighbors.  Each vertex has only in or
     // out edges depending on which side of the graph it is located
-    if(sum.Xy.size() == 0) { vdata.residual = 0; ++vdata.nupdates; return; }
-    mat_type XtX = sum.XtX;
-    vec_type Xy = sum.Xy;
+    if(sum.empty()) { vdata.residual = 0; ++vdata.nupdates; return; }
+    gather_type total = sum;
+    total.finalize();
+    mat_type& XtX = total.XtX;
+    const vec_type& Xy = total.Xy;
     // Add regularization
     double regularization = LAMBDA;
     if (REGNORMAL)
@@ -323,8 +245,12 @@ public:
     for(int i = 0; i < XtX.rows(); ++i) 
       XtX(i,i) += regularization; 
     // Solve the least squares problem using eigen ----------------------------
+    // XtX is positive definite unless the regularization is 0, in which
+    // case the Cholesky factorization may fail and we fall back to LDLt
     const vec_type old_factor = vdata.factor;
-    vdata.factor = XtX.selfadjointView<Eigen::Upper>().ldlt().solve(Xy);
+    Eigen::LLT<mat_type, Eigen::Upper> llt(XtX);
+    if(llt.info() == Eigen::Success) vdata.factor = llt.solve(Xy);
+    else vdata.factor = XtX.selfadjointView<Eigen::Upper>().ldlt().solve(Xy);
     // Compute the residual change in the factor factor -----------------------
     vdata.residual = (vdata.factor - old_factor).cwiseAbs().sum() / XtX.rows();
     ++vdata.nupdates;
@@ -340,6 +266,9 @@ public:
   void scatter(icontext_type& context, const vertex_type& vertex, 
                edge_type& edge) const {
     edge_data& edata = edge.data();
+    // Only the source refreshes the error, so that the two endpoints
+    // never update edata.sqerr at the same time
+    if(edge.source().id() == vertex.id()) update_error(context, edge);
     if(edata.role == edge_data::TRAIN) {
       const vertex_type other_vertex = get_other_vertex(edge, vertex);
       const vertex_data& vdata = vertex.data();
@@ -355,6 +284,13 @@ public:
     }
   } // end of scatter function
 
+  /**
+   * \brief Recompute the squared error of the edge and push the
+   * change to the incremental error aggregator. Must only be called
+   * by one endpoint of the edge.
+   */
+  static void update_error(icontext_type& context, edge_type& edge);
+
 
   /**
    * \brief Signal all vertices on one side of the bipartite graph
@@ -432,6 +368,7 @@ double extract_l2_error(const graph_type::edge_type & edge) {
 
 double als_vertex_program::TOLERANCE = 1e-3;
 double als_vertex_program::LAMBDA = 0.01;
+size_t als_vertex_program::GATHER_BLOCK = gather_type::DEFAULT_BLOCK_SIZE;
 size_t als_vertex_program::MAX_UPDATES = -1;
 double als_vertex_program::MAXVAL = 1e+100;
 double als_vertex_program::MINVAL = -1e+100;
@@ -461,15 +398,31 @@ struct error_aggregator : public graphlab::IS_POD_TYPE {
     validation_error += other.validation_error;
     return *this;
   }
-  static error_aggregator map(icontext_type& context, const graph_type::edge_type& edge) {
+  static error_aggregator from_error(const edge_data& edata, double error) {
     error_aggregator agg;
-    if(edge.data().role == edge_data::TRAIN) {
-      agg.train_error = extract_l2_error(edge); 
-    } else if(edge.data().role == edge_data::VALIDATE) {
-      agg.validation_error = extract_l2_error(edge);
+    if(edata.role == edge_data::TRAIN) {
+      agg.train_error = error;
+    } else if(edata.role == edge_data::VALIDATE) {
+      agg.validation_error = error;
     }
     return agg;
   }
+  /** Seeds the incremental aggregation with the stored edge errors */
+  static error_aggregator map(icontext_type& context, const graph_type::edge_type& edge) {
+    return from_error(edge.data(), edge.data().sqerr);
+  }
+  /** Computes the error from the current factors */
+  static error_aggregator map_current(icontext_type& context,
+                                      const graph_type::edge_type& edge) {
+    if(edge.data().role == edge_data::PREDICT) return error_aggregator();
+    return from_error(edge.data(), extract_l2_error(edge));
+  }
+  /** Initializes the stored error of each edge */
+  static void init_edge(graph_type::edge_type& edge) {
+    if(edge.data().role != edge_data::PREDICT) {
+      edge.data().sqerr = extract_l2_error(edge);
+    }
+  }
   static void finalize(icontext_type& context, const error_aggregator& agg) {
     const double train_error = std::sqrt(agg.train_error / info.training_edges);
     context.cout() << "Time in seconds: " << context.elapsed_seconds() << "\tiTraining RMSE: " << train_error;
@@ -483,6 +436,18 @@ struct error_aggregator : public graphlab::IS_POD_TYPE {
 }; // end of error aggregator
 
 
+void als_vertex_program::update_error(icontext_type& context,
+                                      edge_type& edge) {
+  edge_data& edata = edge.data();
+  if(edata.role == edge_data::PREDICT) return;
+  const float sqerr = extract_l2_error(edge);
+  context.aggregate_delta("error",
+                          error_aggregator::from_error(edata,
+                                                       sqerr - edata.sqerr));
+  edata.sqerr = sqerr;
+} // end of update_error
+
+
 
 
 /**
@@ -595,9 +560,11 @@ int main(int argc, char** argv) {
   clopts.attach_option("predictions", predictions,
                        "The prefix (folder and filename) to save predictions.");
   clopts.attach_option("engine", exec_type, 
-                       "The engine type synchronous or asynchronous");
+                       "The engine type synchronous, asynchronous or ssp");
   clopts.attach_option("regnormal", als_vertex_program::REGNORMAL, 
                        "regularization type. 1 = weighted according to neighbors num. 0 = no weighting - just lambda");
+  clopts.attach_option("gather_block", als_vertex_program::GATHER_BLOCK,
+                       "The number of neighbor factors added to XtX at once");
   
   parse_implicit_command_line(clopts);
   
@@ -606,6 +573,10 @@ int main(int argc, char** argv) {
     clopts.print_description();
     return EXIT_FAILURE;
   }
+  if(als_vertex_program::GATHER_BLOCK == 0) {
+    std::cout << "--gather_block must be positive." << std::endl;
+    return EXIT_FAILURE;
+  }
 
 
   ///! Initialize control plain using mpi
@@ -657,10 +628,16 @@ int main(int argc, char** argv) {
   dc.cout() << "Creating engine" << std::endl;
   engine_type engine(dc, graph, exec_type, clopts);
 
-  // Add error reporting to the engine
-  const bool success = engine.add_edge_aggregator<error_aggregator>
+  // Add error reporting to the engine. The error of an edge is updated
+  // by the scatter of its source, so only the changes are aggregated.
+  // The reported error therefore lags behind the updates of the targets;
+  // the final error is computed from the current factors.
+  graph.transform_edges(error_aggregator::init_edge);
+  const bool success = engine.add_edge_delta_aggregator<error_aggregator>
     ("error", error_aggregator::map, error_aggregator::finalize) &&
-    engine.aggregate_periodic("error", interval);
+    engine.aggregate_periodic("error", interval) &&
+    engine.add_edge_aggregator<error_aggregator>
+    ("final_error", error_aggregator::map_current, error_aggregator::finalize);
   ASSERT_TRUE(success);
   
 
@@ -685,7 +662,7 @@ int main(int argc, char** argv) {
 
   // Compute the final training error -----------------------------------------
   dc.cout() << "Final error: " << std::endl;
-  engine.aggregate_now("error");
+  engine.aggregate_now("final_error");
 
   // Make predictions ---------------------------------------------------------
   if(!predictions.empty()) {
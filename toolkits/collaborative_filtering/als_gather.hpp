@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ *
+ * The gather type of the ALS vertex program, which sums XtX and Xy
+ * over the neighbors of a vertex in blocks of factors.
+ */
+
+#ifndef ALS_GATHER_HPP
+#define ALS_GATHER_HPP
+
+#include <algorithm>
+
+#include <Eigen/Dense>
+
+#include "eigen_serialization.hpp"
+
+/**
+ * \brief We use the eigen library's vector type to represent
+ * mathematical vectors.
+ */
+typedef Eigen::VectorXd vec_type;
+
+/**
+ * \brief We use the eigen library's matrix type to represent
+ * matrices.
+ */
+typedef Eigen::MatrixXd mat_type;
+
+
+
+/**
+ * \brief The gather type used to construct XtX and Xty needed for the ALS
+ * update
+ *
+ * To compute the ALS update we need to compute the sum of 
+ * \code
+ *  sum: XtX = nbr.factor.transpose() * nbr.factor 
+ *  sum: Xy  = nbr.factor * edge.obs
+ * \endcode
+ * For each of the neighbors of a vertex. 
+ *
+ * To do this in the Gather-Apply-Scatter model the gather function
+ * returns the neighbor factor and the observation, and the sum
+ * collects them as the columns of a block of pending factors. When
+ * the block is full it is added to XtX with a single rank-k update
+ * (a BLAS-3 syrk) instead of one rank-1 update per edge.
+ *
+ * The gather on an edge only refers to the factor of the neighbor, so
+ * it allocates nothing. An accumulator allocates its block once, on
+ * the first factor, and keeps it across flushes, so adding the
+ * factors of a vertex of any degree allocates a constant number of
+ * times.
+ *
+ */
+class gather_type {
+public:
+  /** \brief The default number of factors added to XtX at once */
+  static const size_t DEFAULT_BLOCK_SIZE = 32;
+
+  /** \brief The number of factors added to XtX at once */
+  size_t block_size;
+
+  /**
+   * \brief Stores the current sum of nbr.factor.transpose() *
+   * nbr.factor for the factors which are no longer pending. Only the
+   * upper triangle is kept.
+   */
+  mat_type XtX;
+
+  /**
+   * \brief Stores the current sum of nbr.factor * edge.obs for the
+   * factors which are no longer pending
+   */
+  vec_type Xy;
+
+  /** \brief The pending neighbor factors, one per column */
+  mat_type pending;
+
+  /** \brief The observations of the pending factors */
+  vec_type pending_y;
+
+  /** \brief The number of columns of pending in use */
+  size_t npending;
+
+  /** \brief basic default constructor */
+  gather_type() : block_size(DEFAULT_BLOCK_SIZE), npending(0),
+                  edge_X(NULL), edge_y(0) { }
+
+  /**
+   * \brief This constructor refers to X and y as the only factor, and
+   * adds the factors to XtX block_size at a time. X is not copied and
+   * must not change until the gather_type is added or assigned to an
+   * accumulator, or copied; the neighbor factor of an edge gather does
+   * not change during the gather.
+   */
+  gather_type(const vec_type& X, const double y,
+              size_t block_size = DEFAULT_BLOCK_SIZE) :
+    block_size(block_size), npending(0), edge_X(&X), edge_y(y) { }
+
+  /** \brief Copies other, which then owns its factors */
+  gather_type(const gather_type& other) : edge_X(NULL) { *this = other; }
+
+  /**
+   * \brief Copies other. Only the pending columns in use are copied,
+   * and the factor of a single edge gather is copied to a new block.
+   */
+  gather_type& operator=(const gather_type& other) {
+    if(this == &other) return *this;
+    block_size = other.block_size;
+    XtX = other.XtX;
+    Xy = other.Xy;
+    npending = 0;
+    edge_X = NULL;
+    if(other.edge_X != NULL) {
+      append(*other.edge_X, other.edge_y);
+    } else {
+      pending = other.pending.leftCols(other.npending);
+      pending_y = other.pending_y.head(other.npending);
+      npending = other.npending;
+    }
+    return *this;
+  } // end of operator=
+
+  /** \brief True if no factor has been added */
+  bool empty() const {
+    return npending == 0 && Xy.size() == 0 && edge_X == NULL;
+  }
+
+  /**
+   * \brief Adds the pending factors to XtX and Xy. The block which held
+   * them is kept for the next factors.
+   */
+  void flush() {
+    own_edge();
+    if(npending == 0) return;
+    const int n = pending.rows();
+    if(Xy.size() == 0) {
+      XtX.setZero(n, n);
+      Xy.setZero(n);
+    }
+    XtX.selfadjointView<Eigen::Upper>().rankUpdate(pending.leftCols(npending));
+    Xy.noalias() += pending.leftCols(npending) * pending_y.head(npending);
+    npending = 0;
+  } // end of flush
+
+  /**
+   * \brief Adds the pending factors to XtX and Xy and releases the
+   * block, once no more factors will be added
+   */
+  void finalize() {
+    flush();
+    pending.resize(0, 0);
+    pending_y.resize(0);
+  } // end of finalize
+
+  /** \brief Save the values to a binary archive */
+  void save(graphlab::oarchive& arc) const {
+    if(edge_X != NULL) {
+      arc << block_size << XtX << Xy << size_t(1)
+          << mat_type(*edge_X) << vec_type(vec_type::Constant(1, edge_y));
+      return;
+    }
+    arc << block_size << XtX << Xy << npending;
+    if(npending > 0) {
+      arc << mat_type(pending.leftCols(npending))
+          << vec_type(pending_y.head(npending));
+    }
+  }
+
+  /** \brief Read the values from a binary archive */
+  void load(graphlab::iarchive& arc) {
+    edge_X = NULL;
+    arc >> block_size >> XtX >> Xy >> npending;
+    if(npending > 0) arc >> pending >> pending_y;
+  }
+
+  /** 
+   * \brief Computes XtX += other.XtX and Xy += other.Xy updating this
+   * tuples value, and appends the pending factors of other
+   */
+  gather_type& operator+=(const gather_type& other) {
+    if(other.empty()) return *this;
+    if(empty()) { *this = other; return *this; }
+    own_edge();
+    if(other.edge_X != NULL) append(*other.edge_X, other.edge_y);
+    for(size_t i = 0; i < other.npending; ++i) {
+      append(other.pending.col(i), other.pending_y(i));
+    }
+    if(other.Xy.size() > 0) {
+      if(Xy.size() == 0) {
+        XtX = other.XtX; Xy = other.Xy;
+      } else {
+        XtX.triangularView<Eigen::Upper>() += other.XtX;  
+        Xy += other.Xy;
+      }
+    }
+    return *this;
+  } // end of operator+=
+
+private:
+  /** \brief The factor of a single edge gather, not owned */
+  const vec_type* edge_X;
+
+  /** \brief The observation of a single edge gather */
+  double edge_y;
+
+  /** \brief Copies the factor of a single edge gather to the block */
+  void own_edge() {
+    if(edge_X == NULL) return;
+    const vec_type* X = edge_X;
+    edge_X = NULL;
+    append(*X, edge_y);
+  } // end of own_edge
+
+  template <typename Column>
+  void append(const Column& X, const double y) {
+    if(size_t(pending.cols()) <= npending) {
+      // grow to a full block at once, keeping the pending columns
+      const size_t ncols = std::max(block_size, npending + 1);
+      mat_type block(X.size(), ncols);
+      vec_type block_y(ncols);
+      if(npending > 0) {
+        block.leftCols(npending) = pending.leftCols(npending);
+        block_y.head(npending) = pending_y.head(npending);
+      }
+      pending.swap(block);
+      pending_y.swap(block_y);
+    }
+    pending.col(npending) = X;
+    pending_y(npending) = y;
+    if(++npending >= block_size) flush();
+  } // end of append
+
+}; // end of gather type
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ *
+ * Checks that the blocked sums of the ALS gather_type match the sum of
+ * the rank-1 updates.
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+/*
+ * Counts the failed Eigen checks instead of aborting. While
+ * Eigen::internal::set_is_malloc_allowed(false) is in effect, every
+ * allocation by Eigen is a failed check.
+ */
+static size_t eigen_failed_checks = 0;
+#define EIGEN_RUNTIME_NO_MALLOC
+#define eigen_assert(x) do { if(!(x)) ++eigen_failed_checks; } while(0)
+
+#include "als_gather.hpp"
+
+/**
+ * \brief Sums 3 * block_size + 5 factors in three partial sums merged
+ * with +=: one with full blocks and pending factors, one which is also
+ * saved and loaded with pending factors, and one with pending factors
+ * only. The first factors of b and c are a saved and loaded, and a
+ * copied, single edge gather. Aborts on a mismatch.
+ */
+void check_gather_type(size_t nlatent, size_t block_size) {
+  const size_t nfactors = 3 * block_size + 5;
+  std::vector<vec_type> X(nfactors);
+  std::vector<double> y(nfactors);
+  mat_type XtX = mat_type::Zero(nlatent, nlatent);
+  vec_type Xy = vec_type::Zero(nlatent);
+  for(size_t i = 0; i < nfactors; ++i) {
+    X[i] = vec_type::Random(nlatent);
+    y[i] = double(i % 7) - 3;
+    XtX += X[i] * X[i].transpose();
+    Xy += X[i] * y[i];
+  }
+  const mat_type expected = XtX.triangularView<Eigen::Upper>();
+  const size_t split1 = nfactors / 2, split2 = nfactors - 2;
+  gather_type a, b, c;
+  for(size_t i = 0; i < split1; ++i)
+    a += gather_type(X[i], y[i], block_size);
+  graphlab::oarchive edge_oarc;
+  edge_oarc << gather_type(X[split1], y[split1], block_size);
+  graphlab::iarchive edge_iarc(edge_oarc.buf, edge_oarc.off);
+  edge_iarc >> b;
+  free(edge_oarc.buf);
+  for(size_t i = split1 + 1; i < split2; ++i)
+    b += gather_type(X[i], y[i], block_size);
+  const gather_type edge(X[split2], y[split2], block_size);
+  c = edge;
+  for(size_t i = split2 + 1; i < nfactors; ++i)
+    c += gather_type(X[i], y[i], block_size);
+  graphlab::oarchive oarc;
+  oarc << b;
+  graphlab::iarchive iarc(oarc.buf, oarc.off);
+  gather_type loaded;
+  iarc >> loaded;
+  free(oarc.buf);
+  a += loaded;
+  a += c;
+  a.finalize();
+  ASSERT_EQ(a.pending.size(), 0);
+  const mat_type result = a.XtX.triangularView<Eigen::Upper>();
+  ASSERT_LT((result - expected).cwiseAbs().maxCoeff(), 1e-8);
+  ASSERT_LT((a.Xy - Xy).cwiseAbs().maxCoeff(), 1e-8);
+} // end of check_gather_type
+
+/**
+ * \brief Sums the factors of a vertex of degree nedges, as the engine
+ * does, and returns the number of Eigen allocations after the first
+ * flush, which allocates the block, XtX and Xy. Aborts on a mismatch.
+ */
+size_t count_allocations(size_t nlatent, size_t block_size, size_t nedges) {
+  std::vector<vec_type> X(nedges);
+  mat_type XtX = mat_type::Zero(nlatent, nlatent);
+  for(size_t i = 0; i < nedges; ++i) {
+    X[i] = vec_type::Random(nlatent);
+    XtX += X[i] * X[i].transpose();
+  }
+  gather_type accum;
+  accum = gather_type(X[0], 1.0, block_size);
+  for(size_t i = 1; i < block_size; ++i) {
+    accum += gather_type(X[i], 1.0, block_size);
+  }
+  const size_t failed_checks = eigen_failed_checks;
+  Eigen::internal::set_is_malloc_allowed(false);
+  for(size_t i = block_size; i < nedges; ++i) {
+    accum += gather_type(X[i], 1.0, block_size);
+  }
+  accum.flush();
+  Eigen::internal::set_is_malloc_allowed(true);
+  const size_t nallocs = eigen_failed_checks - failed_checks;
+  const mat_type expected = XtX.triangularView<Eigen::Upper>();
+  const mat_type result = accum.XtX.triangularView<Eigen::Upper>();
+  ASSERT_LT((result - expected).cwiseAbs().maxCoeff(), 1e-8);
+  return nallocs;
+} // end of count_allocations
+
+int main(int argc, char** argv) {
+  const size_t nlatents[] = {1, 5, 20};
+  const size_t block_sizes[] = {1, 4, 32};
+  for(size_t i = 0; i < 3; ++i) {
+    for(size_t j = 0; j < 3; ++j) {
+      check_gather_type(nlatents[i], block_sizes[j]);
+    }
+  }
+  std::cout << "gather_type sums match." << std::endl;
+  for(size_t i = 0; i < 3; ++i) {
+    const size_t nallocs = count_allocations(nlatents[i], 32, 500);
+    std::cout << "D = " << nlatents[i] << ", 500 edges: " << nallocs
+              << " allocations after the first block." << std::endl;
+    ASSERT_EQ(nallocs, 0);
+  }
+  return 0;
+}
@@ -384,6 +384,60 @@ double extract_l2_error(const graph_type::edge_type & edge) {
 } // end of extract_l2_error
 
 
+/**
+ * \brief The edge update of --engine=hogwild: a single SGD step on the
+ * factors and biases of both endpoints of a training edge, written in
+ * place without locks. The other edges are skipped and not counted as
+ * updates.
+ */
+bool hogwild_biassgd_update(graph_type::edge_type& edge) {
+  if (edge.data().role != edge_data::TRAIN)
+    return false;
+  vertex_data& user = edge.source().data();
+  vertex_data& item = edge.target().data();
+  double pred = biassgd_vertex_program::GLOBAL_MEAN +
+      user.bias + item.bias + user.pvec.dot(item.pvec);
+  pred = std::min(pred, biassgd_vertex_program::MAXVAL);
+  pred = std::max(pred, biassgd_vertex_program::MINVAL);
+  const double err = pred - edge.data().obs;
+  if (std::isnan(err))
+    logstream(LOG_FATAL)<<"Got into numeric errors.. try to tune step size and regularization using --lambda and --gamma flags" << std::endl;
+  const double gamma = biassgd_vertex_program::GAMMA;
+  const double lambda = biassgd_vertex_program::LAMBDA;
+  user.bias -= gamma*(err + lambda*user.bias);
+  item.bias -= gamma*(err + lambda*item.bias);
+  for (int k = 0; k < user.pvec.size(); ++k) {
+    const double u = user.pvec[k], v = item.pvec[k];
+    user.pvec[k] -= gamma*(err*v + lambda*u);
+    item.pvec[k] -= gamma*(err*u + lambda*v);
+  }
+  return true;
+} // end of hogwild_biassgd_update
+
+/** \brief Adds a mirror's factors and bias into the master's */
+void hogwild_combine(vertex_data& master, const vertex_data& mirror) {
+  master.pvec += mirror.pvec;
+  master.bias += mirror.bias;
+}
+
+/** \brief Averages the summed factors and biases of all replicas */
+void hogwild_average(vertex_data& master, size_t nreplicas) {
+  master.pvec /= double(nreplicas);
+  master.bias /= double(nreplicas);
+}
+
+error_aggregator hogwild_error(const graph_type::edge_type& edge) {
+  error_aggregator agg;
+  if (edge.data().role == edge_data::TRAIN) {
+    agg.train_error = extract_l2_error(edge); agg.ntrain = 1;
+  }
+  else if (edge.data().role == edge_data::VALIDATE) {
+    agg.validation_error = extract_l2_error(edge); agg.nvalidation = 1;
+  }
+  return agg;
+}
+
+
 struct prediction_saver {
   typedef graph_type::vertex_type vertex_type;
   typedef graph_type::edge_type   edge_type;
@@ -575,13 +629,16 @@ int main(int argc, char** argv) {
   std::string predictions;
   size_t interval = 0;
   std::string exec_type = "synchronous";
+  size_t epochs = 10;
   clopts.attach_option("matrix", input_dir,
                        "The directory containing the matrix file");
   clopts.add_positional("matrix");
   clopts.attach_option("D", vertex_data::NLATENT,
                        "Number of latent parameters to use.");
   clopts.attach_option("engine", exec_type, 
-                       "The engine type synchronous or asynchronous");
+                       "The engine type synchronous, asynchronous, ssp or hogwild");
+  clopts.attach_option("epochs", epochs,
+                       "The number of passes over the training edges with --engine=hogwild");
   clopts.attach_option("max_iter", biassgd_vertex_program::MAX_UPDATES,
                        "The maxumum number of udpates allowed for a vertex");
   clopts.attach_option("lambda", biassgd_vertex_program::LAMBDA, 
@@ -650,7 +707,53 @@ dc.cout() << "Finalizing graph." << std::endl;
       << "\n Edge balance ratio: " 
       << float(graph.num_local_edges())/graph.num_edges()
       << std::endl;
- 
+
+  biassgd_vertex_program::GLOBAL_MEAN = graph.map_reduce_edges<double>(calc_global_mean);
+  biassgd_vertex_program::NUM_TRAINING_EDGES = graph.map_reduce_edges<size_t>(count_edges);
+  biassgd_vertex_program::GLOBAL_MEAN /= biassgd_vertex_program::NUM_TRAINING_EDGES;
+  dc.cout() << "Global mean is: " <<biassgd_vertex_program::GLOBAL_MEAN << std::endl;
+
+  if (exec_type == "hogwild") {
+    dc.cout() << "Creating engine" << std::endl;
+    graphlab::hogwild_engine<graph_type> engine(dc, graph, clopts);
+    engine.set_averaging(hogwild_combine, hogwild_average);
+    dc.cout() << "Running Hogwild Bias-SGD" << std::endl;
+    dc.cout() << "Time   Training    Validation" <<std::endl;
+    dc.cout() << "       RMSE        RMSE " <<std::endl;
+    for (size_t i = 0; i < epochs; ++i) {
+      engine.run_epoch(hogwild_biassgd_update);
+      const error_aggregator agg =
+        graph.map_reduce_edges<error_aggregator>(hogwild_error);
+      dc.cout() << std::setw(8) << engine.elapsed_seconds() << "  "
+                << std::setw(8) << std::sqrt(agg.train_error / agg.ntrain);
+      if (agg.nvalidation > 0)
+        dc.cout() << "   " << std::setw(8)
+                  << std::sqrt(agg.validation_error / agg.nvalidation);
+      dc.cout() << std::endl;
+      biassgd_vertex_program::GAMMA *= biassgd_vertex_program::STEP_DEC;
+    }
+    dc.cout() << "----------------------------------------------------------"
+              << std::endl
+              << "Final Runtime (seconds):   " << engine.elapsed_seconds() << std::endl
+              << "Updates executed: " << engine.num_updates() << std::endl
+              << "Update Rate (updates/second): "
+              << engine.num_updates() / engine.elapsed_seconds() << std::endl;
+    if(!predictions.empty()) {
+      graph.save(predictions, prediction_saver(),
+                 false, false, true, 1);
+      graph.save(predictions + ".U", linear_model_saver_U(),
+                 false, true, false, 1);
+      graph.save(predictions + ".V", linear_model_saver_V(),
+                 false, true, false, 1);
+      graph.save(predictions + ".bias.U", linear_model_saver_bias_U(),
+                 false, true, false, 1);
+      graph.save(predictions + ".bias.V", linear_model_saver_bias_V(),
+                 false, true, false, 1);
+    }
+    graphlab::mpi_tools::finalize();
+    return EXIT_SUCCESS;
+  }
+
   dc.cout() << "Creating engine" << std::endl;
   engine_type engine(dc, graph, exec_type, clopts);
 
@@ -659,12 +762,6 @@ dc.cout() << "Finalizing graph." << std::endl;
     ("error", error_aggregator::map, error_aggregator::finalize) &&
     engine.aggregate_periodic("error", interval);
   ASSERT_TRUE(success);
-  
-
-  biassgd_vertex_program::GLOBAL_MEAN = graph.map_reduce_edges<double>(calc_global_mean);
-  biassgd_vertex_program::NUM_TRAINING_EDGES = graph.map_reduce_edges<size_t>(count_edges);
-  biassgd_vertex_program::GLOBAL_MEAN /= biassgd_vertex_program::NUM_TRAINING_EDGES;
-  dc.cout() << "Global mean is: " <<biassgd_vertex_program::GLOBAL_MEAN << std::endl;
 
   // Signal all vertices on the vertices on the left (libersgd) 
   engine.map_reduce_vertices<graphlab::empty>(biassgd_vertex_program::signal_left);
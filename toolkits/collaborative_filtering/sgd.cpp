@@ -398,6 +398,52 @@ double extract_l2_error(const graph_type::edge_type & edge) {
 } // end of extract_l2_error
 
 
+/**
+ * \brief The edge update of --engine=hogwild: a single SGD step on both
+ * endpoints of a training edge, written in place without locks. The
+ * other edges are skipped and not counted as updates.
+ */
+bool hogwild_sgd_update(graph_type::edge_type& edge) {
+	if (edge.data().role != edge_data::TRAIN)
+		return false;
+	vec_type& user = edge.source().data().pvec;
+	vec_type& item = edge.target().data().pvec;
+	double pred = user.dot(item);
+	pred = std::min(pred, sgd_vertex_program::MAXVAL);
+	pred = std::max(pred, sgd_vertex_program::MINVAL);
+	const double err = edge.data().obs - pred;
+	if (std::isnan(err))
+		logstream(LOG_FATAL)<<"Got into numeric errors.. try to tune step size and regularization using --lambda and --gamma flags" << std::endl;
+	const double gamma = sgd_vertex_program::GAMMA;
+	const double lambda = sgd_vertex_program::LAMBDA;
+	for (int k = 0; k < user.size(); ++k) {
+		const double u = user[k], v = item[k];
+		user[k] += gamma*(err*v - lambda*u);
+		item[k] += gamma*(err*u - lambda*v);
+	}
+	return true;
+} // end of hogwild_sgd_update
+
+/** \brief Adds a mirror's factors into the master's */
+void hogwild_combine(vertex_data& master, const vertex_data& mirror) {
+	master.pvec += mirror.pvec;
+}
+
+/** \brief Averages the summed factors of all replicas */
+void hogwild_average(vertex_data& master, size_t nreplicas) {
+	master.pvec /= double(nreplicas);
+}
+
+error_aggregator hogwild_error(const graph_type::edge_type& edge) {
+	error_aggregator agg;
+	if (edge.data().role == edge_data::TRAIN)
+		agg.train_error = extract_l2_error(edge);
+	else if (edge.data().role == edge_data::VALIDATE)
+		agg.validation_error = extract_l2_error(edge);
+	return agg;
+}
+
+
 struct prediction_saver {
 	typedef graph_type::vertex_type vertex_type;
 	typedef graph_type::edge_type   edge_type;
@@ -542,13 +588,16 @@ int main(int argc, char** argv) {
 	std::string predictions;
 	size_t interval = 0;
 	std::string exec_type = "synchronous";
+	size_t epochs = 10;
 	clopts.attach_option("matrix", input_dir,
 			"The directory containing the matrix file");
 	clopts.add_positional("matrix");
 	clopts.attach_option("D", vertex_data::NLATENT,
 			"Number of latent parameters to use.");
 	clopts.attach_option("engine", exec_type, 
-			"The engine type synchronous or asynchronous");
+			"The engine type synchronous, asynchronous, ssp or hogwild");
+	clopts.attach_option("epochs", epochs,
+			"The number of passes over the training edges with --engine=hogwild");
 	clopts.attach_option("max_iter", sgd_vertex_program::MAX_UPDATES,
 			"The maxumum number of udpates allowed for a vertex");
 	clopts.attach_option("lambda", sgd_vertex_program::LAMBDA, 
@@ -621,6 +670,45 @@ int main(int argc, char** argv) {
 		<< float(graph.num_local_edges())/graph.num_edges()
 		<< std::endl;
 
+	if (exec_type == "hogwild") {
+		info = graph.map_reduce_edges<stats_info>(count_edges);
+		dc.cout()<<"Training edges: " << info.training_edges << " validation edges: " << info.validation_edges << std::endl;
+		dc.cout() << "Creating engine" << std::endl;
+		graphlab::hogwild_engine<graph_type> engine(dc, graph, clopts);
+		engine.set_averaging(hogwild_combine, hogwild_average);
+		dc.cout() << "Running Hogwild SGD" << std::endl;
+		dc.cout() << "Time   Training    Validation" <<std::endl;
+		dc.cout() << "       RMSE        RMSE " <<std::endl;
+		for (size_t i = 0; i < epochs; ++i) {
+			engine.run_epoch(hogwild_sgd_update);
+			const error_aggregator agg =
+				graph.map_reduce_edges<error_aggregator>(hogwild_error);
+			dc.cout() << std::setw(8) << engine.elapsed_seconds() << "  " 
+				<< std::setw(8) << std::sqrt(agg.train_error / info.training_edges);
+			if (info.validation_edges > 0)
+				dc.cout() << "   " << std::setw(8)
+					<< std::sqrt(agg.validation_error / info.validation_edges);
+			dc.cout() << std::endl;
+			sgd_vertex_program::GAMMA *= sgd_vertex_program::STEP_DEC;
+		}
+		dc.cout() << "----------------------------------------------------------"
+			<< std::endl
+			<< "Final Runtime (seconds):   " << engine.elapsed_seconds() << std::endl
+			<< "Updates executed: " << engine.num_updates() << std::endl
+			<< "Update Rate (updates/second): " 
+			<< engine.num_updates() / engine.elapsed_seconds() << std::endl;
+		if(!predictions.empty()) {
+			graph.save(predictions, prediction_saver(),
+					false, false, true, 1);
+			graph.save(predictions + ".U", linear_model_saver_U(),
+					false, true, false, 1);
+			graph.save(predictions + ".V", linear_model_saver_V(),
+					false, true, false, 1);
+		}
+		graphlab::mpi_tools::finalize();
+		return EXIT_SUCCESS;
+	}
+
 	dc.cout() << "Creating engine" << std::endl;
 	engine_type engine(dc, graph, exec_type, clopts);
 
@@ -30,6 +30,7 @@
 #include <time.h>
 
 #include <graphlab.hpp>
+#include <graphlab/util/hyperloglog.hpp>
 
 //helper function
 float myrand() {
@@ -47,12 +48,17 @@ size_t hash_value() {
 
 const size_t DUPULICATION_OF_BITMASKS = 10;
 
+//log2 of the number of registers of the HyperLogLog counters
+size_t HLL_PRECISION = 10;
+
 struct vdata {
   //use two bitmasks for consistency
   std::vector<std::vector<bool> > bitmask1;
   std::vector<std::vector<bool> > bitmask2;
   //indicate which is the bitmask for reading (or writing)
   bool odd_iteration;
+  //HyperLogLog counter of the vertices reached (--sketch=hll)
+  graphlab::hyperloglog counter;
   vdata() :
       bitmask1(), bitmask2(), odd_iteration(true) {
   }
@@ -89,7 +95,7 @@ struct vdata {
       for (size_t i = 0; i < size; ++i)
         oarc << (bool)bitmask2[a][i];
     }
-    oarc << odd_iteration;
+    oarc << odd_iteration << counter;
   }
   void load(graphlab::iarchive& iarc) {
     bitmask1.clear();
@@ -114,7 +120,7 @@ struct vdata {
       }
       bitmask2.push_back(mask2);
     }
-    iarc >> odd_iteration;
+    iarc >> odd_iteration >> counter;
   }
 };
 
@@ -129,6 +135,12 @@ void initialize_vertex_with_hash(graph_type::vertex_type& v) {
   v.data().create_hashed_bitmask(v.id());
 }
 
+//initialize HyperLogLog counter with the vertex itself
+void initialize_vertex_with_hll(graph_type::vertex_type& v) {
+  v.data().counter = graphlab::hyperloglog(HLL_PRECISION);
+  v.data().counter.insert(v.id());
+}
+
 //helper function to compute bitwise-or
 void bitwise_or(std::vector<std::vector<bool> >& v1,
     const std::vector<std::vector<bool> >& v2) {
@@ -233,6 +245,39 @@ public:
   }
 };
 
+//The same hop with HyperLogLog counters (HyperANF, Boldi et al. 2011):
+//c(h + 1; i) = c(h; i) MAX {c(h; k) | source = i & target = k},
+//the register-wise maximum giving the counter of the union.
+//A single counter per vertex suffices since the synchronous engine
+//finishes all gathers before any apply.
+class hll_hop: public graphlab::ivertex_program<graph_type,
+                                                graphlab::hyperloglog>,
+    public graphlab::IS_POD_TYPE {
+public:
+  edge_dir_type gather_edges(icontext_type& context,
+      const vertex_type& vertex) const {
+    return graphlab::OUT_EDGES;
+  }
+
+  graphlab::hyperloglog gather(icontext_type& context,
+      const vertex_type& vertex, edge_type& edge) const {
+    return edge.target().data().counter;
+  }
+
+  void apply(icontext_type& context, vertex_type& vertex,
+      const gather_type& total) {
+    vertex.data().counter += total;
+  }
+
+  edge_dir_type scatter_edges(icontext_type& context,
+      const vertex_type& vertex) const {
+    return graphlab::NO_EDGES;
+  }
+  void scatter(icontext_type& context, const vertex_type& vertex,
+      edge_type& edge) const {
+  }
+};
+
 //copy the updated bitmask to the other
 void copy_bitmasks(graph_type::vertex_type& vdata) {
   if (vdata.data().odd_iteration == false) { //odd_iteration has just finished
@@ -271,6 +316,60 @@ size_t absolute_vertex_data_with_hash(
     return count;
 }
 
+//count the number of vertices reached in the current hop with HyperLogLog
+double approximate_pair_number_with_hll(
+    const graph_type::vertex_type& vertex) {
+  return vertex.data().counter.estimate();
+}
+
+//run hops until the number of reached pairs converges, and
+//record the number of pairs after each hop (the neighborhood function)
+template <typename VertexProgram, typename CountFunction>
+size_t neighborhood_function(graphlab::distributed_control& dc,
+    graph_type& graph, graphlab::command_line_options& clopts,
+    CountFunction count_pairs, bool use_copy, float termination_criteria,
+    std::vector<double>& pairs) {
+  graphlab::omni_engine<VertexProgram> engine(dc, graph, "synchronous", clopts);
+  pairs.push_back(graph.map_reduce_vertices<double>(count_pairs));
+
+  //main iteration
+  size_t diameter = 0;
+  for (size_t iter = 0; iter < 100; ++iter) {
+    engine.signal_all();
+    engine.start();
+
+    if (use_copy)
+      graph.transform_vertices(copy_bitmasks);
+
+    const double current_count = graph.map_reduce_vertices<double>(count_pairs);
+    const double previous_count = pairs.back();
+    pairs.push_back(current_count);
+    dc.cout() << iter + 1 << "-th hop: " << (size_t) current_count
+        << " vertex pairs are reached\n";
+    if (iter > 0
+        && (float) current_count
+            < (float) previous_count * (1.0 + termination_criteria)) {
+      diameter = iter;
+      dc.cout() << "converge\n";
+      break;
+    }
+  }
+  return diameter;
+}
+
+//the (interpolated) number of hops within which the given fraction of
+//all reachable pairs are reached
+double effective_diameter(const std::vector<double>& pairs, double fraction) {
+  const double target = fraction * pairs.back();
+  for (size_t h = 1; h < pairs.size(); ++h) {
+    if (pairs[h] >= target) {
+      if (pairs[h - 1] >= target) return h - 1;
+      return h - 1 + (target - pairs[h - 1]) / (pairs[h] - pairs[h - 1]);
+    }
+  }
+  return pairs.size() - 1;
+}
+
 int main(int argc, char** argv) {
   std::cout << "Approximate graph diameter\n\n";
   graphlab::mpi_tools::init(argc, argv);
@@ -285,7 +384,7 @@ int main(int argc, char** argv) {
   std::string graph_dir;
   std::string format = "adj";
   bool use_sketch = true;
-  std::string exec_type = "synchronous";
+  std::string sketch = "hll";
   clopts.attach_option("graph", graph_dir,
                        "The graph file. This is not optional");
   clopts.add_positional("graph");
@@ -296,6 +395,15 @@ int main(int argc, char** argv) {
   clopts.attach_option("use-sketch", use_sketch,
                        "If true, will use Flajolet & Martin bitmask, "
                        "which is more compact and faster.");
+  clopts.attach_option("sketch", sketch,
+                       "The sketch used if use-sketch is true: hll for "
+                       "HyperLogLog counters, fm for Flajolet & Martin "
+                       "bitmasks. HyperLogLog is more accurate for the "
+                       "same memory.");
+  clopts.attach_option("precision", HLL_PRECISION,
+                       "log2 of the number of registers of each HyperLogLog "
+                       "counter, between 4 and 16. The relative error "
+                       "is about 1.04 / sqrt(2^precision).");
 
   if (!clopts.parse(argc, argv)){
     dc.cout() << "Error in parsing command line arguments." << std::endl;
@@ -305,6 +413,16 @@ int main(int argc, char** argv) {
     std::cout << "--graph is not optional\n";
     return EXIT_FAILURE;
   }
+  if (sketch != "hll" && sketch != "fm") {
+    std::cout << "--sketch must be hll or fm\n";
+    return EXIT_FAILURE;
+  }
+  if (HLL_PRECISION < graphlab::hyperloglog::MIN_PRECISION ||
+      HLL_PRECISION > graphlab::hyperloglog::MAX_PRECISION) {
+    std::cout << "--precision must be between 4 and 16\n";
+    return EXIT_FAILURE;
+  }
+  const bool use_hll = use_sketch && sketch == "hll";
 
   //load graph
   graph_type graph(dc, clopts);
@@ -315,43 +433,30 @@ int main(int argc, char** argv) {
   time_t start, end;
   //initialize vertices
   time(&start);
-  if (use_sketch == false)
-    graph.transform_vertices(initialize_vertex);
-  else
-    graph.transform_vertices(initialize_vertex_with_hash);
-
-  graphlab::omni_engine<one_hop> engine(dc, graph, exec_type, clopts);
-
-  //main iteration
-  size_t previous_count = 0;
+  std::vector<double> pairs;
   size_t diameter = 0;
-  for (size_t iter = 0; iter < 100; ++iter) {
-    engine.signal_all();
-    engine.start();
-
-    graph.transform_vertices(copy_bitmasks);
-
-    size_t current_count = 0;
-    if (use_sketch == false)
-      current_count = graph.map_reduce_vertices<size_t>(absolute_vertex_data);
-    else
-      current_count = graph.map_reduce_vertices<size_t>(
-          absolute_vertex_data_with_hash);
-    dc.cout() << iter + 1 << "-th hop: " << current_count
-        << " vertex pairs are reached\n";
-    if (iter > 0
-        && (float) current_count
-            < (float) previous_count * (1.0 + termination_criteria)) {
-      diameter = iter;
-      dc.cout() << "converge\n";
-      break;
-    }
-    previous_count = current_count;
+  if (use_hll) {
+    graph.transform_vertices(initialize_vertex_with_hll);
+    dc.cout() << "HyperLogLog counters with " << (1 << HLL_PRECISION)
+        << " registers, " << graphlab::hyperloglog(HLL_PRECISION).memory_usage()
+        << " bytes per vertex\n";
+    diameter = neighborhood_function<hll_hop>(dc, graph, clopts,
+        approximate_pair_number_with_hll, false, termination_criteria, pairs);
+  } else if (use_sketch) {
+    graph.transform_vertices(initialize_vertex_with_hash);
+    diameter = neighborhood_function<one_hop>(dc, graph, clopts,
+        absolute_vertex_data_with_hash, true, termination_criteria, pairs);
+  } else {
+    graph.transform_vertices(initialize_vertex);
+    diameter = neighborhood_function<one_hop>(dc, graph, clopts,
+        absolute_vertex_data, true, termination_criteria, pairs);
   }
   time(&end);
 
   dc.cout() << "graph calculation time is " << (end - start) << " sec\n";
   dc.cout() << "The approximate diameter is " << diameter << "\n";
+  dc.cout() << "The effective diameter (90% of the pairs) is "
+      << effective_diameter(pairs, 0.9) << "\n";
 
   graphlab::mpi_tools::finalize();
 
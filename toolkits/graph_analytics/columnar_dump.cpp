@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+/*
+ * Prints files written by distributed_graph::save_columnar() as tab
+ * separated text: one "[id] [value]" line per vertex and one
+ * "[source] [target] [value]" line per edge.
+ */
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <graphlab.hpp>
+
+using namespace graphlab;
+
+void print_value(const columnar::block_reader& reader, size_t row) {
+  const columnar::file_header& header = reader.get_header();
+  switch(header.value_code) {
+  case columnar::NO_VALUE: break;
+  case columnar::INT8: std::cout << "\t" << int(reader.value<int8_t>(row)); break;
+  case columnar::UINT8: std::cout << "\t" << int(reader.value<uint8_t>(row)); break;
+  case columnar::INT16: std::cout << "\t" << reader.value<int16_t>(row); break;
+  case columnar::UINT16: std::cout << "\t" << reader.value<uint16_t>(row); break;
+  case columnar::INT32: std::cout << "\t" << reader.value<int32_t>(row); break;
+  case columnar::UINT32: std::cout << "\t" << reader.value<uint32_t>(row); break;
+  case columnar::INT64: std::cout << "\t" << reader.value<int64_t>(row); break;
+  case columnar::UINT64: std::cout << "\t" << reader.value<uint64_t>(row); break;
+  case columnar::FLOAT: std::cout << "\t" << reader.value<float>(row); break;
+  case columnar::DOUBLE: std::cout << "\t" << reader.value<double>(row); break;
+  default: {
+    // opaque values are printed in hex
+    const unsigned char* c =
+        reinterpret_cast<const unsigned char*>(reader.value_ptr(row));
+    char hex[3];
+    std::cout << "\t";
+    for (size_t i = 0; i < header.value_width; ++i) {
+      sprintf(hex, "%02x", c[i]);
+      std::cout << hex;
+    }
+  }
+  }
+} // end of print_value
+
+
+bool dump_file(const std::string& fname, bool header_only) {
+  std::ifstream fin(fname.c_str(), std::ios_base::in | std::ios_base::binary);
+  if (!fin.good()) {
+    logstream(LOG_ERROR) << "Unable to open " << fname << std::endl;
+    return false;
+  }
+  columnar::block_reader reader(fin);
+  if (!reader.good()) {
+    logstream(LOG_ERROR) << "Unable to read the header of " << fname
+                         << std::endl;
+    return false;
+  }
+  const columnar::file_header& header = reader.get_header();
+  if (header_only) {
+    std::cout << fname << ": "
+              << (reader.is_edge_file() ? "edges" : "vertices")
+              << ", " << header.id_width << " byte ids, "
+              << columnar::value_code_name(header.value_code) << " values ("
+              << header.value_width << " bytes)"
+              << ((header.flags & columnar::COMPRESSED) ? ", compressed" : "")
+              << std::endl;
+    return true;
+  }
+  while(reader.next_block()) {
+    for (size_t i = 0; i < reader.num_rows(); ++i) {
+      std::cout << reader.id(i);
+      if (reader.is_edge_file()) std::cout << "\t" << reader.target(i);
+      print_value(reader, i);
+      std::cout << "\n";
+    }
+  }
+  return reader.good();
+} // end of dump_file
+
+
+int main(int argc, char** argv) {
+  global_logger().set_log_level(LOG_WARNING);
+  bool header_only = false;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--header_only") header_only = true;
+    else files.push_back(arg);
+  }
+  if (files.empty()) {
+    std::cerr << "Prints graph files saved in the columnar format as text."
+              << std::endl
+              << "Usage: " << argv[0] << " [--header_only] file..."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  bool success = true;
+  for (size_t i = 0; i < files.size(); ++i) {
+    success = dump_file(files[i], header_only) && success;
+  }
+  std::cout.flush();
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+} // end of main
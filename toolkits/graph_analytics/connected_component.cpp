@@ -30,109 +30,7 @@
 
 #include <graphlab.hpp>
 #include <graphlab/graph/distributed_graph.hpp>
-
-struct vdata {
-  uint64_t labelid;
-  vdata() :
-      labelid(0) {
-  }
-
-  void save(graphlab::oarchive& oarc) const {
-    oarc << labelid;
-  }
-  void load(graphlab::iarchive& iarc) {
-    iarc >> labelid;
-  }
-};
-
-typedef graphlab::distributed_graph<vdata, graphlab::empty> graph_type;
-
-//set label id at vertex id
-void initialize_vertex(graph_type::vertex_type& v) {
-  v.data().labelid = v.id();
-}
-
-//message where summation means minimum
-struct min_message {
-  uint64_t value;
-  explicit min_message(uint64_t v) :
-      value(v) {
-  }
-  min_message() :
-      value(std::numeric_limits<uint64_t>::max()) {
-  }
-  min_message& operator+=(const min_message& other) {
-    value = std::min<uint64_t>(value, other.value);
-    return *this;
-  }
-
-  void save(graphlab::oarchive& oarc) const {
-    oarc << value;
-  }
-  void load(graphlab::iarchive& iarc) {
-    iarc >> value;
-  }
-};
-
-class label_propagation: public graphlab::ivertex_program<graph_type, size_t,
-    min_message>, public graphlab::IS_POD_TYPE {
-private:
-  size_t recieved_labelid;
-  bool perform_scatter;
-public:
-  label_propagation() {
-    recieved_labelid = std::numeric_limits<size_t>::max();
-    perform_scatter = false;
-  }
-
-  //receive messages
-  void init(icontext_type& context, const vertex_type& vertex,
-      const message_type& msg) {
-    recieved_labelid = msg.value;
-  }
-
-  //do not gather
-  edge_dir_type gather_edges(icontext_type& context,
-      const vertex_type& vertex) const {
-    return graphlab::NO_EDGES;
-  }
-  size_t gather(icontext_type& context, const vertex_type& vertex,
-      edge_type& edge) const {
-    return 0;
-  }
-
-  //update label id. If updated, scatter messages
-  void apply(icontext_type& context, vertex_type& vertex,
-      const gather_type& total) {
-    if (recieved_labelid == std::numeric_limits<size_t>::max()) {
-      perform_scatter = true;
-    } else if (vertex.data().labelid > recieved_labelid) {
-      perform_scatter = true;
-      vertex.data().labelid = recieved_labelid;
-    }
-  }
-
-  edge_dir_type scatter_edges(icontext_type& context,
-      const vertex_type& vertex) const {
-    if (perform_scatter)
-      return graphlab::ALL_EDGES;
-    else
-      return graphlab::NO_EDGES;
-  }
-
-  //If a neighbor vertex has a bigger label id, send a massage
-  void scatter(icontext_type& context, const vertex_type& vertex,
-      edge_type& edge) const {
-    if (edge.source().id() != vertex.id()
-        && edge.source().data().labelid > vertex.data().labelid) {
-      context.signal(edge.source(), min_message(vertex.data().labelid));
-    }
-    if (edge.target().id() != vertex.id()
-        && edge.target().data().labelid > vertex.data().labelid) {
-      context.signal(edge.target(), min_message(vertex.data().labelid));
-    }
-  }
-};
+#include "connected_component.hpp"
 
 class graph_writer {
 public:
@@ -158,6 +56,7 @@ int main(int argc, char** argv) {
   std::string saveprefix;
   std::string format = "adj";
   std::string exec_type = "synchronous";
+  std::string algorithm = "union_find";
   clopts.attach_option("graph", graph_dir,
                        "The graph file. This is not optional");
   clopts.add_positional("graph");
@@ -167,6 +66,10 @@ int main(int argc, char** argv) {
                        "If set, will save the pairs of a vertex id and "
                        "a component id to a sequence of files with prefix "
                        "saveprefix");
+  clopts.attach_option("algorithm", algorithm,
+                       "union_find: local union-find on each machine followed "
+                       "by a few global rounds. label_propagation: one "
+                       "iteration for each hop of the diameter.");
   if (!clopts.parse(argc, argv)) {
     dc.cout() << "Error in parsing command line arguments." << std::endl;
     return EXIT_FAILURE;
@@ -175,6 +78,10 @@ int main(int argc, char** argv) {
     std::cout << "--graph is not optional\n";
     return EXIT_FAILURE;
   }
+  if (algorithm != "union_find" && algorithm != "label_propagation") {
+    std::cout << "--algorithm must be union_find or label_propagation\n";
+    return EXIT_FAILURE;
+  }
 
   graph_type graph(dc, clopts);
 
@@ -187,11 +94,21 @@ int main(int argc, char** argv) {
   graph.transform_vertices(initialize_vertex);
 
   //running the engine
-  time_t start, end;
-  graphlab::omni_engine<label_propagation> engine(dc, graph, exec_type, clopts);
-  engine.signal_all();
-  time(&start);
-  engine.start();
+  ti.start();
+  if (algorithm == "union_find") {
+    union_find_components components(dc, graph);
+    components.run();
+    dc.cout() << "Connected components in " << ti.current_time() << " sec, "
+              << components.num_label_edges() << " edges between local "
+              << "components, " << components.num_rounds() << " rounds"
+              << std::endl;
+  } else {
+    graphlab::omni_engine<label_propagation> engine(dc, graph, exec_type, clopts);
+    engine.signal_all();
+    engine.start();
+    dc.cout() << "Connected components in " << ti.current_time() << " sec"
+              << std::endl;
+  }
 
   //write results
   if (saveprefix.size() > 0) {
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef CONNECTED_COMPONENT_HPP
+#define CONNECTED_COMPONENT_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <boost/unordered_map.hpp>
+
+#include <graphlab.hpp>
+#include <graphlab/graph/graph_hash.hpp>
+#include <graphlab/rpc/buffered_exchange.hpp>
+#include <graphlab/util/union_find.hpp>
+#include <graphlab/macros_def.hpp>
+
+/*
+ * The connected components of a graph, labeling every vertex with the
+ * smallest vertex id in its component. Shared by the
+ * connected_component toolkit and connected_component_bench. There are
+ * two algorithms:
+ *
+ *  - label_propagation: every vertex repeatedly sends its label to its
+ *    neighbors, which keep the smallest. Takes as many iterations as
+ *    the diameter of the graph.
+ *
+ *  - union_find_components: every machine merges the vertices of its
+ *    local edges with a union-find, which labels each local component
+ *    with its smallest vertex id. The replicas of a vertex on different
+ *    machines then connect the local components into a much smaller
+ *    graph of labels, whose components are found by hooking roots onto
+ *    smaller roots and pointer jumping, in a few rounds.
+ */
+
+struct vdata {
+  uint64_t labelid;
+  vdata() :
+      labelid(0) {
+  }
+
+  void save(graphlab::oarchive& oarc) const {
+    oarc << labelid;
+  }
+  void load(graphlab::iarchive& iarc) {
+    iarc >> labelid;
+  }
+};
+
+typedef graphlab::distributed_graph<vdata, graphlab::empty> graph_type;
+
+//set label id at vertex id
+void initialize_vertex(graph_type::vertex_type& v) {
+  v.data().labelid = v.id();
+}
+
+//message where summation means minimum
+struct min_message {
+  uint64_t value;
+  explicit min_message(uint64_t v) :
+      value(v) {
+  }
+  min_message() :
+      value(std::numeric_limits<uint64_t>::max()) {
+  }
+  min_message& operator+=(const min_message& other) {
+    value = std::min<uint64_t>(value, other.value);
+    return *this;
+  }
+
+  void save(graphlab::oarchive& oarc) const {
+    oarc << value;
+  }
+  void load(graphlab::iarchive& iarc) {
+    iarc >> value;
+  }
+};
+
+class label_propagation: public graphlab::ivertex_program<graph_type, size_t,
+    min_message>, public graphlab::IS_POD_TYPE {
+private:
+  size_t recieved_labelid;
+  bool perform_scatter;
+public:
+  label_propagation() {
+    recieved_labelid = std::numeric_limits<size_t>::max();
+    perform_scatter = false;
+  }
+
+  //receive messages
+  void init(icontext_type& context, const vertex_type& vertex,
+      const message_type& msg) {
+    recieved_labelid = msg.value;
+  }
+
+  //do not gather
+  edge_dir_type gather_edges(icontext_type& context,
+      const vertex_type& vertex) const {
+    return graphlab::NO_EDGES;
+  }
+  size_t gather(icontext_type& context, const vertex_type& vertex,
+      edge_type& edge) const {
+    return 0;
+  }
+
+  //update label id. If updated, scatter messages
+  void apply(icontext_type& context, vertex_type& vertex,
+      const gather_type& total) {
+    if (recieved_labelid == std::numeric_limits<size_t>::max()) {
+      perform_scatter = true;
+    } else if (vertex.data().labelid > recieved_labelid) {
+      perform_scatter = true;
+      vertex.data().labelid = recieved_labelid;
+    }
+  }
+
+  edge_dir_type scatter_edges(icontext_type& context,
+      const vertex_type& vertex) const {
+    if (perform_scatter)
+      return graphlab::ALL_EDGES;
+    else
+      return graphlab::NO_EDGES;
+  }
+
+  //If a neighbor vertex has a bigger label id, send a massage
+  void scatter(icontext_type& context, const vertex_type& vertex,
+      edge_type& edge) const {
+    if (edge.source().id() != vertex.id()
+        && edge.source().data().labelid > vertex.data().labelid) {
+      context.signal(edge.source(), min_message(vertex.data().labelid));
+    }
+    if (edge.target().id() != vertex.id()
+        && edge.target().data().labelid > vertex.data().labelid) {
+      context.signal(edge.target(), min_message(vertex.data().labelid));
+    }
+  }
+};
+
+
+/*
+ * Connected components by local union-find followed by global hooking
+ * and pointer jumping over the labels of the local components.
+ *
+ * The labels form a forest whose parent pointers are stored on the
+ * machine hash(label) % numprocs; a label without an entry is a root.
+ * Each round finds the roots of both ends of every edge between labels,
+ * drops the edges within a tree, hooks the larger root of every other
+ * edge onto the smaller one, and then replaces every parent by its
+ * parent until all point at their roots. The root of each tree is its
+ * smallest label, so the result is the same as label_propagation.
+ *
+ * All methods must be called on all machines simultaneously.
+ */
+class union_find_components {
+ public:
+  typedef graphlab::vertex_id_type vertex_id_type;
+  typedef graphlab::lvid_type lvid_type;
+  typedef std::pair<vertex_id_type, vertex_id_type> id_pair_type;
+
+ private:
+  graphlab::distributed_control& dc;
+  graph_type& graph;
+  graphlab::buffered_exchange<vertex_id_type> query_exchange;
+  graphlab::buffered_exchange<id_pair_type> pair_exchange;
+  // the label of the local component of each local vertex
+  std::vector<vertex_id_type> labels;
+  // the edges between labels, as (smaller, larger)
+  std::vector<id_pair_type> label_edges;
+  // the parents of the labels stored on this machine
+  boost::unordered_map<vertex_id_type, vertex_id_type> parent;
+  size_t initial_label_edges;
+  size_t nrounds;
+
+ public:
+  union_find_components(graphlab::distributed_control& dc, graph_type& graph) :
+    dc(dc), graph(graph), query_exchange(dc), pair_exchange(dc),
+    initial_label_edges(0), nrounds(0) { }
+
+  /*
+   * Labels every vertex, on all its replicas, with the smallest vertex
+   * id in its connected component.
+   */
+  void run() {
+    local_union_find();
+    connect_replicas();
+    initial_label_edges = label_edges.size();
+    dc.all_reduce(initial_label_edges);
+    nrounds = 0;
+    while(true) {
+      // find the roots of the ends of every edge
+      std::vector<vertex_id_type> keys;
+      keys.reserve(2 * label_edges.size());
+      foreach(const id_pair_type& edge, label_edges) {
+        keys.push_back(edge.first);
+        keys.push_back(edge.second);
+      }
+      boost::unordered_map<vertex_id_type, vertex_id_type> roots = lookup(keys);
+      std::vector<id_pair_type> root_edges;
+      foreach(const id_pair_type& edge, label_edges) {
+        const vertex_id_type a = roots[edge.first], b = roots[edge.second];
+        if (a != b) root_edges.push_back(id_pair_type(std::min(a, b),
+                                                      std::max(a, b)));
+      }
+      std::sort(root_edges.begin(), root_edges.end());
+      root_edges.erase(std::unique(root_edges.begin(), root_edges.end()),
+                       root_edges.end());
+      label_edges.swap(root_edges);
+      size_t nedges = label_edges.size();
+      dc.all_reduce(nedges);
+      if (nedges == 0) break;
+      ++nrounds;
+      // hook the larger root onto the smaller
+      foreach(const id_pair_type& edge, label_edges) {
+        pair_exchange.send(label_owner(edge.second),
+                           id_pair_type(edge.second, edge.first));
+      }
+      pair_exchange.flush();
+      graphlab::procid_t proc;
+      graphlab::buffered_exchange<id_pair_type>::buffer_type buffer;
+      while(pair_exchange.recv(proc, buffer)) {
+        foreach(const id_pair_type& hook, buffer) {
+          vertex_id_type& p = parent.insert(std::make_pair(hook.first,
+                                                           hook.first)).first->second;
+          p = std::min(p, hook.second);
+        }
+        buffer.clear();
+      }
+      pointer_jumping();
+    }
+
+    // every label now points at its root
+    std::vector<vertex_id_type> keys(labels);
+    boost::unordered_map<vertex_id_type, vertex_id_type> roots = lookup(keys);
+    for (lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+      graph.l_vertex(lvid).data().labelid = roots[labels[lvid]];
+    }
+  }
+
+  /// The number of hooking rounds of the last run()
+  size_t num_rounds() const { return nrounds; }
+
+  /// The number of edges between the labels of the local components
+  size_t num_label_edges() const { return initial_label_edges; }
+
+ private:
+  graphlab::procid_t label_owner(vertex_id_type label) const {
+    return graphlab::graph_hash::hash_vertex(label) % dc.numprocs();
+  }
+
+  /*
+   * Merges the ends of all local edges, in parallel, and labels every
+   * local vertex with the smallest vertex id of its local component.
+   */
+  void local_union_find() {
+    const size_t nverts = graph.num_local_vertices();
+    ASSERT_LT(nverts, size_t(std::numeric_limits<uint32_t>::max()));
+    graphlab::concurrent_union_find uf;
+    uf.init(nverts);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+    for (lvid_type lvid = 0; lvid < nverts; ++lvid) {
+      foreach(const graph_type::local_edge_type& edge,
+              graph.l_vertex(lvid).out_edges()) {
+        uf.merge(lvid, edge.target().id());
+      }
+    }
+    std::vector<vertex_id_type> smallest(nverts,
+        std::numeric_limits<vertex_id_type>::max());
+    for (lvid_type lvid = 0; lvid < nverts; ++lvid) {
+      vertex_id_type& s = smallest[uf.find(lvid)];
+      s = std::min(s, graph.global_vid(lvid));
+    }
+    labels.resize(nverts);
+    for (lvid_type lvid = 0; lvid < nverts; ++lvid) {
+      labels[lvid] = smallest[uf.find(lvid)];
+    }
+  }
+
+  /*
+   * The mirrors send their labels to the master of their vertex, which
+   * connects them with its own label.
+   */
+  void connect_replicas() {
+    label_edges.clear();
+    for (lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+      const graph_type::local_vertex_type lvertex = graph.l_vertex(lvid);
+      if (!lvertex.owned()) {
+        pair_exchange.send(lvertex.owner(),
+                           id_pair_type(lvertex.global_id(), labels[lvid]));
+      }
+    }
+    pair_exchange.flush();
+    graphlab::procid_t proc;
+    graphlab::buffered_exchange<id_pair_type>::buffer_type buffer;
+    while(pair_exchange.recv(proc, buffer)) {
+      foreach(const id_pair_type& mirror, buffer) {
+        const vertex_id_type label = labels[graph.vertex(mirror.first).local_id()];
+        if (label != mirror.second) {
+          label_edges.push_back(id_pair_type(std::min(label, mirror.second),
+                                             std::max(label, mirror.second)));
+        }
+      }
+      buffer.clear();
+    }
+    std::sort(label_edges.begin(), label_edges.end());
+    label_edges.erase(std::unique(label_edges.begin(), label_edges.end()),
+                      label_edges.end());
+  }
+
+  /*
+   * Returns the parents of the given labels. Duplicates in keys are
+   * removed.
+   */
+  boost::unordered_map<vertex_id_type, vertex_id_type>
+  lookup(std::vector<vertex_id_type>& keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    foreach(vertex_id_type key, keys) {
+      query_exchange.send(label_owner(key), key);
+    }
+    query_exchange.flush();
+    graphlab::procid_t proc;
+    graphlab::buffered_exchange<vertex_id_type>::buffer_type queries;
+    while(query_exchange.recv(proc, queries)) {
+      foreach(vertex_id_type key, queries) {
+        boost::unordered_map<vertex_id_type, vertex_id_type>::const_iterator it =
+          parent.find(key);
+        pair_exchange.send(proc, id_pair_type(key, it == parent.end() ?
+                                                   key : it->second));
+      }
+      queries.clear();
+    }
+    pair_exchange.flush();
+    boost::unordered_map<vertex_id_type, vertex_id_type> ret;
+    ret.rehash(keys.size());
+    graphlab::buffered_exchange<id_pair_type>::buffer_type answers;
+    while(pair_exchange.recv(proc, answers)) {
+      foreach(const id_pair_type& answer, answers) {
+        ret[answer.first] = answer.second;
+      }
+      answers.clear();
+    }
+    return ret;
+  }
+
+  /*
+   * Replaces the parent of every label by its grandparent until every
+   * label points at its root. Each step halves the depth of the trees.
+   */
+  void pointer_jumping() {
+    while(true) {
+      std::vector<vertex_id_type> keys;
+      keys.reserve(parent.size());
+      typedef boost::unordered_map<vertex_id_type, vertex_id_type>::value_type
+        entry_type;
+      foreach(const entry_type& entry, parent) keys.push_back(entry.second);
+      boost::unordered_map<vertex_id_type, vertex_id_type> grandparent =
+        lookup(keys);
+      size_t changed = 0;
+      foreach(entry_type& entry, parent) {
+        const vertex_id_type g = grandparent[entry.second];
+        if (g != entry.second) {
+          entry.second = g;
+          ++changed;
+        }
+      }
+      dc.all_reduce(changed);
+      if (changed == 0) break;
+    }
+  }
+};
+
+#include <graphlab/macros_undef.hpp>
+
+#endif
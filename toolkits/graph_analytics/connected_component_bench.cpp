@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+/**
+ * Compares the two algorithms of the connected_component toolkit:
+ *
+ *  - label_propagation (connected_component --algorithm=label_propagation)
+ *  - union_find (connected_component --algorithm=union_find)
+ *
+ * on two synthetic graphs:
+ *
+ *  - road: a grid of side x side vertices with a fraction of its edges
+ *    removed, like a road network. Its diameter is about 2 * side, which
+ *    is the number of iterations of label propagation.
+ *  - powerlaw: edges between endpoints chosen with probability
+ *    proportional to (i+1)^(-1/(alpha-1)), with a small diameter.
+ *
+ * Every machine draws the same edges and adds its share of them to the
+ * graph. The labels of both algorithms must agree on every vertex.
+ */
+#include <vector>
+#include <iostream>
+#include <graphlab.hpp>
+#include <graphlab/util/powerlaw_edges.hpp>
+#include "connected_component.hpp"
+#include <graphlab/macros_def.hpp>
+
+typedef std::vector<std::pair<size_t, size_t> > edge_list_type;
+
+edge_list_type make_road_edges(size_t side, double keep) {
+  edge_list_type edges;
+  edges.reserve(2 * side * side);
+  for (size_t i = 0; i < side; ++i) {
+    for (size_t j = 0; j < side; ++j) {
+      const size_t v = i * side + j;
+      if (j + 1 < side && graphlab::random::rand01() < keep) {
+        edges.push_back(std::make_pair(v, v + 1));
+      }
+      if (i + 1 < side && graphlab::random::rand01() < keep) {
+        edges.push_back(std::make_pair(v, v + side));
+      }
+    }
+  }
+  return edges;
+}
+
+void run_benchmark(graphlab::distributed_control& dc,
+                   graphlab::command_line_options& clopts,
+                   const std::string& name, const edge_list_type& edges) {
+  graph_type graph(dc, clopts);
+  for (size_t i = dc.procid(); i < edges.size(); i += dc.numprocs()) {
+    graph.add_edge(edges[i].first, edges[i].second);
+  }
+  graph.finalize();
+  dc.cout() << name << ": " << graph.num_vertices() << " vertices, "
+            << graph.num_edges() << " edges" << std::endl;
+
+  graphlab::timer ti;
+  graph.transform_vertices(initialize_vertex);
+  ti.start();
+  graphlab::omni_engine<label_propagation> engine(dc, graph, "synchronous",
+                                                  clopts);
+  engine.signal_all();
+  engine.start();
+  const double propagation_time = ti.current_time();
+  std::vector<graphlab::vertex_id_type> expected(graph.num_local_vertices());
+  for (graphlab::lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+    expected[lvid] = graph.l_vertex(lvid).data().labelid;
+  }
+  dc.cout() << "  label_propagation:\t" << propagation_time << " s\t"
+            << engine.num_updates() << " updates" << std::endl;
+
+  graph.transform_vertices(initialize_vertex);
+  ti.start();
+  union_find_components components(dc, graph);
+  components.run();
+  const double union_find_time = ti.current_time();
+  size_t mismatches = 0;
+  for (graphlab::lvid_type lvid = 0; lvid < graph.num_local_vertices(); ++lvid) {
+    mismatches += graph.l_vertex(lvid).data().labelid != expected[lvid];
+  }
+  dc.all_reduce(mismatches);
+  dc.cout() << "  union_find:\t\t" << union_find_time << " s\t"
+            << components.num_rounds() << " rounds\t"
+            << (mismatches == 0 ? "labels match" : "LABELS DIFFER")
+            << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+  global_logger().set_log_level(LOG_WARNING);
+  size_t side = 1000;
+  double keep = 0.6;
+  size_t nverts = 1000000;
+  size_t avg_degree = 4;
+  double alpha = 2.1;
+  std::string graphs = "road,powerlaw";
+  graphlab::command_line_options clopts("Connected component benchmark");
+  clopts.attach_option("side", side, "Side of the road grid");
+  clopts.attach_option("keep", keep,
+                       "Fraction of the edges of the road grid kept");
+  clopts.attach_option("nverts", nverts, "Vertices of the power-law graph");
+  clopts.attach_option("degree", avg_degree,
+                       "Average degree of the power-law graph");
+  clopts.attach_option("alpha", alpha, "Exponent of the degree distribution");
+  clopts.attach_option("graphs", graphs,
+                       "Comma separated graphs to run: road,powerlaw");
+  if(!clopts.parse(argc, argv)) return EXIT_FAILURE;
+
+  graphlab::mpi_tools::init(argc, argv);
+  graphlab::distributed_control dc;
+
+  graphlab::random::seed(1);
+  if (graphs.find("road") != std::string::npos) {
+    run_benchmark(dc, clopts, "road", make_road_edges(side, keep));
+  }
+  if (graphs.find("powerlaw") != std::string::npos) {
+    run_benchmark(dc, clopts, "powerlaw",
+                  graphlab::make_powerlaw_edges(nverts, nverts * avg_degree / 2, alpha));
+  }
+
+  graphlab::mpi_tools::finalize();
+  return EXIT_SUCCESS;
+}
+
+#include <graphlab/macros_undef.hpp>
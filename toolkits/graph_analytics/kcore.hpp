@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef KCORE_HPP
+#define KCORE_HPP
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <graphlab.hpp>
+#include <graphlab/macros_def.hpp>
+/**
+ *
+ * In this file we implement the "k-core" decomposition algorithm.
+ * It is shared by the kcore toolkit and the kcore_bench benchmark.
+ * There are two methods:
+ *
+ *  - levels: a parallel variant of
+ *
+ *    V. Batagelj and M. Zaversnik, An O(m) algorithm for cores
+ *    decomposition of networks,
+ *
+ *    which recursively removes everything with degree less than 1,
+ *    then everything with degree less than 2, etc. with one engine run
+ *    for each K.
+ *
+ *  - coreness: computes the core number of every vertex in a single
+ *    engine run, following
+ *
+ *    A. Montresor, F. De Pellegrini and D. Miorandi, Distributed k-Core
+ *    Decomposition, IEEE TPDS 2013.
+ *
+ *    Every vertex starts with its degree as an upper bound of its core
+ *    number, and repeatedly lowers it to the largest k such that at
+ *    least k neighbors have a bound of at least k. The bounds converge
+ *    to the core numbers, and the size of every K-core follows from
+ *    them.
+ */
+
+/*
+ * Each vertex maintains a "degree" count. If this value
+ * is 0, the vertex is "deleted". With the coreness method
+ * this is the upper bound of the core number of the vertex.
+ */
+typedef int vertex_data_type;
+
+/*
+ * Don't need any edges
+ */
+typedef graphlab::empty edge_data_type;
+
+/*
+ * Define the type of the graph
+ */
+typedef graphlab::distributed_graph<vertex_data_type,
+                                    edge_data_type> graph_type;
+
+// The current K to compute
+size_t CURRENT_K;
+
+/*
+ * The core K-core implementation.
+ * The basic concept is simple.
+ * Each vertex maintains a count of the number of adjacent edges.
+ * If a vertex receives a message, the message contains the number of
+ * adjacent edges deleted. The vertex then updates its counter.
+ * If the counter falls below K, it deletes itself
+ * (set the adjacent count to 0) and signals each of its neighbors
+ * with a message of 1.
+ */
+class k_core :
+  public graphlab::ivertex_program<graph_type,
+                                   graphlab::empty, // gathers are integral
+                                   int>,   // messages are integral
+  public graphlab::IS_POD_TYPE  {
+public:
+  // the last received message
+  int msg;
+
+  /* Each vertex can only signal once. I set this flag
+   * if it is the first time this vertex falls below K, so I can
+   * initiate scattering
+   */
+  bool just_deleted;
+
+  k_core():msg(0),just_deleted(false) { }
+
+  /* The message contains the number of adjacent edges deleted.
+   * Store the message in the program, and reset the just_deleted flag
+   */
+  void init(icontext_type& context, const vertex_type& vertex,
+            const message_type& message) {
+    msg = message;
+    just_deleted = false;
+  }
+
+  // gather is never invoked
+  edge_dir_type gather_edges(icontext_type& context,
+                             const vertex_type& vertex) const {
+    return graphlab::NO_EDGES;
+  }
+
+  /* On apply, if the vertex has not yet been deleted,
+   * decrement the counter on the vertex.
+   * If the adjacency count of the vertex falls below K,
+   * the vertex shall be deleted.
+   * We set the vertex data to 0 to designate that it is deleted
+   * and Set the just_deleted flag to signal the neighbors in scatter
+   */
+  void apply(icontext_type& context, vertex_type& vertex,
+             const gather_type& unused) {
+    if (vertex.data() > 0) {
+      vertex.data() -= msg;
+      if (vertex.data() < CURRENT_K) {
+        just_deleted = true;
+        vertex.data() = 0;
+      }
+    }
+  }
+
+  /*
+   * If the vertex is deleted, we signal all neighbors on the scatter
+   */
+  edge_dir_type scatter_edges(icontext_type& context,
+                              const vertex_type& vertex) const {
+    return just_deleted ?
+      graphlab::ALL_EDGES : graphlab::NO_EDGES;
+  }
+
+  /*
+   * For each neighboring vertex, if it is not yet deleted,
+   * signal it.
+   */
+  void scatter(icontext_type& context,
+               const vertex_type& vertex,
+               edge_type& edge) const {
+    vertex_type other = edge.source().id() == vertex.id() ?
+      edge.target() : edge.source();
+    if (other.data() > 0) {
+      context.signal(other, 1);
+    }
+  }
+
+};
+
+// type of the synchronous_engine
+typedef graphlab::synchronous_engine<k_core> engine_type;
+
+
+/*
+ * Counts vertices or edges by core number, or the neighbors of a vertex
+ * by core bound in the gather of the coreness program. A single count
+ * is kept inline so that map_reduce_vertices(), map_reduce_edges() and
+ * the gather on a single edge do not allocate a histogram.
+ */
+struct core_histogram {
+  int single;
+  std::vector<size_t> counts;
+
+  core_histogram(int core = -1) : single(core) { }
+
+  void add(size_t core, size_t n) {
+    if (counts.size() <= core) counts.resize(core + 1, 0);
+    counts[core] += n;
+  }
+
+  core_histogram& operator+=(const core_histogram& other) {
+    if (single < 0) single = other.single;
+    else if (other.single >= 0) add(other.single, 1);
+    if (counts.size() < other.counts.size()) {
+      counts.resize(other.counts.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+      counts[i] += other.counts[i];
+    }
+    return *this;
+  }
+
+  // Entry k is the number of vertices or edges with core number >= k
+  std::vector<size_t> at_least() const {
+    core_histogram h(*this);
+    if (h.single >= 0) h.add(h.single, 1);
+    std::vector<size_t> ret(h.counts.size() + 1, 0);
+    for (size_t k = h.counts.size(); k > 0; --k) {
+      ret[k - 1] = ret[k] + h.counts[k - 1];
+    }
+    return ret;
+  }
+
+  void save(graphlab::oarchive& oarc) const { oarc << single << counts; }
+  void load(graphlab::iarchive& iarc) { iarc >> single >> counts; }
+};
+
+
+/*
+ * Lowers the core bound of a vertex to the largest k such that at least
+ * k of its neighbors have a bound of at least k. The gather counts the
+ * neighbor bounds capped at the current bound, so the histogram has at
+ * most bound + 1 entries whatever the degree of the vertex. If the
+ * bound went down, the neighbors with a larger bound may have to lower
+ * theirs and are signaled. All vertices converge in a single engine
+ * run.
+ */
+class coreness :
+  public graphlab::ivertex_program<graph_type, core_histogram>,
+  public graphlab::IS_POD_TYPE {
+public:
+  // set if the bound went down in the last apply
+  bool lowered;
+
+  coreness() : lowered(false) { }
+
+  edge_dir_type gather_edges(icontext_type& context,
+                             const vertex_type& vertex) const {
+    return graphlab::ALL_EDGES;
+  }
+
+  gather_type gather(icontext_type& context, const vertex_type& vertex,
+                     edge_type& edge) const {
+    const vertex_type other = edge.source().id() == vertex.id() ?
+      edge.target() : edge.source();
+    return core_histogram(std::min(other.data(), vertex.data()));
+  }
+
+  void apply(icontext_type& context, vertex_type& vertex,
+             const gather_type& total) {
+    lowered = false;
+    const int bound = vertex.data();
+    if (bound <= 0) return;
+    // the largest k with at least k neighbors in buckets k .. bound
+    size_t atleast = 0;
+    int k = bound;
+    for (; k > 0; --k) {
+      if (size_t(k) < total.counts.size()) atleast += total.counts[k];
+      if (total.single == k) ++atleast;
+      if (atleast >= size_t(k)) break;
+    }
+    if (k < bound) {
+      vertex.data() = k;
+      lowered = true;
+    }
+  }
+
+  edge_dir_type scatter_edges(icontext_type& context,
+                              const vertex_type& vertex) const {
+    return lowered ? graphlab::ALL_EDGES : graphlab::NO_EDGES;
+  }
+
+  // only the neighbors with a larger bound depend on this bound
+  void scatter(icontext_type& context, const vertex_type& vertex,
+               edge_type& edge) const {
+    const vertex_type other = edge.source().id() == vertex.id() ?
+      edge.target() : edge.source();
+    if (other.data() > vertex.data()) context.signal(other);
+  }
+};
+
+
+core_histogram vertex_core(const graph_type::vertex_type& vertex) {
+  return core_histogram(vertex.data());
+}
+
+// an edge belongs to the K-cores of the smaller core number of its ends
+core_histogram edge_core(const graph_type::edge_type& edge) {
+  return core_histogram(std::min(edge.source().data(), edge.target().data()));
+}
+
+
+/*
+ * Called before any graph operation is performed.
+ * Initializes all vertex data to the number of adjacent edges.
+ * Can be called from a graph.transform_vertices()
+ */
+void initialize_vertex_values(graph_type::vertex_type& v) {
+  v.data() = v.num_in_edges() + v.num_out_edges();
+}
+
+/*
+ * Signals all non-deleted vertices with degree less than K.
+ * Can be called from an engine.map_reduce_vertices()
+ * We return empty since no reduction is performed. Only the map.
+ */
+graphlab::empty signal_vertices_at_k(engine_type::icontext_type& ctx,
+                                     const graph_type::vertex_type& vertex) {
+  if (vertex.data() > 0 && vertex.data() < CURRENT_K) {
+    ctx.signal(vertex, 0);
+  }
+  return graphlab::empty();
+}
+
+/*
+ * Counts the number of un-deleted vertices.
+ */
+size_t count_active_vertices(const graph_type::vertex_type& vertex) {
+  return vertex.data() > 0;
+}
+
+/*
+ * Counts the degree of each un-deleted vertex. Half of this
+ * will be the size of the K-core graph.
+ */
+size_t double_count_active_edges(const graph_type::vertex_type& vertex) {
+  return (size_t) vertex.data();
+}
+
+
+
+/*
+ * Saves the graph in a tsv format with the condition that
+ * the adjacent vertices have a value of at least k: not yet deleted
+ * for the levels method, or a core number of at least k.
+ * This allows saving of the k-core graph.
+ */
+struct save_core_at_k {
+  int k;
+  save_core_at_k(int k = 1) : k(k) { }
+  std::string save_vertex(graph_type::vertex_type) { return ""; }
+  std::string save_edge(graph_type::edge_type e) {
+    if (e.source().data() >= k && e.target().data() >= k) {
+      return graphlab::tostr(e.source().id()) + "\t" +
+        graphlab::tostr(e.target().id()) + "\n";
+    }
+    else return "";
+  }
+};
+
+
+// The size of the K-core graph
+struct core_size {
+  size_t k, numv, nume;
+};
+
+/*
+ * Computes the sizes of the K-core graphs for K in [kmin, kmax], by
+ * recursively deleting all vertices with degree less than K for each K
+ * in turn. Stops at the first empty K-core. Saves each K-core with
+ * prefix [savecores].K. if savecores is non-empty.
+ */
+std::vector<core_size> kcore_by_levels(graphlab::distributed_control& dc,
+                                       graph_type& graph,
+                                       const graphlab::graphlab_options& opts,
+                                       size_t kmin, size_t kmax,
+                                       const std::string& savecores) {
+  std::vector<core_size> sizes;
+  engine_type engine(dc, graph, opts);
+
+  // initialize the vertex data with the degree
+  graph.transform_vertices(initialize_vertex_values);
+
+  // for each K value
+  for (CURRENT_K = kmin; CURRENT_K <= kmax; CURRENT_K++) {
+    // signal all vertices with degree less than K
+    engine.map_reduce_vertices<graphlab::empty>(signal_vertices_at_k);
+    // recursively delete all vertices with degree less than K
+    engine.start();
+    // count the number of vertices and edges remaining
+    core_size size;
+    size.k = CURRENT_K;
+    size.numv = graph.map_reduce_vertices<size_t>(count_active_vertices);
+    size.nume = graph.map_reduce_vertices<size_t>(double_count_active_edges) / 2;
+    if (size.numv == 0) break;
+    sizes.push_back(size);
+
+    // Saves the result if requested
+    if (savecores != "") {
+      graph.save(savecores + "." + graphlab::tostr(CURRENT_K) + ".",
+                 save_core_at_k(),
+                 false, /* no compression */
+                 false, /* do not save vertex */
+                 true, /* save edge */
+                 opts.get_ncpus()); /* one file per machine */
+    }
+  }
+  return sizes;
+}
+
+/*
+ * Computes the same sizes as kcore_by_levels() from the core numbers of
+ * all vertices, which take a single engine run. Leaves the core number
+ * of each vertex in its vertex data.
+ */
+std::vector<core_size> kcore_by_coreness(graphlab::distributed_control& dc,
+                                         graph_type& graph,
+                                         const graphlab::graphlab_options& opts,
+                                         size_t kmin, size_t kmax,
+                                         const std::string& savecores) {
+  std::vector<core_size> sizes;
+  graphlab::synchronous_engine<coreness> engine(dc, graph, opts);
+  graph.transform_vertices(initialize_vertex_values);
+  engine.signal_all();
+  engine.start();
+
+  const std::vector<size_t> numv =
+    graph.map_reduce_vertices<core_histogram>(vertex_core).at_least();
+  const std::vector<size_t> nume =
+    graph.map_reduce_edges<core_histogram>(edge_core).at_least();
+  for (size_t k = kmin; k <= kmax; ++k) {
+    // vertices of degree 0 are never counted, as with the levels method
+    const size_t kk = std::max<size_t>(k, 1);
+    core_size size;
+    size.k = k;
+    size.numv = kk < numv.size() ? numv[kk] : 0;
+    size.nume = kk < nume.size() ? nume[kk] : 0;
+    if (size.numv == 0) break;
+    sizes.push_back(size);
+
+    // Saves the result if requested
+    if (savecores != "") {
+      graph.save(savecores + "." + graphlab::tostr(k) + ".",
+                 save_core_at_k(kk),
+                 false, /* no compression */
+                 false, /* do not save vertex */
+                 true, /* save edge */
+                 opts.get_ncpus()); /* one file per machine */
+    }
+  }
+  return sizes;
+}
+
+#include <graphlab/macros_undef.hpp>
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+/**
+ * Compares the two k-core methods of the kcore toolkit on a synthetic
+ * power-law graph:
+ *
+ *  - levels: one engine run for each K (kcore --method=levels)
+ *  - coreness: the core numbers in one engine run (kcore --method=coreness)
+ *
+ * and, on machine 0, the sequential O(m) bucket algorithm of Batagelj
+ * and Zaversnik as a reference. The sizes of all K-cores must agree.
+ *
+ * Edges are drawn between endpoints chosen with probability
+ * proportional to (i+1)^(-1/(alpha-1)), which gives degrees following a
+ * power law with exponent alpha. Every machine draws the same edges and
+ * adds its share of them to the graph.
+ */
+#include <vector>
+#include <iostream>
+#include <graphlab.hpp>
+#include <graphlab/util/powerlaw_edges.hpp>
+#include "kcore.hpp"
+#include <graphlab/macros_def.hpp>
+
+typedef std::vector<std::pair<size_t, size_t> > edge_list_type;
+
+/*
+ * The core numbers by the bucket algorithm of Batagelj and Zaversnik:
+ * the vertices are kept sorted by their current degree, with bin[d]
+ * the position of the first vertex of degree d, and the vertex of
+ * smallest degree is removed at each step.
+ */
+std::vector<size_t> sequential_coreness(size_t nverts,
+                                        const edge_list_type& edges) {
+  std::vector<size_t> deg(nverts, 0);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    ++deg[edges[i].first];
+    ++deg[edges[i].second];
+  }
+  // adjacency lists in CSR form
+  std::vector<size_t> begin(nverts + 1, 0);
+  for (size_t v = 0; v < nverts; ++v) begin[v + 1] = begin[v] + deg[v];
+  std::vector<size_t> adj(begin[nverts]);
+  std::vector<size_t> fill(begin.begin(), begin.end() - 1);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    adj[fill[edges[i].first]++] = edges[i].second;
+    adj[fill[edges[i].second]++] = edges[i].first;
+  }
+  const size_t maxdeg = nverts ? *std::max_element(deg.begin(), deg.end()) : 0;
+  std::vector<size_t> bin(maxdeg + 1, 0);
+  for (size_t v = 0; v < nverts; ++v) ++bin[deg[v]];
+  size_t start = 0;
+  for (size_t d = 0; d <= maxdeg; ++d) {
+    const size_t num = bin[d];
+    bin[d] = start;
+    start += num;
+  }
+  std::vector<size_t> vert(nverts), pos(nverts);
+  for (size_t v = 0; v < nverts; ++v) {
+    pos[v] = bin[deg[v]]++;
+    vert[pos[v]] = v;
+  }
+  for (size_t d = maxdeg; d > 0; --d) bin[d] = bin[d - 1];
+  bin[0] = 0;
+  for (size_t i = 0; i < nverts; ++i) {
+    const size_t v = vert[i];
+    for (size_t j = begin[v]; j < begin[v + 1]; ++j) {
+      const size_t u = adj[j];
+      if (deg[u] > deg[v]) {
+        // swap u with the first vertex of its bin and shrink the bin
+        const size_t du = deg[u], pu = pos[u];
+        const size_t pw = bin[du], w = vert[pw];
+        if (u != w) {
+          pos[u] = pw; vert[pu] = w;
+          pos[w] = pu; vert[pw] = u;
+        }
+        ++bin[du];
+        --deg[u];
+      }
+    }
+  }
+  return deg;
+}
+
+
+int main(int argc, char** argv) {
+  global_logger().set_log_level(LOG_WARNING);
+  size_t nverts = 1000000;
+  size_t avg_degree = 20;
+  double alpha = 2.1;
+  std::string methods = "levels,coreness";
+  graphlab::command_line_options clopts("K-core benchmark");
+  clopts.attach_option("nverts", nverts, "Number of vertices");
+  clopts.attach_option("degree", avg_degree, "Average degree");
+  clopts.attach_option("alpha", alpha, "Exponent of the degree distribution");
+  clopts.attach_option("methods", methods,
+                       "Comma separated methods to run: levels,coreness");
+  if(!clopts.parse(argc, argv)) return EXIT_FAILURE;
+
+  graphlab::mpi_tools::init(argc, argv);
+  graphlab::distributed_control dc;
+
+  graphlab::random::seed(1);
+  const edge_list_type edges =
+    graphlab::make_powerlaw_edges(nverts, nverts * avg_degree / 2, alpha);
+  graph_type graph(dc, clopts);
+  for (size_t i = dc.procid(); i < edges.size(); i += dc.numprocs()) {
+    graph.add_edge(edges[i].first, edges[i].second);
+  }
+  graph.finalize();
+  dc.cout() << graph.num_vertices() << " vertices, "
+            << graph.num_edges() << " edges" << std::endl;
+
+  // the reference K-core sizes
+  std::vector<core_size> expected;
+  if (dc.procid() == 0) {
+    graphlab::timer ti;
+    ti.start();
+    const std::vector<size_t> core = sequential_coreness(nverts, edges);
+    const double elapsed = ti.current_time();
+    core_histogram numv, nume;
+    for (size_t v = 0; v < nverts; ++v) numv.add(core[v], 1);
+    for (size_t i = 0; i < edges.size(); ++i) {
+      nume.add(std::min(core[edges[i].first], core[edges[i].second]), 1);
+    }
+    const std::vector<size_t> vsize = numv.at_least(), esize = nume.at_least();
+    for (size_t k = 0; std::max<size_t>(k, 1) < vsize.size(); ++k) {
+      const size_t kk = std::max<size_t>(k, 1);
+      if (vsize[kk] == 0) break;
+      core_size size = { k, vsize[kk], esize[kk] };
+      expected.push_back(size);
+    }
+    std::cout << "sequential:\t" << elapsed << " s\t"
+              << "max core " << (expected.empty() ? 0 : expected.back().k)
+              << std::endl;
+  }
+
+  const char* names[] = {"levels", "coreness"};
+  for (size_t m = 0; m < 2; ++m) {
+    if (methods.find(names[m]) == std::string::npos) continue;
+    graphlab::timer ti;
+    ti.start();
+    const std::vector<core_size> sizes = m == 0 ?
+      kcore_by_levels(dc, graph, clopts, 0, (size_t)(-1), "") :
+      kcore_by_coreness(dc, graph, clopts, 0, (size_t)(-1), "");
+    const double elapsed = ti.current_time();
+    if (dc.procid() == 0) {
+      bool match = sizes.size() == expected.size();
+      for (size_t i = 0; match && i < sizes.size(); ++i) {
+        match = sizes[i].numv == expected[i].numv &&
+                sizes[i].nume == expected[i].nume;
+      }
+      std::cout << names[m] << ":\t" << elapsed << " s\t"
+                << (match ? "sizes match" : "SIZES DIFFER") << std::endl;
+    }
+  }
+
+  graphlab::mpi_tools::finalize();
+  return EXIT_SUCCESS;
+}
+
+#include <graphlab/macros_undef.hpp>
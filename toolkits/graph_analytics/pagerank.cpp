@@ -160,6 +160,20 @@ struct pagerank_writer {
 }; // end of pagerank writer
 
 
+/*
+ * The same output for graph.save_columnar(), which stores the ids and
+ * ranks in binary.
+ */
+struct pagerank_columns {
+  typedef double vertex_value_type;
+  typedef graphlab::empty edge_value_type;
+  double vertex_value(graph_type::vertex_type v) { return v.data(); }
+  graphlab::empty edge_value(graph_type::edge_type e) {
+    return graphlab::empty();
+  }
+}; // end of pagerank columns
+
+
 double map_rank(const graph_type::vertex_type& v) { return v.data(); }
 
 
@@ -203,6 +217,10 @@ int main(int argc, char** argv) {
   clopts.attach_option("saveprefix", saveprefix,
                        "If set, will save the resultant pagerank to a "
                        "sequence of files with prefix saveprefix");
+  bool savecolumnar = false;
+  clopts.attach_option("savecolumnar", savecolumnar,
+                       "If set, the files of saveprefix are written in the "
+                       "binary columnar format instead of as text");
 
   if(!clopts.parse(argc, argv)) {
     dc.cout() << "Error in parsing command line arguments." << std::endl;
@@ -258,7 +276,12 @@ int main(int argc, char** argv) {
   std::cout << "Total rank: " << total_rank << std::endl;
 
   // Save the final graph -----------------------------------------------------
-  if (saveprefix != "") {
+  if (saveprefix != "" && savecolumnar) {
+    graph.save_columnar(saveprefix, pagerank_columns(),
+                        true,     // compress blocks
+                        true,     // save vertices
+                        false);   // do not save edges
+  } else if (saveprefix != "") {
     graph.save(saveprefix, pagerank_writer(),
                false,    // do not gzip
                true,     // save vertices
@@ -24,6 +24,7 @@
 #include <boost/unordered_set.hpp>
 #include <graphlab.hpp>
 #include <graphlab/ui/metrics_server.hpp>
+#include <graphlab/util/set_intersection.hpp>
 #include <graphlab/macros_def.hpp>
 /**
  *  
@@ -34,7 +35,7 @@
  *    Phd in computer science, University Karlsruhe, 2007.
  *
  * The procedure is quite straightforward:
- *   - each vertex maintains a list of all of its neighbors in a hash table.
+ *   - each vertex maintains a sorted list of all of its neighbors.
  *   - For each edge (u,v) in the graph, count the number of intersections
  *     of the neighbor set on u and the neighbor set on v.
  *   - We store the size of the intersection on the edge.
@@ -68,8 +69,8 @@
  *
  *
  * \note The implementation here is built to be easy to understand
- * and not necessarily optimal. In particular the unordered_set is slow
- * for small number of entries. There is a much more efficient
+ * and not necessarily optimal. In particular the unordered_set used to
+ * gather the neighborhood is slow for small number of entries. There is a much more efficient
  * (and substantially more complicated) version in undirected_triangle_count.cpp
  */
 
@@ -79,8 +80,8 @@
  */
 struct vertex_data_type {
   vertex_data_type():num_triangles(0) { }
-  // A list of all its neighbors
-  boost::unordered_set<graphlab::vertex_id_type> vid_set;
+  // A sorted list of all its neighbors
+  std::vector<graphlab::vertex_id_type> vid_set;
   // The number of triangles this vertex is involved it.
   // only used if "per vertex counting" is used
   size_t num_triangles;
@@ -189,7 +190,9 @@ public:
    */
   void apply(icontext_type& context, vertex_type& vertex,
              const gather_type& neighborhood) {
-    vertex.data().vid_set = neighborhood.vid_set;
+    vertex.data().vid_set.assign(neighborhood.vid_set.begin(),
+                                 neighborhood.vid_set.end());
+    std::sort(vertex.data().vid_set.begin(), vertex.data().vid_set.end());
   } // end of apply
 
   /*
@@ -203,19 +206,6 @@ public:
   }
 
 
-  /*
-   * Computes the size of the intersection of two unordered sets
-   */
-  static size_t count_set_intersect(
-               const boost::unordered_set<vertex_id_type>& smaller_set,
-               const boost::unordered_set<vertex_id_type>& larger_set) {
-    size_t count = 0;
-    foreach(vertex_id_type vid, smaller_set) {
-      count += larger_set.count(vid);
-    }
-    return count;
-  }
-
   /*
    * For each edge, count the intersection of the neighborhood of the
    * adjacent vertices. This is the number of triangles this edge is involved
@@ -226,12 +216,8 @@ public:
               edge_type& edge) const {
     const vertex_data_type& srclist = edge.source().data();
     const vertex_data_type& targetlist = edge.target().data();
-    if (srclist.vid_set.size() >= targetlist.vid_set.size()) {
-      edge.data() = count_set_intersect(targetlist.vid_set, srclist.vid_set);
-    }
-    else {
-      edge.data() = count_set_intersect(srclist.vid_set, targetlist.vid_set);
-    }
+    edge.data() = graphlab::intersection_size(srclist.vid_set,
+                                              targetlist.vid_set);
   }
 };
 
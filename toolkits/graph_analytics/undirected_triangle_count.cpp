@@ -24,21 +24,25 @@
 #include <boost/unordered_set.hpp>
 #include <graphlab.hpp>
 #include <graphlab/ui/metrics_server.hpp>
-#include <graphlab/util/hopscotch_set.hpp>
+#include <graphlab/util/set_intersection.hpp>
 #include <graphlab/macros_def.hpp>
 /**
  *  
- * In this program we implement the "hash-set" version of the
+ * In this program we implement the "sorted list" version of the
  * "edge-iterator" algorithm described in
  * 
  *    T. Schank. Algorithmic Aspects of Triangle-Based Network Analysis.
  *    Phd in computer science, University Karlsruhe, 2007.
  *
  * The procedure is quite straightforward:
- *   - each vertex maintains a list of all of its neighbors in a hash set.
+ *   - each vertex maintains a sorted list of all of its neighbors.
  *   - For each edge (u,v) in the graph, count the number of intersections
  *     of the neighbor set on u and the neighbor set on v.
  *   - We store the size of the intersection on the edge.
+ *
+ * The intersections are computed by graphlab::intersection_size(), which
+ * uses vectorized block comparisons for lists of similar size and
+ * galloping search when one list is much longer than the other.
  * 
  * This will count every triangle exactly 3 times. Summing across all the
  * edges and dividing by 3 gives the desired result.
@@ -66,6 +70,15 @@
  * \endverbatim
  * Must be counted only once. (Only when processing edge AB, can one
  * observe that A and B have intersecting out-neighbor sets).
+ *
+ * When the program runs as a single process and only the total count
+ * is needed, the neighbor lists are not gathered at all. Instead the graph
+ * builds a degree ordered index of the local adjacency
+ * (distributed_graph::build_local_neighborhoods()) and the scatter
+ * intersects the lists of both endpoints of each edge in place
+ * (local_triangle_count below). On several machines a triangle whose
+ * edges are stored on different machines would be missed, so there the
+ * gathered lists are used.
  */
  
 
@@ -143,190 +156,31 @@ void radix_sort(graphlab::vertex_id_type *array, int offset, int end, int shift)
     }
 }
 
-size_t HASH_THRESHOLD = 64;
-
-// We on each vertex, either a vector of sorted VIDs
-// or a hash set (cuckoo hash) of VIDs.
-// If the number of elements is greater than HASH_THRESHOLD,
-// the hash set is used. Otherwise the vector is used.
-struct vid_vector{
-  std::vector<graphlab::vertex_id_type> vid_vec;
-  graphlab::hopscotch_set<graphlab::vertex_id_type> *cset;
-  vid_vector(): cset(NULL) { }
-  vid_vector(const vid_vector& v):cset(NULL) {
-    (*this) = v;
-  }
-
-  vid_vector& operator=(const vid_vector& v) {
-    if (this == &v) return *this;
-    vid_vec = v.vid_vec;
-    if (v.cset != NULL) {
-      // allocate the cuckoo set if the other side is using a cuckoo set
-      // or clear if I alrady have one
-      if (cset == NULL) {
-        cset = new graphlab::hopscotch_set<graphlab::vertex_id_type>(HASH_THRESHOLD);
-      }
-      else {
-        cset->clear();
-      }
-      (*cset) = *(v.cset);
-    }
-    else {
-      // if the other side is not using a cuckoo set, lets not use a cuckoo set
-      // either
-      if (cset != NULL) {
-        delete cset;
-        cset = NULL;
-      }
-    }
-    return *this;
-  }
-
-  ~vid_vector() {
-    if (cset != NULL) delete cset;
-  }
-
-  // assigns a vector of vertex IDs to this storage.
-  // this function will clear the contents of the vid_vector
-  // and reconstruct it.
-  // If the assigned values has length >= HASH_THRESHOLD,
-  // we will allocate a cuckoo set to store it. Otherwise,
-  // we just store a sorted vector
-  void assign(const std::vector<graphlab::vertex_id_type>& vec) {
-    clear();
-    if (vec.size() >= HASH_THRESHOLD) {
-        // move to cset
-        cset = new graphlab::hopscotch_set<graphlab::vertex_id_type>(HASH_THRESHOLD);
-        foreach (graphlab::vertex_id_type v, vec) {
-          cset->insert(v);
-        }
-    }
-    else {
-      vid_vec = vec;
-      if (vid_vec.size() > 64) {
-        radix_sort(&(vid_vec[0]), 0, vid_vec.size(), 24);
-      }
-      else {
-        std::sort(vid_vec.begin(), vid_vec.end());
-      }
-      std::vector<graphlab::vertex_id_type>::iterator new_end = std::unique(vid_vec.begin(),
-                                               vid_vec.end());
-      vid_vec.erase(new_end, vid_vec.end());
-    }
-  }
-
-  void save(graphlab::oarchive& oarc) const {
-    oarc << (cset != NULL);
-    if (cset == NULL) oarc << vid_vec;
-    else oarc << (*cset);
-  }
-
-
-  void clear() {
-    vid_vec.clear();
-    if (cset != NULL) {
-      delete cset;
-      cset = NULL;
-    }
-  }
-
-  size_t size() const {
-    return cset == NULL ? vid_vec.size() : cset->size();
-  }
-
-  void load(graphlab::iarchive& iarc) {
-    clear();
-    bool hascset;
-    iarc >> hascset;
-    if (!hascset) iarc >> vid_vec;
-    else {
-      cset = new graphlab::hopscotch_set<graphlab::vertex_id_type>(HASH_THRESHOLD);
-      iarc >> (*cset);
-    }
-  }
-};
-
 /*
-  A simple counting iterator which can be used as an insert iterator.
-  but only counts the number of elements inserted. Useful for
-  use with counting the size of an intersection using std::set_intersection
-*/
-template <typename T>
-struct counting_inserter {
-  size_t* i;
-  counting_inserter(size_t* i):i(i) { }
-  counting_inserter& operator++() {
-    ++(*i);
-    return *this;
-  }
-  void operator++(int) {
-    ++(*i);
-  }
-
-  struct empty_val {
-    empty_val operator=(const T&) { return empty_val(); }
-  };
-
-  empty_val operator*() {
-    return empty_val();
-  }
-
-  typedef empty_val reference;
-};
-
-
-/*
- * Computes the size of the intersection of two vid_vector's
+ * Sorts a vector of vertex IDs and removes duplicates.
  */
-static uint32_t count_set_intersect(
-             const vid_vector& smaller_set,
-             const vid_vector& larger_set) {
-
-  if (smaller_set.cset == NULL && larger_set.cset == NULL) {
-    size_t i = 0;
-    counting_inserter<graphlab::vertex_id_type> iter(&i);
-    std::set_intersection(smaller_set.vid_vec.begin(), smaller_set.vid_vec.end(),
-                          larger_set.vid_vec.begin(), larger_set.vid_vec.end(),
-                          iter);
-    return i;
-  }
-  else if (smaller_set.cset == NULL && larger_set.cset != NULL) {
-    size_t i = 0;
-    foreach(graphlab::vertex_id_type vid, smaller_set.vid_vec) {
-      i += larger_set.cset->count(vid);
-    }
-    return i;
-  }
-  else if (smaller_set.cset != NULL && larger_set.cset == NULL) {
-    size_t i = 0;
-    foreach(graphlab::vertex_id_type vid, larger_set.vid_vec) {
-      i += smaller_set.cset->count(vid);
-    }
-    return i;
+void sort_unique(std::vector<graphlab::vertex_id_type>& vid_vec) {
+  if (vid_vec.size() > 64) {
+    radix_sort(&(vid_vec[0]), 0, vid_vec.size(), 24);
   }
   else {
-    size_t i = 0;
-    foreach(graphlab::vertex_id_type vid, *(smaller_set.cset)) {
-      i += larger_set.cset->count(vid);
-    }
-    return i;
-
+    std::sort(vid_vec.begin(), vid_vec.end());
   }
+  std::vector<graphlab::vertex_id_type>::iterator new_end =
+      std::unique(vid_vec.begin(), vid_vec.end());
+  vid_vec.erase(new_end, vid_vec.end());
 }
 
 
 
-
-
-
 /*
  * Each vertex maintains a list of all its neighbors.
  * and a final count for the number of triangles it is involved in
  */
 struct vertex_data_type {
   vertex_data_type(): num_triangles(0){ }
-  // A list of all its neighbors
-  vid_vector vid_set;
+  // A sorted list of all its neighbors
+  std::vector<graphlab::vertex_id_type> vid_set;
   // The number of triangles this vertex is involved it.
   // only used if "per vertex counting" is used
   uint32_t num_triangles;
@@ -478,11 +332,12 @@ public:
      // neighborhood set may be empty or has only 1 element
      vertex.data().vid_set.clear();
      if (neighborhood.v != (graphlab::vertex_id_type(-1))) {
-       vertex.data().vid_set.vid_vec.push_back(neighborhood.v);
+       vertex.data().vid_set.push_back(neighborhood.v);
      }
    }
    else {
-     vertex.data().vid_set.assign(neighborhood.vid_vec);
+     vertex.data().vid_set = neighborhood.vid_vec;
+     sort_unique(vertex.data().vid_set);
    }
    do_not_scatter = vertex.data().vid_set.size() == 0;
   } // end of apply
@@ -511,12 +366,8 @@ public:
     //    vertex_type othervtx = edge.target();
     const vertex_data_type& srclist = edge.source().data();
     const vertex_data_type& targetlist = edge.target().data();
-    if (targetlist.vid_set.size() < srclist.vid_set.size()) {
-      edge.data() += count_set_intersect(targetlist.vid_set, srclist.vid_set);
-    }
-    else {
-      edge.data() += count_set_intersect(srclist.vid_set, targetlist.vid_set);
-    }
+    edge.data() += graphlab::intersection_size(srclist.vid_set,
+                                               targetlist.vid_set);
   }
 };
 
@@ -564,6 +415,44 @@ public:
 
 typedef graphlab::synchronous_engine<triangle_count> engine_type;
 
+
+/*
+ * Counts the triangles using the local neighborhoods of the graph
+ * instead of gathered neighbor lists. Each triangle is found on exactly
+ * one of its edges, the one between its two lowest ranked vertices.
+ */
+class local_triangle_count :
+      public graphlab::ivertex_program<graph_type, graphlab::empty>,
+      /* I have no data. Just force it to POD */
+      public graphlab::IS_POD_TYPE  {
+public:
+  edge_dir_type gather_edges(icontext_type& context,
+                             const vertex_type& vertex) const {
+    return graphlab::NO_EDGES;
+  }
+
+  void apply(icontext_type& context, vertex_type& vertex,
+             const gather_type& unused) { }
+
+  // each edge is stored once, as the out edge of one of its endpoints
+  edge_dir_type scatter_edges(icontext_type& context,
+                              const vertex_type& vertex) const {
+    return graphlab::OUT_EDGES;
+  }
+
+  void scatter(icontext_type& context,
+               const vertex_type& vertex,
+               edge_type& edge) const {
+    const graph_type::local_neighbor_list srclist =
+        edge.source().local_neighbors();
+    const graph_type::local_neighbor_list targetlist =
+        edge.target().local_neighbors();
+    edge.data() = graphlab::intersection_size(srclist.begin(), srclist.size(),
+                                              targetlist.begin(),
+                                              targetlist.size());
+  }
+};
+
 /* Used to sum over all the edges in the graph in a
  * map_reduce_edges call
  * to get the total number of triangles
@@ -605,18 +494,26 @@ int main(int argc, char** argv) {
     "will over count.");
   std::string prefix, format;
   std::string per_vertex;
+  bool use_local = true;
+  size_t hash_threshold = 0;
   clopts.attach_option("graph", prefix,
                        "Graph input. reads all graphs matching prefix*");
   clopts.attach_option("format", format,
                        "The graph format");
- clopts.attach_option("ht", HASH_THRESHOLD,
-                       "Above this size, hash sets are used");
+  clopts.attach_option("ht", hash_threshold,
+                       "Deprecated and ignored: the neighbor sets are "
+                       "always sorted vectors");
   clopts.attach_option("per_vertex", per_vertex,
                        "If not empty, will count the number of "
                        "triangles each vertex belongs to and "
                        "save to file with prefix \"[per_vertex]\". "
                        "The algorithm used is slightly different "
                        "and thus will be a little slower");
+  clopts.attach_option("local", use_local,
+                       "On a single process, count the total number of "
+                       "triangles using the local adjacency of the graph "
+                       "instead of gathering the neighbor lists. Ignored "
+                       "with several processes");
   if(!clopts.parse(argc, argv)) return EXIT_FAILURE;
   if (prefix == "") {
     std::cout << "--graph is not optional\n";
@@ -630,6 +527,11 @@ int main(int argc, char** argv) {
   }
 
 
+  if (hash_threshold != 0) {
+    logstream(LOG_WARNING) << "--ht is deprecated and ignored: the neighbor "
+                           << "sets are always sorted vectors" << std::endl;
+  }
+
   if (per_vertex != "") PER_VERTEX_COUNT = true;
   // Initialize control plane using mpi
   graphlab::mpi_tools::init(argc, argv);
@@ -647,9 +549,22 @@ int main(int argc, char** argv) {
   
   // create engine to count the number of triangles
   dc.cout() << "Counting Triangles..." << std::endl;
-  engine_type engine(dc, graph, clopts);
-  engine.signal_all();
-  engine.start();
+  if (use_local && !PER_VERTEX_COUNT && dc.numprocs() > 1) {
+    dc.cout() << "--local only applies to a single process. "
+              << "Gathering the neighbor lists." << std::endl;
+  }
+  if (use_local && !PER_VERTEX_COUNT && dc.numprocs() == 1) {
+    graph.build_local_neighborhoods(true);
+    graphlab::synchronous_engine<local_triangle_count> engine(dc, graph, clopts);
+    engine.signal_all();
+    engine.start();
+    graph.clear_local_neighborhoods();
+  }
+  else {
+    engine_type engine(dc, graph, clopts);
+    engine.signal_all();
+    engine.start();
+  }
 
   dc.cout() << "Counted in " << ti.current_time() << " seconds" << std::endl;
 
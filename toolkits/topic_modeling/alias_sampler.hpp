@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+#ifndef ALIAS_SAMPLER_HPP
+#define ALIAS_SAMPLER_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <graphlab/util/random.hpp>
+#include <graphlab/parallel/pthread_tools.hpp>
+#include <graphlab/logger/assertions.hpp>
+
+
+/**
+ * \brief Samples from a fixed discrete distribution in O(1) time
+ * (Vose's alias method). Building the table takes O(n) time, and the
+ * table takes 12 bytes per outcome.
+ */
+class alias_table {
+  std::vector<float> prob;
+  std::vector<uint32_t> alias;
+  std::vector<float> weights;
+  double total;
+public:
+  alias_table() : total(0) { }
+
+  /// Builds the table for the distribution proportional to w
+  void build(const std::vector<double>& w) {
+    const size_t n = w.size();
+    ASSERT_GT(n, 0);
+    weights.assign(w.begin(), w.end());
+    total = 0;
+    for (size_t i = 0; i < n; ++i) total += w[i];
+    ASSERT_GT(total, 0);
+    prob.resize(n);
+    alias.resize(n);
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+      scaled[i] = w[i] * n / total;
+      if (scaled[i] < 1.0) small.push_back(i);
+      else large.push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+      const uint32_t s = small.back(); small.pop_back();
+      const uint32_t l = large.back();
+      prob[s] = scaled[s];
+      alias[s] = l;
+      scaled[l] -= 1.0 - scaled[s];
+      if (scaled[l] < 1.0) { large.pop_back(); small.push_back(l); }
+    }
+    // whatever remains is 1 up to rounding
+    for (size_t i = 0; i < small.size(); ++i) {
+      prob[small[i]] = 1.0; alias[small[i]] = small[i];
+    }
+    for (size_t i = 0; i < large.size(); ++i) {
+      prob[large[i]] = 1.0; alias[large[i]] = large[i];
+    }
+  }
+
+  bool empty() const { return prob.empty(); }
+
+  size_t size() const { return prob.size(); }
+
+  /// Draws an index
+  size_t sample() const {
+    const size_t i = graphlab::random::fast_uniform<size_t>(0, prob.size() - 1);
+    return graphlab::random::rand01() < prob[i] ? i : alias[i];
+  }
+
+  /// The unnormalized weight the table was built with
+  double weight(size_t i) const { return weights[i]; }
+
+  /// The sum of all weights
+  double total_weight() const { return total; }
+}; // end of alias_table
+
+
+/**
+ * \brief A sparse copy of the topic counts of a document. Draws a topic
+ * in proportion to its count in O(log nnz) time, and looks up the count
+ * of a topic in O(log nnz) time.
+ */
+class sparse_topic_counts {
+  std::vector<uint32_t> topics;
+  /// cumulative[i] is the sum of the counts of topics[0..i]
+  std::vector<long> cumulative;
+public:
+  template <typename Counts>
+  void build(const Counts& counts, size_t ntopics) {
+    topics.clear();
+    cumulative.clear();
+    long sum = 0;
+    for (size_t t = 0; t < ntopics; ++t) {
+      const long c = long(counts[t]);
+      if (c > 0) {
+        sum += c;
+        topics.push_back(t);
+        cumulative.push_back(sum);
+      }
+    }
+  }
+
+  /// Total number of tokens
+  long total() const { return cumulative.empty() ? 0 : cumulative.back(); }
+
+  /// Draws a topic in proportion to its count. total() must be positive.
+  size_t sample() const {
+    const long r = graphlab::random::fast_uniform<long>(0, total() - 1);
+    const size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), r)
+                     - cumulative.begin();
+    return topics[i];
+  }
+
+  /// The count of topic t
+  long count(size_t t) const {
+    const std::vector<uint32_t>::const_iterator it =
+        std::lower_bound(topics.begin(), topics.end(), t);
+    if (it == topics.end() || *it != t) return 0;
+    const size_t i = it - topics.begin();
+    return cumulative[i] - (i > 0 ? cumulative[i - 1] : 0);
+  }
+}; // end of sparse_topic_counts
+
+
+/**
+ * \brief The Metropolis-Hastings LDA sampler with alias tables
+ * (as in LightLDA, Yuan et al. 2015).
+ *
+ * The collapsed Gibbs conditional of a token of word w in document d
+ * is
+ * \verbatim
+ *   p(t) ~ (n_dt + alpha) * (n_wt + beta) / (n_t + W * beta)
+ * \endverbatim
+ * which costs O(K) to sample directly. Instead, each token takes a few
+ * Metropolis-Hastings steps, alternating between two proposals which
+ * can be sampled in O(1) and O(log K) time:
+ * \li the word proposal, (n_wt + beta) / (n_t + W * beta), sampled from
+ *     an alias table per word
+ * \li the doc proposal, n_dt + alpha, sampled from the sparse topic
+ *     counts of the document, or uniformly with probability
+ *     K * alpha / (n_d + K * alpha)
+ *
+ * Both are built from copies of the counts which are only refreshed
+ * after ntopics draws, so that the O(K) cost of building them is
+ * amortized to O(1) per draw. The acceptance test evaluates the target
+ * with the current counts, so the stale proposals only lower the
+ * acceptance rate; the chain still has the Gibbs conditional as its
+ * stationary distribution.
+ *
+ * The proposals are kept for each vertex (word or document) by an
+ * index chosen by the caller, and are protected by a spinlock per
+ * vertex, so the sampler can be used by all threads at once. Only word
+ * vertices have an alias table (12 bytes per topic) and only document
+ * vertices have sparse topic counts (12 bytes per topic in use).
+ */
+class alias_lda_sampler {
+public:
+  alias_lda_sampler() : ntopics(0), alpha(0), beta(0), nwords(0),
+                        mh_steps(2) { }
+
+  /**
+   * Sets the model parameters and allocates the proposals of
+   * is_word.size() vertices, where vertex i is a word if is_word[i] and
+   * a document otherwise. Any existing proposals are dropped.
+   */
+  void init(const std::vector<bool>& is_word, size_t ntopics, double alpha,
+            double beta, size_t nwords, size_t mh_steps) {
+    this->ntopics = ntopics;
+    this->alpha = alpha;
+    this->beta = beta;
+    this->nwords = nwords;
+    this->mh_steps = mh_steps;
+    entries.clear();
+    entries.resize(is_word.size());
+    size_t nword_vertices = 0;
+    for (size_t i = 0; i < is_word.size(); ++i) {
+      entries[i].is_word = is_word[i];
+      entries[i].slot = is_word[i] ? nword_vertices++
+                                   : i - nword_vertices;
+    }
+    word_tables.clear();
+    word_tables.resize(nword_vertices);
+    doc_proposals.clear();
+    doc_proposals.resize(is_word.size() - nword_vertices);
+  }
+
+  /**
+   * Draws a new topic for a token. The counts must exclude the token
+   * itself. old_topic is the current topic of the token, or a value
+   * >= ntopics if it has none.
+   *
+   * \param doc Index of the proposals of the document
+   * \param doc_counts n_dt for all t
+   * \param word Index of the proposals of the word
+   * \param word_counts n_wt for all t
+   * \param global_counts n_t for all t
+   */
+  template <typename DocCounts, typename WordCounts, typename GlobalCounts>
+  size_t sample(size_t doc, const DocCounts& doc_counts,
+                size_t word, const WordCounts& word_counts,
+                const GlobalCounts& global_counts, size_t old_topic) {
+    entry& dentry = entries[doc];
+    entry& wentry = entries[word];
+    DASSERT_FALSE(dentry.is_word);
+    DASSERT_TRUE(wentry.is_word);
+    const alias_table& words = word_tables[wentry.slot];
+    const sparse_topic_counts& docs = doc_proposals[dentry.slot];
+    size_t s = old_topic;
+    if (s >= ntopics) {
+      // no current topic: start the chain from the word proposal
+      wentry.lock.lock();
+      refresh_word(wentry, word_counts, global_counts);
+      s = words.sample();
+      wentry.lock.unlock();
+    }
+    double ps = target(doc_counts, word_counts, global_counts, s);
+    for (size_t step = 0; step < mh_steps; ++step) {
+      size_t t;
+      double qs, qt;
+      if (step % 2 == 0) {
+        // doc proposal
+        dentry.lock.lock();
+        refresh_doc(dentry, doc_counts);
+        const double nd = docs.total();
+        if (nd == 0 ||
+            graphlab::random::rand01() * (nd + ntopics * alpha) <
+            ntopics * alpha) {
+          t = graphlab::random::fast_uniform<size_t>(0, ntopics - 1);
+        } else {
+          t = docs.sample();
+        }
+        qs = docs.count(s) + alpha;
+        qt = docs.count(t) + alpha;
+        dentry.lock.unlock();
+      } else {
+        // word proposal
+        wentry.lock.lock();
+        refresh_word(wentry, word_counts, global_counts);
+        t = words.sample();
+        qs = words.weight(s);
+        qt = words.weight(t);
+        wentry.lock.unlock();
+      }
+      if (t == s) continue;
+      const double pt = target(doc_counts, word_counts, global_counts, t);
+      // accept with probability min(1, p(t) q(s) / (p(s) q(t)))
+      if (pt * qs >= ps * qt ||
+          graphlab::random::rand01() * ps * qt < pt * qs) {
+        s = t;
+        ps = pt;
+      }
+    }
+    return s;
+  }
+
+private:
+  struct entry {
+    graphlab::simple_spinlock lock;
+    bool is_word;
+    /// Index of the proposal in word_tables or doc_proposals
+    uint32_t slot;
+    /// Draws since the proposal was built
+    uint32_t draws;
+    entry() : is_word(false), slot(0), draws(0) { }
+  };
+
+  size_t ntopics;
+  double alpha, beta;
+  size_t nwords;
+  size_t mh_steps;
+  std::vector<entry> entries;
+  std::vector<alias_table> word_tables;
+  std::vector<sparse_topic_counts> doc_proposals;
+
+  template <typename Counts>
+  static double count(const Counts& counts, size_t t) {
+    return std::max(long(counts[t]), long(0));
+  }
+
+  template <typename DocCounts, typename WordCounts, typename GlobalCounts>
+  double target(const DocCounts& doc_counts, const WordCounts& word_counts,
+                const GlobalCounts& global_counts, size_t t) const {
+    return (count(doc_counts, t) + alpha) * (count(word_counts, t) + beta) /
+           (count(global_counts, t) + beta * nwords);
+  }
+
+  /// Rebuilds the word proposal if it is missing or stale. Called locked.
+  template <typename WordCounts, typename GlobalCounts>
+  void refresh_word(entry& e, const WordCounts& word_counts,
+                    const GlobalCounts& global_counts) {
+    alias_table& words = word_tables[e.slot];
+    if (words.empty() || ++e.draws >= ntopics) {
+      std::vector<double> w(ntopics);
+      for (size_t t = 0; t < ntopics; ++t) {
+        w[t] = (count(word_counts, t) + beta) /
+               (count(global_counts, t) + beta * nwords);
+      }
+      words.build(w);
+      e.draws = 0;
+    }
+  }
+
+  /// Rebuilds the doc proposal if it is stale. Called locked.
+  template <typename DocCounts>
+  void refresh_doc(entry& e, const DocCounts& counts) {
+    if (e.draws == 0 || ++e.draws >= ntopics) {
+      doc_proposals[e.slot].build(counts, ntopics);
+      e.draws = 1;
+    }
+  }
+}; // end of alias_lda_sampler
+
+#endif
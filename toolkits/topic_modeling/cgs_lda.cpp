@@ -43,6 +43,7 @@
 #include <boost/spirit/include/phoenix_operator.hpp>
 #include <boost/spirit/include/phoenix_stl.hpp>
 #include <graphlab/parallel/atomic.hpp>
+#include "alias_sampler.hpp"
 
 
 
@@ -186,6 +187,25 @@ size_t MAX_COUNT = 100;
  */
 float BURNIN = -1;
 
+/**
+ * \brief If set, tokens are sampled with the Metropolis-Hastings
+ * alias sampler (see alias_lda_sampler) in O(1) time per token instead
+ * of the O(NTOPICS) collapsed Gibbs sampler.
+ */
+bool USE_ALIAS_SAMPLER = false;
+
+/**
+ * \brief The number of Metropolis-Hastings steps per token of the
+ * alias sampler.
+ */
+size_t MH_STEPS = 2;
+
+/**
+ * \brief The proposals of the alias sampler, indexed by the local id
+ * of each word and document.
+ */
+alias_lda_sampler ALIAS_SAMPLER;
+
 /**
  * \brief The json top word struct contains the current set of top
  * words for each topic encoded in the form of a json string.
@@ -245,12 +265,14 @@ struct vertex_data {
   uint32_t nchanges;
   ///! The count of tokens in each topic
   factor_type factor;
-  vertex_data() : nupdates(0), nchanges(0), factor(NTOPICS) { }
+  ///! The contribution of the vertex to the likelihood at the last apply
+  double llik;
+  vertex_data() : nupdates(0), nchanges(0), factor(NTOPICS), llik(0) { }
   void save(graphlab::oarchive& arc) const {
-    arc << nupdates << nchanges << factor;
+    arc << nupdates << nchanges << factor << llik;
   }
   void load(graphlab::iarchive& arc) {
-    arc >> nupdates >> nchanges >> factor;
+    arc >> nupdates >> nchanges >> factor >> llik;
   }
 }; // end of vertex_data
 
@@ -485,8 +507,15 @@ public:
     vdata.nupdates++;
     vdata.nchanges = sum.nchanges;
     vdata.factor = sum.factor;
+    update_likelihood(context, vertex);
   } // end of apply
 
+  /**
+   * \brief Recompute the likelihood term of the vertex and push the
+   * change to the incremental likelihood aggregator.
+   */
+  static void update_likelihood(icontext_type& context, vertex_type& vertex);
+
 
   /**
    * \brief Scatter on all edges if the computation is on-going.
@@ -522,8 +551,12 @@ public:
       edge.source().data().factor : edge.target().data().factor;
     ASSERT_EQ(doc_topic_count.size(), NTOPICS);
     ASSERT_EQ(word_topic_count.size(), NTOPICS);
+    const graphlab::lvid_type doc_lvid = is_doc(edge.source()) ?
+      edge.source().local_id() : edge.target().local_id();
+    const graphlab::lvid_type word_lvid = is_word(edge.source()) ?
+      edge.source().local_id() : edge.target().local_id();
     // run the actual gibbs sampling
-    std::vector<double> prob(NTOPICS);
+    std::vector<double> prob(USE_ALIAS_SAMPLER ? 0 : NTOPICS);
     assignment_type& assignment = edge.data().assignment;
     edge.data().nchanges = 0;
     foreach(topic_id_type& asg, assignment) {
@@ -533,16 +566,22 @@ public:
         --word_topic_count[asg];
         --GLOBAL_TOPIC_COUNT[asg];
       }
-      for(size_t t = 0; t < NTOPICS; ++t) {
-        const double n_dt =
-          std::max(count_type(doc_topic_count[t]), count_type(0));
-        const double n_wt =
-          std::max(count_type(word_topic_count[t]), count_type(0));
-        const double n_t  =
-          std::max(count_type(GLOBAL_TOPIC_COUNT[t]), count_type(0));
-        prob[t] = (ALPHA + n_dt) * (BETA + n_wt) / (BETA * NWORDS + n_t);
+      if(USE_ALIAS_SAMPLER) {
+        asg = ALIAS_SAMPLER.sample(doc_lvid, doc_topic_count,
+                                   word_lvid, word_topic_count,
+                                   GLOBAL_TOPIC_COUNT, old_asg);
+      } else {
+        for(size_t t = 0; t < NTOPICS; ++t) {
+          const double n_dt =
+            std::max(count_type(doc_topic_count[t]), count_type(0));
+          const double n_wt =
+            std::max(count_type(word_topic_count[t]), count_type(0));
+          const double n_t  =
+            std::max(count_type(GLOBAL_TOPIC_COUNT[t]), count_type(0));
+          prob[t] = (ALPHA + n_dt) * (BETA + n_wt) / (BETA * NWORDS + n_t);
+        }
+        asg = graphlab::random::multinomial(prob);
       }
-      asg = graphlab::random::multinomial(prob);
       // asg = std::max_element(prob.begin(), prob.end()) - prob.begin();
       ++doc_topic_count[asg];
       ++word_topic_count[asg];
@@ -762,31 +801,63 @@ public:
     return *this;
   } // end of operator +=
 
-  static likelihood_aggregator
-  map(icontext_type& context, const vertex_type& vertex) {
+  /**
+   * \brief Compute the likelihood term of a single vertex from its
+   * topic counts.
+   */
+  static double vertex_term(const vertex_type& vertex) {
     // using boost::math::lgamma;
     const factor_type& factor = vertex.data().factor;
     ASSERT_EQ(factor.size(), NTOPICS);
-    likelihood_aggregator ret;
+    double ret = 0;
     if(is_word(vertex)) {
       for(size_t t = 0; t < NTOPICS; ++t) {
         const count_type value = std::max(count_type(factor[t]), count_type(0));
-        //ret.lik_words_given_topics += lgamma(value + BETA);
-        ret.lik_words_given_topics += BETA_LGAMMA(value);
+        //ret += lgamma(value + BETA);
+        ret += BETA_LGAMMA(value);
       }
     } else {  ASSERT_TRUE(is_doc(vertex));
       double ntokens_in_doc = 0;
       for(size_t t = 0; t < NTOPICS; ++t) {
         const count_type value = std::max(count_type(factor[t]), count_type(0));
-        //ret.lik_topics += lgamma(value + ALPHA);
-        ret.lik_topics += ALPHA_LGAMMA(value);
+        //ret += lgamma(value + ALPHA);
+        ret += ALPHA_LGAMMA(value);
         ntokens_in_doc += value;
       }
-      ret.lik_topics -= lgamma(ntokens_in_doc + NTOPICS * ALPHA);
+      ret -= lgamma(ntokens_in_doc + NTOPICS * ALPHA);
     }
     return ret;
+  } // end of vertex_term
+
+  /**
+   * \brief Wrap the likelihood term (or a change of it) of a vertex
+   * into the sum it contributes to.
+   */
+  static likelihood_aggregator
+  from_term(const vertex_type& vertex, double term) {
+    likelihood_aggregator ret;
+    if(is_word(vertex)) ret.lik_words_given_topics = term;
+    else ret.lik_topics = term;
+    return ret;
+  } // end of from_term
+
+  /**
+   * \brief Seed the incremental aggregation with the terms stored by
+   * the last apply. Later changes arrive as deltas from
+   * cgs_lda_vertex_program::update_likelihood.
+   */
+  static likelihood_aggregator
+  map(icontext_type& context, const vertex_type& vertex) {
+    return from_term(vertex, vertex.data().llik);
   } // end of map function
 
+  /**
+   * \brief Initialize the stored likelihood term of each vertex.
+   */
+  static void init_vertex(graph_type::vertex_type& vertex) {
+    vertex.data().llik = vertex_term(vertex);
+  } // end of init_vertex
+
   static void finalize(icontext_type& context, const likelihood_aggregator& total) {
     using boost::math::lgamma;
     // Address the global sum terms
@@ -811,6 +882,16 @@ public:
 }; // end of likelihood_aggregator struct
 
 
+void cgs_lda_vertex_program::update_likelihood(icontext_type& context,
+                                               vertex_type& vertex) {
+  const double llik = likelihood_aggregator::vertex_term(vertex);
+  context.aggregate_delta("likelihood",
+                          likelihood_aggregator::from_term
+                          (vertex, llik - vertex.data().llik));
+  vertex.data().llik = llik;
+} // end of update_likelihood
+
+
 
 /**
  * \brief The selective signal functions are used to signal only the
@@ -1120,6 +1201,14 @@ int main(int argc, char** argv) {
   clopts.attach_option("burnin", BURNIN, 
                        "The time in second to run until a sample is collected. "
                        "If less than zero the sampler runs indefinitely.");
+  std::string sampler = "gibbs";
+  clopts.attach_option("sampler", sampler,
+                       "The token sampler: gibbs (O(ntopics) per token) or "
+                       "alias (Metropolis-Hastings with alias tables, O(1) "
+                       "per token)");
+  clopts.attach_option("mh_steps", MH_STEPS,
+                       "Metropolis-Hastings steps per token of the alias "
+                       "sampler");
   clopts.attach_option("doc_dir", doc_dir,
                        "The output directory to save the final document counts.");
   clopts.attach_option("word_dir", word_dir,
@@ -1141,6 +1230,13 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if(sampler == "alias") {
+    USE_ALIAS_SAMPLER = true;
+  } else if(sampler != "gibbs") {
+    logstream(LOG_ERROR) << "Unknown sampler " << sampler << std::endl;
+    return EXIT_FAILURE;
+  }
+
   // Start the webserver
   graphlab::launch_metric_server();
   graphlab::add_metric_server_callback("wordclouds", word_cloud_callback);
@@ -1188,6 +1284,14 @@ int main(int argc, char** argv) {
   const size_t ntokens = graph.map_reduce_edges<size_t>(count_tokens);
   dc.cout() << "Total tokens: " << ntokens << std::endl;
 
+  if(USE_ALIAS_SAMPLER) {
+    std::vector<bool> is_word_lvid(graph.num_local_vertices());
+    for(graphlab::lvid_type lvid = 0; lvid < is_word_lvid.size(); ++lvid) {
+      is_word_lvid[lvid] = is_word(graph_type::vertex_type(graph, lvid));
+    }
+    ALIAS_SAMPLER.init(is_word_lvid, NTOPICS, ALPHA, BETA, NWORDS, MH_STEPS);
+  }
+
 
 
   engine_type engine(dc, graph, exec_type, clopts);
@@ -1211,8 +1315,9 @@ int main(int argc, char** argv) {
   }
   
   { // Add the likelihood aggregator
+    graph.transform_vertices(likelihood_aggregator::init_vertex);
     const bool success =
-      engine.add_vertex_aggregator<likelihood_aggregator>
+      engine.add_vertex_delta_aggregator<likelihood_aggregator>
       ("likelihood", 
        likelihood_aggregator::map, 
        likelihood_aggregator::finalize) &&
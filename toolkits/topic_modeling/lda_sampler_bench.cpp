@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2009 Carnegie Mellon University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://www.graphlab.ml.cmu.edu
+ *
+ */
+
+/**
+ * Compares the token throughput of the LDA samplers on a synthetic
+ * corpus, on a single thread:
+ *
+ *  - gibbs: the O(ntopics) collapsed Gibbs sampler of cgs_lda
+ *  - sparse: the bucketed sampler of cgs_lda_mimno_experimental, which
+ *    precomputes the word bucket for each (doc, word) pair
+ *  - alias: the Metropolis-Hastings alias sampler (cgs_lda --sampler=alias)
+ *
+ * Each sampler runs the same number of sweeps from the same random
+ * initialization and reports tokens per second and the final
+ * log-likelihood, which should be close for all of them.
+ */
+#include <cmath>
+#include <map>
+#include <vector>
+#include <iostream>
+#include <boost/math/special_functions/gamma.hpp>
+#include <graphlab.hpp>
+#include "alias_sampler.hpp"
+
+typedef std::vector<long> counts_type;
+
+size_t NTOPICS = 1000;
+size_t NWORDS = 10000;
+size_t NDOCS = 2000;
+size_t DOC_LENGTH = 200;
+double ALPHA = 0.1;
+double BETA = 0.01;
+
+/// A document is a list of (word, count) pairs, like the edges of cgs_lda
+struct doc_type {
+  std::vector<size_t> words;
+  std::vector<std::vector<uint16_t> > assignments;
+};
+
+struct model_type {
+  std::vector<counts_type> doc_counts;
+  std::vector<counts_type> word_counts;
+  counts_type global_counts;
+
+  void init(const std::vector<doc_type>& docs) {
+    doc_counts.assign(NDOCS, counts_type(NTOPICS, 0));
+    word_counts.assign(NWORDS, counts_type(NTOPICS, 0));
+    global_counts.assign(NTOPICS, 0);
+    for (size_t d = 0; d < docs.size(); ++d) {
+      for (size_t i = 0; i < docs[d].words.size(); ++i) {
+        for (size_t j = 0; j < docs[d].assignments[i].size(); ++j) {
+          add(d, docs[d].words[i], docs[d].assignments[i][j], 1);
+        }
+      }
+    }
+  }
+
+  inline void add(size_t d, size_t w, size_t t, long delta) {
+    doc_counts[d][t] += delta;
+    word_counts[w][t] += delta;
+    global_counts[t] += delta;
+  }
+
+  double log_likelihood() const {
+    using boost::math::lgamma;
+    double lik = NTOPICS * (lgamma(NWORDS * BETA) - NWORDS * lgamma(BETA)) +
+                 NDOCS * (lgamma(NTOPICS * ALPHA) - NTOPICS * lgamma(ALPHA));
+    for (size_t t = 0; t < NTOPICS; ++t) {
+      lik -= lgamma(global_counts[t] + NWORDS * BETA);
+    }
+    for (size_t w = 0; w < NWORDS; ++w) {
+      for (size_t t = 0; t < NTOPICS; ++t) lik += lgamma(word_counts[w][t] + BETA);
+    }
+    for (size_t d = 0; d < NDOCS; ++d) {
+      double ntokens = 0;
+      for (size_t t = 0; t < NTOPICS; ++t) {
+        lik += lgamma(doc_counts[d][t] + ALPHA);
+        ntokens += doc_counts[d][t];
+      }
+      lik -= lgamma(ntokens + NTOPICS * ALPHA);
+    }
+    return lik;
+  }
+};
+
+
+/// Draws a corpus with Zipf distributed words and random assignments
+std::vector<doc_type> make_corpus() {
+  std::vector<double> cdf(NWORDS);
+  double sum = 0;
+  for (size_t w = 0; w < NWORDS; ++w) {
+    sum += 1.0 / (w + 1);
+    cdf[w] = sum;
+  }
+  for (size_t w = 0; w < NWORDS; ++w) cdf[w] /= sum;
+  std::vector<doc_type> docs(NDOCS);
+  for (size_t d = 0; d < NDOCS; ++d) {
+    std::map<size_t, size_t> wordcount;
+    for (size_t i = 0; i < DOC_LENGTH; ++i) {
+      ++wordcount[graphlab::random::multinomial_cdf(cdf)];
+    }
+    for (std::map<size_t, size_t>::const_iterator it = wordcount.begin();
+         it != wordcount.end(); ++it) {
+      docs[d].words.push_back(it->first);
+      std::vector<uint16_t> asg(it->second);
+      for (size_t j = 0; j < asg.size(); ++j) {
+        asg[j] = graphlab::random::fast_uniform<size_t>(0, NTOPICS - 1);
+      }
+      docs[d].assignments.push_back(asg);
+    }
+  }
+  return docs;
+}
+
+
+void sweep_gibbs(std::vector<doc_type>& docs, model_type& m) {
+  std::vector<double> prob(NTOPICS);
+  for (size_t d = 0; d < docs.size(); ++d) {
+    for (size_t i = 0; i < docs[d].words.size(); ++i) {
+      const size_t w = docs[d].words[i];
+      const counts_type& nd = m.doc_counts[d];
+      const counts_type& nw = m.word_counts[w];
+      for (size_t j = 0; j < docs[d].assignments[i].size(); ++j) {
+        uint16_t& asg = docs[d].assignments[i][j];
+        m.add(d, w, asg, -1);
+        for (size_t t = 0; t < NTOPICS; ++t) {
+          prob[t] = (ALPHA + nd[t]) * (BETA + nw[t]) /
+                    (BETA * NWORDS + m.global_counts[t]);
+        }
+        asg = graphlab::random::multinomial(prob);
+        m.add(d, w, asg, 1);
+      }
+    }
+  }
+}
+
+
+void sweep_sparse(std::vector<doc_type>& docs, model_type& m) {
+  std::vector<double> qcache(NTOPICS);
+  for (size_t d = 0; d < docs.size(); ++d) {
+    const counts_type& nd = m.doc_counts[d];
+    for (size_t i = 0; i < docs[d].words.size(); ++i) {
+      const size_t w = docs[d].words[i];
+      const counts_type& nw = m.word_counts[w];
+      // the smoothing and document buckets, and the word bucket cache,
+      // rebuilt for each (doc, word) pair as in the experimental toolkit
+      double s = 0, r = 0, q = 0;
+      for (size_t t = 0; t < NTOPICS; ++t) {
+        const double denom = BETA * NWORDS + m.global_counts[t];
+        s += ALPHA * BETA / denom;
+        r += nd[t] * BETA / denom;
+        qcache[t] = nw[t] > 0 ? (ALPHA + nd[t]) * nw[t] / denom : 0;
+        q += qcache[t];
+      }
+      for (size_t j = 0; j < docs[d].assignments[i].size(); ++j) {
+        uint16_t& asg = docs[d].assignments[i][j];
+        size_t t = asg;
+        double denom = BETA * NWORDS + m.global_counts[t];
+        s -= ALPHA * BETA / denom; r -= nd[t] * BETA / denom; q -= qcache[t];
+        m.add(d, w, t, -1);
+        denom = BETA * NWORDS + m.global_counts[t];
+        s += ALPHA * BETA / denom; r += nd[t] * BETA / denom;
+        qcache[t] = nw[t] > 0 ? (ALPHA + nd[t]) * nw[t] / denom : 0;
+        q += qcache[t];
+
+        double f = graphlab::random::uniform<double>(0, s + r + q);
+        t = NTOPICS - 1;
+        if (f < s) {
+          for (size_t k = 0; k < NTOPICS; ++k) {
+            f -= ALPHA * BETA / (BETA * NWORDS + m.global_counts[k]);
+            if (f <= 0) { t = k; break; }
+          }
+        } else if (f < s + r) {
+          f -= s;
+          for (size_t k = 0; k < NTOPICS; ++k) {
+            if (nd[k] == 0) continue;
+            f -= nd[k] * BETA / (BETA * NWORDS + m.global_counts[k]);
+            if (f <= 0) { t = k; break; }
+          }
+        } else {
+          f -= s + r;
+          for (size_t k = 0; k < NTOPICS; ++k) {
+            if (qcache[k] == 0) continue;
+            f -= qcache[k];
+            if (f <= 0) { t = k; break; }
+          }
+        }
+        asg = t;
+        denom = BETA * NWORDS + m.global_counts[t];
+        s -= ALPHA * BETA / denom; r -= nd[t] * BETA / denom; q -= qcache[t];
+        m.add(d, w, t, 1);
+        denom = BETA * NWORDS + m.global_counts[t];
+        s += ALPHA * BETA / denom; r += nd[t] * BETA / denom;
+        qcache[t] = nw[t] > 0 ? (ALPHA + nd[t]) * nw[t] / denom : 0;
+        q += qcache[t];
+      }
+    }
+  }
+}
+
+
+void sweep_alias(std::vector<doc_type>& docs, model_type& m,
+                 alias_lda_sampler& sampler) {
+  for (size_t d = 0; d < docs.size(); ++d) {
+    for (size_t i = 0; i < docs[d].words.size(); ++i) {
+      const size_t w = docs[d].words[i];
+      for (size_t j = 0; j < docs[d].assignments[i].size(); ++j) {
+        uint16_t& asg = docs[d].assignments[i][j];
+        m.add(d, w, asg, -1);
+        // documents use the indices 0..NDOCS-1, words the ones after
+        asg = sampler.sample(d, m.doc_counts[d], NDOCS + w, m.word_counts[w],
+                             m.global_counts, asg);
+        m.add(d, w, asg, 1);
+      }
+    }
+  }
+}
+
+
+int main(int argc, char** argv) {
+  global_logger().set_log_level(LOG_WARNING);
+  size_t sweeps = 5;
+  size_t mh_steps = 2;
+  std::string samplers = "gibbs,sparse,alias";
+  graphlab::command_line_options clopts("LDA sampler benchmark", true);
+  clopts.attach_option("ntopics", NTOPICS, "Number of topics");
+  clopts.attach_option("nwords", NWORDS, "Vocabulary size");
+  clopts.attach_option("ndocs", NDOCS, "Number of documents");
+  clopts.attach_option("doc_length", DOC_LENGTH, "Tokens per document");
+  clopts.attach_option("alpha", ALPHA, "The document hyper-prior");
+  clopts.attach_option("beta", BETA, "The word hyper-prior");
+  clopts.attach_option("sweeps", sweeps, "Sweeps over the corpus per sampler");
+  clopts.attach_option("mh_steps", mh_steps,
+                       "Metropolis-Hastings steps per token of the alias sampler");
+  clopts.attach_option("samplers", samplers,
+                       "Comma separated samplers to run: gibbs,sparse,alias");
+  if(!clopts.parse(argc, argv)) return EXIT_FAILURE;
+  ASSERT_LT(NTOPICS, 65536);
+
+  graphlab::random::seed(1);
+  const std::vector<doc_type> corpus = make_corpus();
+  const size_t ntokens = NDOCS * DOC_LENGTH;
+  std::cout << NDOCS << " documents, " << NWORDS << " words, " << NTOPICS
+            << " topics, " << ntokens << " tokens" << std::endl;
+
+  const char* names[] = {"gibbs", "sparse", "alias"};
+  for (size_t k = 0; k < 3; ++k) {
+    if (samplers.find(names[k]) == std::string::npos) continue;
+    std::vector<doc_type> docs = corpus;
+    model_type m;
+    m.init(docs);
+    alias_lda_sampler sampler;
+    std::vector<bool> is_word(NDOCS + NWORDS, false);
+    std::fill(is_word.begin() + NDOCS, is_word.end(), true);
+    sampler.init(is_word, NTOPICS, ALPHA, BETA, NWORDS, mh_steps);
+    const double initial_lik = m.log_likelihood();
+    graphlab::timer ti; ti.start();
+    for (size_t i = 0; i < sweeps; ++i) {
+      if (k == 0) sweep_gibbs(docs, m);
+      else if (k == 1) sweep_sparse(docs, m);
+      else sweep_alias(docs, m, sampler);
+    }
+    const double elapsed = ti.current_time();
+    std::cout << names[k] << ":\t"
+              << (ntokens * sweeps) / elapsed << " tokens/s\t"
+              << "likelihood " << initial_lik << " -> " << m.log_likelihood()
+              << std::endl;
+  }
+  return EXIT_SUCCESS;
+}